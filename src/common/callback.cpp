@@ -8,6 +8,7 @@
 #include "core/init.h"
 #include "windows/id3dx.h"
 #include "tier0/fasttimer.h"
+#include "tier0/sigcache.h"
 #include "tier1/cvar.h"
 #include "tier1/fmtstr.h"
 #include "engine/shared/shared_rcon.h"
@@ -113,6 +114,8 @@ void Host_Changelevel_f(const CCommand& args)
 static ConVar fs_packedstore_workspace("fs_packedstore_workspace", "ship", FCVAR_DEVELOPMENTONLY, "Determines the current VPK workspace.");
 static ConVar fs_packedstore_compression_level("fs_packedstore_compression_level", "default", FCVAR_DEVELOPMENTONLY, "Determines the VPK compression level.", "fastest faster default better uber");
 static ConVar fs_packedstore_max_helper_threads("fs_packedstore_max_helper_threads", "-1", FCVAR_DEVELOPMENTONLY, "Max # of additional \"helper\" threads to create during compression.", true, -1, true, LZHAM_MAX_HELPER_THREADS, "Must range between [-1,LZHAM_MAX_HELPER_THREADS], where -1=max practical");
+static ConVar fs_packedstore_max_worker_threads("fs_packedstore_max_worker_threads", "-1", FCVAR_DEVELOPMENTONLY, "Max # of threads packing or unpacking VPK entries in parallel.", true, -1, false, 0, "-1=all logical processors");
+static ConVar fs_packedstore_content_defined_chunking("fs_packedstore_content_defined_chunking", "0", FCVAR_DEVELOPMENTONLY, "Carve deduplicated VPK entries on content-defined boundaries so similar assets share chunks.");
 
 /*
 =====================
@@ -146,6 +149,8 @@ void VPK_Pack_f(const CCommand& args)
 	CPackedStoreBuilder builder;
 
 	builder.InitLzEncoder(fs_packedstore_max_helper_threads.GetInt(), fs_packedstore_compression_level.GetString());
+	builder.InitWorkerThreads(fs_packedstore_max_worker_threads.GetInt());
+	builder.InitChunking(fs_packedstore_content_defined_chunking.GetBool());
 	builder.PackStore(pair, workspacePath, "vpk/");
 
 	timer.End();
@@ -185,6 +190,7 @@ void VPK_Unpack_f(const CCommand& args)
 	CPackedStoreBuilder builder;
 
 	builder.InitLzDecoder();
+	builder.InitWorkerThreads(fs_packedstore_max_worker_threads.GetInt());
 	builder.UnpackStore(vpk, fs_packedstore_workspace.GetString());
 
 	timer.End();
@@ -514,6 +520,42 @@ void CVFlag_f(const CCommand& args)
 	cv->CvarFindFlags_f(args);
 }
 
+/*
+=====================
+Sig_Benchmark_f
+
+  Measures cold start time
+  of the pattern scanner
+  against the pattern count
+=====================
+*/
+void Sig_Benchmark_f(const CCommand& args)
+{
+	const int bufferSizeMiB = args.ArgC() > 1 ? Clamp(atoi(args.Arg(1)), 1, 1024) : 64;
+	const int maxPatterns = args.ArgC() > 2 ? Clamp(atoi(args.Arg(2)), 1, 65536) : 1024;
+
+	PatternScan_Benchmark(g_GameDll, size_t(bufferSizeMiB) * 1024 * 1024, size_t(maxPatterns));
+}
+
+/*
+=====================
+Sig_ConvertCache_f
+
+  Converts a legacy signature
+  cache file to the current
+  table format
+=====================
+*/
+void Sig_ConvertCache_f(const CCommand& args)
+{
+	if (args.ArgC() < 3)
+	{
+		return;
+	}
+
+	CSigCache::ConvertLegacyCache(args.Arg(1), args.Arg(2));
+}
+
 #ifndef DEDICATED
 static double s_flScriptExecTimeBase = 0.0f;
 static int s_nScriptExecCount = 0;
@@ -34,6 +34,8 @@ void CVHelp_f(const CCommand& args);
 void CVList_f(const CCommand& args);
 void CVDiff_f(const CCommand& args);
 void CVFlag_f(const CCommand& args);
+void Sig_Benchmark_f(const CCommand& args);
+void Sig_ConvertCache_f(const CCommand& args);
 ///////////////////////////////////////////////////////////////////////////////
 class VCallback : public IDetour
 {
@@ -356,6 +356,9 @@ static ConCommand fs_vpk_unmount("fs_vpk_unmount", VPK_Unmount_f, "Unmount a VPK
 static ConCommand fs_vpk_pack("fs_vpk_pack", VPK_Pack_f, "Pack a VPK file from current workspace", FCVAR_DEVELOPMENTONLY);
 static ConCommand fs_vpk_unpack("fs_vpk_unpack", VPK_Unpack_f, "Unpack all files from a VPK file", FCVAR_DEVELOPMENTONLY);
 
+static ConCommand sig_benchmark("sig_benchmark", Sig_Benchmark_f, "Benchmark single and batched signature scanning on a synthetic buffer", FCVAR_DEVELOPMENTONLY, nullptr, "sig_benchmark <bufferSizeMiB> <maxPatterns>");
+static ConCommand sig_convert_cache("sig_convert_cache", Sig_ConvertCache_f, "Convert a legacy signature cache file to the current table format", FCVAR_DEVELOPMENTONLY, nullptr, "sig_convert_cache <legacyFile> <outFile>");
+
 //-----------------------------------------------------------------------------
 // Purpose: shipped ConCommand initialization
 //-----------------------------------------------------------------------------
@@ -4,8 +4,11 @@
 //
 //===========================================================================//
 #pragma once
+#include <deque>
+#include <memory>
 
 typedef int SocketHandle_t;
+typedef std::shared_ptr<const vector<char>> NetConFrame_t; // Length-prefixed frame, shared between send queues.
 
 enum class ServerDataRequestType_t : int
 {
@@ -31,26 +34,33 @@ class CConnectedNetConsoleData
 {
 public:
 	SocketHandle_t m_hSocket;
-	int  m_nPayloadLen;     // Num bytes for this message.
-	int  m_nPayloadRead;    // Num read bytes from input buffer.
+	int  m_nRecvHead;       // Offset of the first unprocessed byte in the receive buffer.
+	int  m_nRecvTail;       // Offset past the last received byte in the receive buffer.
 	int  m_nFailedAttempts; // Num failed authentication attempts.
 	int  m_nIgnoredMessage; // Count how many times client ignored the no-auth message.
 	bool m_bValidated;      // Revalidates netconsole if false.
 	bool m_bAuthorized;     // Set to true after successful netconsole auth.
 	bool m_bInputOnly;      // If set, don't send spew to this netconsole.
-	vector<uint8_t> m_RecvBuffer;
+	vector<uint8_t> m_RecvBuffer; // Frames are parsed in place.
+
+	std::deque<NetConFrame_t> m_SendQueue; // Frames waiting for the socket to become writable.
+	size_t m_nSendQueueLen; // Num bytes left to send from the queue.
+	int  m_nSendOffset;     // Num bytes already sent from the front frame.
+	bool m_bSendFailed;     // Set if the queue overflowed or the socket errored; connection gets dropped.
 
 	CConnectedNetConsoleData(SocketHandle_t hSocket = -1)
 	{
 		m_hSocket = hSocket;
-		m_nPayloadLen = 0;
-		m_nPayloadRead = 0;
+		m_nRecvHead = 0;
+		m_nRecvTail = 0;
 		m_nFailedAttempts = 0;
 		m_nIgnoredMessage = 0;
 		m_bValidated = false;
 		m_bAuthorized = false;
 		m_bInputOnly = true;
-		m_RecvBuffer.resize(sizeof(u_long)); // Reserve enough for length-prefix.
+		m_nSendQueueLen = 0;
+		m_nSendOffset = 0;
+		m_bSendFailed = false;
 	}
 };
 
@@ -32,6 +32,7 @@
 #include "filesystem/filesystem.h"
 #include "datacache/mdlcache.h"
 #include "ebisusdk/EbisuSDK.h"
+#include "networksystem/pylon.h"
 #ifndef DEDICATED
 #include "codecs/bink/bink_impl.h"
 #include "codecs/miles/miles_impl.h"
@@ -298,6 +299,9 @@ void Systems_Shutdown()
 	LiveAPISystem()->Shutdown();
 #endif// !CLIENT_DLL
 
+	// Finish master server requests in flight
+	g_PylonExecutor.Shutdown();
+
 	CFastTimer shutdownTimer;
 	shutdownTimer.Start();
 
@@ -442,7 +446,31 @@ void DetourInit() // Run the sigscan
 	bool bInitDivider = false;
 
 	g_SigCache.SetDisabled(bNoSmap);
-	g_SigCache.ReadCache(SIGDB_FILE);
+
+	if (!g_SigCache.ReadCache(SIGDB_FILE))
+	{
+		// The cache was generated by another SDK build; resolve all game
+		// executable patterns of the previous cache in a single pass instead
+		// of scanning for them one by one.
+		const vector<string>& stalePatterns = g_SigCache.GetStalePatterns();
+
+		if (!stalePatterns.empty())
+		{
+			vector<const char*> pszPatterns(stalePatterns.size());
+			vector<CMemory> results(stalePatterns.size());
+
+			for (size_t i = 0; i < stalePatterns.size(); i++)
+				pszPatterns[i] = stalePatterns[i].c_str();
+
+			const double flStartTime = Plat_FloatTime();
+			const size_t nFound = g_GameDll.FindPatternsSIMD(pszPatterns.data(), pszPatterns.size(), results.data());
+
+			DevMsg(eDLL_T::COMMON, "%s: resolved '%zu' of '%zu' patterns from outdated cache in '%lf' seconds\n",
+				__FUNCTION__, nFound, pszPatterns.size(), Plat_FloatTime() - flStartTime);
+
+			g_SigCache.ClearStalePatterns();
+		}
+	}
 
 	// No debug logging in non dev builds.
 	const bool bDevMode = !IsCert() && !IsRetail();
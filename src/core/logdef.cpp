@@ -1,5 +1,6 @@
 #include "core/stdafx.h"
 #include "core/logdef.h"
+#include "core/logger.h"
 
 std::shared_ptr<spdlog::logger> g_TermLogger;
 std::shared_ptr<spdlog::logger> g_ImGuiLogger;
@@ -111,6 +112,7 @@ void SpdLog_Init(const bool bAnsiColor)
 //#############################################################################
 void SpdLog_Shutdown()
 {
+	Logger_Shutdown(); // Write all queued lines before the loggers are dropped.
 	spdlog::shutdown();
 #ifdef _TOOLS
 	// Destroy the tools logger to flush it.
@@ -12,8 +12,22 @@
 #ifndef _TOOLS
 #include "vscript/languages/squirrel_re/include/sqstdaux.h"
 #endif // !_TOOLS
-static const std::regex s_AnsiRowRegex("\\\033\\[.*?m");
-static std::mutex s_LogMutex;
+#ifndef _TOOLS
+#include "tier1/cvar.h"
+#endif // !_TOOLS
+#include <atomic>
+#include <condition_variable>
+
+#define LOG_QUEUE_SIZE 4096 // Must be a power of 2.
+#define LOG_RECORD_TEXT_SIZE 448 // Longer lines are copied to the heap.
+#define LOG_RECORD_NAME_SIZE 32
+#define LOG_FORMAT_BUFFER_SIZE 4096 // Initial size of each thread's format buffer, grows for longer lines.
+#define LOG_STRIP_BUFFER_SIZE 2048 // Lines that are stripped on the stack, longer lines are stripped on the heap.
+#define LOG_MAX_CACHED_LOGGERS 16
+
+#define LOG_WRITER_BATCH_SIZE 256 // Max records written per lock of the writer thread.
+#define LOG_WRITER_IDLE_WAIT_MS 10
+#define LOG_WRITER_SHUTDOWN_WAIT_MS 2000
 
 #if !defined (DEDICATED) && !defined (_TOOLS)
 ImVec4 CheckForWarnings(LogType_t type, eDLL_T context, const ImVec4& defaultCol)
@@ -126,29 +140,905 @@ bool LoggedFromClient(eDLL_T context)
 #endif // !DEDICATED
 }
 
+//-----------------------------------------------------------------------------
+// Everything needed to emit a log line, besides the text itself
+//-----------------------------------------------------------------------------
+struct LogRecordInfo_s
+{
+	LogType_t logType;
+	LogLevel_t logLevel;
+	eDLL_T context;
+
+#if !defined (DEDICATED) && !defined (_TOOLS)
+	eDLL_T overlayContext;
+	ImVec4 overlayColor;
+#endif // !DEDICATED && !_TOOLS
+
+	bool bToConsole;
+	bool bUseColor;
+	bool bImportant; // Warnings and errors are never dropped.
+
+	// The text starts with the up time, followed by the context
+	// and colors, and ends with the formatted input.
+	int upTimeLen;
+	int formattedOffset;
+	int textLen;
+
+	char loggerName[LOG_RECORD_NAME_SIZE];
+};
+
+//-----------------------------------------------------------------------------
+// Queued log record, the text is stored inline unless it doesn't fit
+//-----------------------------------------------------------------------------
+struct LogRecord_s
+{
+	std::atomic<size_t> sequence;
+	LogRecordInfo_s info;
+
+	char* pHeapText;
+	char text[LOG_RECORD_TEXT_SIZE];
+
+	inline const char* GetText() const { return pHeapText ? pHeapText : text; }
+};
+
+//-----------------------------------------------------------------------------
+// Growable text buffer, used per thread to format log lines without
+// allocating; it only grows for lines longer than it has seen before
+//-----------------------------------------------------------------------------
+class CLogFormatBuffer
+{
+public:
+	CLogFormatBuffer() : m_nLength(0)
+	{
+		m_Buffer.resize(LOG_FORMAT_BUFFER_SIZE);
+		m_Buffer[0] = '\0';
+	}
+
+	inline void Clear() { m_nLength = 0; m_Buffer[0] = '\0'; }
+
+	inline const char* Get() const { return m_Buffer.data(); }
+	inline size_t Length() const { return m_nLength; }
+
+	void Append(const char* const pszText, const size_t nLen);
+	inline void Append(const char* const pszText) { Append(pszText, strlen(pszText)); }
+
+	void AppendV(const char* const pszFormat, va_list args);
+	void Insert(const size_t nPos, const char* const pszText);
+
+private:
+	void EnsureCapacity(const size_t nSize);
+
+	vector<char> m_Buffer;
+	size_t m_nLength;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: grows the buffer to hold at least nSize characters
+//-----------------------------------------------------------------------------
+void CLogFormatBuffer::EnsureCapacity(const size_t nSize)
+{
+	if (nSize > m_Buffer.size())
+		m_Buffer.resize(Max(nSize, m_Buffer.size() * 2));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: appends text to the buffer
+//-----------------------------------------------------------------------------
+void CLogFormatBuffer::Append(const char* const pszText, const size_t nLen)
+{
+	EnsureCapacity(m_nLength + nLen + 1);
+
+	memcpy(&m_Buffer[m_nLength], pszText, nLen);
+	m_nLength += nLen;
+
+	m_Buffer[m_nLength] = '\0';
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: formats and appends text to the buffer
+//-----------------------------------------------------------------------------
+void CLogFormatBuffer::AppendV(const char* const pszFormat, va_list args)
+{
+	const size_t nAvailable = m_Buffer.size() - m_nLength;
+
+	va_list argsCopy;
+	va_copy(argsCopy, args);
+	const int nLen = vsnprintf(&m_Buffer[m_nLength], nAvailable, pszFormat, argsCopy);
+	va_end(argsCopy);
+
+	if (nLen < 0) // Encoding error, drop the input.
+	{
+		m_Buffer[m_nLength] = '\0';
+		return;
+	}
+
+	if (size_t(nLen) >= nAvailable)
+	{
+		EnsureCapacity(m_nLength + nLen + 1);
+
+		va_copy(argsCopy, args);
+		vsnprintf(&m_Buffer[m_nLength], m_Buffer.size() - m_nLength, pszFormat, argsCopy);
+		va_end(argsCopy);
+	}
+
+	m_nLength += nLen;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: inserts text into the buffer at given position
+//-----------------------------------------------------------------------------
+void CLogFormatBuffer::Insert(const size_t nPos, const char* const pszText)
+{
+	Assert(nPos <= m_nLength);
+	const size_t nLen = strlen(pszText);
+
+	EnsureCapacity(m_nLength + nLen + 1);
+
+	memmove(&m_Buffer[nPos + nLen], &m_Buffer[nPos], m_nLength - nPos + 1);
+	memcpy(&m_Buffer[nPos], pszText, nLen);
+
+	m_nLength += nLen;
+}
+
+static thread_local CLogFormatBuffer s_LogFormatBuffer;
+static thread_local bool s_bLogFormatBufferInUse = false;
+
+//-----------------------------------------------------------------------------
+// Provides the calling thread's format buffer; lines logged while the thread
+// is still emitting one (e.g. from the log writer) get a buffer of their own
+//-----------------------------------------------------------------------------
+class CScopedLogFormatBuffer
+{
+public:
+	CScopedLogFormatBuffer()
+		: m_pNested(s_bLogFormatBufferInUse ? new CLogFormatBuffer() : nullptr)
+	{
+		s_bLogFormatBufferInUse = true;
+		Get().Clear();
+	}
+
+	~CScopedLogFormatBuffer()
+	{
+		if (m_pNested)
+			delete m_pNested;
+		else
+			s_bLogFormatBufferInUse = false;
+	}
+
+	inline CLogFormatBuffer& Get() { return m_pNested ? *m_pNested : s_LogFormatBuffer; }
+
+private:
+	CLogFormatBuffer* const m_pNested;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: copies the up time from the start of a log line
+// Input  : &info -
+//			*pszText -
+//			*pszOut -
+//			nOutSize -
+//-----------------------------------------------------------------------------
+static void Logger_CopyUpTime(const LogRecordInfo_s& info, const char* const pszText, char* const pszOut, const size_t nOutSize)
+{
+	const size_t nLen = Min(size_t(info.upTimeLen), nOutSize - 1);
+
+	memcpy(pszOut, pszText, nLen);
+	pszOut[nLen] = '\0';
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: copies text without its ANSI rows in a single pass, matches what
+//          the regex '\033\[.*?m' used to remove
+// Input  : *pszText -
+//			nLen -
+//			*pszOut - must hold at least nLen + 1 characters
+// Output : length of the stripped text
+//-----------------------------------------------------------------------------
+static size_t Logger_StripAnsiRows(const char* const pszText, const size_t nLen, char* const pszOut)
+{
+	const char* p = pszText;
+	const char* const pEnd = pszText + nLen;
+
+	char* pOut = pszOut;
+
+	while (p < pEnd)
+	{
+		const char* const pEscape = static_cast<const char*>(memchr(p, '\033', pEnd - p));
+		const char* const pRunEnd = pEscape ? pEscape : pEnd;
+
+		memcpy(pOut, p, pRunEnd - p);
+		pOut += pRunEnd - p;
+		p = pRunEnd;
+
+		if (!pEscape)
+			break;
+
+		const char* q = p + 1;
+
+		if (q < pEnd && *q == '[')
+		{
+			// Rows don't span lines.
+			while (++q < pEnd && *q != 'm' && *q != '\n' && *q != '\r');
+
+			if (q < pEnd && *q == 'm')
+			{
+				p = q + 1;
+				continue;
+			}
+		}
+
+		// Not an ANSI row, keep the escape character.
+		*pOut++ = *p++;
+	}
+
+	*pOut = '\0';
+	return size_t(pOut - pszOut);
+}
+
+// Set while the current thread writes records; the write lock is held and
+// any log line emitted while writing (e.g. from RCON) is written in place.
+static thread_local bool s_bInLogWriter = false;
+
+//-----------------------------------------------------------------------------
+// Writes log records to all interfaces. Records are submitted to a bounded
+// lock-free queue and written from a background thread, so the logging
+// thread only formats the line and never waits on terminal, file or network
+// IO unless the queue overflows. Records are written from the submitting
+// thread when the writer isn't running (tools, shutdown) or when the process
+// is about to be terminated, after everything queued before.
+//-----------------------------------------------------------------------------
+class CLogWriter
+{
+public:
+	CLogWriter();
+	~CLogWriter();
+
+	void Submit(const LogRecordInfo_s& info, const char* const pszText);
+	void WriteNow(const LogRecordInfo_s& info, const char* const pszText);
+
+	void Flush();
+	void Shutdown();
+
+	inline void SetOverflowPolicy(const LogOverflowPolicy_t policy) { m_OverflowPolicy.store(policy, std::memory_order_relaxed); }
+	inline uint64_t GetDroppedCount() const { return m_nDroppedTotal.load(std::memory_order_relaxed); }
+
+private:
+	bool IsRunning();
+	bool StartWriter();
+	void WriterThread();
+
+	bool ShouldDrop(const LogRecordInfo_s& info) const;
+
+	LogRecord_s* TryClaim(size_t& nPos);
+	LogRecord_s* Peek() const;
+	void Release(LogRecord_s* const pRecord);
+
+	inline bool HasPending() const { return m_nEnqueuePos.load() != m_nDequeuePos.load(); }
+
+	int Drain(const int nMax);
+	void DrainClaimed();
+	void WriteRecord(const LogRecordInfo_s& info, const char* const pszText);
+
+#ifndef _TOOLS
+	spdlog::logger* FindLogger(const char* const pszName);
+
+	struct CachedLogger_s
+	{
+		char name[LOG_RECORD_NAME_SIZE];
+		std::shared_ptr<spdlog::logger> logger;
+	};
+
+	CachedLogger_s m_LoggerCache[LOG_MAX_CACHED_LOGGERS];
+	int m_nCachedLoggers;
+#endif // !_TOOLS
+
+	LogRecord_s* m_pRecords; // Allocated when the writer starts, never freed.
+
+	// Producers and the consumer each get their own cache line.
+	alignas(64) std::atomic<size_t> m_nEnqueuePos;
+	alignas(64) std::atomic<size_t> m_nDequeuePos;
+
+	alignas(64) std::atomic<bool> m_bRunning;
+	std::atomic<bool> m_bWriterIdle;
+	std::atomic<bool> m_bStopWriter;
+	std::atomic<bool> m_bWriterDone;
+
+	std::atomic<LogOverflowPolicy_t> m_OverflowPolicy;
+	std::atomic<uint32_t> m_nDroppedPending; // Dropped since the last notice.
+	std::atomic<uint64_t> m_nDroppedTotal;
+
+	bool m_bShutdown;
+
+	std::mutex m_StartMutex;
+	std::mutex m_WriteMutex; // Held while writing records, serializes all consumers.
+
+	std::mutex m_WakeMutex;
+	std::condition_variable m_WakeCondition;
+
+	std::thread m_WriterThread;
+};
+
+static CLogWriter s_LogWriter;
+
+//-----------------------------------------------------------------------------
+// Purpose: constructor
+//-----------------------------------------------------------------------------
+CLogWriter::CLogWriter()
+	: m_pRecords(nullptr)
+	, m_nEnqueuePos(0)
+	, m_nDequeuePos(0)
+	, m_bRunning(false)
+	, m_bWriterIdle(false)
+	, m_bStopWriter(false)
+	, m_bWriterDone(false)
+	, m_OverflowPolicy(LogOverflowPolicy_t::LOG_OVERFLOW_DROP_INFO)
+	, m_nDroppedPending(0)
+	, m_nDroppedTotal(0)
+	, m_bShutdown(false)
+{
+#ifndef _TOOLS
+	m_nCachedLoggers = 0;
+#endif // !_TOOLS
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: destructor
+//-----------------------------------------------------------------------------
+CLogWriter::~CLogWriter()
+{
+	// Only reached without a shutdown if the process exits abruptly,
+	// don't terminate it on the thread that is still running.
+	if (m_WriterThread.joinable())
+		m_WriterThread.detach();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: returns whether records should be queued, starts the writer on
+//          first use. The tools write everything in place as their output
+//          is interleaved with interactive input.
+//-----------------------------------------------------------------------------
+bool CLogWriter::IsRunning()
+{
+#ifndef _TOOLS
+	return m_bRunning.load(std::memory_order_acquire) || StartWriter();
+#else
+	return false;
+#endif // !_TOOLS
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: starts the writer thread, unless the writer has been shut down
+//-----------------------------------------------------------------------------
+bool CLogWriter::StartWriter()
+{
+	std::lock_guard<std::mutex> lock(m_StartMutex);
+
+	if (m_bShutdown)
+		return false;
+
+	if (m_bRunning.load(std::memory_order_relaxed))
+		return true;
+
+	m_pRecords = new LogRecord_s[LOG_QUEUE_SIZE];
+
+	for (size_t i = 0; i < LOG_QUEUE_SIZE; i++)
+	{
+		m_pRecords[i].sequence.store(i, std::memory_order_relaxed);
+		m_pRecords[i].pHeapText = nullptr;
+	}
+
+	m_WriterThread = std::thread(&CLogWriter::WriterThread, this);
+	m_bRunning.store(true, std::memory_order_release);
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes queued records until shut down
+//-----------------------------------------------------------------------------
+void CLogWriter::WriterThread()
+{
+	while (!m_bStopWriter.load(std::memory_order_acquire))
+	{
+		if (!HasPending())
+		{
+			std::unique_lock<std::mutex> lock(m_WakeMutex);
+			m_bWriterIdle.store(true);
+
+			m_WakeCondition.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_IDLE_WAIT_MS), [this]()
+				{
+					return HasPending() || m_bStopWriter.load(std::memory_order_acquire);
+				});
+
+			m_bWriterIdle.store(false, std::memory_order_relaxed);
+			continue;
+		}
+
+		int nWritten;
+		{
+			std::lock_guard<std::mutex> lock(m_WriteMutex);
+			s_bInLogWriter = true;
+
+			nWritten = Drain(LOG_WRITER_BATCH_SIZE);
+
+			s_bInLogWriter = false;
+		}
+
+		if (!nWritten) // A producer claimed a record, but hasn't published it yet.
+			std::this_thread::yield();
+	}
+
+	m_bWriterDone.store(true, std::memory_order_release);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: returns whether to drop a record that doesn't fit the queue,
+//          as opposed to blocking until it can be written
+//-----------------------------------------------------------------------------
+bool CLogWriter::ShouldDrop(const LogRecordInfo_s& info) const
+{
+	switch (m_OverflowPolicy.load(std::memory_order_relaxed))
+	{
+	case LogOverflowPolicy_t::LOG_OVERFLOW_DROP_INFO:
+		return !info.bImportant;
+	case LogOverflowPolicy_t::LOG_OVERFLOW_DROP:
+		return true;
+	case LogOverflowPolicy_t::LOG_OVERFLOW_BLOCK:
+	default:
+		return false;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: claims the next free record in the queue (any thread)
+// Input  : &nPos - position of the record, used to publish it
+// Output : the record, or nullptr if the queue is full
+//-----------------------------------------------------------------------------
+LogRecord_s* CLogWriter::TryClaim(size_t& nPos)
+{
+	nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+
+	for (;;)
+	{
+		LogRecord_s* const pRecord = &m_pRecords[nPos & (LOG_QUEUE_SIZE - 1)];
+
+		const size_t nSequence = pRecord->sequence.load(std::memory_order_acquire);
+		const intptr_t nDiff = intptr_t(nSequence) - intptr_t(nPos);
+
+		if (nDiff == 0)
+		{
+			if (m_nEnqueuePos.compare_exchange_weak(nPos, nPos + 1, std::memory_order_relaxed))
+				return pRecord;
+		}
+		else if (nDiff < 0) // The record from the previous lap hasn't been written yet.
+			return nullptr;
+		else
+			nPos = m_nEnqueuePos.load(std::memory_order_relaxed);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: returns the oldest published record (write lock holder only)
+// Output : the record, or nullptr if none is ready to be written
+//-----------------------------------------------------------------------------
+LogRecord_s* CLogWriter::Peek() const
+{
+	const size_t nPos = m_nDequeuePos.load(std::memory_order_relaxed);
+	LogRecord_s* const pRecord = &m_pRecords[nPos & (LOG_QUEUE_SIZE - 1)];
+
+	if (pRecord->sequence.load(std::memory_order_acquire) != nPos + 1)
+		return nullptr;
+
+	return pRecord;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: hands a written record back to the producers (write lock holder only)
+//-----------------------------------------------------------------------------
+void CLogWriter::Release(LogRecord_s* const pRecord)
+{
+	const size_t nPos = m_nDequeuePos.load(std::memory_order_relaxed);
+
+	if (pRecord->pHeapText)
+	{
+		delete[] pRecord->pHeapText;
+		pRecord->pHeapText = nullptr;
+	}
+
+	pRecord->sequence.store(nPos + LOG_QUEUE_SIZE, std::memory_order_release);
+	m_nDequeuePos.store(nPos + 1, std::memory_order_relaxed);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes queued records (write lock holder only)
+// Input  : nMax -
+// Output : number of records written
+//-----------------------------------------------------------------------------
+int CLogWriter::Drain(const int nMax)
+{
+	if (!m_pRecords)
+		return 0;
+
+	int nWritten = 0;
+
+	for (; nWritten < nMax; nWritten++)
+	{
+		LogRecord_s* const pRecord = Peek();
+
+		if (!pRecord)
+			break;
+
+		WriteRecord(pRecord->info, pRecord->GetText());
+		Release(pRecord);
+	}
+
+	const uint32_t nDropped = m_nDroppedPending.exchange(0, std::memory_order_relaxed);
+
+	if (nDropped)
+	{
+		// Written in place as we hold the write lock, and never dropped.
+		Warning(eDLL_T::COMMON, "Dropped %u log message(s); the log queue was full\n", nDropped);
+	}
+
+	return nWritten;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes all records claimed so far, including those that are still
+//          being filled in (write lock holder only); this keeps the lines of
+//          each thread in order when a record is written in place
+//-----------------------------------------------------------------------------
+void CLogWriter::DrainClaimed()
+{
+	if (!m_pRecords)
+		return;
+
+	const size_t nEnd = m_nEnqueuePos.load(std::memory_order_relaxed);
+
+	while (intptr_t(nEnd - m_nDequeuePos.load(std::memory_order_relaxed)) > 0)
+	{
+		if (!Drain(INT_MAX)) // Claimed, but not yet published.
+			std::this_thread::yield();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: queues a record for the writer thread, or writes it in place if
+//          the writer isn't running
+// Input  : &info -
+//			*pszText -
+//-----------------------------------------------------------------------------
+void CLogWriter::Submit(const LogRecordInfo_s& info, const char* const pszText)
+{
+	if (s_bInLogWriter || !IsRunning())
+	{
+		WriteNow(info, pszText);
+		return;
+	}
+
+	size_t nPos;
+	LogRecord_s* const pRecord = TryClaim(nPos);
+
+	if (!pRecord)
+	{
+		if (ShouldDrop(info))
+		{
+			m_nDroppedPending.fetch_add(1, std::memory_order_relaxed);
+			m_nDroppedTotal.fetch_add(1, std::memory_order_relaxed);
+
+			return;
+		}
+
+		// Queue is full, write the backlog and this record from here.
+		WriteNow(info, pszText);
+		return;
+	}
+
+	pRecord->info = info;
+
+	if (info.textLen < LOG_RECORD_TEXT_SIZE)
+		memcpy(pRecord->text, pszText, info.textLen + 1);
+	else
+	{
+		pRecord->pHeapText = new char[info.textLen + 1];
+		memcpy(pRecord->pHeapText, pszText, info.textLen + 1);
+	}
+
+	pRecord->sequence.store(nPos + 1, std::memory_order_release);
+
+	// Pairs with the store in Shutdown; if the writer got shut down after
+	// the running check above, its last drain may have missed this record.
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if (!m_bRunning.load(std::memory_order_relaxed))
+	{
+		Flush();
+		return;
+	}
+
+	if (m_bWriterIdle.load())
+	{
+		// Taking the lock ensures the writer is either waiting,
+		// or has yet to check for pending records.
+		{
+			std::lock_guard<std::mutex> lock(m_WakeMutex);
+		}
+		m_WakeCondition.notify_one();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes a record from the calling thread, after all queued ones
+// Input  : &info -
+//			*pszText -
+//-----------------------------------------------------------------------------
+void CLogWriter::WriteNow(const LogRecordInfo_s& info, const char* const pszText)
+{
+	if (s_bInLogWriter)
+	{
+		WriteRecord(info, pszText);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock(m_WriteMutex);
+	s_bInLogWriter = true;
+
+	DrainClaimed();
+	WriteRecord(info, pszText);
+
+	s_bInLogWriter = false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes all queued records from the calling thread
+//-----------------------------------------------------------------------------
+void CLogWriter::Flush()
+{
+	if (s_bInLogWriter)
+		return;
+
+	std::lock_guard<std::mutex> lock(m_WriteMutex);
+	s_bInLogWriter = true;
+
+	DrainClaimed();
+
+	s_bInLogWriter = false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: stops the writer thread and writes what it left behind; records
+//          submitted afterwards are written in place
+//-----------------------------------------------------------------------------
+void CLogWriter::Shutdown()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_StartMutex);
+		m_bShutdown = true;
+	}
+
+	if (m_bRunning.load(std::memory_order_acquire))
+	{
+		m_bRunning.store(false);
+		m_bStopWriter.store(true, std::memory_order_release);
+
+		{
+			std::lock_guard<std::mutex> lock(m_WakeMutex);
+		}
+		m_WakeCondition.notify_one();
+
+		// Wait for the loop to end rather than joining the thread, this can
+		// run from DllMain where the thread can't exit, or from the crash
+		// handler where it might be the crashing thread or already killed.
+		if (std::this_thread::get_id() != m_WriterThread.get_id())
+		{
+			const HANDLE hThread = m_WriterThread.native_handle();
+			const ULONGLONG nDeadline = GetTickCount64() + LOG_WRITER_SHUTDOWN_WAIT_MS;
+
+			while (!m_bWriterDone.load(std::memory_order_acquire)
+				&& WaitForSingleObject(hThread, 1) == WAIT_TIMEOUT
+				&& GetTickCount64() < nDeadline);
+		}
+
+		m_WriterThread.detach();
+	}
+
+	if (s_bInLogWriter)
+		return; // Shutdown was initiated while writing, e.g. a crash.
+
+	// Don't wait for the lock, a writer that didn't stop could hold it.
+	std::unique_lock<std::mutex> lock(m_WriteMutex, std::try_to_lock);
+
+	if (!lock.owns_lock())
+		return;
+
+	s_bInLogWriter = true;
+	DrainClaimed();
+	s_bInLogWriter = false;
+
+#ifndef _TOOLS
+	// Release the loggers, so they get destroyed and flushed with spdlog.
+	for (int i = 0; i < m_nCachedLoggers; i++)
+		m_LoggerCache[i].logger.reset();
+
+	m_nCachedLoggers = 0;
+#endif // !_TOOLS
+}
+
+#ifndef _TOOLS
+//-----------------------------------------------------------------------------
+// Purpose: finds a logger by name, replaces looking it up in the spdlog
+//          registry for every line (write lock holder only)
+// Input  : *pszName -
+// Output : the logger, or nullptr if it doesn't exist
+//-----------------------------------------------------------------------------
+spdlog::logger* CLogWriter::FindLogger(const char* const pszName)
+{
+	for (int i = 0; i < m_nCachedLoggers; i++)
+	{
+		if (strcmp(m_LoggerCache[i].name, pszName) == 0)
+			return m_LoggerCache[i].logger.get();
+	}
+
+	std::shared_ptr<spdlog::logger> logger = spdlog::get(pszName);
+
+	if (!logger)
+		return nullptr;
+
+	if (m_nCachedLoggers < LOG_MAX_CACHED_LOGGERS)
+	{
+		CachedLogger_s& entry = m_LoggerCache[m_nCachedLoggers++];
+
+		strncpy_s(entry.name, pszName, _TRUNCATE);
+		entry.logger = logger;
+	}
+	else
+		Assert(0, "Log writer's logger cache is full");
+
+	// Kept alive by the cache or the spdlog registry.
+	return logger.get();
+}
+#endif // !_TOOLS
+
+//-----------------------------------------------------------------------------
+// Purpose: emits a record to all interfaces (write lock holder only)
+// Input  : &info -
+//			*pszText -
+//-----------------------------------------------------------------------------
+void CLogWriter::WriteRecord(const LogRecordInfo_s& info, const char* const pszText)
+{
+	const char* pszMessage = pszText;
+	size_t nMessageLen = size_t(info.textLen);
+
+	// Stripped lines are kept on the stack, as lines
+	// logged while writing this one are written in place.
+	char szStripped[LOG_STRIP_BUFFER_SIZE];
+	string strippedHeap;
+
+	if (info.bToConsole)
+	{
+		g_TermLogger->log(spdlog::level::debug, spdlog::string_view_t(pszMessage, nMessageLen));
+
+		if (info.bUseColor)
+		{
+			// Remove ANSI rows before emitting to file or over wire.
+			char* pszOut = szStripped;
+
+			if (nMessageLen >= sizeof(szStripped))
+			{
+				strippedHeap.resize(nMessageLen);
+				pszOut = &strippedHeap[0];
+			}
+
+			nMessageLen = Logger_StripAnsiRows(pszMessage, nMessageLen, pszOut);
+			pszMessage = pszOut;
+		}
+	}
+
+	const spdlog::string_view_t message(pszMessage, nMessageLen);
+
+	// If a debugger is attached, emit the text there too
+	if (Plat_IsInDebugSession())
+		Plat_DebugString(pszMessage);
+
+#ifndef _TOOLS
+	// Output is always logged to the file.
+	spdlog::logger* const ntlogger = FindLogger(info.loggerName); // <-- Obtain by 'loggerName'.
+	assert(ntlogger != nullptr);
+
+	if (ntlogger)
+		ntlogger->log(spdlog::level::debug, message);
+
+	if (info.bToConsole)
+	{
+#ifndef CLIENT_DLL
+		if (!LoggedFromClient(info.context) && RCONServer()->ShouldSend(netcon::response_e::SERVERDATA_RESPONSE_CONSOLE_LOG))
+		{
+			char szUpTime[64];
+			Logger_CopyUpTime(info, pszText, szUpTime, sizeof(szUpTime));
+
+			RCONServer()->SendEncoded(pszText + info.formattedOffset, szUpTime, netcon::response_e::SERVERDATA_RESPONSE_CONSOLE_LOG,
+				int(info.context), int(info.logType));
+		}
+#endif // !CLIENT_DLL
+#ifndef DEDICATED
+		g_ImGuiLogger->log(spdlog::level::debug, message);
+
+		const string logStreamBuf = g_LogStream.str();
+		g_Console.AddLog(logStreamBuf.c_str(), ImGui::ColorConvertFloat4ToU32(info.overlayColor));
+
+		// We can only log to the in-game overlay console when the SDK has
+		// been fully initialized, due to the use of ConVar's.
+		if (g_bSdkInitialized && info.logLevel >= LogLevel_t::LEVEL_NOTIFY)
+		{
+			// Draw to mini console.
+			g_TextOverlay.AddLog(info.overlayContext, logStreamBuf.c_str());
+		}
+#endif // !DEDICATED
+	}
+
+#ifndef DEDICATED
+	g_LogStream.str(string());
+	g_LogStream.clear();
+#endif // !DEDICATED
+
+#else
+	if (g_SuppementalToolsLogger)
+	{
+		g_SuppementalToolsLogger->log(spdlog::level::debug, message);
+	}
+#endif
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: Show logs to all console interfaces (va_list version)
-// Input  : logType - 
-//			logLevel - 
-//			context - 
-//			*pszLogger - 
+// Input  : logType -
+//			logLevel -
+//			context -
+//			*pszLogger -
 //			*pszFormat -
-//			args - 
-//			exitCode - 
-//			*pszUptimeOverride - 
+//			args -
+//			exitCode -
+//			*pszUptimeOverride -
 //-----------------------------------------------------------------------------
 void EngineLoggerSink(LogType_t logType, LogLevel_t logLevel, eDLL_T context,
 	const char* pszLogger, const char* pszFormat, va_list args,
 	const UINT exitCode /*= NO_ERROR*/, const char* pszUptimeOverride /*= nullptr*/)
 {
-	const char* pszUpTime = pszUptimeOverride ? pszUptimeOverride : Plat_GetProcessUpTime();
-	string message(pszUpTime);
+	// Lines are formatted in a per-thread buffer, and only
+	// copied into the queue once complete.
+	CScopedLogFormatBuffer formatBuffer;
+	CLogFormatBuffer& message = formatBuffer.Get();
+
+	if (pszUptimeOverride)
+		message.Append(pszUptimeOverride);
+	else
+	{
+		char szUpTime[64];
+		Plat_GetProcessUpTime(szUpTime, sizeof(szUpTime));
+
+		message.Append(szUpTime);
+	}
+
+	LogRecordInfo_s info;
+
+	info.logType = logType;
+	info.logLevel = logLevel;
+	info.context = context;
+	info.upTimeLen = int(message.Length());
 
 	const bool bToConsole = (logLevel >= LogLevel_t::LEVEL_CONSOLE);
 	const bool bUseColor = (bToConsole && g_bSpdLog_UseAnsiClr);
 
+	info.bToConsole = bToConsole;
+	info.bUseColor = bUseColor;
+	info.bImportant = (logType == LogType_t::LOG_WARNING || logType == LogType_t::LOG_ERROR
+		|| logType == LogType_t::SQ_WARNING || context == eDLL_T::SYSTEM_WARNING || context == eDLL_T::SYSTEM_ERROR);
+
+	Assert(strlen(pszLogger) < sizeof(info.loggerName));
+	strncpy_s(info.loggerName, pszLogger, _TRUNCATE);
+
 	const char* pszContext = GetContextNameByIndex(context, bUseColor);
-	message.append(pszContext);
+	message.Append(pszContext);
 
 #if !defined (DEDICATED) && !defined (_TOOLS)
 	ImVec4 overlayColor = GetColorForContext(logType, context);
@@ -159,8 +1049,6 @@ void EngineLoggerSink(LogType_t logType, LogLevel_t logLevel, eDLL_T context,
 	bool bSquirrel = false;
 	bool bWarning = false;
 	bool bError = false;
-#else
-	NOTE_UNUSED(pszLogger);
 #endif // !_TOOLS
 
 	//-------------------------------------------------------------------------
@@ -174,7 +1062,7 @@ void EngineLoggerSink(LogType_t logType, LogLevel_t logLevel, eDLL_T context,
 #endif // !DEDICATED && !_TOOLS
 		if (bUseColor)
 		{
-			message.append(g_svYellowF);
+			message.Append(g_svYellowF);
 		}
 		break;
 	case LogType_t::LOG_ERROR:
@@ -183,7 +1071,7 @@ void EngineLoggerSink(LogType_t logType, LogLevel_t logLevel, eDLL_T context,
 #endif // !DEDICATED && !_TOOLS
 		if (bUseColor)
 		{
-			message.append(g_svRedF);
+			message.Append(g_svRedF);
 		}
 		break;
 #ifndef _TOOLS
@@ -206,10 +1094,10 @@ void EngineLoggerSink(LogType_t logType, LogLevel_t logLevel, eDLL_T context,
 	//-------------------------------------------------------------------------
 	// Format actual input
 	//-------------------------------------------------------------------------
-	va_list argsCopy;
-	va_copy(argsCopy, args);
-	const string formatted = FormatV(pszFormat, argsCopy);
-	va_end(argsCopy);
+	const size_t nFormattedOffset = message.Length();
+	message.AppendV(pszFormat, args);
+
+	info.formattedOffset = int(nFormattedOffset);
 
 #ifndef _TOOLS
 	//-------------------------------------------------------------------------
@@ -217,25 +1105,29 @@ void EngineLoggerSink(LogType_t logType, LogLevel_t logLevel, eDLL_T context,
 	//-------------------------------------------------------------------------
 	if (bToConsole && bSquirrel)
 	{
+		const char* const pszFormatted = message.Get() + nFormattedOffset;
+
 		if (bWarning && g_bSQAuxError)
 		{
-			if (formatted.find("SCRIPT ERROR:") != string::npos ||
-				formatted.find(" -> ") != string::npos)
+			if (strstr(pszFormatted, "SCRIPT ERROR:") ||
+				strstr(pszFormatted, " -> "))
 			{
 				bError = true;
 			}
 		}
 		else if (g_bSQAuxBadLogic)
 		{
-			if (formatted.find("There was a problem processing game logic.") != string::npos)
+			if (strstr(pszFormatted, "There was a problem processing game logic."))
 			{
 				bError = true;
 				g_bSQAuxBadLogic = false;
 			}
 		}
 
-		// Append warning/error color before appending the formatted text,
+		// Insert warning/error color before the formatted text,
 		// so that this gets marked as such while preserving context colors.
+		const char* pszColor = nullptr;
+
 		if (bError)
 		{
 #ifndef DEDICATED
@@ -243,87 +1135,159 @@ void EngineLoggerSink(LogType_t logType, LogLevel_t logLevel, eDLL_T context,
 			overlayColor = ImVec4(1.00f, 0.00f, 0.00f, 0.80f);
 #endif // !DEDICATED
 
+			info.bImportant = true;
+
 			if (bUseColor)
 			{
-				message.append(g_svRedF);
+				pszColor = g_svRedF;
 			}
 		}
 		else if (bUseColor && bWarning)
 		{
-			message.append(g_svYellowF);
+			pszColor = g_svYellowF;
+		}
+
+		if (pszColor)
+		{
+			message.Insert(nFormattedOffset, pszColor);
+			info.formattedOffset += int(strlen(pszColor));
 		}
 	}
 #endif // !_TOOLS
-	message.append(formatted);
+
+#if !defined (DEDICATED) && !defined (_TOOLS)
+	info.overlayContext = overlayContext;
+	info.overlayColor = overlayColor;
+#endif // !DEDICATED && !_TOOLS
+
+	info.textLen = int(message.Length());
 
 	//-------------------------------------------------------------------------
 	// Emit to all interfaces
 	//-------------------------------------------------------------------------
-	std::lock_guard<std::mutex> lock(s_LogMutex);
-	if (bToConsole)
+	if (!exitCode)
 	{
-		g_TermLogger->debug(message);
+		s_LogWriter.Submit(info, message.Get());
+		return;
+	}
 
-		if (bUseColor)
-		{
-			// Remove ANSI rows before emitting to file or over wire.
-			message = std::regex_replace(message, s_AnsiRowRegex, "");
-		}
+	// Terminate the process if an exit code was passed, the line
+	// and everything before it must be written before we do so.
+	s_LogWriter.WriteNow(info, message.Get());
+
+	char szUpTime[64];
+	Logger_CopyUpTime(info, message.Get(), szUpTime, sizeof(szUpTime));
+
+	if (MessageBoxA(NULL, Format("%s- %s", szUpTime, message.Get() + info.formattedOffset).c_str(),
+		"SDK Error", MB_ICONERROR | MB_OK))
+	{
+		TerminateProcess(GetCurrentProcess(), exitCode);
 	}
+}
 
-	// If a debugger is attached, emit the text there too
-	if (Plat_IsInDebugSession())
-		Plat_DebugString(message.c_str());
+//-----------------------------------------------------------------------------
+// Purpose: sets what to do with log lines when the log queue is full
+// Input  : policy -
+//-----------------------------------------------------------------------------
+void Logger_SetOverflowPolicy(const LogOverflowPolicy_t policy)
+{
+	s_LogWriter.SetOverflowPolicy(policy);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: returns the number of log lines dropped as the log queue was full
+//-----------------------------------------------------------------------------
+uint64_t Logger_GetDroppedCount()
+{
+	return s_LogWriter.GetDroppedCount();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes all queued log lines from the calling thread
+//-----------------------------------------------------------------------------
+void Logger_Flush()
+{
+	s_LogWriter.Flush();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: stops the log writer thread and writes all queued log lines,
+//          lines logged afterwards are written in place
+//-----------------------------------------------------------------------------
+void Logger_Shutdown()
+{
+	s_LogWriter.Shutdown();
+}
 
 #ifndef _TOOLS
-	// Output is always logged to the file.
-	std::shared_ptr<spdlog::logger> ntlogger = spdlog::get(pszLogger); // <-- Obtain by 'pszLogger'.
-	assert(ntlogger.get() != nullptr);
-	ntlogger->debug(message);
+static void Logger_OverflowPolicy_f(IConVar* pConVar, const char* pOldString, float flOldValue, ChangeUserData_t pUserData)
+{
+	if (const ConVar* const pConVarRef = g_pCVar->FindVar(pConVar->GetName()))
+		Logger_SetOverflowPolicy(LogOverflowPolicy_t(pConVarRef->GetInt()));
+}
 
-	if (bToConsole)
-	{
-#ifndef CLIENT_DLL
-		if (!LoggedFromClient(context) && RCONServer()->ShouldSend(netcon::response_e::SERVERDATA_RESPONSE_CONSOLE_LOG))
-		{
-			RCONServer()->SendEncoded(formatted.c_str(), pszUpTime, netcon::response_e::SERVERDATA_RESPONSE_CONSOLE_LOG,
-				int(context), int(logType));
-		}
-#endif // !CLIENT_DLL
-#ifndef DEDICATED
-		g_ImGuiLogger->debug(message);
+static ConVar logger_overflowPolicy("logger_overflowPolicy", "0", FCVAR_RELEASE, "What to do with log lines when the log queue is full", true, 0.f, true, 2.f, &Logger_OverflowPolicy_f,
+	"0 = drop informational lines, block on warnings and errors; 1 = block; 2 = drop");
 
-		const string logStreamBuf = g_LogStream.str();
-		g_Console.AddLog(logStreamBuf.c_str(), ImGui::ColorConvertFloat4ToU32(overlayColor));
+/*
+==================
+Logger_Benchmark_f
 
-		// We can only log to the in-game overlay console when the SDK has
-		// been fully initialized, due to the use of ConVar's.
-		if (g_bSdkInitialized && logLevel >= LogLevel_t::LEVEL_NOTIFY)
-		{
-			// Draw to mini console.
-			g_TextOverlay.AddLog(overlayContext, logStreamBuf.c_str());
-		}
-#endif // !DEDICATED
-	}
+Logs many lines to disk
+from multiple threads,
+and reports how fast they
+were submitted and written
+==================
+*/
+static void Logger_Benchmark_f(const CCommand& args)
+{
+	const int numThreads = args.ArgC() > 1 ? Clamp(atoi(args.Arg(1)), 1, 64) : 4;
+	const int numLines = args.ArgC() > 2 ? Clamp(atoi(args.Arg(2)), 1, 1000000) : 50000;
 
-#ifndef DEDICATED
-	g_LogStream.str(string());
-	g_LogStream.clear();
-#endif // !DEDICATED
+	const int64_t totalLines = int64_t(numThreads) * numLines;
+	const uint64_t droppedBefore = Logger_GetDroppedCount();
 
-#else
-	if (g_SuppementalToolsLogger)
+	std::atomic<int64_t> submitTimeNs(0);
+	std::vector<std::thread> producers;
+
+	const double startTime = Plat_FloatTime();
+
+	for (int i = 0; i < numThreads; i++)
 	{
-		g_SuppementalToolsLogger->debug(message);
+		producers.emplace_back([&, i]()
+			{
+				const double threadStart = Plat_FloatTime();
+
+				for (int j = 0; j < numLines; j++)
+				{
+					CoreMsg(LogType_t::LOG_INFO, LogLevel_t::LEVEL_DISK_ONLY, eDLL_T::ENGINE, NO_ERROR, "sdk",
+						"%s: thread %d line %d; %f\n", __FUNCTION__, i, j, Plat_FloatTime());
+				}
+
+				submitTimeNs.fetch_add(int64_t((Plat_FloatTime() - threadStart) * 1e9), std::memory_order_relaxed);
+			});
 	}
-#endif
 
-	if (exitCode) // Terminate the process if an exit code was passed.
+	for (std::thread& producer : producers)
+		producer.join();
+
+	const double submitTime = Plat_FloatTime() - startTime;
+
+	Logger_Flush();
+
+	const double totalTime = Plat_FloatTime() - startTime;
+	const uint64_t dropped = Logger_GetDroppedCount() - droppedBefore;
+
+	Msg(eDLL_T::ENGINE, "%s: %d threads logged %lld lines (%.1f ns per line per thread); submitted in %.3f ms (%.0f lines/s), written in %.3f ms (%.0f lines/s)\n",
+		__FUNCTION__, numThreads, totalLines, double(submitTimeNs.load()) / double(totalLines), submitTime * 1000.0, double(totalLines) / submitTime,
+		totalTime * 1000.0, double(totalLines - dropped) / totalTime);
+
+	if (dropped)
 	{
-		if (MessageBoxA(NULL, Format("%s- %s", pszUpTime, formatted.c_str()).c_str(),
-			"SDK Error", MB_ICONERROR | MB_OK))
-		{
-			TerminateProcess(GetCurrentProcess(), exitCode);
-		}
+		Warning(eDLL_T::ENGINE, "%s: %llu lines dropped as the log queue was full (logger_overflowPolicy %d)\n",
+			__FUNCTION__, dropped, logger_overflowPolicy.GetInt());
 	}
 }
+
+static ConCommand logger_benchmark("logger_benchmark", Logger_Benchmark_f, "Benchmarks logging throughput with many threads writing to disk", FCVAR_DEVELOPMENTONLY, nullptr, "logger_benchmark <numThreads> <linesPerThread>");
+#endif // !_TOOLS
@@ -1,8 +1,24 @@
 #ifndef LOGGER_H
 #define LOGGER_H
 
+//-----------------------------------------------------------------------------
+// What to do with log lines when the log queue is full
+//-----------------------------------------------------------------------------
+enum class LogOverflowPolicy_t
+{
+	LOG_OVERFLOW_DROP_INFO = 0, // Drop informational lines, block on warnings and errors.
+	LOG_OVERFLOW_BLOCK,         // Block until the line can be written.
+	LOG_OVERFLOW_DROP           // Drop the line.
+};
+
 void EngineLoggerSink(LogType_t logType, LogLevel_t logLevel, eDLL_T context,
 	const char* pszLogger, const char* pszFormat, va_list args,
 	const UINT exitCode /*= NO_ERROR*/, const char* pszUptimeOverride /*= nullptr*/);
 
+void Logger_SetOverflowPolicy(const LogOverflowPolicy_t policy);
+uint64_t Logger_GetDroppedCount();
+
+void Logger_Flush();
+void Logger_Shutdown();
+
 #endif // LOGGER_H
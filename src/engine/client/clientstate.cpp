@@ -18,6 +18,7 @@
 #include "engine/server/server.h"
 #endif // !CLIENT_DLL
 #include "clientstate.h"
+#include "datablock_receiver.h"
 #include "common/callback.h"
 #include "cdll_engine_int.h"
 #include "vgui/vgui_baseui_interface.h"
@@ -459,6 +460,10 @@ void CClientState::VConnect(CClientState* thisptr, connectparams_t* connectParam
         }
     }
 
+    // Must be loaded before connecting, as the available dictionaries are
+    // advertised to the server through UserInfo ConVars.
+    DataBlock_LoadClientDictionaries();
+
     CClientState__Connect(thisptr, connectParams);
 }
 
@@ -8,6 +8,141 @@
 #include "common/proto_oob.h"
 #include "engine/common.h"
 #include "engine/host_cmd.h"
+#include "engine/shared/datablock_codec.h"
+#include "filesystem/filesystem.h"
+
+// advertised to the server on connect, which only sends codecs we support
+static ConVar cl_dataBlockCodecs("cl_dataBlockCodecs", "15", FCVAR_HIDDEN | FCVAR_USERINFO | FCVAR_DONTRECORD, "Bit mask of data block codecs supported by this client");
+static ConVar cl_dataBlockDictionaries("cl_dataBlockDictionaries", "", FCVAR_HIDDEN | FCVAR_USERINFO | FCVAR_DONTRECORD, "Ids of data block dictionaries available on this client");
+
+//-----------------------------------------------------------------------------
+// Decoder state, kept alive for the lifetime of the process so decoding a
+// data block never allocates
+//-----------------------------------------------------------------------------
+class CDataBlockDecoder
+{
+public:
+	CDataBlockDecoder() : m_dctx(nullptr), m_dictsLoaded(false) {}
+	~CDataBlockDecoder();
+
+	void LoadDictionaries();
+	int Decode(const DataBlockCodec_e codec, const void* const source, const int sourceSize, void* const dest, const int destCapacity);
+
+	// the encoded data gets copied in here so we can decode back into the
+	// data block buffer we copied the encoded data from
+	char m_encodedBuffer[SNAPSHOT_SCRATCH_BUFFER_SIZE];
+
+private:
+	ZSTD_DCtx* m_dctx;
+	std::unordered_map<uint32_t, ZSTD_DDict*> m_dicts;
+	bool m_dictsLoaded;
+};
+
+static CDataBlockDecoder s_dataBlockDecoder;
+
+CDataBlockDecoder::~CDataBlockDecoder()
+{
+	for (const auto& it : m_dicts)
+		ZSTD_freeDDict(it.second);
+
+	ZSTD_freeDCtx(m_dctx);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: loads all data block dictionaries and advertises them to servers,
+//          only done once as the dictionaries are shipped with the game
+//-----------------------------------------------------------------------------
+void CDataBlockDecoder::LoadDictionaries()
+{
+	if (m_dictsLoaded)
+		return;
+
+	m_dictsLoaded = true;
+
+	string advertisedIds;
+	FileFindHandle_t findHandle;
+
+	const char* fileName = FileSystem()->FindFirstEx(DATABLOCK_DICT_PATH "*" DATABLOCK_DICT_EXT, "PLATFORM", &findHandle);
+
+	for (; fileName; fileName = FileSystem()->FindNext(findHandle))
+	{
+		if (FileSystem()->FindIsDirectory(findHandle))
+			continue;
+
+		if (m_dicts.size() >= DATABLOCK_DICT_MAX_ADVERTISED)
+		{
+			Warning(eDLL_T::CLIENT, "%s: more than %d dictionaries; ignoring '%s'\n",
+				__FUNCTION__, DATABLOCK_DICT_MAX_ADVERTISED, fileName);
+			continue;
+		}
+
+		DataBlockDictionary_s dict;
+
+		if (!DataBlock_LoadDictionary(Format("platform/" DATABLOCK_DICT_PATH "%s", fileName).c_str(), dict)
+			|| m_dicts.find(dict.id) != m_dicts.end())
+			continue;
+
+		ZSTD_DDict* const ddict = ZSTD_createDDict(dict.data.data(), dict.data.size());
+
+		if (!ddict)
+			continue;
+
+		m_dicts.emplace(dict.id, ddict);
+
+		if (!advertisedIds.empty())
+			advertisedIds += ',';
+
+		advertisedIds += Format("%08x", dict.id);
+	}
+
+	FileSystem()->FindClose(findHandle);
+	cl_dataBlockDictionaries.SetValue(advertisedIds.c_str());
+
+	DevMsg(eDLL_T::CLIENT, "Loaded %zu data block dictionaries\n", m_dicts.size());
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: decodes the data block
+// Output : decoded size, -1 on failure
+//-----------------------------------------------------------------------------
+int CDataBlockDecoder::Decode(const DataBlockCodec_e codec, const void* const source, const int sourceSize,
+	void* const dest, const int destCapacity)
+{
+	const ZSTD_DDict* ddict = nullptr;
+
+	if (codec == DATABLOCK_CODEC_ZSTD || codec == DATABLOCK_CODEC_ZSTD_DICT)
+	{
+		if (!m_dctx)
+		{
+			m_dctx = ZSTD_createDCtx();
+
+			if (!m_dctx)
+				return -1;
+		}
+
+		if (codec == DATABLOCK_CODEC_ZSTD_DICT)
+		{
+			// the frame carries the id of the dictionary it was encoded with
+			const auto it = m_dicts.find(ZSTD_getDictID_fromFrame(source, sourceSize));
+
+			if (it == m_dicts.end())
+				return -1;
+
+			ddict = it->second;
+		}
+	}
+
+	return DataBlock_Decode(codec, m_dctx, ddict, source, sourceSize, dest, destCapacity);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: loads the data block dictionaries, must be called before the
+//          connection is made as the UserInfo ConVars are sent on connect
+//-----------------------------------------------------------------------------
+void DataBlock_LoadClientDictionaries()
+{
+	s_dataBlockDecoder.LoadDictionaries();
+}
 
 //-----------------------------------------------------------------------------
 // Purpose: send an ack back to the server to let them know
@@ -104,28 +239,25 @@ bool ClientDataBlockReceiver::ProcessDataBlock(const double startTime, const sho
 
 	const ClientDataBlockHeader_s* const pHeader = reinterpret_cast<ClientDataBlockHeader_s*>(m_pScratchBuffer);
 
-	if (pHeader->isCompressed)
+	if (pHeader->codec != DATABLOCK_CODEC_NONE)
 	{
-		// NOTE: the engine's implementation of this function does NOT free
-		// this buffer when a malformed/corrupt LZ4 packet is sent to the
-		// receiver; wrapped buffer in unique_ptr to make sure it never leaks!
-		std::unique_ptr<char> encodedDataBuf(new char[SNAPSHOT_SCRATCH_BUFFER_SIZE]);
-
-		char* const pEncodedDataBuf = encodedDataBuf.get();
+		const DataBlockCodec_e codec = DataBlockCodec_e(pHeader->codec);
 		char* const dataLocation = m_pScratchBuffer + sizeof(ClientDataBlockHeader_s);
 
-		// copy the encoded data in the newly allocated buffer so we can decode back
+		// copy the encoded data in the persistent buffer so we can decode back
 		// into the data block buffer we copied the encoded data from
 		const int compressedSize = m_nTransferSize -1;
 
-		memcpy(pEncodedDataBuf, dataLocation, compressedSize);
-		const int numDecode = LZ4_decompress_safe(pEncodedDataBuf, dataLocation, compressedSize, SNAPSHOT_SCRATCH_BUFFER_SIZE);
+		memcpy(s_dataBlockDecoder.m_encodedBuffer, dataLocation, compressedSize);
+		const int numDecode = s_dataBlockDecoder.Decode(codec, s_dataBlockDecoder.m_encodedBuffer,
+			compressedSize, dataLocation, SNAPSHOT_SCRATCH_BUFFER_SIZE);
 
 		if (numDecode < 0)
 		{
 			Assert(0);
 
-			COM_ExplainDisconnection(true, "LZ4 error decompressing data block from server.\n");
+			COM_ExplainDisconnection(true, "Error decoding data block from server (codec \"%s\").\n",
+				DataBlock_GetCodecName(codec));
 			v_Host_Disconnect(true);
 
 			return false;
@@ -135,7 +267,7 @@ bool ClientDataBlockReceiver::ProcessDataBlock(const double startTime, const sho
 	}
 	else
 	{
-		// truncate the byte that determines whether the data was compressed
+		// truncate the byte that determines the codec of the data
 		m_nTransferSize--;
 	}
 
@@ -146,7 +278,7 @@ bool ClientDataBlockReceiver::ProcessDataBlock(const double startTime, const sho
 // NOTE: detoured for 2 reasons:
 // 1: when a corrupt or malformed compress packet is sent, the code never freed
 //    the temporary copy buffer it made to decode the data into the scratch buf
-// 2: exploring other compression algorithms for potential optimizations
+// 2: support for the zstd codecs, see DataBlockCodec_e
 //-----------------------------------------------------------------------------
 static bool HK_ProcessDataBlock(ClientDataBlockReceiver* receiver, const double startTime,
 	const short transferId, const int transferSize, const short transferNr,
@@ -21,9 +21,11 @@ public:
 struct ClientDataBlockHeader_s
 {
 	char reserved[3]; // unused in retail
-	bool isCompressed;
+	uint8_t codec; // DataBlockCodec_e, retail only received 0 or 1 (isCompressed)
 };
 
+void DataBlock_LoadClientDictionaries();
+
 // virtual methods
 inline void*(*ClientDataBlockReceiver__AcknowledgeTransmission)(ClientDataBlockReceiver* thisptr);
 
@@ -6,6 +6,8 @@
 //=============================================================================//
 
 #include "core/stdafx.h"
+#include <atomic>
+#include <random>
 #include "tier0/frametask.h"
 #include "engine/host.h"
 #ifndef DEDICATED
@@ -95,6 +97,116 @@ void _Host_Error(const char* error, ...)
 	v_Host_Error(buf);
 }
 
+/*
+==================
+Host_FrameTaskStress_f
+
+Dispatches tasks from many
+producer threads into a
+private frame task queue,
+while this thread runs its
+frames, and verifies each
+task ran once and on time
+==================
+*/
+static void Host_FrameTaskStress_f(const CCommand& args)
+{
+	const int numThreads = args.ArgC() > 1 ? Clamp(atoi(args.Arg(1)), 1, 64) : 8;
+	const int numTasks = args.ArgC() > 2 ? Clamp(atoi(args.Arg(2)), 1, 1000000) : 100000;
+
+	const int64_t totalTasks = int64_t(numThreads) * numTasks;
+
+	CFrameTask* const taskQueue = new CFrameTask();
+
+	std::atomic<uint64_t> publishedFrame(0);
+	std::atomic<int64_t> numExecuted(0);
+	std::atomic<int64_t> numEarly(0);
+	std::atomic<int> numProducersDone(0);
+
+	uint64_t runningFrame = 0; // Only accessed by this thread, and the tasks it runs.
+	double dispatchTime = 0.0;
+
+	std::mutex timeMutex;
+	std::vector<std::thread> producers;
+
+	for (int i = 0; i < numThreads; i++)
+	{
+		producers.emplace_back([&, i]()
+			{
+				std::mt19937 rng(i);
+				const double startTime = Plat_FloatTime();
+
+				for (int j = 0; j < numTasks; j++)
+				{
+					// Exceed the wheel size so tasks also take multiple turns.
+					const unsigned int delay = rng() % (FRAMETASK_WHEEL_SIZE + 64);
+					const uint64_t minFrame = publishedFrame.load(std::memory_order_acquire) + delay;
+
+					auto onRun = [&, minFrame]()
+					{
+						if (runningFrame < minFrame)
+							numEarly.fetch_add(1, std::memory_order_relaxed);
+
+						numExecuted.fetch_add(1, std::memory_order_relaxed);
+					};
+
+					// Every so often, dispatch a functor that doesn't fit inline.
+					if ((j & 15) == 0)
+					{
+						char padding[FRAMETASK_INLINE_SIZE * 2] = {};
+						taskQueue->Dispatch([onRun, padding]() { onRun(); }, delay);
+					}
+					else
+						taskQueue->Dispatch(onRun, delay);
+				}
+
+				const double elapsed = Plat_FloatTime() - startTime;
+				{
+					std::lock_guard<std::mutex> lock(timeMutex);
+					dispatchTime += elapsed;
+				}
+
+				numProducersDone.fetch_add(1, std::memory_order_release);
+			});
+	}
+
+	const double startTime = Plat_FloatTime();
+	uint64_t idleFrames = 0;
+
+	// Keep running frames until everything ran, with a bound in case tasks got
+	// lost; all tasks are due within the wheel size past the last dispatch.
+	while (numExecuted.load(std::memory_order_relaxed) < totalTasks && idleFrames < FRAMETASK_WHEEL_SIZE * 4)
+	{
+		if (numProducersDone.load(std::memory_order_acquire) == numThreads)
+			idleFrames++;
+
+		taskQueue->RunFrame();
+
+		publishedFrame.store(++runningFrame, std::memory_order_release);
+	}
+
+	const double totalTime = Plat_FloatTime() - startTime;
+
+	for (std::thread& producer : producers)
+		producer.join();
+
+	delete taskQueue;
+
+	const int64_t executed = numExecuted.load();
+	const int64_t early = numEarly.load();
+
+	Msg(eDLL_T::ENGINE, "%s: %d producers dispatched %lld tasks (%.1f ns per dispatch), ran over %llu frames in %.3f ms\n",
+		__FUNCTION__, numThreads, totalTasks, dispatchTime / double(totalTasks) * 1e9, runningFrame, totalTime * 1000.0);
+
+	if (executed != totalTasks || early != 0)
+	{
+		Warning(eDLL_T::ENGINE, "%s: FAILED; %lld tasks missing, %lld ran early\n",
+			__FUNCTION__, totalTasks - executed, early);
+	}
+}
+
+static ConCommand host_frameTaskStress("host_frameTaskStress", Host_FrameTaskStress_f, "Stress tests the frame task queue with many producer threads", FCVAR_DEVELOPMENTONLY, nullptr, "host_frameTaskStress <numThreads> <tasksPerThread>");
+
 ///////////////////////////////////////////////////////////////////////////////
 void VHost::Detour(const bool bAttach) const
 {
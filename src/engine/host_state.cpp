@@ -101,7 +101,7 @@ static void HostState_KeepAlive()
 			).count()
 	};
 
-	std::thread request([&, gameServer]
+	g_PylonExecutor.Submit([gameServer]
 		{
 			string errorMsg;
 			string hostToken;
@@ -137,8 +137,6 @@ static void HostState_KeepAlive()
 				}, 0);
 		}
 	);
-
-	request.detach();
 }
 #endif // DEDICATED
 
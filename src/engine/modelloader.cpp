@@ -16,6 +16,10 @@
 
 //model_t* pErrorMDL = nullptr;
 
+static ConVar mod_lumpPrefetch("mod_lumpPrefetch", "1", FCVAR_RELEASE, "Read the lumps of a map in parallel as soon as its header is loaded.");
+static ConVar mod_lumpPrefetchThreads("mod_lumpPrefetchThreads", "4", FCVAR_RELEASE, "Number of threads reading map lumps in parallel.", true, 1.f, true, float(MAP_LUMP_PREFETCH_MAX_THREADS));
+static ConVar mod_lumpPrefetchMaxMiB("mod_lumpPrefetchMaxMiB", "256", FCVAR_RELEASE, "Max size of the prefetched lumps that haven't been used by the map loader yet, in MiB.", true, 1.f, false, 0.f);
+
 //-----------------------------------------------------------------------------
 // Purpose: returns whether or not the lump type could be loaded from cache
 // Input  : lumpType - 
@@ -132,6 +136,367 @@ bool IsLumpTypeForServer(int lumpType)
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: constructor
+//-----------------------------------------------------------------------------
+CMapLumpPrefetcher::CMapLumpPrefetcher()
+	: m_nNextJob(0)
+	, m_bCancel(false)
+	, m_nBytesRead(0)
+	, m_nBytesInFlight(0)
+	, m_nMaxBytesInFlight(0)
+	, m_hMapFile(FILESYSTEM_INVALID_HANDLE)
+	, m_bActive(false)
+	, m_bStarted(false)
+	, m_flStartTime(0.0)
+	, m_flReadEndTime(0.0)
+	, m_flWaitTime(0.0)
+	, m_nLumpsUsed(0)
+{
+	m_szMapPathName[0] = '\0';
+
+	for (int i = 0; i < HEADER_LUMPS; i++)
+	{
+		m_Lumps[i].state.store(MapLumpState_e::LUMP_STATE_NONE, std::memory_order_relaxed);
+		m_Lumps[i].pData = nullptr;
+		m_Lumps[i].bReserved = false;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: enables prefetching for the map that is about to be loaded, reads
+//          are started once the first lump is requested as the header has
+//          been loaded by then
+//-----------------------------------------------------------------------------
+void CMapLumpPrefetcher::BeginMap()
+{
+	Assert(!m_bActive);
+
+	m_bActive = mod_lumpPrefetch.GetBool();
+	m_bStarted = false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: queues all server lumps of the map, and starts the reader threads
+//-----------------------------------------------------------------------------
+void CMapLumpPrefetcher::Start()
+{
+	m_bStarted = true;
+
+	m_flStartTime = Plat_FloatTime();
+	m_flReadEndTime = m_flStartTime;
+	m_flWaitTime = 0.0;
+
+	m_nLumpsUsed = 0;
+	m_nBytesRead.store(0, std::memory_order_relaxed);
+
+	m_nBytesInFlight = 0;
+	m_nMaxBytesInFlight = int64_t(mod_lumpPrefetchMaxMiB.GetInt()) * 1024 * 1024;
+
+	// Copy the path, as it is temporarily replaced while loading the game lump.
+	V_strncpy(m_szMapPathName, s_szMapPathName, sizeof(m_szMapPathName));
+
+	m_Jobs.clear();
+	m_nNextJob.store(0, std::memory_order_relaxed);
+	m_bCancel.store(false, std::memory_order_relaxed);
+
+	const int nLastLump = Min(s_MapHeader->lastLump, HEADER_LUMPS-1);
+
+	for (int i = 0; i <= nLastLump; i++)
+	{
+		MapLumpPrefetch_s& entry = m_Lumps[i];
+		entry.state.store(MapLumpState_e::LUMP_STATE_NONE, std::memory_order_relaxed);
+
+		const lump_t* const lump = &s_MapHeader->lumps[i];
+
+		// The game lump is loaded through AddGameLump, which patches the map
+		// path and header to read it from its external file.
+		if (!IsLumpTypeForServer(i) || i == LUMP_GAME_LUMP || lump->filelen <= 0)
+			continue;
+
+		if (IsLumpTypeCachable(i))
+		{
+			char lumpPathBuf[MAX_PATH];
+			V_snprintf(lumpPathBuf, sizeof(lumpPathBuf), "%s.%.4X.bsp_lump", m_szMapPathName, i);
+
+			FileSystemCache fileCache;
+			fileCache.pBuffer = nullptr;
+
+			// Served from the filesystem cache, no need to read it.
+			if (FileSystem()->ReadFromCache(lumpPathBuf, &fileCache))
+				continue;
+		}
+
+		entry.pData = nullptr;
+		entry.nSize = lump->filelen;
+		entry.nOffset = lump->fileofs;
+		entry.bExternal = false;
+		entry.bFailed = false;
+		entry.bReserved = false;
+		entry.state.store(MapLumpState_e::LUMP_STATE_QUEUED, std::memory_order_relaxed);
+
+		m_Jobs.push_back(i);
+	}
+
+	const int nNumThreads = Min(mod_lumpPrefetchThreads.GetInt(), int(m_Jobs.size()));
+
+	for (int i = 0; i < nNumThreads; i++)
+		m_Workers.emplace_back(&CMapLumpPrefetcher::WorkerThread, this);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reads queued lumps until all have been read
+//-----------------------------------------------------------------------------
+void CMapLumpPrefetcher::WorkerThread()
+{
+	FileHandle_t hMapFile = FILESYSTEM_INVALID_HANDLE;
+
+	for (;;)
+	{
+		const int nJob = m_nNextJob.fetch_add(1, std::memory_order_relaxed);
+
+		if (nJob >= int(m_Jobs.size()) || m_bCancel.load(std::memory_order_relaxed))
+			break;
+
+		const int nLumpId = m_Jobs[nJob];
+		MapLumpPrefetch_s& entry = m_Lumps[nLumpId];
+
+		// Wait until the loader used enough of the lumps read ahead, the
+		// lump isn't claimed yet so the loader never waits on this.
+		if (!ReserveBytes(entry.nSize))
+			break;
+
+		int nState = MapLumpState_e::LUMP_STATE_QUEUED;
+
+		// Might have already been picked up by the loader.
+		if (entry.state.compare_exchange_strong(nState, MapLumpState_e::LUMP_STATE_READING))
+		{
+			entry.bReserved = true;
+			ReadLump(nLumpId, hMapFile);
+		}
+		else
+			ReleaseBytes(entry.nSize);
+	}
+
+	if (hMapFile != FILESYSTEM_INVALID_HANDLE)
+		FileSystem()->Close(hMapFile);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: waits until the lump fits within the max bytes in flight, a lump
+//          is always allowed if nothing is in flight so large lumps still
+//          get read
+// Input  : nSize - 
+// Output : false if prefetching got cancelled while waiting
+//-----------------------------------------------------------------------------
+bool CMapLumpPrefetcher::ReserveBytes(const int nSize)
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_BytesReleased.wait(lock, [this, nSize]()
+		{
+			return m_bCancel.load(std::memory_order_relaxed) || !m_nBytesInFlight
+				|| m_nBytesInFlight + nSize <= m_nMaxBytesInFlight;
+		});
+
+	if (m_bCancel.load(std::memory_order_relaxed))
+		return false;
+
+	m_nBytesInFlight += nSize;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: releases bytes reserved with ReserveBytes
+// Input  : nSize - 
+//-----------------------------------------------------------------------------
+void CMapLumpPrefetcher::ReleaseBytes(const int nSize)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_nBytesInFlight -= nSize;
+	}
+
+	m_BytesReleased.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reads a lump from its external file, or from the packed BSP file
+// Input  : nLumpId - 
+//			&hMapFile - handle to the BSP file owned by the calling thread,
+//			            opened on first use
+//-----------------------------------------------------------------------------
+void CMapLumpPrefetcher::ReadLump(const int nLumpId, FileHandle_t& hMapFile)
+{
+	MapLumpPrefetch_s& entry = m_Lumps[nLumpId];
+
+	char lumpPathBuf[MAX_PATH];
+	V_snprintf(lumpPathBuf, sizeof(lumpPathBuf), "%s.%.4X.bsp_lump", m_szMapPathName, nLumpId);
+
+	entry.pData = new byte[entry.nSize];
+	ssize_t nRead = 0;
+
+	FileHandle_t hLumpFile = FileSystem()->Open(lumpPathBuf, "rb");
+	if (hLumpFile != FILESYSTEM_INVALID_HANDLE)
+	{
+		nRead = FileSystem()->ReadEx(entry.pData, entry.nSize, entry.nSize, hLumpFile);
+		FileSystem()->Close(hLumpFile);
+
+		entry.bExternal = true;
+	}
+	else // Read from the packed BSP file, each thread has its own handle to seek.
+	{
+		if (hMapFile == FILESYSTEM_INVALID_HANDLE)
+			hMapFile = FileSystem()->Open(m_szMapPathName, "rb");
+
+		if (hMapFile != FILESYSTEM_INVALID_HANDLE)
+		{
+			FileSystem()->Seek(hMapFile, entry.nOffset, FILESYSTEM_SEEK_HEAD);
+			nRead = FileSystem()->ReadEx(entry.pData, entry.nSize, entry.nSize, hMapFile);
+		}
+	}
+
+	entry.bFailed = (nRead != entry.nSize);
+
+	if (!entry.bFailed)
+		m_nBytesRead.fetch_add(entry.nSize, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+
+		m_flReadEndTime = Plat_FloatTime();
+		entry.state.store(MapLumpState_e::LUMP_STATE_READY, std::memory_order_release);
+	}
+
+	m_LumpReady.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: takes ownership of a prefetched lump, waits for it if it is still
+//          being read, or reads it from here if no thread picked it up yet
+// Input  : nLumpId - 
+//			*lump - the lump as currently described by the header
+//			*&pData - lump data, allocated with new[]
+//			&bExternal - whether the lump was read from its external file
+// Output : true if the lump was prefetched, false if it has to be loaded
+//-----------------------------------------------------------------------------
+bool CMapLumpPrefetcher::Acquire(const int nLumpId, const lump_t* const lump, byte*& pData, bool& bExternal)
+{
+	if (!m_bActive || nLumpId == LUMP_GAME_LUMP)
+		return false;
+
+	if (!m_bStarted)
+		Start();
+	else if (V_strcmp(s_szMapPathName, m_szMapPathName) != 0)
+		return false; // The map path is patched, the lump is read from elsewhere.
+
+	MapLumpPrefetch_s& entry = m_Lumps[nLumpId];
+	int nState = MapLumpState_e::LUMP_STATE_QUEUED;
+
+	if (entry.state.compare_exchange_strong(nState, MapLumpState_e::LUMP_STATE_READING))
+	{
+		// No thread picked it up yet, read it from here rather than waiting.
+		ReadLump(nLumpId, m_hMapFile);
+	}
+	else if (nState == MapLumpState_e::LUMP_STATE_READING)
+	{
+		const double flWaitStart = Plat_FloatTime();
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		m_LumpReady.wait(lock, [&entry]()
+			{
+				return entry.state.load(std::memory_order_acquire) == MapLumpState_e::LUMP_STATE_READY;
+			});
+
+		m_flWaitTime += Plat_FloatTime() - flWaitStart;
+	}
+	else if (nState != MapLumpState_e::LUMP_STATE_READY)
+		return false; // Not prefetched, or already handed out.
+
+	entry.state.store(MapLumpState_e::LUMP_STATE_CLAIMED, std::memory_order_relaxed);
+
+	if (entry.bReserved)
+	{
+		entry.bReserved = false;
+		ReleaseBytes(entry.nSize);
+	}
+
+	// The header could have been patched since it was queued.
+	if (entry.bFailed || entry.nSize != lump->filelen || (!entry.bExternal && entry.nOffset != lump->fileofs))
+	{
+		delete[] entry.pData;
+		entry.pData = nullptr;
+
+		return false;
+	}
+
+	pData = entry.pData;
+	bExternal = entry.bExternal;
+
+	entry.pData = nullptr;
+	m_nLumpsUsed++;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: stops prefetching once the map has been loaded, frees the lumps
+//          that weren't used and logs the timings
+//-----------------------------------------------------------------------------
+void CMapLumpPrefetcher::EndMap()
+{
+	if (!m_bActive)
+		return;
+
+	m_bActive = false;
+
+	if (!m_bStarted)
+		return;
+
+	{
+		// Set under the lock, so workers waiting for bytes to be released
+		// can't miss it.
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_bCancel.store(true, std::memory_order_relaxed);
+	}
+
+	m_BytesReleased.notify_all();
+
+	for (std::thread& worker : m_Workers)
+		worker.join();
+
+	m_Workers.clear();
+
+	if (m_hMapFile != FILESYSTEM_INVALID_HANDLE)
+	{
+		FileSystem()->Close(m_hMapFile);
+		m_hMapFile = FILESYSTEM_INVALID_HANDLE;
+	}
+
+	int nLumpsUnused = 0;
+
+	for (const int nLumpId : m_Jobs)
+	{
+		MapLumpPrefetch_s& entry = m_Lumps[nLumpId];
+
+		if (entry.pData)
+		{
+			delete[] entry.pData;
+			entry.pData = nullptr;
+
+			nLumpsUnused++;
+		}
+
+		entry.bReserved = false;
+		entry.state.store(MapLumpState_e::LUMP_STATE_NONE, std::memory_order_relaxed);
+	}
+
+	DevMsg(eDLL_T::ENGINE, "%s: prefetched %d of %zu lumps (%.2f MiB) for '%s' in %.3f ms; waited %.3f ms, %d unused\n",
+		__FUNCTION__, m_nLumpsUsed, m_Jobs.size(), double(m_nBytesRead.load()) / (1024.0 * 1024.0), m_szMapPathName,
+		(m_flReadEndTime - m_flStartTime) * 1000.0, m_flWaitTime * 1000.0, nLumpsUnused);
+}
+
+static CMapLumpPrefetcher s_MapLumpPrefetcher;
+
 //-----------------------------------------------------------------------------
 // Purpose: 
 // Input  : *loader - 
@@ -172,7 +537,11 @@ void CModelLoader::LoadModel(CModelLoader* loader, model_t* model)
 //-----------------------------------------------------------------------------
 uint64_t CModelLoader::Map_LoadModelGuts(CModelLoader* loader, model_t* model)
 {
-	return CModelLoader__Map_LoadModelGuts(loader, model);
+	s_MapLumpPrefetcher.BeginMap();
+	const uint64_t result = CModelLoader__Map_LoadModelGuts(loader, model);
+	s_MapLumpPrefetcher.EndMap();
+
+	return result;
 }
 
 void CMapLoadHelper::Constructor(CMapLoadHelper* loader, int lumpToLoad)
@@ -240,6 +609,9 @@ void CMapLoadHelper::Constructor(CMapLoadHelper* loader, int lumpToLoad)
 		char lumpPathBuf[MAX_PATH];
 		V_snprintf(lumpPathBuf, sizeof(lumpPathBuf), "%s.%.4X.bsp_lump", s_szMapPathName, lumpToLoad);
 
+		byte* pPrefetchedData;
+		bool bPrefetchedExternal;
+
 		// Determine whether to load the lump from filesystem cache or disk.
 		if (IsLumpTypeCachable(lumpToLoad) &&
 			FileSystem()->ReadFromCache(lumpPathBuf, &fileCache))
@@ -249,6 +621,22 @@ void CMapLoadHelper::Constructor(CMapLoadHelper* loader, int lumpToLoad)
 			loader->m_bExternal = IsLumpTypeExternal(lumpToLoad);
 			loader->m_bUnk = fileCache.pBuffer->nUnk0 == 0;
 		}
+		else if (s_MapLumpPrefetcher.Acquire(lumpToLoad, lump, pPrefetchedData, bPrefetchedExternal))
+		{
+			loader->m_pData = pPrefetchedData;
+
+			if (bPrefetchedExternal)
+			{
+				DevMsg(eDLL_T::ENGINE, "Loading lump %.4x from file. Buffer: %p\n", lumpToLoad, loader->m_pData);
+
+				loader->m_pRawData = nullptr;
+				loader->m_bExternal = IsLumpTypeExternal(lumpToLoad);
+			}
+			else
+			{
+				loader->m_pRawData = pPrefetchedData;
+			}
+		}
 		else
 		{
 			loader->m_pRawData = new byte[lumpSize];
@@ -1,4 +1,6 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
 #include "engine/gl_model_private.h"
 #include "public/bspfile.h"
 
@@ -71,6 +73,82 @@ public:
 	char m_szLumpFilename[260];
 };
 
+#define MAP_LUMP_PREFETCH_MAX_THREADS 16
+
+//-----------------------------------------------------------------------------
+// Purpose: reads the server lumps of the map being loaded in parallel, so
+//          CMapLoadHelper only waits for the lump it needs rather than
+//          reading each one after another
+//-----------------------------------------------------------------------------
+class CMapLumpPrefetcher
+{
+public:
+	CMapLumpPrefetcher();
+
+	void BeginMap();
+	void EndMap();
+
+	bool Acquire(const int nLumpId, const lump_t* const lump, byte*& pData, bool& bExternal);
+
+private:
+	void Start();
+	void WorkerThread();
+	void ReadLump(const int nLumpId, FileHandle_t& hMapFile);
+
+	bool ReserveBytes(const int nSize);
+	void ReleaseBytes(const int nSize);
+
+	enum MapLumpState_e
+	{
+		LUMP_STATE_NONE = 0, // Not prefetched.
+		LUMP_STATE_QUEUED,
+		LUMP_STATE_READING,
+		LUMP_STATE_READY,
+		LUMP_STATE_CLAIMED
+	};
+
+	struct MapLumpPrefetch_s
+	{
+		std::atomic<int> state;
+		byte* pData;
+		int nSize;
+		int nOffset;
+		bool bExternal; // Read from its .bsp_lump file.
+		bool bFailed;
+		bool bReserved; // Counts towards the bytes in flight until claimed.
+	};
+
+	MapLumpPrefetch_s m_Lumps[HEADER_LUMPS];
+
+	vector<int> m_Jobs;
+	std::atomic<int> m_nNextJob;
+	std::atomic<bool> m_bCancel;
+	std::atomic<int64_t> m_nBytesRead;
+
+	vector<std::thread> m_Workers;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_LumpReady;
+	std::condition_variable m_BytesReleased;
+
+	// Bytes read or being read by the workers that haven't been claimed yet,
+	// guarded by m_Mutex.
+	int64_t m_nBytesInFlight;
+	int64_t m_nMaxBytesInFlight;
+
+	FileHandle_t m_hMapFile; // Used when the loader reads a lump itself.
+	char m_szMapPathName[MAX_PATH];
+
+	bool m_bActive;
+	bool m_bStarted;
+
+	double m_flStartTime;
+	double m_flReadEndTime;
+	double m_flWaitTime;
+
+	int m_nLumpsUsed;
+};
+
 inline void*(*CModelLoader__FindModel)(CModelLoader* loader, const char* pszModelName);
 inline void(*CModelLoader__LoadModel)(CModelLoader* loader, model_t* model);
 inline uint64_t(*CModelLoader__UnloadModel)(CModelLoader* loader, model_t* model);
@@ -4,10 +4,153 @@
 // 
 //===========================================================================//
 #include "engine/client/client.h"
+#include "engine/host_state.h"
+#include "engine/shared/datablock_codec.h"
 #include "common/proto_oob.h"
 #include "datablock_sender.h"
 
+static CDataBlockCapture s_dataBlockCapture;
+
+static void DataBlock_Capture_Changed_f(IConVar* pConVar, const char* pOldString, float flOldValue, ChangeUserData_t pUserData)
+{
+	const ConVar* const pConVarRef = g_pCVar->FindVar(pConVar->GetName());
+
+	if (!pConVarRef->GetBool())
+		s_dataBlockCapture.Close();
+}
+
 static ConVar net_compressDataBlockLzAcceleration("net_compressDataBlockLzAcceleration", "1", FCVAR_DEVELOPMENTONLY, "The acceleration value for LZ4 data block compression");
+static ConVar net_compressDataBlockZstdLevel("net_compressDataBlockZstdLevel", "1", FCVAR_DEVELOPMENTONLY, "The compression level for zstd data block compression", true, -7.f, true, 9.f);
+
+static ConVar net_compressDataBlockCodec("net_compressDataBlockCodec", "3", FCVAR_DEVELOPMENTONLY, "The preferred data block codec, falls back to the next best codec the client supports; 1 = LZ4, 2 = zstd, 3 = zstd with level dictionary",
+	true, float(DATABLOCK_CODEC_LZ4), true, float(DATABLOCK_CODEC_ZSTD_DICT));
+
+static ConVar net_dataBlockCapture("net_dataBlockCapture", "0", FCVAR_DEVELOPMENTONLY, "Captures uncompressed data blocks for training dictionaries and benchmarking codecs", DataBlock_Capture_Changed_f);
+
+//-----------------------------------------------------------------------------
+// Compression dictionary of the current level, shared between all senders
+//-----------------------------------------------------------------------------
+struct ServerDataBlockDict_s
+{
+	ServerDataBlockDict_s(const char* const level, const int compressionLevel)
+		: levelName(level), level(compressionLevel), id(0), cdict(nullptr) {}
+	~ServerDataBlockDict_s() { ZSTD_freeCDict(cdict); }
+
+	string levelName;
+	int level;
+
+	uint32_t id;
+	ZSTD_CDict* cdict; // nullptr if the level has no dictionary.
+};
+
+//-----------------------------------------------------------------------------
+// Compression context, one per thread as data blocks for different clients
+// can be written concurrently
+//-----------------------------------------------------------------------------
+class CDataBlockCompressContext
+{
+public:
+	CDataBlockCompressContext() : m_cctx(ZSTD_createCCtx()) {}
+	~CDataBlockCompressContext() { ZSTD_freeCCtx(m_cctx); }
+
+	inline ZSTD_CCtx* Get() const { return m_cctx; }
+
+private:
+	ZSTD_CCtx* m_cctx;
+};
+
+static thread_local CDataBlockCompressContext s_compressContext;
+
+//-----------------------------------------------------------------------------
+// Purpose: gets the compression dictionary for the current level, the result
+//          is cached so missing dictionaries are only looked up once per level
+// Input  : compressionLevel -
+//-----------------------------------------------------------------------------
+static std::shared_ptr<const ServerDataBlockDict_s> DataBlock_GetLevelDictionary(const int compressionLevel)
+{
+	static std::mutex s_dictMutex;
+	static std::shared_ptr<const ServerDataBlockDict_s> s_levelDict;
+
+	const char* const levelName = g_pHostState->m_levelName;
+	std::lock_guard<std::mutex> lock(s_dictMutex);
+
+	if (s_levelDict && s_levelDict->level == compressionLevel && s_levelDict->levelName == levelName)
+		return s_levelDict;
+
+	std::shared_ptr<ServerDataBlockDict_s> levelDict = std::make_shared<ServerDataBlockDict_s>(levelName, compressionLevel);
+	DataBlockDictionary_s dict;
+
+	if (DataBlock_LoadDictionary(Format("platform/" DATABLOCK_DICT_PATH "%s" DATABLOCK_DICT_EXT, levelName).c_str(), dict))
+	{
+		levelDict->cdict = ZSTD_createCDict(dict.data.data(), dict.data.size(), compressionLevel);
+
+		if (levelDict->cdict)
+			levelDict->id = dict.id;
+	}
+
+	s_levelDict = levelDict;
+	return s_levelDict;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: checks if the dictionary is in the client's comma separated list
+// Input  : *dictList -
+//          dictId -
+//-----------------------------------------------------------------------------
+static bool DataBlock_ClientHasDictionary(const char* dictList, const uint32_t dictId)
+{
+	while (*dictList)
+	{
+		char* end;
+		const uint32_t listedId = strtoul(dictList, &end, 16);
+
+		if (end == dictList)
+			break;
+
+		if (listedId == dictId)
+			return true;
+
+		dictList = (*end == ',') ? end + 1 : end;
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: selects the preferred codec, limited to what the client supports.
+//          Clients advertise their codecs and dictionaries through UserInfo
+//          ConVars, retail clients only support LZ4
+// Input  : *clientConVars - UserInfo ConVars of the client (nullptr if none)
+//          compressionLevel - zstd compression level
+//          &dict - set to the level dictionary if the dictionary codec is used
+//-----------------------------------------------------------------------------
+static DataBlockCodec_e DataBlock_SelectCodec(KeyValues* const clientConVars, const int compressionLevel,
+	std::shared_ptr<const ServerDataBlockDict_s>& dict)
+{
+	const int clientCodecs = clientConVars
+		? clientConVars->GetInt("cl_dataBlockCodecs", DATABLOCK_CODECS_RETAIL)
+		: DATABLOCK_CODECS_RETAIL;
+
+	int codec = net_compressDataBlockCodec.GetInt();
+
+	if (codec == DATABLOCK_CODEC_ZSTD_DICT)
+	{
+		if (clientCodecs & DATABLOCK_CODEC_BIT(DATABLOCK_CODEC_ZSTD_DICT))
+		{
+			dict = DataBlock_GetLevelDictionary(compressionLevel);
+
+			if (dict->cdict && DataBlock_ClientHasDictionary(clientConVars->GetString("cl_dataBlockDictionaries"), dict->id))
+				return DATABLOCK_CODEC_ZSTD_DICT;
+		}
+
+		codec = DATABLOCK_CODEC_ZSTD;
+	}
+
+	if (codec == DATABLOCK_CODEC_ZSTD && (clientCodecs & DATABLOCK_CODEC_BIT(DATABLOCK_CODEC_ZSTD)))
+		return DATABLOCK_CODEC_ZSTD;
+
+	return DATABLOCK_CODEC_LZ4;
+}
 
 //-----------------------------------------------------------------------------
 // Purpose: sends the data block
@@ -106,16 +249,29 @@ void ServerDataBlockSender::WriteDataBlock(const uint8_t* const sourceData, cons
 
 	int actualDataSize = dataSize;
 
+	if (net_dataBlockCapture.GetBool())
+		s_dataBlockCapture.Write(g_pHostState->m_levelName, sourceData, dataSize);
+
 	if (net_compressDataBlock->GetBool())
 	{
-		const int encodedSize = LZ4_compress_fast((const char*)sourceData, (char*)m_pScratchBuffer + sizeof(ServerDataBlockHeader_s),
-			dataSize, SNAPSHOT_SCRATCH_BUFFER_SIZE, net_compressDataBlockLzAcceleration.GetInt());
+		const int compressionLevel = net_compressDataBlockZstdLevel.GetInt();
+		std::shared_ptr<const ServerDataBlockDict_s> dict;
 
-		// this shouldn't happen at all
+		const DataBlockCodec_e codec = DataBlock_SelectCodec(m_pClient ? m_pClient->m_ConVars : nullptr, compressionLevel, dict);
+		const int level = codec == DATABLOCK_CODEC_LZ4 ? net_compressDataBlockLzAcceleration.GetInt() : compressionLevel;
+
+		const int encodedSize = DataBlock_Encode(codec, level, s_compressContext.Get(), dict ? dict->cdict : nullptr,
+			sourceData, dataSize, m_pScratchBuffer + sizeof(ServerDataBlockHeader_s),
+			SNAPSHOT_SCRATCH_BUFFER_SIZE - sizeof(ServerDataBlockHeader_s));
+
+		// this shouldn't happen at all, zstd can fail here if the encoded data
+		// doesn't fit, which means it's larger than the raw data anyways
 		if (!encodedSize)
 		{
-			Assert(0);
-			Error(eDLL_T::SERVER, 0, "LZ4 error compressing data block for client.\n");
+			Assert(codec != DATABLOCK_CODEC_LZ4);
+
+			if (codec == DATABLOCK_CODEC_LZ4)
+				Error(eDLL_T::SERVER, 0, "LZ4 error compressing data block for client.\n");
 		}
 
 		// make sure the encoded data is smaller than the raw data, in some cases
@@ -124,7 +280,7 @@ void ServerDataBlockSender::WriteDataBlock(const uint8_t* const sourceData, cons
 		{
 			actualDataSize = encodedSize;
 
-			pHeader->isCompressed = true;
+			pHeader->codec = codec;
 			copyRaw = false;
 		}
 	}
@@ -135,7 +291,7 @@ void ServerDataBlockSender::WriteDataBlock(const uint8_t* const sourceData, cons
 		// this should equal the dataSize at this point, even if compression failed
 		Assert(actualDataSize == dataSize);
 
-		pHeader->isCompressed = false;
+		pHeader->codec = DATABLOCK_CODEC_NONE;
 		memcpy(m_pScratchBuffer + sizeof(ServerDataBlockHeader_s), sourceData, actualDataSize);
 	}
 
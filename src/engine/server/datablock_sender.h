@@ -30,7 +30,7 @@ struct ServerDataBlock
 
 struct ServerDataBlockHeader_s
 {
-	bool isCompressed;
+	uint8_t codec; // DataBlockCodec_e, retail only sent 0 or 1 (isCompressed)
 };
 
 inline void* (*ServerDataBlockSender__SendDataBlock)(ServerDataBlockSender* thisptr,
@@ -192,8 +192,7 @@ CClient* CServer::ConnectClient(CServer* pServer, user_creds_s* pChallenge)
 			const string addressBufferCopy(pszAddresBuffer);
 			const string personaNameCopy(pszPersonaName);
 
-			std::thread th(SV_CheckForBanAndDisconnect, pClient, addressBufferCopy, nNucleusID, personaNameCopy, nPort);
-			th.detach();
+			SV_CheckForBanAndDisconnect(pClient, addressBufferCopy, nNucleusID, personaNameCopy, nPort);
 		}
 	}
 
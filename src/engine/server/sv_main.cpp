@@ -16,35 +16,31 @@
 #include "game/server/gameinterface.h"
 
 //-----------------------------------------------------------------------------
-// Purpose: checks if particular client is banned on the comp server
+// Purpose: queues a check if particular client is banned on the comp server,
+//          checks of clients connecting at the same time are coalesced
 //-----------------------------------------------------------------------------
 void SV_CheckForBanAndDisconnect(CClient* const pClient, const string& svIPAddr,
 	const NucleusID_t nNucleusID, const string& svPersonaName, const int nPort)
 {
 	Assert(pClient != nullptr);
 
-	string svError;
-	const bool bCompBanned = g_MasterServer.CheckForBan(svIPAddr, nNucleusID, svPersonaName, svError);
-
-	if (bCompBanned)
-	{
-		g_TaskQueue.Dispatch([pClient, svError, svIPAddr, nNucleusID, nPort]
+	g_PylonExecutor.QueueBanCheck(svIPAddr, nNucleusID, svPersonaName,
+		[pClient, svIPAddr, nNucleusID, nPort](const string& svError)
+		{
+			// Make sure client isn't already disconnected,
+			// and that if there is a valid netchannel, that
+			// it hasn't been taken by a different client by
+			// the time this task is getting executed.
+			const CNetChan* const pChan = pClient->GetNetChan();
+			if (pChan && pClient->GetNucleusID() == nNucleusID)
 			{
-				// Make sure client isn't already disconnected,
-				// and that if there is a valid netchannel, that
-				// it hasn't been taken by a different client by
-				// the time this task is getting executed.
-				const CNetChan* const pChan = pClient->GetNetChan();
-				if (pChan && pClient->GetNucleusID() == nNucleusID)
-				{
-					const int nUserID = pClient->GetUserID();
+				const int nUserID = pClient->GetUserID();
 
-					pClient->Disconnect(Reputation_t::REP_MARK_BAD, svError.c_str());
-					Warning(eDLL_T::SERVER, "Removed client '[%s]:%i' from slot #%i ('%llu' is banned globally!)\n",
-						svIPAddr.c_str(), nPort, nUserID, nNucleusID);
-				}
-			}, 0);
-	}
+				pClient->Disconnect(Reputation_t::REP_MARK_BAD, svError.c_str());
+				Warning(eDLL_T::SERVER, "Removed client '[%s]:%i' from slot #%i ('%llu' is banned globally!)\n",
+					svIPAddr.c_str(), nPort, nUserID, nNucleusID);
+			}
+		});
 }
 
 //-----------------------------------------------------------------------------
@@ -123,13 +119,14 @@ void SV_CheckClientsForBan(const CBanSystem::BannedList_t* const pBannedVec /*=
 
 	if (bannedVec && !bannedVec->IsEmpty())
 	{
-		std::thread bulkCheck([bannedVec]()
+		// The job owns the list, so it is also freed if the executor
+		// rejects the job after it has been shut down.
+		const std::shared_ptr<const CBanSystem::BannedList_t> bannedList(bannedVec);
+
+		g_PylonExecutor.Submit([bannedList]()
 			{
-				SV_ProcessBulkCheck(bannedVec);
-				delete bannedVec;
+				SV_ProcessBulkCheck(bannedList.get());
 			});
-
-		bulkCheck.detach();
 	}
 	else if (bannedVec)
 	{
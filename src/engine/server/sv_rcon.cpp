@@ -116,6 +116,11 @@ void CRConServer::Shutdown(void)
 
 	m_bInitialized = false;
 
+	{
+		std::lock_guard<std::mutex> lock(m_PendingMutex);
+		m_PendingFrames.clear();
+	}
+
 	const int nConnCount = m_Socket.GetAcceptedSocketCount();
 	m_Socket.CloseAllAcceptedSockets();
 
@@ -245,57 +250,94 @@ void CRConServer::RunFrame(void)
 		m_Socket.RunFrame();
 		Think();
 
+		DispatchPendingFrames();
+
 		const int nCount = m_Socket.GetAcceptedSocketCount();
 		for (m_nConnIndex = nCount - 1; m_nConnIndex >= 0; m_nConnIndex--)
 		{
+			// Processing a message can close other connections, skip the
+			// ones that no longer exist; the others are handled next frame.
+			if (m_nConnIndex >= m_Socket.GetAcceptedSocketCount())
+			{
+				continue;
+			}
+
 			CConnectedNetConsoleData& data = m_Socket.GetAcceptedSocketData(m_nConnIndex);
 
 			if (CheckForBan(data))
 			{
-				SendEncoded(data.m_hSocket, s_BannedMessage, "",
+				SendEncoded(data, s_BannedMessage, "",
 					netcon::response_e::SERVERDATA_RESPONSE_AUTH, int(eDLL_T::NETCON));
 
 				Disconnect("banned");
 				continue;
 			}
 
+			if (!FlushSendQueue(data))
+			{
+				Disconnect("send failed"); // Socket error or unresponsive.
+				continue;
+			}
+
 			Recv(data, sv_rcon_maxframesize.GetInt());
 		}
 	}
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: send message to all connected sockets
-// Input  : *pMsgBuf - 
-//			nMsgLen - 
+// Purpose: queue frames broadcasted from other threads on the sockets
+//-----------------------------------------------------------------------------
+void CRConServer::DispatchPendingFrames(void)
+{
+	vector<NetConFrame_t> pendingFrames;
+
+	{
+		std::lock_guard<std::mutex> lock(m_PendingMutex);
+		pendingFrames.swap(m_PendingFrames);
+	}
+
+	for (const NetConFrame_t& frame : pendingFrames)
+	{
+		SendToAll(frame);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: queue frame on all connected sockets, the frame is shared between
+//			the send queues
+// Input  : &frame - 
 // Output: true on success, false otherwise
 //-----------------------------------------------------------------------------
-bool CRConServer::SendToAll(const char* pMsgBuf, const int nMsgLen) const
+bool CRConServer::SendToAll(const NetConFrame_t& frame)
 {
-	ostringstream sendbuf;
-	const u_long nLen = htonl(u_long(nMsgLen));
+	if (!ThreadInMainThread())
+	{
+		// Sockets are only touched by the main thread, it will dispatch
+		// this frame on the next RunFrame().
+		std::lock_guard<std::mutex> lock(m_PendingMutex);
 
-	bool bSuccess = true;
+		if (m_PendingFrames.size() >= RCON_MAX_PENDING_FRAMES)
+		{
+			return false; // Main thread is stalled, drop it.
+		}
+
+		m_PendingFrames.push_back(frame);
+		return true;
+	}
 
-	sendbuf.write(reinterpret_cast<const char*>(&nLen), sizeof(u_long));
-	sendbuf.write(pMsgBuf, nMsgLen);
+	bool bSuccess = true;
 
 	const int nCount = m_Socket.GetAcceptedSocketCount();
 	for (int i = nCount - 1; i >= 0; i--)
 	{
-		const CConnectedNetConsoleData& data = m_Socket.GetAcceptedSocketData(i);
+		CConnectedNetConsoleData& data = m_Socket.GetAcceptedSocketData(i);
 
 		if (data.m_bAuthorized && !data.m_bInputOnly)
 		{
-			int ret = ::send(data.m_hSocket, sendbuf.str().data(),
-				int(sendbuf.str().size()), MSG_NOSIGNAL);
-
-			if (ret == SOCKET_ERROR)
+			// Failed connections are dropped in RunFrame().
+			if (!QueueFrame(data, frame))
 			{
-				if (!bSuccess)
-				{
-					bSuccess = false;
-				}
+				bSuccess = false;
 			}
 		}
 	}
@@ -313,26 +355,24 @@ bool CRConServer::SendToAll(const char* pMsgBuf, const int nMsgLen) const
 // Output: true on success, false otherwise
 //-----------------------------------------------------------------------------
 bool CRConServer::SendEncoded(const char* pResponseMsg, const char* pResponseVal,
-	const netcon::response_e responseType, const int nMessageId, const int nMessageType) const
+	const netcon::response_e responseType, const int nMessageId, const int nMessageType)
 {
-	vector<char> vecMsg;
-	if (!Serialize(vecMsg, pResponseMsg, pResponseVal,
-		responseType, nMessageId, nMessageType))
-	{
-		return false;
-	}
-	if (!SendToAll(vecMsg.data(), int(vecMsg.size())))
+	const NetConFrame_t frame = SerializeFrame(pResponseMsg, pResponseVal,
+		responseType, nMessageId, nMessageType);
+
+	if (!frame)
 	{
-		Error(eDLL_T::SERVER, NO_ERROR, "Failed to send RCON message: (%s)\n", "SOCKET_ERROR");
 		return false;
 	}
 
-	return true;
+	// Don't log failures here, this is called from the logger itself.
+	// Failed connections are reported when they get dropped.
+	return SendToAll(frame);
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: encode and send message to specific socket
-// Input  : hSocket - 
+// Purpose: encode and send message to specific connection
+// Input  : &data - 
 //			*pResponseMsg - 
 //			*pResponseVal - 
 //			responseType - 
@@ -340,16 +380,18 @@ bool CRConServer::SendEncoded(const char* pResponseMsg, const char* pResponseVal
 //			nMessageType - 
 // Output: true on success, false otherwise
 //-----------------------------------------------------------------------------
-bool CRConServer::SendEncoded(const SocketHandle_t hSocket, const char* pResponseMsg, const char* pResponseVal,
-	const netcon::response_e responseType, const int nMessageId, const int nMessageType) const
+bool CRConServer::SendEncoded(CConnectedNetConsoleData& data, const char* pResponseMsg, const char* pResponseVal,
+	const netcon::response_e responseType, const int nMessageId, const int nMessageType)
 {
-	vector<char> vecMsg;
-	if (!Serialize(vecMsg, pResponseMsg, pResponseVal,
-		responseType, nMessageId, nMessageType))
+	const NetConFrame_t frame = SerializeFrame(pResponseMsg, pResponseVal,
+		responseType, nMessageId, nMessageType);
+
+	if (!frame)
 	{
 		return false;
 	}
-	if (!Send(hSocket, vecMsg.data(), int(vecMsg.size())))
+	// Queued behind any pending logs, to keep the stream in order.
+	if (!QueueFrame(data, frame))
 	{
 		Error(eDLL_T::SERVER, NO_ERROR, "Failed to send RCON message: (%s)\n", "SOCKET_ERROR");
 		return false;
@@ -375,6 +417,33 @@ bool CRConServer::Serialize(vector<char>& vecBuf, const char* pResponseMsg, cons
 		rcon_encryptframes.GetBool(), rcon_debug.GetBool());
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: serializes input into a length-prefixed frame that can be queued
+//			on any number of connections
+// Input  : *pResponseMsg - 
+//			*pResponseVal - 
+//			responseType - 
+//			nMessageId - 
+//			nMessageType - 
+// Output : the frame, or nullptr on failure
+//-----------------------------------------------------------------------------
+NetConFrame_t CRConServer::SerializeFrame(const char* pResponseMsg, const char* pResponseVal,
+	const netcon::response_e responseType, const int nMessageId, const int nMessageType) const
+{
+	std::shared_ptr<vector<char>> frame = std::make_shared<vector<char>>();
+
+	if (!NetconServer_Serialize(this, *frame, pResponseMsg, pResponseVal, responseType, nMessageId, nMessageType,
+		rcon_encryptframes.GetBool(), rcon_debug.GetBool(), RCON_FRAME_PREFIX_SIZE))
+	{
+		return nullptr;
+	}
+
+	const u_long nLen = htonl(u_long(frame->size() - RCON_FRAME_PREFIX_SIZE));
+	memcpy(frame->data(), &nLen, sizeof(nLen));
+
+	return frame;
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: authenticate new connections
 // Input  : &request - 
@@ -391,16 +460,19 @@ void CRConServer::Authenticate(const netcon::request& request, CConnectedNetCons
 	if (Comparator(request.requestmsg()))
 	{
 		data.m_bAuthorized = true;
+
+		const char* pSendLogs = (!sv_rcon_sendlogs.GetBool() || data.m_bInputOnly) ? "0" : "1";
+
+		SendEncoded(data, s_AuthMessage, pSendLogs,
+			netcon::response_e::SERVERDATA_RESPONSE_AUTH, static_cast<int>(eDLL_T::NETCON));
+
+		// Closing the other connections moves the connection data, so this
+		// must happen after the last access to it.
 		if (++m_nAuthConnections >= sv_rcon_maxconnections.GetInt())
 		{
 			m_Socket.CloseListenSocket();
 			CloseNonAuthConnection();
 		}
-
-		const char* pSendLogs = (!sv_rcon_sendlogs.GetBool() || data.m_bInputOnly) ? "0" : "1";
-
-		SendEncoded(data.m_hSocket, s_AuthMessage, pSendLogs,
-			netcon::response_e::SERVERDATA_RESPONSE_AUTH, static_cast<int>(eDLL_T::NETCON));
 	}
 	else // Bad password.
 	{
@@ -410,7 +482,7 @@ void CRConServer::Authenticate(const netcon::request& request, CConnectedNetCons
 			Msg(eDLL_T::SERVER, "Bad RCON password attempt from '%s'\n", netAdr.ToString());
 		}
 
-		SendEncoded(data.m_hSocket, s_WrongPwMessage, "",
+		SendEncoded(data, s_WrongPwMessage, "",
 			netcon::response_e::SERVERDATA_RESPONSE_AUTH, static_cast<int>(eDLL_T::NETCON));
 
 		data.m_bAuthorized = false;
@@ -460,7 +532,7 @@ bool CRConServer::ProcessMessage(const char* pMsgBuf, const int nMsgLen)
 		request.requesttype() != netcon::request_e::SERVERDATA_REQUEST_AUTH)
 	{
 		// Notify netconsole that authentication is required.
-		SendEncoded(data.m_hSocket, s_NoAuthMessage, "",
+		SendEncoded(data, s_NoAuthMessage, "",
 			netcon::response_e::SERVERDATA_RESPONSE_AUTH, static_cast<int>(eDLL_T::NETCON));
 
 		data.m_bValidated = false;
@@ -767,6 +839,183 @@ static void RCON_UseLoopbackSocketChanged_f(IConVar* pConVar, const char* pOldSt
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: floods console logs to loopback netconsole clients and measures the
+//			broadcast throughput of the send queues
+//-----------------------------------------------------------------------------
+static void RCON_BenchmarkBroadcast_f(const CCommand& args)
+{
+	const int nNumClients = args.ArgC() > 1 ? Clamp(atoi(args.Arg(1)), 1, 64) : 4;
+	const int nNumMessages = args.ArgC() > 2 ? Clamp(atoi(args.Arg(2)), 1, 10000000) : 100000;
+
+	const SOCKET hListenSocket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+	if (hListenSocket == INVALID_SOCKET)
+	{
+		Warning(eDLL_T::SERVER, "RCON broadcast benchmark: socket error (%s)\n", NET_ErrorString(WSAGetLastError()));
+		return;
+	}
+
+	sockaddr_in listenAddr;
+	memset(&listenAddr, 0, sizeof(listenAddr));
+
+	listenAddr.sin_family = AF_INET;
+	listenAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	int nAddrLen = sizeof(listenAddr);
+
+	if (::bind(hListenSocket, reinterpret_cast<sockaddr*>(&listenAddr), sizeof(listenAddr)) == SOCKET_ERROR ||
+		::listen(hListenSocket, nNumClients) == SOCKET_ERROR ||
+		::getsockname(hListenSocket, reinterpret_cast<sockaddr*>(&listenAddr), &nAddrLen) == SOCKET_ERROR)
+	{
+		Warning(eDLL_T::SERVER, "RCON broadcast benchmark: listen error (%s)\n", NET_ErrorString(WSAGetLastError()));
+		::closesocket(hListenSocket);
+
+		return;
+	}
+
+	vector<CConnectedNetConsoleData> connections;
+	vector<SOCKET> clientSockets;
+
+	connections.reserve(nNumClients);
+	clientSockets.reserve(nNumClients);
+
+	for (int i = 0; i < nNumClients; i++)
+	{
+		const SOCKET hClientSocket = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+		if (hClientSocket == INVALID_SOCKET)
+		{
+			break;
+		}
+
+		clientSockets.push_back(hClientSocket);
+
+		if (::connect(hClientSocket, reinterpret_cast<sockaddr*>(&listenAddr), sizeof(listenAddr)) == SOCKET_ERROR)
+		{
+			break;
+		}
+
+		const SOCKET hServerSocket = ::accept(hListenSocket, nullptr, nullptr);
+
+		if (hServerSocket == INVALID_SOCKET)
+		{
+			break;
+		}
+
+		u_long nNonBlocking = 1;
+		::ioctlsocket(hServerSocket, FIONBIO, &nNonBlocking);
+
+		CConnectedNetConsoleData& data = connections.emplace_back(SocketHandle_t(hServerSocket));
+
+		data.m_bAuthorized = true;
+		data.m_bInputOnly = false;
+	}
+
+	::closesocket(hListenSocket);
+
+	if (int(connections.size()) != nNumClients)
+	{
+		Warning(eDLL_T::SERVER, "RCON broadcast benchmark: connect error (%s)\n", NET_ErrorString(WSAGetLastError()));
+	}
+
+	// The netconsole clients only drain their sockets.
+	vector<int64_t> receivedLens(clientSockets.size(), 0);
+	vector<std::thread> drainThreads;
+
+	for (size_t i = 0; i < connections.size(); i++)
+	{
+		drainThreads.emplace_back([&receivedLens, &clientSockets, i]()
+			{
+				char recvBuf[0x10000];
+				int nRecvLen;
+
+				while ((nRecvLen = ::recv(clientSockets[i], recvBuf, sizeof(recvBuf), 0)) > 0)
+				{
+					receivedLens[i] += nRecvLen;
+				}
+			});
+	}
+
+	CRConServer* const pServer = RCONServer();
+	const double flStartTime = Plat_FloatTime();
+
+	int nNumSent = 0;
+	bool bFailed = false;
+
+	for (; nNumSent < nNumMessages && !bFailed; nNumSent++)
+	{
+		char szLogLine[128];
+		snprintf(szLogLine, sizeof(szLogLine), "Benchmark console log line #%d, mirrored to every netconsole\n", nNumSent);
+
+		const NetConFrame_t frame = pServer->SerializeFrame(szLogLine, "0.0",
+			netcon::response_e::SERVERDATA_RESPONSE_CONSOLE_LOG, int(eDLL_T::SERVER), int(LogType_t::LOG_INFO));
+
+		if (!frame)
+		{
+			bFailed = true;
+			break;
+		}
+
+		for (CConnectedNetConsoleData& data : connections)
+		{
+			// Let the clients catch up rather than having them dropped.
+			while (data.m_nSendQueueLen > RCON_MAX_SEND_QUEUE_SIZE / 2 && !data.m_bSendFailed)
+			{
+				pServer->FlushSendQueue(data);
+				std::this_thread::yield();
+			}
+
+			bFailed |= !pServer->QueueFrame(data, frame);
+		}
+	}
+
+	// Flush the remainder and signal the end of the stream.
+	for (CConnectedNetConsoleData& data : connections)
+	{
+		while (!data.m_SendQueue.empty() && pServer->FlushSendQueue(data))
+		{
+			std::this_thread::yield();
+		}
+
+		bFailed |= data.m_bSendFailed;
+		::shutdown(SOCKET(data.m_hSocket), SD_SEND);
+	}
+
+	for (std::thread& thread : drainThreads)
+	{
+		thread.join();
+	}
+
+	const double flElapsed = MAX(Plat_FloatTime() - flStartTime, 1e-9);
+	int64_t nTotalReceived = 0;
+
+	for (const int64_t nReceivedLen : receivedLens)
+	{
+		nTotalReceived += nReceivedLen;
+	}
+
+	for (const CConnectedNetConsoleData& data : connections)
+	{
+		::closesocket(SOCKET(data.m_hSocket));
+	}
+	for (const SOCKET hClientSocket : clientSockets)
+	{
+		::closesocket(hClientSocket);
+	}
+
+	if (bFailed)
+	{
+		Warning(eDLL_T::SERVER, "RCON broadcast benchmark: send failed after %d messages\n", nNumSent);
+	}
+
+	Msg(eDLL_T::SERVER, "RCON broadcast benchmark: %d messages to %zu clients in %.3f seconds (%.0f messages/s, %.0f ns per message, %.1f MiB/s received)\n",
+		nNumSent, connections.size(), flElapsed, nNumSent / flElapsed, (flElapsed * 1e9) / MAX(nNumSent, 1),
+		(double(nTotalReceived) / (1024.0 * 1024.0)) / flElapsed);
+}
+
+static ConCommand rcon_broadcast_benchmark("rcon_broadcast_benchmark", RCON_BenchmarkBroadcast_f, "Floods console logs to loopback netconsole clients and measures the RCON broadcast throughput", FCVAR_DEVELOPMENTONLY, nullptr, "rcon_broadcast_benchmark <numClients> <numMessages>");
+
 ///////////////////////////////////////////////////////////////////////////////
 static CRConServer s_RCONServer;
 CRConServer* RCONServer() // Singleton RCON Server.
@@ -7,6 +7,7 @@
 #define RCON_MIN_PASSWORD_LEN 8
 #define RCON_MAX_BANNEDLIST_SIZE 512
 #define RCON_SHA512_HASH_SIZE 64
+#define RCON_MAX_PENDING_FRAMES 4096 // Max frames broadcasted from other threads between frames.
 
 class CRConServer : public CNetConBase
 {
@@ -28,16 +29,18 @@ public:
 	bool SendEncoded(const char* pResponseMsg, const char* pResponseVal,
 		const netcon::response_e responseType,
 		const int nMessageId = static_cast<int>(eDLL_T::NETCON),
-		const int nMessageType = static_cast<int>(LogType_t::LOG_NET)) const;
+		const int nMessageType = static_cast<int>(LogType_t::LOG_NET));
 
-	bool SendEncoded(const SocketHandle_t hSocket, const char* pResponseMsg,
+	bool SendEncoded(CConnectedNetConsoleData& data, const char* pResponseMsg,
 		const char* pResponseVal, const netcon::response_e responseType,
 		const int nMessageId = static_cast<int>(eDLL_T::NETCON),
-		const int nMessageType = static_cast<int>(LogType_t::LOG_NET)) const;
+		const int nMessageType = static_cast<int>(LogType_t::LOG_NET));
 
-	bool SendToAll(const char* pMsgBuf, const int nMsgLen) const;
+	bool SendToAll(const NetConFrame_t& frame);
 	bool Serialize(vector<char>& vecBuf, const char* pResponseMsg, const char* pResponseVal, const netcon::response_e responseType,
 		const int nMessageId = static_cast<int>(eDLL_T::NETCON), const int nMessageType = static_cast<int>(LogType_t::LOG_NET)) const;
+	NetConFrame_t SerializeFrame(const char* pResponseMsg, const char* pResponseVal, const netcon::response_e responseType,
+		const int nMessageId = static_cast<int>(eDLL_T::NETCON), const int nMessageType = static_cast<int>(LogType_t::LOG_NET)) const;
 
 	void Authenticate(const netcon::request& request, CConnectedNetConsoleData& data);
 	bool Comparator(const string& svPassword) const;
@@ -58,12 +61,19 @@ public:
 	void CloseAllSockets() { m_Socket.CloseAllAcceptedSockets(); }
 
 private:
+	void DispatchPendingFrames(void);
+
 	int                      m_nConnIndex;
 	int                      m_nAuthConnections;
 	bool                     m_bInitialized;
 	std::unordered_set<std::string> m_BannedList;
 	uint8_t                  m_PasswordHash[RCON_SHA512_HASH_SIZE];
 	netadr_t                 m_WhiteListAddress;
+
+	// Frames broadcasted from other threads, these are queued on the
+	// sockets by the main thread as it owns them.
+	std::mutex               m_PendingMutex;
+	vector<NetConFrame_t>    m_PendingFrames;
 };
 
 CRConServer* RCONServer();
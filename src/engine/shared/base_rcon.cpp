@@ -137,79 +137,158 @@ bool CNetConBase::Connect(const char* pHostName, const int nPort)
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: parses input response buffer using length-prefix framing
+// Purpose: returns the free space at the end of the receive buffer, the
+//			space is large enough to hold the remainder of a pending frame
+// Input  : &data - 
+//			nMinLen - 
+//			&nFreeLen - 
+// Output : pointer to the free space
+//-----------------------------------------------------------------------------
+char* CNetConBase::ReserveRecvSpace(CConnectedNetConsoleData& data,
+	const int nMinLen, int& nFreeLen) const
+{
+	vector<uint8_t>& recvBuf = data.m_RecvBuffer;
+	const int nPendingLen = data.m_nRecvTail - data.m_nRecvHead;
+
+	int nNeededLen = nMinLen;
+
+	// The prefix of a pending frame has already been validated by
+	// ProcessFrames(), make sure the whole frame fits in the buffer.
+	if (nPendingLen >= RCON_FRAME_PREFIX_SIZE)
+	{
+		u_long nPrefix;
+		memcpy(&nPrefix, &recvBuf[data.m_nRecvHead], sizeof(nPrefix));
+
+		const int nFrameLen = RCON_FRAME_PREFIX_SIZE + int(ntohl(nPrefix));
+		nNeededLen = MAX(nNeededLen, nFrameLen - nPendingLen);
+	}
+
+	if (int(recvBuf.size()) - data.m_nRecvTail < nNeededLen)
+	{
+		// Only the bytes of a single incomplete frame are ever moved.
+		if (data.m_nRecvHead > 0)
+		{
+			memmove(recvBuf.data(), &recvBuf[data.m_nRecvHead], nPendingLen);
+
+			data.m_nRecvHead = 0;
+			data.m_nRecvTail = nPendingLen;
+		}
+
+		if (int(recvBuf.size()) - data.m_nRecvTail < nNeededLen)
+		{
+			recvBuf.resize(data.m_nRecvTail + nNeededLen);
+		}
+	}
+
+	nFreeLen = int(recvBuf.size()) - data.m_nRecvTail;
+	return reinterpret_cast<char*>(&recvBuf[data.m_nRecvTail]);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: appends received data to the receive buffer and processes all
+//			completed frames
 // Input  : &data - 
 //			*pRecvBuf - 
 //			nRecvLen - 
 //			nMaxLen - 
 // Output: true on success, false otherwise
 //-----------------------------------------------------------------------------
-bool CNetConBase::ProcessBuffer(CConnectedNetConsoleData& data, 
+bool CNetConBase::ProcessBuffer(CConnectedNetConsoleData& data,
 	const char* pRecvBuf, int nRecvLen, const int nMaxLen)
 {
-	bool bSuccess = true;
-
 	while (nRecvLen > 0)
 	{
-		if (data.m_nPayloadLen)
+		int nFreeLen;
+		char* const pFreeBuf = ReserveRecvSpace(data, MIN(nRecvLen, RCON_RECV_CHUNK_SIZE), nFreeLen);
+
+		const int nCopyLen = MIN(nRecvLen, nFreeLen);
+		memcpy(pFreeBuf, pRecvBuf, nCopyLen);
+
+		data.m_nRecvTail += nCopyLen;
+
+		pRecvBuf += nCopyLen;
+		nRecvLen -= nCopyLen;
+
+		if (!ProcessFrames(data, nMaxLen))
 		{
-			if (data.m_nPayloadRead < data.m_nPayloadLen)
-			{
-				data.m_RecvBuffer[data.m_nPayloadRead++] = *pRecvBuf;
+			return false;
+		}
+	}
 
-				pRecvBuf++;
-				nRecvLen--;
-			}
-			if (data.m_nPayloadRead == data.m_nPayloadLen)
-			{
-				if (!ProcessMessage(
-					reinterpret_cast<const char*>(data.m_RecvBuffer.data()), data.m_nPayloadLen)
-					&& bSuccess)
-				{
-					bSuccess = false;
-				}
+	return true;
+}
 
-				data.m_nPayloadLen = 0;
-				data.m_nPayloadRead = 0;
+//-----------------------------------------------------------------------------
+// Purpose: processes all completed frames in the receive buffer using
+//			length-prefix framing, the frames are passed to ProcessMessage
+//			directly from the receive buffer
+// Input  : &data - 
+//			nMaxLen - 
+// Output: true on success, false if the connection got closed or moved
+//-----------------------------------------------------------------------------
+bool CNetConBase::ProcessFrames(CConnectedNetConsoleData& data, const int nMaxLen)
+{
+	const char* const pBuf = reinterpret_cast<const char*>(data.m_RecvBuffer.data());
+	const int nConnCount = m_Socket.GetAcceptedSocketCount();
+
+	while (data.m_nRecvTail - data.m_nRecvHead >= RCON_FRAME_PREFIX_SIZE)
+	{
+		u_long nPrefix;
+		memcpy(&nPrefix, &pBuf[data.m_nRecvHead], sizeof(nPrefix));
+
+		const int nPayloadLen = int(ntohl(nPrefix));
+
+		if (!data.m_bAuthorized && nMaxLen > -1)
+		{
+			if (nPayloadLen > nMaxLen)
+			{
+				Disconnect("overflow"); // Sending large messages while not authenticated.
+				return false;
 			}
 		}
-		else if (data.m_nPayloadRead < sizeof(int)) // Read size field.
+
+		if (nPayloadLen < 0 || nPayloadLen > RCON_MAX_FRAME_SIZE)
 		{
-			data.m_RecvBuffer[data.m_nPayloadRead++] = *pRecvBuf;
+			Error(eDLL_T::ENGINE, NO_ERROR, "RCON Cmd: sync error (%d)\n", nPayloadLen);
+			Disconnect("desync"); // Out of sync (irrecoverable).
 
-			pRecvBuf++;
-			nRecvLen--;
+			return false;
 		}
-		else // Build prefix.
+
+		const int nFrameLen = RCON_FRAME_PREFIX_SIZE + nPayloadLen;
+
+		if (data.m_nRecvTail - data.m_nRecvHead < nFrameLen)
 		{
-			data.m_nPayloadLen = int(ntohl(*reinterpret_cast<u_long*>(&data.m_RecvBuffer[0])));
-			data.m_nPayloadRead = 0;
+			break; // Remainder of the frame hasn't been received yet.
+		}
 
-			if (!data.m_bAuthorized && nMaxLen > -1)
-			{
-				if (data.m_nPayloadLen > nMaxLen)
-				{
-					Disconnect("overflow"); // Sending large messages while not authenticated.
-					return false;
-				}
-			}
+		const char* const pPayload = &pBuf[data.m_nRecvHead + RCON_FRAME_PREFIX_SIZE];
+		data.m_nRecvHead += nFrameLen;
 
-			if (data.m_nPayloadLen < 0 ||
-				data.m_nPayloadLen > data.m_RecvBuffer.max_size())
-			{
-				Error(eDLL_T::ENGINE, NO_ERROR, "RCON Cmd: sync error (%d)\n", data.m_nPayloadLen);
-				Disconnect("desync"); // Out of sync (irrecoverable).
+		// The message handler disconnects on failure, which destroys the
+		// connection data; it must not be accessed anymore at this point.
+		if (!ProcessMessage(pPayload, nPayloadLen))
+		{
+			return false;
+		}
 
-				return false;
-			}
-			else
-			{
-				data.m_RecvBuffer.resize(data.m_nPayloadLen);
-			}
+		// The message handler can also close other connections, e.g. all the
+		// non-authenticated ones once the max has been reached, which moves
+		// or destroys the connection data. Stop here, the remaining frames
+		// are processed on the next call to Recv.
+		if (m_Socket.GetAcceptedSocketCount() != nConnCount)
+		{
+			return false;
 		}
 	}
 
-	return bSuccess;
+	if (data.m_nRecvHead == data.m_nRecvTail)
+	{
+		data.m_nRecvHead = 0;
+		data.m_nRecvTail = 0;
+	}
+
+	return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -281,72 +360,171 @@ bool CNetConBase::Decode(google::protobuf::MessageLite* pMsg,
 bool CNetConBase::Send(const SocketHandle_t hSocket, const char* pMsgBuf,
 	const int nMsgLen) const
 {
-	std::ostringstream sendbuf;
-	const u_long nLen = htonl(u_long(nMsgLen));
+	u_long nLen = htonl(u_long(nMsgLen));
+
+	// Gather the prefix and message, no need to copy them together.
+	WSABUF buffers[2];
 
-	sendbuf.write(reinterpret_cast<const char*>(&nLen), sizeof(u_long));
-	sendbuf.write(pMsgBuf, nMsgLen);
+	buffers[0].buf = reinterpret_cast<char*>(&nLen);
+	buffers[0].len = sizeof(u_long);
+	buffers[1].buf = const_cast<char*>(pMsgBuf);
+	buffers[1].len = ULONG(nMsgLen);
 
-	int ret = ::send(hSocket, sendbuf.str().data(), int(sendbuf.str().size()),
-		MSG_NOSIGNAL);
+	DWORD nSentLen = 0;
+	const int ret = ::WSASend(hSocket, buffers, ARRAYSIZE(buffers), &nSentLen, 0, nullptr, nullptr);
 
 	return (ret != SOCKET_ERROR);
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: receive message
+// Purpose: queue a length-prefixed frame on the connection and try to send it
 // Input  : &data - 
-//			nMaxLen - 
-// Output: true on success, false otherwise
+//			&frame - 
+// Output: true on success, false if the connection should be dropped
 //-----------------------------------------------------------------------------
-void CNetConBase::Recv(CConnectedNetConsoleData& data, const int nMaxLen)
+bool CNetConBase::QueueFrame(CConnectedNetConsoleData& data, const NetConFrame_t& frame) const
 {
-	static char szRecvBuf[1024];
+	if (data.m_bSendFailed)
+	{
+		return false;
+	}
+
+	if (data.m_nSendQueueLen + frame->size() > RCON_MAX_SEND_QUEUE_SIZE)
+	{
+		// Remote doesn't read fast enough, dropping frames would corrupt
+		// the stream so the connection gets dropped instead.
+		data.m_bSendFailed = true;
+		return false;
+	}
 
-	{//////////////////////////////////////////////
-		const int nPendingLen = ::recv(data.m_hSocket, szRecvBuf, sizeof(char), MSG_PEEK);
-		if (nPendingLen == SOCKET_ERROR && m_Socket.IsSocketBlocking())
+	data.m_SendQueue.push_back(frame);
+	data.m_nSendQueueLen += frame->size();
+
+	return FlushSendQueue(data);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: send as much of the queue as the socket accepts, multiple frames
+//			are gathered into a single send call
+// Input  : &data - 
+// Output: true on success, false if the connection should be dropped
+//-----------------------------------------------------------------------------
+bool CNetConBase::FlushSendQueue(CConnectedNetConsoleData& data) const
+{
+	while (!data.m_SendQueue.empty())
+	{
+		WSABUF buffers[RCON_MAX_SEND_GATHER];
+		DWORD nBufferCount = 0;
+		size_t nRequestLen = 0;
+
+		for (const NetConFrame_t& frame : data.m_SendQueue)
 		{
-			return;
+			// Only the front frame can be partially sent.
+			const int nOffset = nBufferCount ? 0 : data.m_nSendOffset;
+			WSABUF& buffer = buffers[nBufferCount];
+
+			buffer.buf = const_cast<char*>(frame->data()) + nOffset;
+			buffer.len = ULONG(frame->size() - nOffset);
+
+			nRequestLen += buffer.len;
+
+			if (++nBufferCount == RCON_MAX_SEND_GATHER)
+			{
+				break;
+			}
 		}
-		else if (nPendingLen == 0) // Socket was closed.
+
+		DWORD nSentLen = 0;
+
+		if (::WSASend(data.m_hSocket, buffers, nBufferCount, &nSentLen, 0, nullptr, nullptr) == SOCKET_ERROR)
 		{
-			Disconnect("remote closed socket");
-			return;
+			if (m_Socket.IsSocketBlocking())
+			{
+				return true; // Socket buffer is full, try again next frame.
+			}
+
+			data.m_bSendFailed = true;
+			return false;
+		}
+
+		data.m_nSendQueueLen -= nSentLen;
+
+		// Pop all frames that have been sent entirely.
+		for (size_t nRemainingLen = nSentLen; nRemainingLen > 0;)
+		{
+			const size_t nFrontLen = data.m_SendQueue.front()->size() - data.m_nSendOffset;
+
+			if (nRemainingLen < nFrontLen)
+			{
+				data.m_nSendOffset += int(nRemainingLen);
+				break;
+			}
+
+			nRemainingLen -= nFrontLen;
+
+			data.m_SendQueue.pop_front();
+			data.m_nSendOffset = 0;
 		}
-		else if (nPendingLen < 0)
+
+		if (nSentLen < nRequestLen)
 		{
-			Disconnect("socket closed unexpectedly");
-			return;
+			return true; // Partial write, socket buffer is full.
 		}
-	}//////////////////////////////////////////////
+	}
 
-	int nReadLen = 0; // Find out how much we have to read.
-	int iResult = ::ioctlsocket(data.m_hSocket, FIONREAD, reinterpret_cast<u_long*>(&nReadLen));
+	return true;
+}
 
-	if (iResult == SOCKET_ERROR)
+//-----------------------------------------------------------------------------
+// Purpose: receive message
+// Input  : &data - 
+//			nMaxLen - 
+//-----------------------------------------------------------------------------
+void CNetConBase::Recv(CConnectedNetConsoleData& data, const int nMaxLen)
+{
+	// Process the frames left over from an interrupted call first, these
+	// could otherwise stall until the remote sends more data.
+	if (!ProcessFrames(data, nMaxLen))
 	{
-		Error(eDLL_T::ENGINE, NO_ERROR, "RCON Cmd: ioctl(%s) error (%s)\n", "FIONREAD", NET_ErrorString(WSAGetLastError()));
 		return;
 	}
 
-	while (nReadLen > 0)
+	for (;;)
 	{
-		const int nRecvLen = ::recv(data.m_hSocket, szRecvBuf, MIN(sizeof(szRecvBuf), nReadLen), MSG_NOSIGNAL);
+		// Receive straight into the connection's buffer, frames are then
+		// processed in place without any further copies.
+		int nFreeLen;
+		char* const pRecvBuf = ReserveRecvSpace(data, RCON_RECV_CHUNK_SIZE, nFreeLen);
+
+		const int nRecvLen = ::recv(data.m_hSocket, pRecvBuf, nFreeLen, MSG_NOSIGNAL);
+
 		if (nRecvLen == 0) // Socket was closed.
 		{
-			Disconnect("socket closed");
-			break;
+			Disconnect("remote closed socket");
+			return;
+		}
+		else if (nRecvLen < 0)
+		{
+			if (!m_Socket.IsSocketBlocking())
+			{
+				Disconnect("socket closed unexpectedly");
+			}
+
+			return; // Nothing left to read.
 		}
-		if (nRecvLen < 0 && !m_Socket.IsSocketBlocking())
+
+		data.m_nRecvTail += nRecvLen;
+
+		if (!ProcessFrames(data, nMaxLen))
 		{
-			Error(eDLL_T::ENGINE, NO_ERROR, "RCON Cmd: recv error (%s)\n", NET_ErrorString(WSAGetLastError()));
-			break;
+			return; // Connection has been closed.
 		}
 
-		nReadLen -= nRecvLen; // Process what we've got.
-		ProcessBuffer(data, szRecvBuf, nRecvLen, nMaxLen);
+		// Only read again if the buffer got filled up entirely, as there
+		// could be more data pending on the socket.
+		if (nRecvLen < nFreeLen)
+		{
+			return;
+		}
 	}
-
-	return;
 }
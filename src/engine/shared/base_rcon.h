@@ -9,6 +9,21 @@
 // Max size of the payload in the envelope frame
 #define RCON_MAX_PAYLOAD_SIZE 1024*1024
 
+// Max size of the envelope frame, the payload plus the envelope fields
+#define RCON_MAX_FRAME_SIZE (RCON_MAX_PAYLOAD_SIZE + 64)
+
+// Size of the length prefix in front of each envelope frame
+#define RCON_FRAME_PREFIX_SIZE int(sizeof(u_long))
+
+// Min free space in the receive buffer for each recv call
+#define RCON_RECV_CHUNK_SIZE 0x4000
+
+// Max num bytes queued on a connection before it is considered unresponsive
+#define RCON_MAX_SEND_QUEUE_SIZE (RCON_MAX_FRAME_SIZE * 4)
+
+// Max num queued frames gathered into a single send call
+#define RCON_MAX_SEND_GATHER 64
+
 class CNetConBase
 {
 public:
@@ -24,6 +39,7 @@ public:
 	virtual void Disconnect(const char* szReason = nullptr) { NOTE_UNUSED(szReason); };
 
 	virtual bool ProcessBuffer(CConnectedNetConsoleData& data, const char* pRecvBuf, int nRecvLen, const int nMaxLen = SOCKET_ERROR);
+	virtual bool ProcessFrames(CConnectedNetConsoleData& data, const int nMaxLen = SOCKET_ERROR);
 	virtual bool ProcessMessage(const char* /*pMsgBuf*/, int /*nMsgLen*/) { return true; };
 
 	virtual bool Encrypt(CryptoContext_s& ctx, const char* pInBuf, char* pOutBuf, const size_t nDataLen) const;
@@ -33,12 +49,16 @@ public:
 	virtual bool Decode(google::protobuf::MessageLite* pMsg, const char* pMsgBuf, const size_t nMsgLen) const;
 
 	virtual bool Send(const SocketHandle_t hSocket, const char* pMsgBuf, const int nMsgLen) const;
+	bool QueueFrame(CConnectedNetConsoleData& data, const NetConFrame_t& frame) const;
+	bool FlushSendQueue(CConnectedNetConsoleData& data) const;
 	virtual void Recv(CConnectedNetConsoleData& data, const int nMaxLen = SOCKET_ERROR);
 
 	CSocketCreator* GetSocketCreator(void) { return &m_Socket; }
 	netadr_t* GetNetAddress(void) { return &m_Address; }
 
 protected:
+	char* ReserveRecvSpace(CConnectedNetConsoleData& data, const int nMinLen, int& nFreeLen) const;
+
 	CSocketCreator m_Socket;
 	netadr_t m_Address;
 	CryptoKey_t m_NetKey;
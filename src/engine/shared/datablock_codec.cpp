@@ -0,0 +1,449 @@
+//===========================================================================//
+//
+// Purpose: data block compression codecs
+//
+//===========================================================================//
+#include "thirdparty/zstd/zdict.h"
+#include "common/protocol.h"
+#include "datablock_codec.h"
+
+//-----------------------------------------------------------------------------
+// Purpose: gets the name of the codec
+//-----------------------------------------------------------------------------
+const char* DataBlock_GetCodecName(const int codec)
+{
+	switch (codec)
+	{
+	case DATABLOCK_CODEC_NONE: return "none";
+	case DATABLOCK_CODEC_LZ4: return "lz4";
+	case DATABLOCK_CODEC_ZSTD: return "zstd";
+	case DATABLOCK_CODEC_ZSTD_DICT: return "zstd_dict";
+	}
+
+	return "unknown";
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: loads a zstd dictionary
+// Input  : *filePath -
+//          &dict -
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool DataBlock_LoadDictionary(const char* const filePath, DataBlockDictionary_s& dict)
+{
+	CIOStream stream;
+
+	// not having a dictionary for a level is fine
+	if (!stream.Open(filePath, CIOStream::READ | CIOStream::BINARY))
+		return false;
+
+	const size_t fileSize = size_t(stream.GetSize());
+
+	if (!fileSize || fileSize > DATABLOCK_DICT_MAX_SIZE)
+	{
+		Warning(eDLL_T::ENGINE, "%s: dictionary '%s' has an invalid size (%zu)\n", __FUNCTION__, filePath, fileSize);
+		return false;
+	}
+
+	dict.data.resize(fileSize);
+	stream.Read(dict.data.data(), fileSize);
+
+	dict.id = ZDICT_getDictID(dict.data.data(), fileSize);
+
+	// raw content dictionaries have no id, which we need to match them
+	// between the sender and receiver
+	if (!dict.id)
+	{
+		Warning(eDLL_T::ENGINE, "%s: '%s' is not a zstd dictionary\n", __FUNCTION__, filePath);
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reads all data blocks from a capture file
+// Input  : *filePath -
+//          &blocks -
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool DataBlock_ReadCapture(const char* const filePath, vector<vector<uint8_t>>& blocks)
+{
+	CIOStream stream;
+
+	if (!stream.Open(filePath, CIOStream::READ | CIOStream::BINARY))
+	{
+		Error(eDLL_T::ENGINE, NO_ERROR, "%s: failed to open capture '%s'\n", __FUNCTION__, filePath);
+		return false;
+	}
+
+	const size_t fileSize = size_t(stream.GetSize());
+	size_t offset = sizeof(int);
+
+	if (fileSize < offset || stream.Read<int>() != DATABLOCK_CAPTURE_MAGIC)
+	{
+		Error(eDLL_T::ENGINE, NO_ERROR, "%s: '%s' is not a data block capture\n", __FUNCTION__, filePath);
+		return false;
+	}
+
+	while (offset + sizeof(int) <= fileSize)
+	{
+		const int blockSize = stream.Read<int>();
+		offset += sizeof(int);
+
+		// a truncated block means the capture wasn't closed properly,
+		// everything before it is still usable
+		if (blockSize <= 0 || blockSize > SNAPSHOT_SCRATCH_BUFFER_SIZE || offset + blockSize > fileSize)
+			break;
+
+		vector<uint8_t>& block = blocks.emplace_back(blockSize);
+		stream.Read(block.data(), blockSize);
+
+		offset += blockSize;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: starts a new capture file for given level
+// Input  : *levelName -
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CDataBlockCapture::Open(const char* const levelName)
+{
+	const string filePath = Format("platform/" DATABLOCK_CAPTURE_PATH "%s_%lld" DATABLOCK_CAPTURE_EXT,
+		levelName, static_cast<long long>(time(nullptr)));
+
+	CreateDirectories(filePath);
+
+	if (!m_stream.Open(filePath.c_str(), CIOStream::WRITE | CIOStream::BINARY))
+	{
+		Error(eDLL_T::ENGINE, NO_ERROR, "%s: failed to create capture '%s'\n", __FUNCTION__, filePath.c_str());
+		return false;
+	}
+
+	m_stream.Write<int>(DATABLOCK_CAPTURE_MAGIC);
+
+	m_levelName = levelName;
+	m_isOpen = true;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: closes the capture file
+//-----------------------------------------------------------------------------
+void CDataBlockCapture::Close()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_isOpen)
+	{
+		m_stream.Close();
+		m_isOpen = false;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: appends an uncompressed data block to the capture of the level
+// Input  : *levelName -
+//          *data -
+//          dataSize -
+//-----------------------------------------------------------------------------
+void CDataBlockCapture::Write(const char* const levelName, const uint8_t* const data, const int dataSize)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (m_isOpen && m_levelName != levelName)
+	{
+		m_stream.Close();
+		m_isOpen = false;
+	}
+
+	if (!m_isOpen && !Open(levelName))
+		return;
+
+	m_stream.Write(dataSize);
+	m_stream.Write(data, dataSize);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: encodes a data block
+// Input  : codec -
+//          level - acceleration for LZ4, compression level for zstd
+//          *cctx - required for zstd codecs
+//          *cdict - required for the zstd dictionary codec
+//          *source -
+//          sourceSize -
+//          *dest -
+//          destCapacity -
+// Output : encoded size, 0 on failure
+//-----------------------------------------------------------------------------
+int DataBlock_Encode(const DataBlockCodec_e codec, const int level, ZSTD_CCtx* const cctx, const ZSTD_CDict* const cdict,
+	const void* const source, const int sourceSize, void* const dest, const int destCapacity)
+{
+	size_t encodedSize;
+
+	switch (codec)
+	{
+	case DATABLOCK_CODEC_LZ4:
+		return LZ4_compress_fast((const char*)source, (char*)dest, sourceSize, destCapacity, level);
+	case DATABLOCK_CODEC_ZSTD:
+		encodedSize = ZSTD_compressCCtx(cctx, dest, destCapacity, source, sourceSize, level);
+		break;
+	case DATABLOCK_CODEC_ZSTD_DICT:
+		Assert(cdict);
+		encodedSize = ZSTD_compress_usingCDict(cctx, dest, destCapacity, source, sourceSize, cdict);
+		break;
+	default:
+		Assert(0);
+		return 0;
+	}
+
+	return ZSTD_isError(encodedSize) ? 0 : int(encodedSize);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: decodes a data block
+// Input  : codec -
+//          *dctx - required for zstd codecs
+//          *ddict - required for the zstd dictionary codec
+//          *source -
+//          sourceSize -
+//          *dest -
+//          destCapacity -
+// Output : decoded size, -1 on failure
+//-----------------------------------------------------------------------------
+int DataBlock_Decode(const DataBlockCodec_e codec, ZSTD_DCtx* const dctx, const ZSTD_DDict* const ddict,
+	const void* const source, const int sourceSize, void* const dest, const int destCapacity)
+{
+	size_t decodedSize;
+
+	switch (codec)
+	{
+	case DATABLOCK_CODEC_LZ4:
+		return LZ4_decompress_safe((const char*)source, (char*)dest, sourceSize, destCapacity);
+	case DATABLOCK_CODEC_ZSTD:
+		decodedSize = ZSTD_decompressDCtx(dctx, dest, destCapacity, source, sourceSize);
+		break;
+	case DATABLOCK_CODEC_ZSTD_DICT:
+		if (!ddict)
+			return -1;
+
+		decodedSize = ZSTD_decompress_usingDDict(dctx, dest, destCapacity, source, sourceSize, ddict);
+		break;
+	default:
+		return -1;
+	}
+
+	return ZSTD_isError(decodedSize) ? -1 : int(decodedSize);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: trains a zstd dictionary on captured data blocks
+//-----------------------------------------------------------------------------
+static void DataBlock_TrainDictionary_f(const CCommand& args)
+{
+	if (args.ArgC() < 3)
+	{
+		Msg(eDLL_T::ENGINE, "Usage: %s <captureFile> <outputFile> [dictSize]\n", args.Arg(0));
+		return;
+	}
+
+	const size_t dictCapacity = args.ArgC() > 3
+		? size_t(Clamp(atoi(args.Arg(3)), 1024, DATABLOCK_DICT_MAX_SIZE))
+		: DATABLOCK_DICT_DEFAULT_SIZE;
+
+	vector<vector<uint8_t>> blocks;
+
+	if (!DataBlock_ReadCapture(args.Arg(1), blocks))
+		return;
+
+	vector<uint8_t> samples;
+	vector<size_t> sampleSizes;
+
+	sampleSizes.reserve(blocks.size());
+
+	for (const vector<uint8_t>& block : blocks)
+	{
+		samples.insert(samples.end(), block.begin(), block.end());
+		sampleSizes.push_back(block.size());
+	}
+
+	vector<char> dict(dictCapacity);
+
+	const size_t dictSize = ZDICT_trainFromBuffer(dict.data(), dictCapacity,
+		samples.data(), sampleSizes.data(), unsigned(sampleSizes.size()));
+
+	if (ZDICT_isError(dictSize))
+	{
+		Error(eDLL_T::ENGINE, NO_ERROR, "%s: training failed on %zu data blocks (%s)\n",
+			__FUNCTION__, blocks.size(), ZDICT_getErrorName(dictSize));
+		return;
+	}
+
+	const char* const outputPath = args.Arg(2);
+	CreateDirectories(outputPath);
+
+	CIOStream stream;
+
+	if (!stream.Open(outputPath, CIOStream::WRITE | CIOStream::BINARY))
+	{
+		Error(eDLL_T::ENGINE, NO_ERROR, "%s: failed to create dictionary '%s'\n", __FUNCTION__, outputPath);
+		return;
+	}
+
+	stream.Write(dict.data(), dictSize);
+
+	Msg(eDLL_T::ENGINE, "Trained dictionary '%s' (id %08x, %zu bytes) on %zu data blocks (%zu bytes)\n",
+		outputPath, ZDICT_getDictID(dict.data(), dictSize), dictSize, blocks.size(), samples.size());
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: replays captured data blocks through each codec, and compares the
+//          compression ratio against the encode and decode times
+//-----------------------------------------------------------------------------
+static void DataBlock_BenchmarkCodecs_f(const CCommand& args)
+{
+	if (args.ArgC() < 2)
+	{
+		Msg(eDLL_T::ENGINE, "Usage: %s <captureFile> [dictFile]\n", args.Arg(0));
+		return;
+	}
+
+	vector<vector<uint8_t>> blocks;
+
+	if (!DataBlock_ReadCapture(args.Arg(1), blocks))
+		return;
+
+	if (blocks.empty())
+	{
+		Warning(eDLL_T::ENGINE, "%s: capture '%s' contains no data blocks\n", __FUNCTION__, args.Arg(1));
+		return;
+	}
+
+	DataBlockDictionary_s dict;
+	const bool hasDict = args.ArgC() > 2 && DataBlock_LoadDictionary(args.Arg(2), dict);
+
+	if (args.ArgC() > 2 && !hasDict)
+		Warning(eDLL_T::ENGINE, "%s: failed to load dictionary '%s'\n", __FUNCTION__, args.Arg(2));
+
+	struct BenchmarkConfig_s
+	{
+		DataBlockCodec_e codec;
+		int level;
+	};
+
+	static const BenchmarkConfig_s s_configs[] =
+	{
+		{ DATABLOCK_CODEC_LZ4, 1 },
+		{ DATABLOCK_CODEC_LZ4, 8 },
+		{ DATABLOCK_CODEC_ZSTD, -5 },
+		{ DATABLOCK_CODEC_ZSTD, -1 },
+		{ DATABLOCK_CODEC_ZSTD, 1 },
+		{ DATABLOCK_CODEC_ZSTD, 3 },
+		{ DATABLOCK_CODEC_ZSTD_DICT, -1 },
+		{ DATABLOCK_CODEC_ZSTD_DICT, 1 },
+		{ DATABLOCK_CODEC_ZSTD_DICT, 3 },
+	};
+
+	size_t rawSize = 0;
+
+	for (const vector<uint8_t>& block : blocks)
+		rawSize += block.size();
+
+	ZSTD_CCtx* const cctx = ZSTD_createCCtx();
+	ZSTD_DCtx* const dctx = ZSTD_createDCtx();
+
+	ZSTD_DDict* const ddict = hasDict
+		? ZSTD_createDDict(dict.data.data(), dict.data.size())
+		: nullptr;
+
+	const int encodeCapacity = ZSTD_compressBound(SNAPSHOT_SCRATCH_BUFFER_SIZE);
+
+	vector<vector<uint8_t>> encodedBlocks(blocks.size());
+	vector<uint8_t> decodeBuffer(SNAPSHOT_SCRATCH_BUFFER_SIZE);
+
+	Msg(eDLL_T::ENGINE, "Replaying %zu data blocks (%zu bytes) from '%s'\n", blocks.size(), rawSize, args.Arg(1));
+
+	for (const BenchmarkConfig_s& config : s_configs)
+	{
+		if (config.codec == DATABLOCK_CODEC_ZSTD_DICT && !hasDict)
+			continue;
+
+		ZSTD_CDict* const cdict = config.codec == DATABLOCK_CODEC_ZSTD_DICT
+			? ZSTD_createCDict(dict.data.data(), dict.data.size(), config.level)
+			: nullptr;
+
+		size_t encodedSize = 0;
+		bool failed = false;
+
+		const double encodeStart = Plat_FloatTime();
+
+		for (size_t i = 0; i < blocks.size(); i++)
+		{
+			const vector<uint8_t>& block = blocks[i];
+			vector<uint8_t>& encoded = encodedBlocks[i];
+
+			encoded.resize(encodeCapacity);
+
+			const int numEncoded = DataBlock_Encode(config.codec, config.level, cctx, cdict,
+				block.data(), int(block.size()), encoded.data(), encodeCapacity);
+
+			encoded.resize(numEncoded);
+
+			// the sender falls back to raw data if encoding didn't help
+			encodedSize += (numEncoded && size_t(numEncoded) < block.size()) ? numEncoded : block.size();
+			failed |= !numEncoded;
+		}
+
+		const double encodeTime = Plat_FloatTime() - encodeStart;
+		const double decodeStart = Plat_FloatTime();
+
+		for (size_t i = 0; i < blocks.size() && !failed; i++)
+		{
+			const vector<uint8_t>& encoded = encodedBlocks[i];
+
+			const int numDecoded = DataBlock_Decode(config.codec, dctx, ddict,
+				encoded.data(), int(encoded.size()), decodeBuffer.data(), SNAPSHOT_SCRATCH_BUFFER_SIZE);
+
+			failed |= numDecoded != int(blocks[i].size());
+		}
+
+		const double decodeTime = Plat_FloatTime() - decodeStart;
+
+		// verified separately, so the memcmp doesn't count towards decode time
+		for (size_t i = 0; i < blocks.size() && !failed; i++)
+		{
+			const vector<uint8_t>& encoded = encodedBlocks[i];
+
+			DataBlock_Decode(config.codec, dctx, ddict, encoded.data(), int(encoded.size()),
+				decodeBuffer.data(), SNAPSHOT_SCRATCH_BUFFER_SIZE);
+
+			failed |= memcmp(decodeBuffer.data(), blocks[i].data(), blocks[i].size()) != 0;
+		}
+
+		ZSTD_freeCDict(cdict);
+
+		if (failed)
+		{
+			Warning(eDLL_T::ENGINE, "%-9s level %3d: round trip FAILED\n",
+				DataBlock_GetCodecName(config.codec), config.level);
+			continue;
+		}
+
+		const double rawMiB = double(rawSize) / (1024.0 * 1024.0);
+
+		Msg(eDLL_T::ENGINE, "%-9s level %3d: ratio %6.3f, %10zu bytes, encode %8.1f MiB/s, decode %8.1f MiB/s\n",
+			DataBlock_GetCodecName(config.codec), config.level, double(rawSize) / double(encodedSize), encodedSize,
+			rawMiB / MAX(encodeTime, 1e-9), rawMiB / MAX(decodeTime, 1e-9));
+	}
+
+	ZSTD_freeDDict(ddict);
+	ZSTD_freeDCtx(dctx);
+	ZSTD_freeCCtx(cctx);
+}
+
+static ConCommand net_dataBlockTrainDictionary("net_dataBlockTrainDictionary", DataBlock_TrainDictionary_f, "Trains a data block compression dictionary on a capture", FCVAR_DEVELOPMENTONLY, nullptr, "net_dataBlockTrainDictionary <captureFile> <outputFile> [dictSize]");
+static ConCommand net_dataBlockBenchmark("net_dataBlockBenchmark", DataBlock_BenchmarkCodecs_f, "Replays captured data blocks through each compression codec", FCVAR_DEVELOPMENTONLY, nullptr, "net_dataBlockBenchmark <captureFile> [dictFile]");
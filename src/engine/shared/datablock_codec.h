@@ -0,0 +1,88 @@
+//===========================================================================//
+//
+// Purpose: data block compression codecs
+//
+//===========================================================================//
+#ifndef DATABLOCK_CODEC_H
+#define DATABLOCK_CODEC_H
+#include "tier0/binstream.h"
+
+//-----------------------------------------------------------------------------
+// The codec is stored in the first byte of each data block, retail used this
+// byte as a boolean for LZ4 compression hence the order of the first 2 codecs
+//-----------------------------------------------------------------------------
+enum DataBlockCodec_e : uint8_t
+{
+	DATABLOCK_CODEC_NONE = 0,
+	DATABLOCK_CODEC_LZ4,
+	DATABLOCK_CODEC_ZSTD,
+	DATABLOCK_CODEC_ZSTD_DICT, // Zstandard with the dictionary trained for the current level.
+
+	DATABLOCK_CODEC_COUNT
+};
+
+#define DATABLOCK_CODEC_BIT(codec) (1 << (codec))
+
+// codecs every receiver supports, assumed for clients that don't advertise theirs
+#define DATABLOCK_CODECS_RETAIL (DATABLOCK_CODEC_BIT(DATABLOCK_CODEC_NONE) | DATABLOCK_CODEC_BIT(DATABLOCK_CODEC_LZ4))
+#define DATABLOCK_CODECS_ALL ((1 << DATABLOCK_CODEC_COUNT) -1)
+
+// dictionaries are stored per level in this directory, relative to the platform path
+#define DATABLOCK_DICT_PATH "datablock/"
+#define DATABLOCK_DICT_EXT ".zdict"
+
+#define DATABLOCK_DICT_MAX_SIZE (1024 * 1024)
+#define DATABLOCK_DICT_DEFAULT_SIZE (110 * 1024)
+
+// max dictionaries a receiver advertises to the sender
+#define DATABLOCK_DICT_MAX_ADVERTISED 32
+
+// captured data blocks, used for training dictionaries and benchmarking
+#define DATABLOCK_CAPTURE_PATH "datablock/captures/"
+#define DATABLOCK_CAPTURE_EXT ".dbcap"
+#define DATABLOCK_CAPTURE_MAGIC (('P'<<24)+('C'<<16)+('B'<<8)+'D')
+
+//-----------------------------------------------------------------------------
+// Data block dictionary, loaded from the platform path
+//-----------------------------------------------------------------------------
+struct DataBlockDictionary_s
+{
+	DataBlockDictionary_s() : id(0) {}
+
+	uint32_t id;
+	vector<char> data;
+};
+
+//-----------------------------------------------------------------------------
+// Appends uncompressed data blocks to a capture file, a new file is started
+// for each level; can be used from multiple threads
+//-----------------------------------------------------------------------------
+class CDataBlockCapture
+{
+public:
+	CDataBlockCapture() : m_isOpen(false) {}
+	~CDataBlockCapture() { Close(); }
+
+	void Write(const char* const levelName, const uint8_t* const data, const int dataSize);
+	void Close();
+
+private:
+	bool Open(const char* const levelName);
+
+	std::mutex m_mutex;
+	CIOStream m_stream;
+	string m_levelName;
+	bool m_isOpen;
+};
+
+const char* DataBlock_GetCodecName(const int codec);
+
+bool DataBlock_LoadDictionary(const char* const filePath, DataBlockDictionary_s& dict);
+bool DataBlock_ReadCapture(const char* const filePath, vector<vector<uint8_t>>& blocks);
+
+int DataBlock_Encode(const DataBlockCodec_e codec, const int level, ZSTD_CCtx* const cctx, const ZSTD_CDict* const cdict,
+	const void* const source, const int sourceSize, void* const dest, const int destCapacity);
+int DataBlock_Decode(const DataBlockCodec_e codec, ZSTD_DCtx* const dctx, const ZSTD_DDict* const ddict,
+	const void* const source, const int sourceSize, void* const dest, const int destCapacity);
+
+#endif // DATABLOCK_CODEC_H
@@ -7,6 +7,7 @@
 #include "base_rcon.h"
 #include "shared_rcon.h"
 #include "protoc/netcon.pb.h"
+#include <random>
 
 //-----------------------------------------------------------------------------
 // Purpose: serialize message to vector
@@ -19,10 +20,11 @@
 //			nMessageType - 
 //			bEncrypt - 
 //			bDebug - 
+//			nHeaderLen - 
 // Output : true on success, false otherwise
 //-----------------------------------------------------------------------------
 bool NetconServer_Serialize(const CNetConBase* pBase, vector<char>& vecBuf, const char* pResponseMsg, const char* pResponseVal,
-	const netcon::response_e responseType, const int nMessageId, const int nMessageType, const bool bEncrypt, const bool bDebug)
+	const netcon::response_e responseType, const int nMessageId, const int nMessageType, const bool bEncrypt, const bool bDebug, const size_t nHeaderLen)
 {
 	netcon::response response;
 
@@ -32,7 +34,7 @@ bool NetconServer_Serialize(const CNetConBase* pBase, vector<char>& vecBuf, cons
 	response.set_responsemsg(pResponseMsg);
 	response.set_responseval(pResponseVal);
 
-	if (!NetconShared_PackEnvelope(pBase, vecBuf, response.ByteSizeLong(), &response, bEncrypt, bDebug))
+	if (!NetconShared_PackEnvelope(pBase, vecBuf, response.ByteSizeLong(), &response, bEncrypt, bDebug, nHeaderLen))
 	{
 		return false;
 	}
@@ -122,10 +124,11 @@ bool NetconClient_Connect(CNetConBase* pBase, const char* pHostAdr, const int nH
 //			*inMsg - 
 //			bEncrypt - 
 //			bDebug - 
+//			nHeaderLen - num bytes to leave in front of the envelope (e.g. for the frame prefix)
 // Output : true on success, false otherwise
 //-----------------------------------------------------------------------------
 bool NetconShared_PackEnvelope(const CNetConBase* pBase, vector<char>& outMsgBuf, const size_t nMsgLen,
-	google::protobuf::MessageLite* inMsg, const bool bEncrypt, const bool bDebug)
+	google::protobuf::MessageLite* inMsg, const bool bEncrypt, const bool bDebug, const size_t nHeaderLen)
 {
 	char* encodeBuf = new char[nMsgLen];
 	std::unique_ptr<char[]> encodedContainer(encodeBuf);
@@ -169,9 +172,9 @@ bool NetconShared_PackEnvelope(const CNetConBase* pBase, vector<char>& outMsgBuf
 	envelope.set_data(dataBuf, nMsgLen);
 	const size_t envelopeSize = envelope.ByteSizeLong();
 
-	outMsgBuf.resize(envelopeSize);
+	outMsgBuf.resize(nHeaderLen + envelopeSize);
 
-	if (!pBase->Encode(&envelope, &outMsgBuf[0], envelopeSize))
+	if (!pBase->Encode(&envelope, outMsgBuf.data() + nHeaderLen, envelopeSize))
 	{
 		if (bDebug)
 		{
@@ -397,4 +400,239 @@ void RCON_InitClientAndTrySyncKeys()
 }
 #endif // !DEDICATED
 
+
+//-----------------------------------------------------------------------------
+// Purpose: frame parser test harness, verifies each received frame against
+//			the stream it was taken from
+//-----------------------------------------------------------------------------
+class CNetConFramerTest : public CNetConBase
+{
+public:
+	CNetConFramerTest(const string& stream, const bool bVerify)
+		: m_Stream(stream)
+		, m_bVerify(bVerify)
+		, m_nStreamOffset(0)
+		, m_nFrameCount(0)
+		, m_nMismatchCount(0)
+		, m_pDisconnectReason(nullptr)
+	{}
+
+	virtual void Disconnect(const char* szReason) override
+	{
+		m_pDisconnectReason = szReason;
+	}
+
+	virtual bool ProcessMessage(const char* pMsgBuf, const int nMsgLen) override
+	{
+		const size_t nPayloadOffset = m_nStreamOffset + RCON_FRAME_PREFIX_SIZE;
+
+		if (m_bVerify && (nPayloadOffset + nMsgLen > m_Stream.size() ||
+			memcmp(&m_Stream[nPayloadOffset], pMsgBuf, nMsgLen) != 0))
+		{
+			m_nMismatchCount++;
+		}
+
+		m_nStreamOffset = (nPayloadOffset + nMsgLen) % m_Stream.size();
+		m_nFrameCount++;
+
+		return true;
+	}
+
+	// Feeds the stream the way Recv() does, minus the socket.
+	bool Feed(CConnectedNetConsoleData& data, const char* pRecvBuf, int nRecvLen, const int nMaxLen)
+	{
+		while (nRecvLen > 0)
+		{
+			int nFreeLen;
+			char* const pFreeBuf = ReserveRecvSpace(data, RCON_RECV_CHUNK_SIZE, nFreeLen);
+
+			const int nCopyLen = MIN(nRecvLen, nFreeLen);
+			memcpy(pFreeBuf, pRecvBuf, nCopyLen);
+
+			data.m_nRecvTail += nCopyLen;
+
+			pRecvBuf += nCopyLen;
+			nRecvLen -= nCopyLen;
+
+			if (!ProcessFrames(data, nMaxLen))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	const string& m_Stream;
+	bool m_bVerify;
+
+	size_t m_nStreamOffset;
+	int64_t m_nFrameCount;
+	int64_t m_nMismatchCount;
+
+	const char* m_pDisconnectReason;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: appends a length prefixed frame to the stream
+//-----------------------------------------------------------------------------
+static void RCON_AppendTestFrame(string& stream, std::mt19937& rng, const int nPayloadLen)
+{
+	const u_long nPrefix = htonl(u_long(nPayloadLen));
+	stream.append(reinterpret_cast<const char*>(&nPrefix), sizeof(nPrefix));
+
+	for (int i = 0; i < nPayloadLen; i++)
+	{
+		stream.push_back(char(rng()));
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: feeds the stream in random chunks and checks the results
+//-----------------------------------------------------------------------------
+static bool RCON_FuzzFramer(const string& stream, const int64_t nNumFrames, std::mt19937& rng, const int nMaxChunkLen)
+{
+	CNetConFramerTest test(stream, true);
+	CConnectedNetConsoleData data;
+	data.m_bAuthorized = true;
+
+	std::uniform_int_distribution<int> chunkDist(1, nMaxChunkLen);
+	int nChunkCount = 0;
+
+	for (size_t i = 0; i < stream.size();)
+	{
+		const size_t nRandomLen = size_t(chunkDist(rng));
+		const int nChunkLen = int(MIN(nRandomLen, stream.size() - i));
+
+		// Alternate between both receive paths.
+		const bool bRet = (nChunkCount++ & 1)
+			? test.ProcessBuffer(data, &stream[i], nChunkLen)
+			: test.Feed(data, &stream[i], nChunkLen, SOCKET_ERROR);
+
+		if (!bRet)
+		{
+			break;
+		}
+
+		i += nChunkLen;
+	}
+
+	if (test.m_pDisconnectReason || test.m_nFrameCount != nNumFrames ||
+		test.m_nMismatchCount || data.m_nRecvHead != data.m_nRecvTail)
+	{
+		Warning(eDLL_T::ENGINE, "RCON framer fuzz failed (chunk=%d): frames=%lld/%lld mismatches=%lld pending=%d disconnect=%s\n",
+			nMaxChunkLen, test.m_nFrameCount, nNumFrames, test.m_nMismatchCount,
+			data.m_nRecvTail - data.m_nRecvHead, test.m_pDisconnectReason ? test.m_pDisconnectReason : "none");
+
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: feeds a single bad frame and checks if the connection got dropped
+//-----------------------------------------------------------------------------
+static bool RCON_FuzzBadFrame(const int nPayloadLen, const bool bAuthorized, const int nMaxLen, const char* pExpectedReason)
+{
+	const string empty(1, '\0');
+	CNetConFramerTest test(empty, false);
+
+	CConnectedNetConsoleData data;
+	data.m_bAuthorized = bAuthorized;
+
+	const u_long nPrefix = htonl(u_long(nPayloadLen));
+	test.ProcessBuffer(data, reinterpret_cast<const char*>(&nPrefix), sizeof(nPrefix), nMaxLen);
+
+	const char* const pReason = test.m_pDisconnectReason;
+
+	if (!pReason || strcmp(pReason, pExpectedReason) != 0 || test.m_nFrameCount)
+	{
+		Warning(eDLL_T::ENGINE, "RCON framer fuzz failed (prefix=%d): expected disconnect '%s', got '%s'\n",
+			nPayloadLen, pExpectedReason, pReason ? pReason : "none");
+
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: fuzzes the RCON frame parser and measures its throughput
+//-----------------------------------------------------------------------------
+static void RCON_TestFramer_f(const CCommand& args)
+{
+	const int nNumFrames = args.ArgC() > 1 ? Clamp(atoi(args.Arg(1)), 1, 1000000) : 10000;
+	const int nSeed = args.ArgC() > 2 ? atoi(args.Arg(2)) : 0;
+
+	std::mt19937 rng(nSeed);
+	std::uniform_int_distribution<int> typeDist(0, 99);
+
+	string stream;
+
+	// Mostly small messages, like commands and log lines, with the
+	// occasional large one.
+	for (int i = 0; i < nNumFrames; i++)
+	{
+		const int nType = typeDist(rng);
+		int nPayloadLen;
+
+		if (nType < 70)
+			nPayloadLen = std::uniform_int_distribution<int>(0, 256)(rng);
+		else if (nType < 99)
+			nPayloadLen = std::uniform_int_distribution<int>(257, 8192)(rng);
+		else
+			nPayloadLen = std::uniform_int_distribution<int>(8193, 256 * 1024)(rng);
+
+		RCON_AppendTestFrame(stream, rng, nPayloadLen);
+	}
+
+	// Largest frame that is allowed.
+	RCON_AppendTestFrame(stream, rng, RCON_MAX_FRAME_SIZE);
+
+	bool bSuccess = true;
+
+	static const int s_ChunkSizes[] = { 1, 7, 64, 1500, RCON_RECV_CHUNK_SIZE, RCON_MAX_FRAME_SIZE * 2 };
+
+	for (const int nChunkLen : s_ChunkSizes)
+	{
+		bSuccess &= RCON_FuzzFramer(stream, nNumFrames + 1, rng, nChunkLen);
+	}
+
+	bSuccess &= RCON_FuzzBadFrame(-1, true, SOCKET_ERROR, "desync");
+	bSuccess &= RCON_FuzzBadFrame(RCON_MAX_FRAME_SIZE + 1, true, SOCKET_ERROR, "desync");
+	bSuccess &= RCON_FuzzBadFrame(1025, false, 1024, "overflow");
+
+	Msg(eDLL_T::ENGINE, "RCON framer fuzz %s (%d frames, %zu bytes, seed %d)\n",
+		bSuccess ? "passed" : "FAILED", nNumFrames + 1, stream.size(), nSeed);
+
+	// Throughput, the stream is fed in chunks the size of a single recv.
+	CNetConFramerTest test(stream, false);
+	CConnectedNetConsoleData data;
+	data.m_bAuthorized = true;
+
+	const size_t nTotalLen = MAX(stream.size(), size_t(256 * 1024 * 1024));
+	size_t nProcessed = 0;
+
+	const double flStartTime = Plat_FloatTime();
+
+	while (nProcessed < nTotalLen)
+	{
+		for (size_t i = 0; i < stream.size(); i += RCON_RECV_CHUNK_SIZE)
+		{
+			test.Feed(data, &stream[i], int(MIN(size_t(RCON_RECV_CHUNK_SIZE), stream.size() - i)), SOCKET_ERROR);
+		}
+
+		nProcessed += stream.size();
+	}
+
+	const double flElapsed = MAX(Plat_FloatTime() - flStartTime, 1e-9);
+
+	Msg(eDLL_T::ENGINE, "RCON framer throughput: %.1f MiB/s, %.0f frames/s (%lld frames, %.3f seconds)\n",
+		(double(nProcessed) / (1024.0 * 1024.0)) / flElapsed, double(test.m_nFrameCount) / flElapsed,
+		test.m_nFrameCount, flElapsed);
+}
+
+static ConCommand rcon_framer_test("rcon_framer_test", RCON_TestFramer_f, "Fuzzes the RCON frame parser and measures its throughput", FCVAR_DEVELOPMENTONLY, nullptr, "rcon_framer_test <numFrames> <seed>");
+
 #endif // !_TOOLS
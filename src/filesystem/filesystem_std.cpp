@@ -29,6 +29,23 @@ FileHandle_t CBaseFileSystem::Open(const char* pFileName, const char* pOptions,
 	return (FileHandle_t)fopen(fullPath, pOptions);
 }
 
+const char* CBaseFileSystem::RelativePathToFullPath(const char* pFileName, const char* pPathID, char* pLocalPath, ssize_t localPathBufferSize, PathTypeFilter_t pathFilter, PathTypeQuery_t* pPathType)
+{
+	NOTE_UNUSED(pathFilter);
+
+	// There are no search paths, so the path is only valid if the file exists as is.
+	if (!FileExists(pFileName, pPathID))
+		return nullptr;
+
+	snprintf(pLocalPath, localPathBufferSize, "%s", pFileName);
+	V_FixSlashes(pLocalPath);
+
+	if (pPathType)
+		*pPathType = PATH_IS_NORMAL;
+
+	return pLocalPath;
+}
+
 void CBaseFileSystem::Close(FileHandle_t file)
 {
 	fclose((FILE*)file);
@@ -266,6 +283,69 @@ bool CBaseFileSystem::ReadFile(const char* pFileName, const char* pPath, CUtlBuf
 	return bSuccess;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: reads a file without copying, by attaching the buffer to a
+//          read-only mapped view of it. Text buffers need their line endings
+//          translated, and buffers with pending data would lose it, so those
+//          (and files that fail to map) take the regular ReadFile path
+// Input  : *pFileName    - 
+//          *pPath        - 
+//          &buf          - 
+//          &view         - receives the mapping, must outlive buf's use of it
+//          access        - expected access pattern of the caller
+//          nMaxBytes     - 
+//          nStartingByte - 
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CBaseFileSystem::ReadFileMapped(const char* pFileName, const char* pPath, CUtlBuffer& buf, CMappedFileView& view,
+	const FileMapAccess_t access, ssize_t nMaxBytes, ptrdiff_t nStartingByte)
+{
+	if (view.IsMapped())
+	{
+		const uint8_t* const pBase = reinterpret_cast<const uint8_t*>(buf.Base());
+
+		// Detach the buffer if it still points into the previous mapping.
+		if (pBase >= view.Base() && pBase < view.Base() + view.Size())
+			buf.Purge();
+
+		view.Unmap();
+	}
+
+	const bool bBinary = !(buf.IsText() && !buf.ContainsCRLF());
+
+	if (!bBinary || buf.TellPut() != 0 || nStartingByte < 0)
+		return ReadFile(pFileName, pPath, buf, nMaxBytes, nStartingByte);
+
+	char fullPath[1024];
+	snprintf(fullPath, sizeof(fullPath), "%s", pFileName);
+
+	V_FixSlashes(fullPath);
+
+	if (!view.Map(fullPath, access) || nStartingByte >= view.Size())
+	{
+		view.Unmap();
+		return ReadFile(pFileName, pPath, buf, nMaxBytes, nStartingByte);
+	}
+
+	ssize_t nBytesToRead = view.Size() - nStartingByte;
+
+	if (nMaxBytes > 0)
+	{
+		// can't read more than file has
+		nBytesToRead = MIN(nMaxBytes, nBytesToRead);
+	}
+
+	// Only read ahead what the caller asked for, not the whole file.
+	if (access == FileMapAccess_t::FILEMAP_ACCESS_SEQUENTIAL)
+		view.PrefetchRange(nStartingByte, nBytesToRead);
+
+	// The view is mapped read-only, so the buffer must never be written to.
+	buf.SetExternalBuffer(const_cast<uint8_t*>(view.Base() + nStartingByte), nBytesToRead, nBytesToRead,
+		(buf.GetFlags() & ~CUtlBuffer::EXTERNAL_GROWABLE) | CUtlBuffer::READ_ONLY);
+
+	return true;
+}
+
 bool CBaseFileSystem::WriteFile(const char* pFileName, const char* pPath, CUtlBuffer& buf)
 {
 	const char* pWriteFlags = "wb";
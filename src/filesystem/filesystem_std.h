@@ -2,6 +2,7 @@
 #define FILESYSTEM_H
 #include <tier1/keyvalues.h>
 #include "ifilesystem.h"
+#include "tier1/mappedfile.h"
 
 class CBaseFileSystem : public CTier1AppSystem<IFileSystem>
 {
@@ -29,7 +30,7 @@ public:
 	virtual void			RemoveAllSearchPaths(void) {};
 	virtual void			RemoveSearchPaths(const char* szPathID) {};
 	virtual void			MarkPathIDByRequestOnly(const char* pPathID, bool bRequestOnly) {}
-	virtual const char* RelativePathToFullPath(const char* pFileName, const char* pPathID, char* pLocalPath, ssize_t localPathBufferSize, PathTypeFilter_t pathFilter = FILTER_NONE, PathTypeQuery_t* pPathType = NULL) { return nullptr; };
+	virtual const char* RelativePathToFullPath(const char* pFileName, const char* pPathID, char* pLocalPath, ssize_t localPathBufferSize, PathTypeFilter_t pathFilter = FILTER_NONE, PathTypeQuery_t* pPathType = NULL);
 #if IsGameConsole()
 	virtual bool            GetPackFileInfoFromRelativePath(const char* pFileName, const char* pPathID, char* pPackPath, ssize_t nPackPathBufferSize, ptrdiff_t& nPosition, ssize_t& nLength) { return false; };
 #endif
@@ -264,6 +265,11 @@ public:
 
 	char* ReadLine(char* maxChars, ssize_t maxOutputLength, FileHandle_t file);
 	CUtlString ReadString(FileHandle_t pFile);
+
+	// Zero-copy variant of ReadFile; buf becomes a read-only external buffer
+	// over the mapped view. Falls back to ReadFile when mapping isn't possible.
+	bool ReadFileMapped(const char* pFileName, const char* pPath, CUtlBuffer& buf, CMappedFileView& view,
+		const FileMapAccess_t access = FileMapAccess_t::FILEMAP_ACCESS_SEQUENTIAL, ssize_t nMaxBytes = 0, ptrdiff_t nStartingByte = 0);
 };
 
 class CFileSystem_Stdio : public CBaseFileSystem
@@ -14,6 +14,7 @@
 #include "game/server/ai_node.h"
 #include "game/server/ai_network.h"
 #include "game/server/ai_networkmanager.h"
+#include "game/server/ai_nodeindex.h"
 #include "game/server/ai_navmesh.h"
 #include <public/worldsize.h>
 
@@ -523,6 +524,7 @@ CAI_NetworkManager::LoadNetworkGraphEx
 void CAI_NetworkManager::LoadNetworkGraphEx(CAI_NetworkManager* pManager, CUtlBuffer* pBuffer, const char* szAIGraphFile)
 {
 	CAI_NetworkManager__LoadNetworkGraph(pManager, pBuffer, szAIGraphFile);
+	g_AIScriptNodeIndex.Rebuild(pManager->m_pNetwork);
 
 	if (ai_ainDumpOnLoad.GetBool())
 	{
@@ -542,6 +544,7 @@ CAI_NetworkBuilder::Build
 void CAI_NetworkBuilder::Build(CAI_NetworkBuilder* pBuilder, CAI_Network* pAINetwork)
 {
 	CAI_NetworkBuilder__Build(pBuilder, pAINetwork);
+	g_AIScriptNodeIndex.Rebuild(pAINetwork);
 	CAI_NetworkBuilder::SaveNetworkGraph(pAINetwork);
 }
 
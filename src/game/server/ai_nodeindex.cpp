@@ -0,0 +1,659 @@
+//=============================================================================//
+//
+// Purpose: Spatial index for AI network nodes
+//
+//=============================================================================//
+#include "core/stdafx.h"
+#include <random>
+#include "tier1/cvar.h"
+#include "game/server/ai_network.h"
+#include "game/server/ai_nodeindex.h"
+
+// Sentinel origin of padding lanes, the squared distance to it stays finite.
+static constexpr float AI_NODE_INDEX_SENTINEL = 1.0e18f;
+static constexpr float AI_NODE_INDEX_MAX_VIRTUAL_CELL = 16777216.0f;
+
+//-----------------------------------------------------------------------------
+// Purpose: computes the squared distances to the 4 origins in the block
+//-----------------------------------------------------------------------------
+template <typename Block_t>
+static FORCEINLINE fltx4 AI_NodeIndex_DistSqr(const Block_t& block, const fltx4& xPosX, const fltx4& xPosY, const fltx4& xPosZ)
+{
+	const fltx4 xDeltaX = SubSIMD(LoadAlignedSIMD(block.x), xPosX);
+	const fltx4 xDeltaY = SubSIMD(LoadAlignedSIMD(block.y), xPosY);
+	const fltx4 xDeltaZ = SubSIMD(LoadAlignedSIMD(block.z), xPosZ);
+
+	return MaddSIMD(xDeltaX, xDeltaX, MaddSIMD(xDeltaY, xDeltaY, MulSIMD(xDeltaZ, xDeltaZ)));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: orders candidates on distance, then on node index so results are
+//          deterministic and match a linear scan
+//-----------------------------------------------------------------------------
+static FORCEINLINE bool AI_NodeIndex_IsCloser(const float flDistSqr, const int nIndex, const float flOtherDistSqr, const int nOtherIndex)
+{
+	return flDistSqr < flOtherDistSqr || (flDistSqr == flOtherDistSqr && nIndex < nOtherIndex);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: constructor
+//-----------------------------------------------------------------------------
+CAI_NodeSpatialIndex::CAI_NodeSpatialIndex()
+{
+	Clear();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: releases the index
+//-----------------------------------------------------------------------------
+void CAI_NodeSpatialIndex::Clear()
+{
+	m_flMinX = 0.0f;
+	m_flMinY = 0.0f;
+	m_flCellSize = 1.0f;
+	m_flInvCellSize = 1.0f;
+
+	m_nCellsX = 0;
+	m_nCellsY = 0;
+	m_nCount = 0;
+
+	m_CellStart.clear();
+	m_Blocks.clear();
+	m_Indices.clear();
+
+	m_pNetwork = nullptr;
+	m_pScriptNodes = nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: builds the index
+// Input  : *pOrigins -
+//          nCount    -
+//          nStride   - byte offset between each origin
+//-----------------------------------------------------------------------------
+void CAI_NodeSpatialIndex::Build(const Vector3D* pOrigins, const int nCount, const size_t nStride)
+{
+	Clear();
+
+	if (nCount <= 0)
+		return;
+
+	const auto GetOrigin = [&](const int i) -> const Vector3D&
+	{
+		return *reinterpret_cast<const Vector3D*>(reinterpret_cast<const uint8_t*>(pOrigins) + i * nStride);
+	};
+
+	float flMinX = FLT_MAX, flMinY = FLT_MAX;
+	float flMaxX = -FLT_MAX, flMaxY = -FLT_MAX;
+
+	for (int i = 0; i < nCount; i++)
+	{
+		const Vector3D& vOrigin = GetOrigin(i);
+
+		flMinX = Min(flMinX, vOrigin.x);
+		flMinY = Min(flMinY, vOrigin.y);
+		flMaxX = Max(flMaxX, vOrigin.x);
+		flMaxY = Max(flMaxY, vOrigin.y);
+	}
+
+	const float flWidth = Max(flMaxX - flMinX, 1.0f);
+	const float flDepth = Max(flMaxY - flMinY, 1.0f);
+
+	float flCellSize = Max(sqrtf(flWidth * flDepth * AI_NODE_INDEX_CELL_TARGET / nCount), AI_NODE_INDEX_MIN_CELL_SIZE);
+
+	int nCellsX = int(flWidth / flCellSize) + 1;
+	int nCellsY = int(flDepth / flCellSize) + 1;
+
+	while (int64_t(nCellsX) * nCellsY > AI_NODE_INDEX_MAX_CELLS)
+	{
+		flCellSize *= 2.0f;
+
+		nCellsX = int(flWidth / flCellSize) + 1;
+		nCellsY = int(flDepth / flCellSize) + 1;
+	}
+
+	m_flMinX = flMinX;
+	m_flMinY = flMinY;
+	m_flCellSize = flCellSize;
+	m_flInvCellSize = 1.0f / flCellSize;
+
+	m_nCellsX = nCellsX;
+	m_nCellsY = nCellsY;
+
+	const int nCells = nCellsX * nCellsY;
+
+	std::vector<int> nodeCells(nCount);
+	std::vector<int> cellCounts(nCells, 0);
+
+	for (int i = 0; i < nCount; i++)
+	{
+		const Vector3D& vOrigin = GetOrigin(i);
+
+		const int nCellX = Clamp(int((vOrigin.x - flMinX) * m_flInvCellSize), 0, nCellsX - 1);
+		const int nCellY = Clamp(int((vOrigin.y - flMinY) * m_flInvCellSize), 0, nCellsY - 1);
+
+		nodeCells[i] = nCellX + nCellY * nCellsX;
+		cellCounts[nodeCells[i]]++;
+	}
+
+	// Each cell is padded to whole blocks, so blocks never span cells.
+	m_CellStart.resize(nCells + 1);
+	int nBlocks = 0;
+
+	for (int i = 0; i < nCells; i++)
+	{
+		m_CellStart[i] = nBlocks;
+		nBlocks += (cellCounts[i] + 3) / 4;
+	}
+
+	m_CellStart[nCells] = nBlocks;
+
+	Block_s sentinel;
+
+	for (int i = 0; i < 4; i++)
+	{
+		sentinel.x[i] = AI_NODE_INDEX_SENTINEL;
+		sentinel.y[i] = AI_NODE_INDEX_SENTINEL;
+		sentinel.z[i] = AI_NODE_INDEX_SENTINEL;
+	}
+
+	m_Blocks.assign(nBlocks, sentinel);
+	m_Indices.assign(nBlocks * 4, NO_NODE);
+
+	// Reuse the counts as the next free lane of each cell, nodes are inserted
+	// in index order so each cell stays sorted on node index.
+	for (int i = 0; i < nCells; i++)
+		cellCounts[i] = m_CellStart[i] * 4;
+
+	for (int i = 0; i < nCount; i++)
+	{
+		const Vector3D& vOrigin = GetOrigin(i);
+		const int nLane = cellCounts[nodeCells[i]]++;
+
+		Block_s& block = m_Blocks[nLane / 4];
+
+		block.x[nLane % 4] = vOrigin.x;
+		block.y[nLane % 4] = vOrigin.y;
+		block.z[nLane % 4] = vOrigin.z;
+
+		m_Indices[nLane] = i;
+	}
+
+	m_nCount = nCount;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: builds the index over the script nodes of the network
+// Input  : *pNetwork -
+//-----------------------------------------------------------------------------
+void CAI_NodeSpatialIndex::Build(const CAI_Network* pNetwork)
+{
+	if (pNetwork && pNetwork->m_ScriptNode)
+		Build(&pNetwork->m_ScriptNode->m_vOrigin, pNetwork->m_iNumScriptNodes, sizeof(CAI_ScriptNode));
+	else
+		Clear();
+
+	m_pNetwork = pNetwork;
+	m_pScriptNodes = pNetwork ? pNetwork->m_ScriptNode : nullptr;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: checks if the index is up to date with the script nodes of the network
+// Input  : *pNetwork -
+//-----------------------------------------------------------------------------
+bool CAI_NodeSpatialIndex::IsBuiltFor(const CAI_Network* pNetwork) const
+{
+	return pNetwork && m_pNetwork == pNetwork
+		&& m_pScriptNodes == pNetwork->m_ScriptNode
+		&& m_nCount == (m_pScriptNodes ? pNetwork->m_iNumScriptNodes : 0);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: gets the unclamped cell coordinate of a position on an axis
+//-----------------------------------------------------------------------------
+int CAI_NodeSpatialIndex::GetVirtualCell(const float flPos, const float flMin) const
+{
+	const float flCell = floorf((flPos - flMin) * m_flInvCellSize);
+
+	if (!(flCell > -AI_NODE_INDEX_MAX_VIRTUAL_CELL)) // Also catches NaN.
+		return -int(AI_NODE_INDEX_MAX_VIRTUAL_CELL);
+	if (flCell > AI_NODE_INDEX_MAX_VIRTUAL_CELL)
+		return int(AI_NODE_INDEX_MAX_VIRTUAL_CELL);
+
+	return int(flCell);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: gets the first ring around the cell that overlaps the grid
+//-----------------------------------------------------------------------------
+int CAI_NodeSpatialIndex::GetFirstRing(const int nCellX, const int nCellY) const
+{
+	const int nDeltaX = nCellX < 0 ? -nCellX : Max(nCellX - (m_nCellsX - 1), 0);
+	const int nDeltaY = nCellY < 0 ? -nCellY : Max(nCellY - (m_nCellsY - 1), 0);
+
+	return Max(nDeltaX, nDeltaY);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: gets the ring around the cell that covers the entire grid
+//-----------------------------------------------------------------------------
+int CAI_NodeSpatialIndex::GetLastRing(const int nCellX, const int nCellY) const
+{
+	const int nDeltaX = Max(abs(nCellX), abs(nCellX - (m_nCellsX - 1)));
+	const int nDeltaY = Max(abs(nCellY), abs(nCellY - (m_nCellsY - 1)));
+
+	return Max(nDeltaX, nDeltaY);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: visits each cell within the grid on the square ring around a cell
+//-----------------------------------------------------------------------------
+template <typename Functor>
+void CAI_NodeSpatialIndex::ForEachCellInRing(const int nCellX, const int nCellY, const int nRing, Functor fnVisit) const
+{
+	const int nMinX = Max(nCellX - nRing, 0);
+	const int nMaxX = Min(nCellX + nRing, m_nCellsX - 1);
+
+	// Top and bottom rows.
+	for (int nSide = 0; nSide < (nRing ? 2 : 1); nSide++)
+	{
+		const int y = nSide ? nCellY + nRing : nCellY - nRing;
+
+		if (y < 0 || y >= m_nCellsY)
+			continue;
+
+		for (int x = nMinX; x <= nMaxX; x++)
+			fnVisit(x + y * m_nCellsX);
+	}
+
+	if (!nRing)
+		return;
+
+	const int nMinY = Max(nCellY - nRing + 1, 0);
+	const int nMaxY = Min(nCellY + nRing - 1, m_nCellsY - 1);
+
+	// Left and right columns, without the corners.
+	for (int nSide = 0; nSide < 2; nSide++)
+	{
+		const int x = nSide ? nCellX + nRing : nCellX - nRing;
+
+		if (x < 0 || x >= m_nCellsX)
+			continue;
+
+		for (int y = nMinY; y <= nMaxY; y++)
+			fnVisit(x + y * m_nCellsX);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: finds the nearest node to position
+// Input  : &vPos     -
+//          flMaxDist - only nodes closer than this are considered
+//          nExclude  - node index to skip, e.g. the node queried from
+// Output : node index, NO_NODE if none was found
+//-----------------------------------------------------------------------------
+int CAI_NodeSpatialIndex::FindNearest(const Vector3D& vPos, const float flMaxDist, const int nExclude) const
+{
+	if (!m_nCount)
+		return NO_NODE;
+
+	const fltx4 xPosX = ReplicateX4(vPos.x);
+	const fltx4 xPosY = ReplicateX4(vPos.y);
+	const fltx4 xPosZ = ReplicateX4(vPos.z);
+
+	const float flMaxDistSqr = flMaxDist * flMaxDist;
+
+	float flBestDistSqr = flMaxDistSqr;
+	int nBest = NO_NODE;
+
+	const int nCellX = GetVirtualCell(vPos.x, m_flMinX);
+	const int nCellY = GetVirtualCell(vPos.y, m_flMinY);
+
+	const auto VisitCell = [&](const int nCell)
+	{
+		for (int b = m_CellStart[nCell], e = m_CellStart[nCell + 1]; b < e; b++)
+		{
+			const fltx4 xDistSqr = AI_NodeIndex_DistSqr(m_Blocks[b], xPosX, xPosY, xPosZ);
+			const int nMask = TestSignSIMD(CmpLeSIMD(xDistSqr, ReplicateX4(flBestDistSqr)));
+
+			if (!nMask)
+				continue;
+
+			ALIGN16 float flDistSqr[4] ALIGN16_POST;
+			StoreAlignedSIMD(flDistSqr, xDistSqr);
+
+			for (int l = 0; l < 4; l++)
+			{
+				const int nIndex = m_Indices[b * 4 + l];
+
+				if (!(nMask & (1 << l)) || nIndex == NO_NODE || nIndex == nExclude)
+					continue;
+
+				if (nBest == NO_NODE
+					? flDistSqr[l] < flMaxDistSqr
+					: AI_NodeIndex_IsCloser(flDistSqr[l], nIndex, flBestDistSqr, nBest))
+				{
+					flBestDistSqr = flDistSqr[l];
+					nBest = nIndex;
+				}
+			}
+		}
+	};
+
+	for (int r = GetFirstRing(nCellX, nCellY), nLastRing = GetLastRing(nCellX, nCellY); r <= nLastRing; r++)
+	{
+		// Nodes in this ring are at least this far away horizontally.
+		const float flRingDist = float(Max(r - 1, 0)) * m_flCellSize;
+
+		if (flRingDist * flRingDist > flBestDistSqr)
+			break;
+
+		ForEachCellInRing(nCellX, nCellY, r, VisitCell);
+	}
+
+	return nBest;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: finds the k nearest nodes to position
+// Input  : &vPos      -
+//          nK         - clamped to AI_NODE_INDEX_MAX_K
+//          flMaxDist  - only nodes closer than this are considered
+//          *pIndices  - receives the node indices, nearest first
+//          *pDistSqr  - receives the squared distances (optional)
+// Output : number of nodes found
+//-----------------------------------------------------------------------------
+int CAI_NodeSpatialIndex::FindKNearest(const Vector3D& vPos, int nK, const float flMaxDist, int* pIndices, float* pDistSqr) const
+{
+	nK = Min(nK, AI_NODE_INDEX_MAX_K);
+
+	if (!m_nCount || nK <= 0)
+		return 0;
+
+	const fltx4 xPosX = ReplicateX4(vPos.x);
+	const fltx4 xPosY = ReplicateX4(vPos.y);
+	const fltx4 xPosZ = ReplicateX4(vPos.z);
+
+	const float flMaxDistSqr = flMaxDist * flMaxDist;
+
+	float flFoundDistSqr[AI_NODE_INDEX_MAX_K];
+	int nFound = 0;
+
+	// Distance a candidate has to be within, the farthest result once full.
+	float flWorstDistSqr = flMaxDistSqr;
+
+	const int nCellX = GetVirtualCell(vPos.x, m_flMinX);
+	const int nCellY = GetVirtualCell(vPos.y, m_flMinY);
+
+	const auto VisitCell = [&](const int nCell)
+	{
+		for (int b = m_CellStart[nCell], e = m_CellStart[nCell + 1]; b < e; b++)
+		{
+			const fltx4 xDistSqr = AI_NodeIndex_DistSqr(m_Blocks[b], xPosX, xPosY, xPosZ);
+			const int nMask = TestSignSIMD(CmpLeSIMD(xDistSqr, ReplicateX4(flWorstDistSqr)));
+
+			if (!nMask)
+				continue;
+
+			ALIGN16 float flDistSqr[4] ALIGN16_POST;
+			StoreAlignedSIMD(flDistSqr, xDistSqr);
+
+			for (int l = 0; l < 4; l++)
+			{
+				const int nIndex = m_Indices[b * 4 + l];
+
+				if (!(nMask & (1 << l)) || nIndex == NO_NODE)
+					continue;
+
+				const float flDist = flDistSqr[l];
+				int nSlot;
+
+				if (nFound < nK)
+				{
+					if (!(flDist < flMaxDistSqr))
+						continue;
+
+					nSlot = nFound++;
+				}
+				else
+				{
+					if (!AI_NodeIndex_IsCloser(flDist, nIndex, flFoundDistSqr[nK - 1], pIndices[nK - 1]))
+						continue;
+
+					nSlot = nK - 1; // Replaces the farthest.
+				}
+
+				// Insertion sort, k is small.
+				for (; nSlot > 0 && AI_NodeIndex_IsCloser(flDist, nIndex, flFoundDistSqr[nSlot - 1], pIndices[nSlot - 1]); nSlot--)
+				{
+					flFoundDistSqr[nSlot] = flFoundDistSqr[nSlot - 1];
+					pIndices[nSlot] = pIndices[nSlot - 1];
+				}
+
+				flFoundDistSqr[nSlot] = flDist;
+				pIndices[nSlot] = nIndex;
+
+				if (nFound == nK)
+					flWorstDistSqr = flFoundDistSqr[nK - 1];
+			}
+		}
+	};
+
+	for (int r = GetFirstRing(nCellX, nCellY), nLastRing = GetLastRing(nCellX, nCellY); r <= nLastRing; r++)
+	{
+		const float flRingDist = float(Max(r - 1, 0)) * m_flCellSize;
+
+		if (flRingDist * flRingDist > flWorstDistSqr)
+			break;
+
+		ForEachCellInRing(nCellX, nCellY, r, VisitCell);
+	}
+
+	if (pDistSqr)
+		memcpy(pDistSqr, flFoundDistSqr, nFound * sizeof(float));
+
+	return nFound;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: finds all nodes within radius of position
+// Input  : &vPos     -
+//          flRadius  -
+//          &results  - node indices are appended to this, in no particular order
+// Output : number of nodes found
+//-----------------------------------------------------------------------------
+int CAI_NodeSpatialIndex::FindInRadius(const Vector3D& vPos, const float flRadius, CUtlVector<int>& results) const
+{
+	if (!m_nCount || flRadius < 0.0f)
+		return 0;
+
+	const int nMinX = Max(GetVirtualCell(vPos.x - flRadius, m_flMinX), 0);
+	const int nMaxX = Min(GetVirtualCell(vPos.x + flRadius, m_flMinX), m_nCellsX - 1);
+	const int nMinY = Max(GetVirtualCell(vPos.y - flRadius, m_flMinY), 0);
+	const int nMaxY = Min(GetVirtualCell(vPos.y + flRadius, m_flMinY), m_nCellsY - 1);
+
+	const fltx4 xPosX = ReplicateX4(vPos.x);
+	const fltx4 xPosY = ReplicateX4(vPos.y);
+	const fltx4 xPosZ = ReplicateX4(vPos.z);
+	const fltx4 xRadiusSqr = ReplicateX4(flRadius * flRadius);
+
+	const int nOldCount = results.Count();
+
+	for (int y = nMinY; y <= nMaxY; y++)
+	{
+		for (int x = nMinX; x <= nMaxX; x++)
+		{
+			const int nCell = x + y * m_nCellsX;
+
+			for (int b = m_CellStart[nCell], e = m_CellStart[nCell + 1]; b < e; b++)
+			{
+				const fltx4 xDistSqr = AI_NodeIndex_DistSqr(m_Blocks[b], xPosX, xPosY, xPosZ);
+				const int nMask = TestSignSIMD(CmpLeSIMD(xDistSqr, xRadiusSqr));
+
+				for (int l = 0; l < 4; l++)
+				{
+					const int nIndex = m_Indices[b * 4 + l];
+
+					if ((nMask & (1 << l)) && nIndex != NO_NODE)
+						results.AddToTail(nIndex);
+				}
+			}
+		}
+	}
+
+	return results.Count() - nOldCount;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: builds a new index over the script nodes and publishes it, the
+//          previous index is released once its last reader is done with it
+// Input  : *pNetwork -
+//-----------------------------------------------------------------------------
+void CAI_ScriptNodeIndex::Rebuild(const CAI_Network* pNetwork)
+{
+	std::shared_ptr<CAI_NodeSpatialIndex> pIndex = std::make_shared<CAI_NodeSpatialIndex>();
+	pIndex->Build(pNetwork);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_pIndex = std::move(pIndex);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: gets the last published index
+// Output : index, nullptr if none has been built yet
+//-----------------------------------------------------------------------------
+std::shared_ptr<const CAI_NodeSpatialIndex> CAI_ScriptNodeIndex::Get() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_pIndex;
+}
+
+//-----------------------------------------------------------------------------
+CAI_ScriptNodeIndex g_AIScriptNodeIndex;
+
+//-----------------------------------------------------------------------------
+// Purpose: linear scan reference for the benchmark, mirrors FindNearest
+//-----------------------------------------------------------------------------
+static int AI_NodeIndex_BruteForceNearest(const std::vector<Vector3D>& origins, const Vector3D& vPos, const float flMaxDist)
+{
+	float flBestDistSqr = flMaxDist * flMaxDist;
+	int nBest = NO_NODE;
+
+	for (int i = 0, n = int(origins.size()); i < n; i++)
+	{
+		const Vector3D vDelta = origins[i] - vPos;
+		const float flDistSqr = vDelta.x * vDelta.x + (vDelta.y * vDelta.y + vDelta.z * vDelta.z);
+
+		if (flDistSqr < flBestDistSqr)
+		{
+			flBestDistSqr = flDistSqr;
+			nBest = i;
+		}
+	}
+
+	return nBest;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: benchmarks the spatial index against a linear scan on a synthetic
+//          network; nodes are clustered on a few floors like a real map
+//-----------------------------------------------------------------------------
+static void AI_NodeIndexBenchmark_f(const CCommand& args)
+{
+	const int nNodes = args.ArgC() > 1 ? Clamp(atoi(args.Arg(1)), 1, 1000000) : 50000;
+	const int nQueries = args.ArgC() > 2 ? Clamp(atoi(args.Arg(2)), 1, 1000000) : 10000;
+
+	const float flMapExtent = 16384.0f;
+	const float flMaxDist = 800.0f;
+	const float flRadius = 512.0f;
+	const int nK = 8;
+
+	std::mt19937 rng(1);
+	std::uniform_real_distribution<float> mapDist(-flMapExtent, flMapExtent);
+	std::normal_distribution<float> clusterDist(0.0f, 1500.0f);
+
+	Vector3D vClusters[64];
+
+	for (Vector3D& vCluster : vClusters)
+		vCluster.Init(mapDist(rng), mapDist(rng), 0.0f);
+
+	std::vector<Vector3D> origins(nNodes);
+
+	for (int i = 0; i < nNodes; i++)
+	{
+		const float flFloor = float(rng() % 4) * 256.0f;
+
+		if (rng() % 10 < 6)
+		{
+			const Vector3D& vCluster = vClusters[rng() % ARRAYSIZE(vClusters)];
+			origins[i].Init(vCluster.x + clusterDist(rng), vCluster.y + clusterDist(rng), flFloor);
+		}
+		else
+			origins[i].Init(mapDist(rng), mapDist(rng), flFloor);
+	}
+
+	std::vector<Vector3D> queries(nQueries);
+
+	for (int i = 0; i < nQueries; i++)
+	{
+		// Half of the queries near a node, like script node lookups.
+		if (i & 1)
+			queries[i] = origins[rng() % nNodes] + Vector3D(float(rng() % 200) - 100.0f, float(rng() % 200) - 100.0f, 32.0f);
+		else
+			queries[i].Init(mapDist(rng), mapDist(rng), float(rng() % 1024));
+	}
+
+	CAI_NodeSpatialIndex index;
+
+	double flStart = Plat_FloatTime();
+	index.Build(origins.data(), nNodes, sizeof(Vector3D));
+	const double flBuildTime = Plat_FloatTime() - flStart;
+
+	std::vector<int> bruteResults(nQueries);
+	std::vector<int> indexResults(nQueries);
+
+	flStart = Plat_FloatTime();
+	for (int i = 0; i < nQueries; i++)
+		bruteResults[i] = AI_NodeIndex_BruteForceNearest(origins, queries[i], flMaxDist);
+	const double flBruteTime = Plat_FloatTime() - flStart;
+
+	flStart = Plat_FloatTime();
+	for (int i = 0; i < nQueries; i++)
+		indexResults[i] = index.FindNearest(queries[i], flMaxDist);
+	const double flNearestTime = Plat_FloatTime() - flStart;
+
+	int nMismatches = 0;
+
+	for (int i = 0; i < nQueries; i++)
+		nMismatches += bruteResults[i] != indexResults[i];
+
+	int nKIndices[AI_NODE_INDEX_MAX_K];
+	int64_t nKFound = 0;
+
+	flStart = Plat_FloatTime();
+	for (int i = 0; i < nQueries; i++)
+		nKFound += index.FindKNearest(queries[i], nK, FLT_MAX, nKIndices);
+	const double flKNearestTime = Plat_FloatTime() - flStart;
+
+	CUtlVector<int> radiusResults;
+	int64_t nRadiusFound = 0;
+
+	flStart = Plat_FloatTime();
+	for (int i = 0; i < nQueries; i++)
+	{
+		radiusResults.RemoveAll();
+		nRadiusFound += index.FindInRadius(queries[i], flRadius, radiusResults);
+	}
+	const double flRadiusTime = Plat_FloatTime() - flStart;
+
+	Msg(eDLL_T::SERVER, "%s: %d nodes, built in %.3f ms\n", __FUNCTION__, nNodes, flBuildTime * 1000.0);
+	Msg(eDLL_T::SERVER, "  linear nearest: %8.3f us/query\n", flBruteTime * 1e6 / nQueries);
+	Msg(eDLL_T::SERVER, "  index nearest : %8.3f us/query (%d mismatches)\n", flNearestTime * 1e6 / nQueries, nMismatches);
+	Msg(eDLL_T::SERVER, "  index %d-NN   : %8.3f us/query (%.1f avg found)\n", nK, flKNearestTime * 1e6 / nQueries, double(nKFound) / nQueries);
+	Msg(eDLL_T::SERVER, "  index radius  : %8.3f us/query (%.1f avg found within %.0f)\n", flRadiusTime * 1e6 / nQueries, double(nRadiusFound) / nQueries, flRadius);
+
+	if (nMismatches)
+		Warning(eDLL_T::SERVER, "%s: nearest node results differ from the linear scan!\n", __FUNCTION__);
+}
+
+static ConCommand ai_nodeIndexBenchmark("ai_nodeIndexBenchmark", AI_NodeIndexBenchmark_f, "Benchmarks the AI node spatial index on a synthetic network", FCVAR_DEVELOPMENTONLY, nullptr, "ai_nodeIndexBenchmark <numNodes> <numQueries>");
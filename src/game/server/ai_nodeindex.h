@@ -0,0 +1,91 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include "mathlib/ssemath.h"
+#include "game/server/ai_node.h"
+
+class CAI_Network;
+
+constexpr int   AI_NODE_INDEX_CELL_TARGET   = 8;       // Average nodes per occupied cell the grid is sized for.
+constexpr int   AI_NODE_INDEX_MAX_CELLS     = 1 << 20; // Cell size grows until the grid fits within this.
+constexpr float AI_NODE_INDEX_MIN_CELL_SIZE = 64.0f;
+constexpr int   AI_NODE_INDEX_MAX_K         = 64;      // Max results of a k-nearest query.
+
+//-----------------------------------------------------------------------------
+// CAI_NodeSpatialIndex
+//
+// Purpose: Uniform 2D grid over node origins, for nearest, k-nearest and
+//          radius queries without scanning the whole network. Origins are
+//          stored per cell in SoA blocks of 4 (padded with sentinels), so
+//          each block is tested with a single SIMD distance evaluation.
+//          Positions are copied on build; rebuild when the nodes change.
+//-----------------------------------------------------------------------------
+class CAI_NodeSpatialIndex
+{
+public:
+	CAI_NodeSpatialIndex();
+
+	void Build(const Vector3D* pOrigins, const int nCount, const size_t nStride);
+	void Build(const CAI_Network* pNetwork);
+	void Clear();
+
+	bool IsBuiltFor(const CAI_Network* pNetwork) const;
+	inline int GetCount() const { return m_nCount; }
+
+	int FindNearest(const Vector3D& vPos, const float flMaxDist, const int nExclude = NO_NODE) const;
+	int FindKNearest(const Vector3D& vPos, int nK, const float flMaxDist, int* pIndices, float* pDistSqr = nullptr) const;
+	int FindInRadius(const Vector3D& vPos, const float flRadius, CUtlVector<int>& results) const;
+
+private:
+	struct Block_s
+	{
+		ALIGN16 float x[4] ALIGN16_POST;
+		ALIGN16 float y[4] ALIGN16_POST;
+		ALIGN16 float z[4] ALIGN16_POST;
+	};
+
+	int GetVirtualCell(const float flPos, const float flMin) const;
+	int GetFirstRing(const int nCellX, const int nCellY) const;
+	int GetLastRing(const int nCellX, const int nCellY) const;
+
+	template <typename Functor>
+	void ForEachCellInRing(const int nCellX, const int nCellY, const int nRing, Functor fnVisit) const;
+
+	float m_flMinX;
+	float m_flMinY;
+	float m_flCellSize;
+	float m_flInvCellSize;
+
+	int m_nCellsX;
+	int m_nCellsY;
+	int m_nCount;
+
+	std::vector<int> m_CellStart; // First block of each cell, with a trailing end entry.
+	std::vector<Block_s> m_Blocks;
+	std::vector<int> m_Indices;   // Node index per block lane, NO_NODE for padding.
+
+	// Source of the last build from a network, see IsBuiltFor.
+	const CAI_Network* m_pNetwork;
+	const CAI_ScriptNode* m_pScriptNodes;
+};
+
+//-----------------------------------------------------------------------------
+// CAI_ScriptNodeIndex
+//
+// Purpose: Publishes the index over the script nodes of the network. It is
+//          only rebuilt on the server thread when a network is loaded or
+//          built; readers on any thread (e.g. the debug overlay) hold on to
+//          the last published index, which is never modified afterwards.
+//-----------------------------------------------------------------------------
+class CAI_ScriptNodeIndex
+{
+public:
+	void Rebuild(const CAI_Network* pNetwork);
+	std::shared_ptr<const CAI_NodeSpatialIndex> Get() const;
+
+private:
+	mutable std::mutex m_Mutex; // Only guards swapping the published index.
+	std::shared_ptr<const CAI_NodeSpatialIndex> m_pIndex;
+};
+
+extern CAI_ScriptNodeIndex g_AIScriptNodeIndex;
@@ -33,67 +33,20 @@
 	██╔══╝  ╚██╗ ██╔╝██╔══╝  ██║╚██╗██║   ██║     ██║╚██╔╝██║██╔══╝  ╚════██║╚════██║██╔══██║██║   ██║██╔══╝  ╚════██║
 	███████╗ ╚████╔╝ ███████╗██║ ╚████║   ██║     ██║ ╚═╝ ██║███████╗███████║███████║██║  ██║╚██████╔╝███████╗███████║
 	╚══════╝  ╚═══╝  ╚══════╝╚═╝  ╚═══╝   ╚═╝     ╚═╝     ╚═╝╚══════╝╚══════╝╚══════╝╚═╝  ╚═╝ ╚═════╝ ╚══════╝╚══════╝
-	NOTE: messages are statically allocated to save on runtime overhead, each message is cleared after usage.
+	NOTE: messages are created in the arena of a recycled LiveAPI work item, the arena is reset once the event got processed.
 */
 
-static rtech::liveapi::AmmoUsed s_ammoUsed;
-static rtech::liveapi::ArenasItemDeselected s_arenasItemDeselected;
-static rtech::liveapi::ArenasItemSelected s_arenasItemSelected;
-static rtech::liveapi::BannerCollected s_bannerCollected;
-static rtech::liveapi::BlackMarketAction s_blackMarketAction;
-//static rtech::liveapi::ChangeCamera s_changeCamera;
-static rtech::liveapi::CharacterSelected s_characterSelected;
-//static rtech::liveapi::CustomMatch_CreateLobby s_customMatch_CreateLobby;
-//static rtech::liveapi::CustomMatch_GetLobbyPlayers s_customMatch_GetLobbyPlayers;
-//static rtech::liveapi::CustomMatch_GetSettings s_customMatch_GetSettings;
-//static rtech::liveapi::CustomMatch_JoinLobby s_customMatch_JoinLobby;
-//static rtech::liveapi::CustomMatch_KickPlayer s_customMatch_KickPlayer;
-//static rtech::liveapi::CustomMatch_LeaveLobby s_customMatch_LeaveLobby;
-//static rtech::liveapi::CustomMatch_LobbyPlayers s_customMatch_LobbyPlayers;
-//static rtech::liveapi::CustomMatch_SendChat s_customMatch_SendChat;
-//static rtech::liveapi::CustomMatch_SetMatchmaking s_customMatch_SetMatchmaking;
-//static rtech::liveapi::CustomMatch_SetReady s_customMatch_SetReady;
-//static rtech::liveapi::CustomMatch_SetSettings s_customMatch_SetSettings;
-//static rtech::liveapi::CustomMatch_SetTeam s_customMatch_SetTeam;
-//static rtech::liveapi::CustomMatch_SetTeamName s_customMatch_SetTeamName;
-static rtech::liveapi::CustomEvent s_customEvent;
-static rtech::liveapi::GameStateChanged s_gameStateChanged;
-static rtech::liveapi::GibraltarShieldAbsorbed s_gibraltarShieldAbsorbed;
-static rtech::liveapi::GrenadeThrown s_grenadeThrown;
-static rtech::liveapi::Init s_init;
-static rtech::liveapi::InventoryDrop s_inventoryDrop;
-static rtech::liveapi::InventoryPickUp s_inventoryPickUp;
-static rtech::liveapi::InventoryUse s_inventoryUse;
-static rtech::liveapi::LegendUpgradeSelected s_legendUpgradeSelected;
-static rtech::liveapi::LiveAPIEvent s_liveAPIEvent;
-static rtech::liveapi::MatchSetup s_matchSetup;
-static rtech::liveapi::MatchStateEnd s_matchStateEnd;
-static rtech::liveapi::ObserverAnnotation s_observerAnnotation;
-static rtech::liveapi::ObserverSwitched s_observerSwitched;
-//static rtech::liveapi::PauseToggle s_pauseToggle;
-static rtech::liveapi::PlayerAbilityUsed s_playerAbilityUsed;
-static rtech::liveapi::PlayerAssist s_playerAssist;
-static rtech::liveapi::PlayerConnected s_playerConnected;
-static rtech::liveapi::PlayerDamaged s_playerDamaged;
-static rtech::liveapi::PlayerDisconnected s_playerDisconnected;
-static rtech::liveapi::PlayerDowned s_playerDowned;
-static rtech::liveapi::PlayerKilled s_playerKilled;
-static rtech::liveapi::PlayerRespawnTeam s_playerRespawnTeam;
-static rtech::liveapi::PlayerRevive s_playerRevive;
-static rtech::liveapi::PlayerStatChanged s_playerStatChanged;
-static rtech::liveapi::PlayerUpgradeTierChanged s_playerUpgradeTierChanged;
-//static rtech::liveapi::Request s_request;
-//static rtech::liveapi::RequestStatus s_requestStatus;
-//static rtech::liveapi::Response s_response;
-static rtech::liveapi::RevenantForgedShadowDamaged s_revenantForgedShadowDamaged;
-static rtech::liveapi::RingFinishedClosing s_ringFinishedClosing;
-static rtech::liveapi::RingStartClosing s_ringStartClosing;
-static rtech::liveapi::SquadEliminated s_squadEliminated;
-static rtech::liveapi::WarpGateUsed s_warpGateUsed;
-static rtech::liveapi::WeaponSwitched s_weaponSwitched;
-static rtech::liveapi::WraithPortal s_wraithPortal;
-static rtech::liveapi::ZiplineUsed s_ziplineUsed;
+//-----------------------------------------------------------------------------
+// Returns the event message being built, creating it in the arena on first use
+//-----------------------------------------------------------------------------
+template<typename T>
+static T* LiveAPI_GetEventMessage(google::protobuf::Arena* const arena, google::protobuf::Message*& msg)
+{
+	if (!msg)
+		msg = google::protobuf::Arena::CreateMessage<T>(arena);
 
+	return static_cast<T*>(msg);
+}
 
 /*
 	███████╗███╗   ██╗██╗   ██╗███╗   ███╗███████╗██████╗  █████╗ ████████╗██╗ ██████╗ ███╗   ██╗███████╗
@@ -1954,19 +1907,9 @@ static bool LiveAPI_HandleCustomEvent(HSQUIRRELVM const v, const SQObject& obj,
 	╚══════╝  ╚═══╝  ╚══════╝╚═╝  ╚═══╝   ╚═╝     ╚═════╝ ╚═╝╚══════╝╚═╝     ╚═╝  ╚═╝   ╚═╝    ╚═════╝╚═╝  ╚═╝╚══════╝╚═╝  ╚═╝
 */
 
-static void LiveAPI_SendEvent(const google::protobuf::Message* const msg)
-{
-	s_liveAPIEvent.set_event_size(msg->ByteSize());
-	s_liveAPIEvent.mutable_gamemessage()->PackFrom(*msg);
-
-	LiveAPISystem()->LogEvent(&s_liveAPIEvent, &s_liveAPIEvent.gamemessage());
-	s_liveAPIEvent.Clear();
-}
-
-static bool LiveAPI_HandleEventByCategory(HSQUIRRELVM const v, const SQTable* const table, const eLiveAPI_EventTypes eventType)
+static bool LiveAPI_BuildEventByCategory(HSQUIRRELVM const v, const SQTable* const table, const eLiveAPI_EventTypes eventType,
+	google::protobuf::Arena* const arena, google::protobuf::Message*& msg)
 {
-	google::protobuf::Message* msg = nullptr;
-
 	SQ_FOR_EACH_TABLE(table, i)
 	{
 		const SQTable::_HashNode& node = table->_nodes[i];
@@ -1985,156 +1928,118 @@ static bool LiveAPI_HandleEventByCategory(HSQUIRRELVM const v, const SQTable* co
 		switch (eventType)
 		{
 		case eLiveAPI_EventTypes::init:
-			msg = &s_init;
-			ret = LiveAPI_HandleInitEvent(&s_init, eventType);
+			ret = LiveAPI_HandleInitEvent(LiveAPI_GetEventMessage<rtech::liveapi::Init>(arena, msg), eventType);
 			break;
 		case eLiveAPI_EventTypes::matchSetup:
-			msg = &s_matchSetup;
-			ret = LiveAPI_HandleMatchSetup(v, obj, &s_matchSetup, eventType, fieldNum);
+			ret = LiveAPI_HandleMatchSetup(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::MatchSetup>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::ammoUsed:
-			msg = &s_ammoUsed;
-			ret = LiveAPI_HandleAmmoUsed(v, obj, &s_ammoUsed, eventType, fieldNum);
+			ret = LiveAPI_HandleAmmoUsed(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::AmmoUsed>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::arenasItemDeselected:
-			msg = &s_arenasItemDeselected;
-			ret = LiveAPI_HandleInventoryChange(v, obj, &s_arenasItemDeselected, eventType, fieldNum);
+			ret = LiveAPI_HandleInventoryChange(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::ArenasItemDeselected>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::arenasItemSelected:
-			msg = &s_arenasItemSelected;
-			ret = LiveAPI_HandleInventoryChange(v, obj, &s_arenasItemSelected, eventType, fieldNum);
+			ret = LiveAPI_HandleInventoryChange(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::ArenasItemSelected>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::bannerCollected:
-			msg = &s_bannerCollected;
-			ret = LiveAPI_HandleBannerCollected(v, obj, &s_bannerCollected, eventType, fieldNum);
+			ret = LiveAPI_HandleBannerCollected(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::BannerCollected>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::customEvent:
-			msg = &s_customEvent;
-			ret = LiveAPI_HandleCustomEvent(v, obj, &s_customEvent, eventType, fieldNum);
+			ret = LiveAPI_HandleCustomEvent(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::CustomEvent>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::inventoryPickUp:
-			msg = &s_inventoryPickUp;
-			ret = LiveAPI_HandleInventoryChange(v, obj, &s_inventoryPickUp, eventType, fieldNum);
+			ret = LiveAPI_HandleInventoryChange(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::InventoryPickUp>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::inventoryDrop:
-			msg = &s_inventoryDrop;
-			ret = LiveAPI_HandleInventoryDrop(v, obj, &s_inventoryDrop, eventType, fieldNum);
+			ret = LiveAPI_HandleInventoryDrop(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::InventoryDrop>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::inventoryUse:
-			msg = &s_inventoryUse;
-			ret = LiveAPI_HandleInventoryChange(v, obj, &s_inventoryUse, eventType, fieldNum);
+			ret = LiveAPI_HandleInventoryChange(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::InventoryUse>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::gameStateChanged:
-			msg = &s_gameStateChanged;
-			ret = LiveAPI_HandleGameStateChanged(v, obj, &s_gameStateChanged, eventType, fieldNum);
+			ret = LiveAPI_HandleGameStateChanged(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::GameStateChanged>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::matchStateEnd:
-			msg = &s_matchStateEnd;
-			ret = LiveAPI_HandleMatchStateEnd(v, obj, &s_matchStateEnd, eventType, fieldNum);
+			ret = LiveAPI_HandleMatchStateEnd(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::MatchStateEnd>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::characterSelected:
-			msg = &s_characterSelected;
-			ret = LiveAPI_HandleSimplePlayerMessage(v, obj, &s_characterSelected, eventType, fieldNum);
+			ret = LiveAPI_HandleSimplePlayerMessage(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::CharacterSelected>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::warpGateUsed:
-			msg = &s_warpGateUsed;
-			ret = LiveAPI_HandleSimplePlayerMessage(v, obj, &s_warpGateUsed, eventType, fieldNum);
+			ret = LiveAPI_HandleSimplePlayerMessage(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::WarpGateUsed>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::wraithPortal:
-			msg = &s_wraithPortal;
-			ret = LiveAPI_HandleSimplePlayerMessage(v, obj, &s_wraithPortal, eventType, fieldNum);
+			ret = LiveAPI_HandleSimplePlayerMessage(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::WraithPortal>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerConnected:
-			msg = &s_playerConnected;
-			ret = LiveAPI_HandleSimplePlayerMessage(v, obj, &s_playerConnected, eventType, fieldNum);
+			ret = LiveAPI_HandleSimplePlayerMessage(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerConnected>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerRevive:
-			msg = &s_playerRevive;
-			ret = LiveAPI_HandlePlayerRevive(v, obj, &s_playerRevive, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerRevive(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerRevive>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerDisconnected:
-			msg = &s_playerDisconnected;
-			ret = LiveAPI_HandlePlayerDisconnected(v, obj, &s_playerDisconnected, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerDisconnected(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerDisconnected>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerDamaged:
-			msg = &s_playerDamaged;
-			ret = LiveAPI_HandlePlayerDamaged(v, obj, &s_playerDamaged, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerDamaged(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerDamaged>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerDowned:
-			msg = &s_playerDowned;
-			ret = LiveAPI_HandlePlayerDowned(v, obj, &s_playerDowned, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerDowned(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerDowned>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerKilled:
-			msg = &s_playerKilled;
-			ret = LiveAPI_HandlePlayerKilled(v, obj, &s_playerKilled, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerKilled(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerKilled>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerAssist:
-			msg = &s_playerAssist;
-			ret = LiveAPI_HandlePlayerAssist(v, obj, &s_playerAssist, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerAssist(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerAssist>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerRespawnTeam:
-			msg = &s_playerRespawnTeam;
-			ret = LiveAPI_HandlePlayerRespawnTeam(v, obj, &s_playerRespawnTeam, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerRespawnTeam(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerRespawnTeam>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerStatChanged:
-			msg = &s_playerStatChanged;
-			ret = LiveAPI_HandlePlayerStatChanged(v, obj, &s_playerStatChanged, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerStatChanged(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerStatChanged>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerUpgradeTierChanged:
-			msg = &s_playerUpgradeTierChanged;
-			ret = LiveAPI_HandlePlayerUpgradeTierChanged(v, obj, &s_playerUpgradeTierChanged, eventType, fieldNum);
+			ret = LiveAPI_HandlePlayerUpgradeTierChanged(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerUpgradeTierChanged>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::legendUpgradeSelected:
-			msg = &s_legendUpgradeSelected;
-			ret = LiveAPI_HandleLegendUpgradeSelected(v, obj, &s_legendUpgradeSelected, eventType, fieldNum);
+			ret = LiveAPI_HandleLegendUpgradeSelected(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::LegendUpgradeSelected>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::gibraltarShieldAbsorbed:
-			msg = &s_gibraltarShieldAbsorbed;
-			ret = LiveAPI_HandleAbilityDamaged(v, obj, &s_gibraltarShieldAbsorbed, eventType, fieldNum);
+			ret = LiveAPI_HandleAbilityDamaged(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::GibraltarShieldAbsorbed>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::revenantForgedShadowDamaged:
-			msg = &s_revenantForgedShadowDamaged;
-			ret = LiveAPI_HandleAbilityDamaged(v, obj, &s_revenantForgedShadowDamaged, eventType, fieldNum);
+			ret = LiveAPI_HandleAbilityDamaged(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::RevenantForgedShadowDamaged>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::ringStartClosing:
-			msg = &s_ringStartClosing;
-			ret = LiveAPI_HandleDeathFieldStartClosing(v, obj, &s_ringStartClosing, eventType, fieldNum);
+			ret = LiveAPI_HandleDeathFieldStartClosing(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::RingStartClosing>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::ringFinishedClosing:
-			msg = &s_ringFinishedClosing;
-			ret = LiveAPI_HandleRingFinishedClosing(v, obj, &s_ringFinishedClosing, eventType, fieldNum);
+			ret = LiveAPI_HandleRingFinishedClosing(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::RingFinishedClosing>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::squadEliminated:
-			msg = &s_squadEliminated;
-			ret = LiveAPI_HandleSquadEliminated(v, obj, &s_squadEliminated, eventType, fieldNum);
+			ret = LiveAPI_HandleSquadEliminated(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::SquadEliminated>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::ziplineUsed:
-			msg = &s_ziplineUsed;
-			ret = LiveAPI_HandleLinkedEntityEvent(v, obj, &s_ziplineUsed, eventType, fieldNum);
+			ret = LiveAPI_HandleLinkedEntityEvent(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::ZiplineUsed>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::grenadeThrown:
-			msg = &s_grenadeThrown;
-			ret = LiveAPI_HandleLinkedEntityEvent(v, obj, &s_grenadeThrown, eventType, fieldNum);
+			ret = LiveAPI_HandleLinkedEntityEvent(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::GrenadeThrown>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::playerAbilityUsed:
-			msg = &s_playerAbilityUsed;
-			ret = LiveAPI_HandleLinkedEntityEvent(v, obj, &s_playerAbilityUsed, eventType, fieldNum);
+			ret = LiveAPI_HandleLinkedEntityEvent(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::PlayerAbilityUsed>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::weaponSwitched:
-			msg = &s_weaponSwitched;
-			ret = LiveAPI_HandleWeaponSwitchedEvent(v, obj, &s_weaponSwitched, eventType, fieldNum);
+			ret = LiveAPI_HandleWeaponSwitchedEvent(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::WeaponSwitched>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::blackMarketAction:
-			msg = &s_blackMarketAction;
-			ret = LiveAPI_HandleBlackMarketActionEvent(v, obj, &s_blackMarketAction, eventType, fieldNum);
+			ret = LiveAPI_HandleBlackMarketActionEvent(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::BlackMarketAction>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::observerSwitched:
-			msg = &s_observerSwitched;
-			ret = LiveAPI_HandleObserverSwitched(v, obj, &s_observerSwitched, eventType, fieldNum);
+			ret = LiveAPI_HandleObserverSwitched(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::ObserverSwitched>(arena, msg), eventType, fieldNum);
 			break;
 		case eLiveAPI_EventTypes::observerAnnotation:
-			msg = &s_observerAnnotation;
-			ret = LiveAPI_HandleObserverAnnotation(v, obj, &s_observerAnnotation, eventType, fieldNum);
+			ret = LiveAPI_HandleObserverAnnotation(v, obj, LiveAPI_GetEventMessage<rtech::liveapi::ObserverAnnotation>(arena, msg), eventType, fieldNum);
 			break;
 		default:
 			v_SQVM_RaiseError(v, "Event type \"%d\" not found.", eventType);
@@ -2142,12 +2047,7 @@ static bool LiveAPI_HandleEventByCategory(HSQUIRRELVM const v, const SQTable* co
 		}
 
 		if (!ret)
-		{
-			Assert(msg);
-
-			msg->Clear();
 			return false;
-		}
 	}
 
 	if (!msg) // Script bug, e.g. giving an empty table (either completely empty or filled with null)
@@ -2156,8 +2056,23 @@ static bool LiveAPI_HandleEventByCategory(HSQUIRRELVM const v, const SQTable* co
 		return false;
 	}
 
-	LiveAPI_SendEvent(msg);
-	msg->Clear();
+	return true;
+}
+
+static bool LiveAPI_HandleEventByCategory(HSQUIRRELVM const v, const SQTable* const table, const eLiveAPI_EventTypes eventType)
+{
+	LiveAPIQueuedEvent_s* const item = LiveAPISystem()->AllocEvent();
+	google::protobuf::Message* msg = nullptr;
+
+	if (!LiveAPI_BuildEventByCategory(v, table, eventType, &item->arena, msg))
+	{
+		LiveAPISystem()->ReleaseEvent(item);
+		return false;
+	}
+
+	// Ownership goes to the LiveAPI system, the item is recycled afterwards.
+	item->message = msg;
+	LiveAPISystem()->LogEvent(item);
 
 	return true;
 }
@@ -17,6 +17,7 @@
 #include "game/server/ai_utility.h"
 #include "game/server/ai_networkmanager.h"
 #include "game/server/ai_network.h"
+#include "game/server/ai_nodeindex.h"
 #include "game/client/viewrender.h"
 #include "thirdparty/recast/Shared/Include/SharedCommon.h"
 #include "thirdparty/recast/Detour/Include/DetourNavMesh.h"
@@ -24,6 +25,9 @@
 static ConVar ai_script_nodes_draw_range("ai_script_nodes_draw_range", "0", FCVAR_DEVELOPMENTONLY, "Debug draw AIN script nodes ranging from shift index to this cvar");
 static ConVar ai_script_nodes_draw_nearest("ai_script_nodes_draw_nearest", "1", FCVAR_DEVELOPMENTONLY, "Debug draw AIN script node links to nearest node (build order is used if null)");
 
+// Nodes farther away than this are never considered nearest.
+static constexpr float AI_NEAREST_NODE_MAX_DIST = 800.0f;
+
 static ConVar navmesh_debug_type("navmesh_debug_type", "0", FCVAR_DEVELOPMENTONLY, "NavMesh debug draw hull index", true, 0.f, true, 4.f, nullptr, "0 = small, 1 = med_short, 2 = medium, 3 = large, 4 = extra large");
 static ConVar navmesh_debug_tile_range("navmesh_debug_tile_range", "0", FCVAR_DEVELOPMENTONLY, "NavMesh debug draw tiles ranging from shift index to this cvar", true, 0.f, false, 0.f);
 static ConVar navmesh_debug_camera_range("navmesh_debug_camera_range", "2000", FCVAR_DEVELOPMENTONLY, "Only debug draw tiles within this distance from camera origin", true, 0.f, false, 0.f);
@@ -148,7 +152,8 @@ void CAI_Utility::DrawAIScriptNetwork(
 
         if (bDrawNearest) // Render links to the nearest node.
         {
-            int nNearest = GetNearestNodeToPos(pNetwork, &pScriptNode->m_vOrigin);
+            // Exclude the node itself, as it is always the nearest.
+            int nNearest = GetNearestNodeToPos(pNetwork, &pScriptNode->m_vOrigin, i);
             if (nNearest != NO_NODE) // NO_NODE = -1
             {
                 shortx8 packedLinks = PackNodeLink(i, nNearest);
@@ -612,112 +617,40 @@ bool CAI_Utility::IsTileWithinRange(const dtMeshTile* pTile, const VPlane& vPlan
 // Purpose: gets the nearest node index to position
 // Input  : *pAINetwork - 
 //          *vPos       - 
+//          nExclude    - node index to skip
 // Output : node index ('NO_NODE' if no node has been found)
 //------------------------------------------------------------------------------
-int CAI_Utility::GetNearestNodeToPos(const CAI_Network* pAINetwork, const Vector3D* vPos) const
+int CAI_Utility::GetNearestNodeToPos(const CAI_Network* pAINetwork, const Vector3D* vPos, const int nExclude) const
 {
-    int result; // rax
-    unsigned int v3; // er10
-    __int64 v4; // rdx
-    float v5; // xmm3_4
-    unsigned int v6; // er8
-    CAI_ScriptNode* v7; // rax
-    float v8; // xmm4_4
-    float v9; // xmm5_4
-    float v10; // xmm6_4
-    float* v11; // rcx
-    float* v12; // rax
-    float v13; // xmm7_4
-    float v14; // xmm2_4
-    unsigned int v15; // er9
-    float v16; // xmm8_4
-    float v17; // xmm2_4
-    unsigned int v18; // er8
-    float v19; // xmm9_4
-    float v20; // xmm2_4
-    unsigned int v21; // er9
-    float v22; // xmm7_4
-    float v23; // xmm2_4
-    float* v24; // r9
-    float v25; // xmm4_4
-    float v26; // xmm2_4
-    unsigned int v27; // ecx
-
-    if (pAINetwork)
+    if (!pAINetwork)
+        return NO_NODE;
+
+    // The index is only rebuilt on the server thread when the network is
+    // loaded or built, as this is also called from the render thread. If
+    // the script nodes were changed since, scan them instead.
+    const std::shared_ptr<const CAI_NodeSpatialIndex> pIndex = g_AIScriptNodeIndex.Get();
+
+    if (pIndex && pIndex->IsBuiltFor(pAINetwork))
+        return pIndex->FindNearest(*vPos, AI_NEAREST_NODE_MAX_DIST, nExclude);
+
+    float flBestDistSqr = AI_NEAREST_NODE_MAX_DIST * AI_NEAREST_NODE_MAX_DIST;
+    int nBest = NO_NODE;
+
+    for (int i = 0; i < pAINetwork->m_iNumScriptNodes; i++)
     {
-        v3 = pAINetwork->m_iNumScriptNodes;
-        v4 = 0i64;
-        v5 = 640000.0;
-        v6 = (unsigned int)NO_NODE;
-        if (v3 >= 4)
-        {
-            v7 = pAINetwork->m_ScriptNode;
-            v8 = vPos->x;
-            v9 = vPos->y;
-            v10 = vPos->z;
-            v11 = &v7->m_vOrigin.z;
-            v12 = &v7[1].m_vOrigin.y;
-            do
-            {
-                v13 = v5;
-                v14 = (float)((float)((float)(*(v11 - 1) - v9) * (float)(*(v11 - 1) - v9)) + (float)((float)(*(v11 - 2) - v8) * (float)(*(v11 - 2) - v8))) + (float)((float)(*v11 - v10) * (float)(*v11 - v10));
-                if (v5 > v14)
-                    v5 = (float)((float)((float)(*(v11 - 1) - v9) * (float)(*(v11 - 1) - v9)) + (float)((float)(*(v11 - 2) - v8) * (float)(*(v11 - 2) - v8))) + (float)((float)(*v11 - v10) * (float)(*v11 - v10));
-                v15 = (unsigned int)v4;
-                if (v13 <= v14)
-                    v15 = v6;
-                v16 = v5;
-                v17 = (float)((float)((float)(*(v12 - 1) - v9) * (float)(*(v12 - 1) - v9)) + (float)((float)(v11[3] - v8) * (float)(v11[3] - v8))) + (float)((float)(*v12 - v10) * (float)(*v12 - v10));
-                if (v5 > v17)
-                    v5 = (float)((float)((float)(*(v12 - 1) - v9) * (float)(*(v12 - 1) - v9)) + (float)((float)(v11[3] - v8) * (float)(v11[3] - v8))) + (float)((float)(*v12 - v10) * (float)(*v12 - v10));
-                v18 = (unsigned int)v4 + 1;
-                if (v16 <= v17)
-                    v18 = v15;
-                v19 = v5;
-                v20 = (float)((float)((float)(v12[4] - v9) * (float)(v12[4] - v9)) + (float)((float)(v11[8] - v8) * (float)(v11[8] - v8))) + (float)((float)(v12[5] - v10) * (float)(v12[5] - v10));
-                if (v5 > v20)
-                    v5 = (float)((float)((float)(v12[4] - v9) * (float)(v12[4] - v9)) + (float)((float)(v11[8] - v8) * (float)(v11[8] - v8))) + (float)((float)(v12[5] - v10) * (float)(v12[5] - v10));
-                v21 = (unsigned int)v4 + 2;
-                if (v19 <= v20)
-                    v21 = v18;
-                v22 = v5;
-                v23 = (float)((float)((float)(v12[9] - v9) * (float)(v12[9] - v9)) + (float)((float)(v11[13] - v8) * (float)(v11[13] - v8))) + (float)((float)(v12[10] - v10) * (float)(v12[10] - v10));
-                if (v5 > v23)
-                    v5 = (float)((float)((float)(v12[9] - v9) * (float)(v12[9] - v9)) + (float)((float)(v11[13] - v8) * (float)(v11[13] - v8))) + (float)((float)(v12[10] - v10) * (float)(v12[10] - v10));
-                v6 = (unsigned int)v4 + 3;
-                if (v22 <= v23)
-                    v6 = v21;
-                v11 += 20;
-                v12 += 20;
-                v4 = (unsigned int)(v4 + 4);
-            } while ((unsigned int)v4 < v3 - 3);
-        }
-        if ((unsigned int)v4 < v3)
+        if (i == nExclude)
+            continue;
+
+        const float flDistSqr = pAINetwork->m_ScriptNode[i].m_vOrigin.DistToSqr(*vPos);
+
+        if (flDistSqr < flBestDistSqr)
         {
-            v24 = &pAINetwork->m_ScriptNode->m_vOrigin.x + 5 * v4;
-            do
-            {
-                v25 = v5;
-                v26 = (float)((float)((float)(v24[1] - vPos->y) * (float)(v24[1] - vPos->y)) + (float)((float)(*v24 - vPos->x) * (float)(*v24 - vPos->x)))
-                    + (float)((float)(v24[2] - vPos->z) * (float)(v24[2] - vPos->z));
-                if (v5 > v26)
-                    v5 = (float)((float)((float)(v24[1] - vPos->y) * (float)(v24[1] - vPos->y)) + (float)((float)(*v24 - vPos->x) * (float)(*v24 - vPos->x)))
-                    + (float)((float)(v24[2] - vPos->z) * (float)(v24[2] - vPos->z));
-                v27 = (unsigned int)v4;
-                if (v25 <= v26)
-                    v27 = v6;
-                v24 += 5;
-                LODWORD(v4) = (unsigned int)v4 + 1;
-                v6 = v27;
-            } while ((unsigned int)v4 < v3);
+            flBestDistSqr = flDistSqr;
+            nBest = i;
         }
-        result = v6;
     }
-    else
-    {
-        result = NULL;
-    }
-    return result;
+
+    return nBest;
 }
 
 CAI_Utility g_AIUtility;
@@ -343,3 +343,29 @@ int rcGetChunksOverlappingSegment(const rcChunkyTriMesh* cm,
 	
 	return n;
 }
+
+bool rcChunksOverlapSegment(const rcChunkyTriMesh* cm,
+							float p[2], float q[2])
+{
+	// Traverse tree
+	int i = 0;
+	while (i < cm->nnodes)
+	{
+		const rcChunkyTriMeshNode* node = &cm->nodes[i];
+		const bool overlap = checkOverlapSegment(p, q, node->bmin, node->bmax);
+		const bool isLeafNode = node->i >= 0;
+
+		if (isLeafNode && overlap)
+			return true;
+
+		if (overlap || isLeafNode)
+			i++;
+		else
+		{
+			const int escapeIndex = -node->i;
+			i += escapeIndex;
+		}
+	}
+
+	return false;
+}
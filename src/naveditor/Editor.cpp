@@ -28,11 +28,15 @@
 #include "NavEditor/Include/GameUtils.h"
 #include "NavEditor/Include/InputGeom.h"
 #include "NavEditor/Include/Editor.h"
+#include "NavEditor/Include/PerfTimer.h"
 
 #include "game/server/ai_navmesh.h"
 #include "game/server/ai_hull.h"
 #include "coordsize.h"
 
+#include <thread>
+#include <atomic>
+
 unsigned int EditorDebugDraw::areaToCol(unsigned int area)
 {
 	switch(area)
@@ -473,6 +477,9 @@ void Editor::handleCommonSettings()
 	if (ImGui::SliderFloat("Extra Offset", &m_traverseRayExtraOffset, 0, 128))
 		m_traverseLinkDrawParams.extraOffset = m_traverseRayExtraOffset;
 
+	if (m_geom && ImGui::Button("Benchmark Traverse Raycasts"))
+		m_geom->benchmarkRaycastMesh(m_ctx, 100000);
+
 	ImGui::Separator();
 }
 
@@ -817,224 +824,120 @@ static const int s_traverseAnimTraverseFlags[TraverseAnimType_e::ANIMTYPE_COUNT]
 	0000003000, // ANIMTYPE_GOLIATH // Doesn't exist in MSET 5
 };
 
-// TODO: create lookup table and look for distance + slope to determine the
-// correct jumpType.
-// TODO: make sure we don't generate duplicate pairs of jump types between
-// 2 polygons.
-void Editor::connectTileTraverseLinks(dtMeshTile* const baseTile, const bool linkToNeighbor)
+static unsigned char getBestTraverseTypeForLink(void* userData, const float traverseDist, const float elevation,
+	const float /*slopeAngle*/, const bool /*baseOverlaps*/, const bool /*landOverlaps*/, const bool samePolyGroup)
 {
-	// If we link to the same tile, we need at least 2 links.
-	if (!baseTile->linkCountAvailable(linkToNeighbor ? 1 : 2))
-		return;
+	const Editor* editor = (const Editor*)userData;
+	const TraverseType_e traverseType = GetBestTraverseType(elevation, dtQuantLinkDistance(traverseDist), samePolyGroup);
 
-	const dtMeshHeader* baseHeader = baseTile->header;
-	const dtPolyRef basePolyRefBase = m_navMesh->getPolyRefBase(baseTile);
+	if (traverseType == DT_NULL_TRAVERSE_TYPE)
+		return DT_NULL_TRAVERSE_TYPE;
 
-	bool firstBaseTileLinkUsed = false;
+	const NavMeshType_e navMeshType = editor->getSelectedNavMeshType();
 
-	for (int i = 0; i < baseHeader->polyCount; ++i)
+	if (navMeshType > NavMeshType_e::NAVMESH_SMALL)
 	{
-		dtPoly* const basePoly = &baseTile->polys[i];
+		const int traverseTableIndex = NavMesh_GetFirstTraverseAnimTypeForType(navMeshType);
+		const bool traverseTypeSupported = rdBitCellBit(traverseType) & s_traverseAnimTraverseFlags[traverseTableIndex];
 
-		if (basePoly->groupId == DT_UNLINKED_POLY_GROUP)
-			continue;
+		if (!traverseTypeSupported)
+			return DT_NULL_TRAVERSE_TYPE;
+	}
 
-		for (int j = 0; j < basePoly->vertCount; ++j)
-		{
-			// Hard edges only!
-			if (basePoly->neis[j] != 0)
-				continue;
+	return (unsigned char)traverseType;
+}
 
-			// Polygon 1 edge
-			const float* const basePolySpos = &baseTile->verts[basePoly->verts[j] * 3];
-			const float* const basePolyEpos = &baseTile->verts[basePoly->verts[(j + 1) % basePoly->vertCount] * 3];
+static bool traverseLinkInLOSForLink(void* userData, const float* lowerEdgeMid, const float* higherEdgeMid,
+	const float* lowerEdgeDir, const float* higherEdgeDir, const float walkableRadius, const float slopeAngle)
+{
+	Editor* editor = (Editor*)userData;
 
-			float basePolyEdgeMid[3];
-			rdVsad(basePolyEdgeMid, basePolySpos, basePolyEpos, 0.5f);
+	const float maxAngle = rdCalcMaxLOSAngle(walkableRadius, editor->getCellHeight());
+	const float offsetAmount = rdCalcLedgeSpanOffsetAmount(walkableRadius, slopeAngle, maxAngle);
 
-			unsigned char baseSide = rdClassifyPointInsideBounds(basePolyEdgeMid, baseHeader->bmin, baseHeader->bmax);
-			const int MAX_NEIS = 32; // Max neighbors
+	return traverseLinkInLOS(editor->getInputGeom(), lowerEdgeMid, higherEdgeMid, lowerEdgeDir, higherEdgeDir, offsetAmount);
+}
 
-			dtMeshTile* neis[MAX_NEIS];
-			int nneis;
+static unsigned int* findFromPolyMap(void* userData, const dtPolyRef basePolyRef, const dtPolyRef landPolyRef)
+{
+	Editor* editor = (Editor*)userData;
+	std::map<TraverseLinkPolyPair, unsigned int>& polyMap = editor->getTraverseLinkPolyMap();
 
-			if (linkToNeighbor) // Retrieve the neighboring tiles on the side of our base poly edge.
-				nneis = m_navMesh->getNeighbourTilesAt(baseHeader->x, baseHeader->y, baseSide, neis, MAX_NEIS);
-			else
-			{
-				// Internal links.
-				nneis = 1;
-				neis[0] = baseTile;
-			}
+	auto it = polyMap.find(TraverseLinkPolyPair(basePolyRef, landPolyRef));
 
-			for (int k = 0; k < nneis; ++k)
-			{
-				dtMeshTile* landTile = neis[k];
-				const bool sameTile = baseTile == landTile;
+	if (it == polyMap.end())
+		return nullptr;
+
+	return &it->second;
+}
 
-				// Don't connect to same tile edges yet, leave that for the second pass.
-				if (linkToNeighbor && sameTile)
-					continue;
+static int addToPolyMap(void* userData, const dtPolyRef basePolyRef, const dtPolyRef landPolyRef, const unsigned int traverseTypeBit)
+{
+	Editor* editor = (Editor*)userData;
+	std::map<TraverseLinkPolyPair, unsigned int>& polyMap = editor->getTraverseLinkPolyMap();
 
-				// Skip same polygon.
-				if (sameTile && i == k)
-					continue;
+	const auto ret = polyMap.emplace(TraverseLinkPolyPair(basePolyRef, landPolyRef), traverseTypeBit);
+	return ret.second ? 0 : 1;
+}
 
-				if (!landTile->linkCountAvailable(1))
-					continue;
+void Editor::createTraverseLinkParams(dtTraverseLinkConnectParams& params)
+{
+	params.getTraverseType = &getBestTraverseTypeForLink;
+	params.traverseLinkInLOS = &traverseLinkInLOSForLink;
+	params.findPolyLink = &findFromPolyMap;
+	params.addPolyLink = &addToPolyMap;
+	params.userData = this;
+	params.minEdgeOverlap = m_traverseEdgeMinOverlap;
+	params.linkToNeighbor = true;
+}
 
-				const dtMeshHeader* landHeader = landTile->header;
-				const dtPolyRef landPolyRefBase = m_navMesh->getPolyRefBase(landTile);
+void Editor::connectTileTraverseLinks(dtMeshTile* const baseTile, const bool linkToNeighbor)
+{
+	dtTraverseLinkConnectParams params;
+	createTraverseLinkParams(params);
 
-				bool firstLandTileLinkUsed = false;
+	params.linkToNeighbor = linkToNeighbor;
+	m_navMesh->connectTraverseLinks(m_navMesh->getTileRef(baseTile), params);
+}
 
-				for (int m = 0; m < landHeader->polyCount; ++m)
-				{
-					dtPoly* const landPoly = &landTile->polys[m];
+void Editor::connectTraverseLinks(const dtTileRef* tileRefs, const int tileRefCount, const bool linkToNeighbor)
+{
+	if (!tileRefCount)
+		return;
 
-					if (landPoly->groupId == DT_UNLINKED_POLY_GROUP)
-						continue;
+	dtTraverseLinkConnectParams params;
+	createTraverseLinkParams(params);
 
-					for (int n = 0; n < landPoly->vertCount; ++n)
-					{
-						if (landPoly->neis[n] != 0)
-							continue;
+	params.linkToNeighbor = linkToNeighbor;
 
-						// We need at least 2 links available, figure out if
-						// we link to the same tile or another one.
-						if (linkToNeighbor)
-						{
-							if (firstLandTileLinkUsed && !landTile->linkCountAvailable(1))
-								continue;
+	std::vector<rdTempVector<dtTraverseLinkCandidate>> candidates(tileRefCount);
 
-							else if (firstBaseTileLinkUsed && !baseTile->linkCountAvailable(1))
-								return;
-						}
-						else if (firstBaseTileLinkUsed && !baseTile->linkCountAvailable(2))
-							return;
-
-						// Polygon 2 edge
-						const float* const landPolySpos = &landTile->verts[landPoly->verts[n] * 3];
-						const float* const landPolyEpos = &landTile->verts[landPoly->verts[(n + 1) % landPoly->vertCount] * 3];
-
-						float landPolyEdgeMid[3];
-						rdVsad(landPolyEdgeMid, landPolySpos, landPolyEpos, 0.5f);
-
-						const float dist = dtCalcLinkDistance(basePolyEdgeMid, landPolyEdgeMid);
-						const unsigned char quantDist = dtQuantLinkDistance(dist);
-
-						if (quantDist == 0)
-							continue; // Link distance is greater than maximum supported.
-
-						float baseEdgeDir[3], landEdgeDir[3];
-						rdVsub(baseEdgeDir, basePolyEpos, basePolySpos);
-						rdVsub(landEdgeDir, landPolyEpos, landPolySpos);
-
-						const float dotProduct = rdVdot(baseEdgeDir, landEdgeDir);
-
-						// Edges facing the same direction should not be linked.
-						// Doing so causes links to go through from underneath
-						// geometry. E.g. we have an HVAC on a roof, and we try
-						// to link our roof poly edge facing north to the edge
-						// of the poly on the HVAC also facing north, the link
-						// will go through the HVAC and thus cause the NPC to
-						// jump through it.
-						// Another case where this is necessary is when having
-						// a land edge that connects with the base edge, this
-						// prevents the algorithm from establishing a parallel
-						// traverse link.
-						if (dotProduct > 0)
-							continue;
-
-						const float elevation = rdMathFabsf(basePolyEdgeMid[2]-landPolyEdgeMid[2]);
-						const bool samePolyGroup = basePoly->groupId == landPoly->groupId;
-
-						const TraverseType_e traverseType = GetBestTraverseType(elevation, quantDist, samePolyGroup);
-
-						if (traverseType == DT_NULL_TRAVERSE_TYPE)
-							continue;
-
-						if (m_selectedNavMeshType > NavMeshType_e::NAVMESH_SMALL)
-						{
-							const int traverseTableIndex = NavMesh_GetFirstTraverseAnimTypeForType(m_selectedNavMeshType);
-							const bool traverseTypeSupported = rdBitCellBit(traverseType) & s_traverseAnimTraverseFlags[traverseTableIndex];
-
-							if (!traverseTypeSupported)
-								continue;
-						}
-
-						const dtPolyRef basePolyRef = basePolyRefBase | i;
-						const dtPolyRef landPolyRef = landPolyRefBase | l;
-
-						const TraverseLinkPolyPair linkedPolyPair(basePolyRef, landPolyRef);
-						auto linkedIt = m_traverseLinkPolyMap.find(linkedPolyPair);
-
-						bool traverseLinkFound = false;
-
-						if (linkedIt != m_traverseLinkPolyMap.end())
-							traverseLinkFound = true;
-
-						// These 2 polygons are already linked with the same traverse type.
-						if (traverseLinkFound && (rdBitCellBit(traverseType) & linkedIt->second))
-							continue;
-
-						const bool basePolyHigher = basePolyEdgeMid[2] > landPolyEdgeMid[2];
-						float* const lowerEdgeMid = basePolyHigher ? landPolyEdgeMid : basePolyEdgeMid;
-						float* const higherEdgeMid = basePolyHigher ? basePolyEdgeMid : landPolyEdgeMid;
-						float* const lowerEdgeDir = basePolyHigher ? landEdgeDir : baseEdgeDir;
-						float* const higherEdgeDir = basePolyHigher ? baseEdgeDir : landEdgeDir;
-
-						const float walkableRadius = basePolyHigher ? baseHeader->walkableRadius : landHeader->walkableRadius;
-
-						const float slopeAngle = rdMathFabsf(rdCalcSlopeAngle(basePolyEdgeMid, landPolyEdgeMid));
-						const float maxAngle = rdCalcMaxLOSAngle(walkableRadius, m_cellHeight);
-						const float offsetAmount = rdCalcLedgeSpanOffsetAmount(walkableRadius, slopeAngle, maxAngle);
-
-						if (!traverseLinkInLOS(m_geom, lowerEdgeMid, higherEdgeMid, lowerEdgeDir, higherEdgeDir, offsetAmount))
-							continue;
-
-						const unsigned char landSide = linkToNeighbor
-							? rdClassifyPointOutsideBounds(landPolyEdgeMid, landHeader->bmin, landHeader->bmax)
-							: rdClassifyPointInsideBounds(landPolyEdgeMid, landHeader->bmin, landHeader->bmax);
-
-						const unsigned int forwardIdx = baseTile->allocLink();
-						const unsigned int reverseIdx = landTile->allocLink();
-
-						// Allocated 2 new links, need to check for enough space on subsequent runs.
-						// This optimization saves a lot of time generating navmeshes for larger or
-						// more complicated geometry.
-						firstBaseTileLinkUsed = true;
-						firstLandTileLinkUsed = true;
-
-						dtLink* const forwardLink = &baseTile->links[forwardIdx];
-
-						forwardLink->ref = landPolyRef;
-						forwardLink->edge = (unsigned char)j;
-						forwardLink->side = landSide;
-						forwardLink->bmin = 0;
-						forwardLink->bmax = 255;
-						forwardLink->next = basePoly->firstLink;
-						basePoly->firstLink = forwardIdx;
-						forwardLink->traverseType = (unsigned char)traverseType;
-						forwardLink->traverseDist = quantDist;
-						forwardLink->reverseLink = (unsigned short)reverseIdx;
-
-						dtLink* const reverseLink = &landTile->links[reverseIdx];
-
-						reverseLink->ref = basePolyRef;
-						reverseLink->edge = (unsigned char)m;
-						reverseLink->side = baseSide;
-						reverseLink->bmin = 0;
-						reverseLink->bmax = 255;
-						reverseLink->next = landPoly->firstLink;
-						landPoly->firstLink = reverseIdx;
-						reverseLink->traverseType = (unsigned char)traverseType;
-						reverseLink->traverseDist = quantDist;
-						reverseLink->reverseLink = (unsigned short)forwardIdx;
-					}
-				}
-			}
-		}
+	const int threadCount = rdClamp((int)std::thread::hardware_concurrency(), 1, tileRefCount);
+	std::atomic<int> nextTile(0);
+
+	// Searching for links only reads the navmesh and the input geometry, so
+	// do this for all tiles concurrently as the raycasts are very expensive.
+	auto findWorker = [&]()
+	{
+		for (int i = nextTile++; i < tileRefCount; i = nextTile++)
+			m_navMesh->findTraverseLinks(tileRefs[i], params, candidates[i]);
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount);
+
+	for (int i = 0; i < threadCount; i++)
+		workers.emplace_back(findWorker);
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	// Commit the links in tile order, this respects the link budgets of
+	// each tile in the same way a serial build would.
+	for (int i = 0; i < tileRefCount; i++)
+	{
+		const rdTempVector<dtTraverseLinkCandidate>& tileCandidates = candidates[i];
+		m_navMesh->commitTraverseLinks(tileRefs[i], params, tileCandidates.data(), tileCandidates.size());
 	}
 }
 
@@ -1044,28 +947,53 @@ bool Editor::createTraverseLinks()
 	m_traverseLinkPolyMap.clear();
 
 	const int maxTiles = m_navMesh->getMaxTiles();
+	std::vector<dtTileRef> tileRefs;
 
-	// First pass to connect edges between external tiles together.
 	for (int i = 0; i < maxTiles; i++)
 	{
-		dtMeshTile* baseTile = m_navMesh->getTile(i);
+		const dtMeshTile* baseTile = m_navMesh->getTile(i);
 		if (!baseTile || !baseTile->header)
 			continue;
 
-		connectTileTraverseLinks(baseTile, true);
+		tileRefs.push_back(m_navMesh->getTileRef(baseTile));
 	}
 
+	return updateTraverseLinks(tileRefs.data(), (int)tileRefs.size());
+}
+
+bool Editor::updateTraverseLinks(const dtTileRef* tileRefs, const int tileRefCount)
+{
+	rdAssert(m_navMesh);
+
+	// First pass to connect edges between external tiles together.
+	connectTraverseLinks(tileRefs, tileRefCount, true);
+
 	// Second pass to use remaining links to connect internal edges on the same tile together.
-	for (int i = 0; i < maxTiles; i++)
+	connectTraverseLinks(tileRefs, tileRefCount, false);
+
+	return true;
+}
+
+// Drops the polygon pairs of a removed or rebuilt tile from the traverse link
+// map, so the pairs are available again when links are created for the tile.
+void Editor::removeTraverseLinkPolyPairs(const dtTileRef tileRef)
+{
+	rdAssert(m_navMesh);
+	const unsigned int tileId = m_navMesh->decodePolyIdTile(tileRef);
+
+	for (auto it = m_traverseLinkPolyMap.cbegin(); it != m_traverseLinkPolyMap.cend();)
 	{
-		dtMeshTile* baseTile = m_navMesh->getTile(i);
-		if (!baseTile || !baseTile->header)
+		const TraverseLinkPolyPair& pair = it->first;
+
+		if (m_navMesh->decodePolyIdTile(pair.poly1) == tileId ||
+			m_navMesh->decodePolyIdTile(pair.poly2) == tileId)
+		{
+			it = m_traverseLinkPolyMap.erase(it);
 			continue;
+		}
 
-		connectTileTraverseLinks(baseTile, false);
+		++it;
 	}
-
-	return true;
 }
 
 bool Editor::createStaticPathingData(const dtTraverseTableCreateParams* params)
@@ -1099,12 +1027,19 @@ bool Editor::updateStaticPathingData(const dtTraverseTableCreateParams* params)
 		return false;
 	}
 
+	const TimeVal tableBuildStart = getPerfTime();
+
 	if (!dtCreateTraverseTableData(params))
 	{
 		m_ctx->log(RC_LOG_ERROR, "updateStaticPathingData: Failed to build traverse table data.");
 		return false;
 	}
 
+	const TimeVal tableBuildEnd = getPerfTime();
+
+	m_ctx->log(RC_LOG_PROGRESS, ">> Traverse tables: %d tables  %d poly groups  %.2fms",
+		params->tableCount, params->nav->getPolyGroupCount(), getPerfTimeUsec(tableBuildEnd-tableBuildStart)/1000.0f);
+
 	return true;
 }
 
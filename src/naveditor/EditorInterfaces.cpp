@@ -125,6 +125,11 @@ const char* BuildContext::getLogText(const int i) const
 	return m_messages[i]+1;
 }
 
+rcLogCategory BuildContext::getLogCategory(const int i) const
+{
+	return (rcLogCategory)m_messages[i][0];
+}
+
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
 class GLCheckerTexture
@@ -37,6 +37,10 @@
 #include "game/server/ai_hull.h"
 #include "coordsize.h"
 
+#include <thread>
+#include <atomic>
+#include <mutex>
+
 
 #ifdef DT_POLYREF64
 const static int MAX_POLYREF_CHARS = 22;
@@ -682,7 +686,13 @@ void Editor_TileMesh::buildTile(const float* pos)
 	unsigned char* data = buildTileMesh(tx, ty, m_lastBuiltTileBmin, m_lastBuiltTileBmax, dataSize);
 
 	// Remove any previous data (navmesh owns and deletes the data).
-	m_navMesh->removeTile(m_navMesh->getTileRefAt(tx,ty,0),0,0);
+	const dtTileRef oldTileRef = m_navMesh->getTileRefAt(tx,ty,0);
+
+	if (dtStatusSucceed(m_navMesh->removeTile(oldTileRef,0,0)))
+	{
+		// The links of the old tile are gone, release its polygon pairs.
+		removeTraverseLinkPolyPairs(oldTileRef);
+	}
 
 	// Add tile, or leave the location empty.
 	if (data)
@@ -735,14 +745,9 @@ void Editor_TileMesh::buildTile(const float* pos)
 				}
 			}
 
-			// Reconnect the traverse links.
-			dtTraverseLinkConnectParams params;
-			createTraverseLinkParams(params);
-
-			params.linkToNeighbor = false;
-			m_navMesh->connectTraverseLinks(tileRef, params);
-			params.linkToNeighbor = true;
-			m_navMesh->connectTraverseLinks(tileRef, params);
+			// Reconnect the traverse links, only the rebuilt tile has to be
+			// processed as the links are always created in pairs.
+			updateTraverseLinks(&tileRef, 1);
 
 			buildStaticPathingData();
 		}
@@ -792,21 +797,7 @@ void Editor_TileMesh::removeTile(const float* pos)
 	{
 		// Update traverse link map so the next time we rebuild this
 		// tile, the polygon pairs will be marked as available.
-		const unsigned int tileId = m_navMesh->decodePolyIdTile(tileRef);
-
-		for (auto it = m_traverseLinkPolyMap.cbegin(); it != m_traverseLinkPolyMap.cend();)
-		{
-			const TraverseLinkPolyPair& pair = it->first;
-
-			if (m_navMesh->decodePolyIdTile(pair.poly1) == tileId || 
-				m_navMesh->decodePolyIdTile(pair.poly2) == tileId)
-			{
-				it = m_traverseLinkPolyMap.erase(it);
-				continue;
-			}
-
-			++it;
-		}
+		removeTraverseLinkPolyPairs(tileRef);
 
 		buildStaticPathingData();
 	}
@@ -828,14 +819,74 @@ void Editor_TileMesh::buildAllTiles()
 	// Start the build process.
 	m_ctx->startTimer(RC_TIMER_TEMP);
 
+	// Intermediate results are only kept around for single tile builds.
+	cleanup();
+
+	const int tileCount = tw*th;
+	std::vector<TileMeshBuildResult> results(tileCount);
+
+	const int threadCount = rdClamp((int)std::thread::hardware_concurrency(), 1, tileCount);
+	std::vector<BuildContext> contexts(threadCount);
+	std::atomic<int> nextTile(0);
+	std::mutex logMutex;
+
+	// Tile meshes are independent from each other, so build them all
+	// concurrently; each thread owns its own build context and scratch
+	// data and fetches the next tile from the grid when it is done.
+	auto buildWorker = [&](const int threadIndex)
+	{
+		BuildContext& context = contexts[threadIndex];
+
+		TileMeshBuildData build;
+		build.ctx = &context;
+		build.keepInterResults = false;
+
+		for (int i = nextTile++; i < tileCount; i = nextTile++)
+		{
+			const int x = i % tw;
+			const int y = i / tw;
+
+			float tileBmin[3], tileBmax[3];
+			getTileExtents(x, y, tileBmin, tileBmax);
+
+			TileMeshBuildResult& result = results[i];
+			result.data = buildTileMesh(build, x, y, tileBmin, tileBmax, result.dataSize);
+
+			result.tileTriCount = build.tileTriCount;
+			result.tileMemUsage = build.tileMemUsage;
+			result.tileBuildTime = build.tileBuildTime;
+
+			// Forward the log of this tile to the main context, and reset
+			// the thread's log so it never fills up over a large build.
+			{
+				std::lock_guard<std::mutex> lock(logMutex);
+
+				for (int j = 0; j < context.getLogCount(); j++)
+					m_ctx->log(context.getLogCategory(j), "%s", context.getLogText(j));
+			}
+
+			context.resetLog();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount);
+
+	for (int i = 0; i < threadCount; i++)
+		workers.emplace_back(buildWorker, i);
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	// Add the tiles in grid order so the resulting navmesh is identical
+	// to one built on a single thread.
 	for (int y = 0; y < th; ++y)
 	{
 		for (int x = 0; x < tw; ++x)
 		{
-			getTileExtents(x, y, m_lastBuiltTileBmin, m_lastBuiltTileBmax);
-			
-			int dataSize = 0;
-			unsigned char* data = buildTileMesh(x, y, m_lastBuiltTileBmin, m_lastBuiltTileBmax, dataSize);
+			const TileMeshBuildResult& result = results[y*tw+x];
+			unsigned char* data = result.data;
+
 			if (data)
 			{
 				// Remove any previous data (navmesh owns and deletes the data).
@@ -843,7 +894,7 @@ void Editor_TileMesh::buildAllTiles()
 				// Let the navmesh own the data.
 
 				dtTileRef tileRef = 0;
-				dtStatus status = m_navMesh->addTile(data,dataSize,DT_TILE_FREE_DATA,0,&tileRef);
+				dtStatus status = m_navMesh->addTile(data,result.dataSize,DT_TILE_FREE_DATA,0,&tileRef);
 				if (dtStatusFailed(status))
 					rdFree(data);
 				else
@@ -852,6 +903,18 @@ void Editor_TileMesh::buildAllTiles()
 		}
 	}
 
+	// The overlay shows the stats of the last built tile.
+	if (tileCount > 0)
+	{
+		const TileMeshBuildResult& lastResult = results[tileCount-1];
+
+		m_tileTriCount = lastResult.tileTriCount;
+		m_tileMemUsage = lastResult.tileMemUsage;
+		m_tileBuildTime = lastResult.tileBuildTime;
+	}
+
+	getTileExtents(tw-1, th-1, m_lastBuiltTileBmin, m_lastBuiltTileBmax);
+
 	connectOffMeshLinks();
 	createTraverseLinks();
 
@@ -905,18 +968,92 @@ void Editor_TileMesh::buildAllHulls()
 	}
 }
 
+TileMeshBuildData::TileMeshBuildData() :
+	ctx(0),
+	triareas(0),
+	solid(0),
+	chf(0),
+	cset(0),
+	pmesh(0),
+	dmesh(0),
+	tileTriCount(0),
+	tileMemUsage(0),
+	tileBuildTime(0),
+	keepInterResults(false)
+{
+	memset(&cfg, 0, sizeof(cfg));
+}
+
+TileMeshBuildData::~TileMeshBuildData()
+{
+	cleanup();
+}
+
+void TileMeshBuildData::cleanup()
+{
+	delete[] triareas;
+	triareas = 0;
+	rcFreeHeightField(solid);
+	solid = 0;
+	rcFreeCompactHeightfield(chf);
+	chf = 0;
+	rcFreeContourSet(cset);
+	cset = 0;
+	rcFreePolyMesh(pmesh);
+	pmesh = 0;
+	rcFreePolyMeshDetail(dmesh);
+	dmesh = 0;
+}
+
+void TileMeshBuildData::release()
+{
+	triareas = 0;
+	solid = 0;
+	chf = 0;
+	cset = 0;
+	pmesh = 0;
+	dmesh = 0;
+}
+
 unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const float* bmin, const float* bmax, int& dataSize)
+{
+	cleanup();
+
+	TileMeshBuildData build;
+	build.ctx = m_ctx;
+	build.keepInterResults = m_keepInterResults;
+
+	unsigned char* navData = buildTileMesh(build, tx, ty, bmin, bmax, dataSize);
+
+	// Hand the intermediate results over to the editor so they can be rendered.
+	m_triareas = build.triareas;
+	m_solid = build.solid;
+	m_chf = build.chf;
+	m_cset = build.cset;
+	m_pmesh = build.pmesh;
+	m_dmesh = build.dmesh;
+	m_cfg = build.cfg;
+
+	m_tileTriCount = build.tileTriCount;
+	m_tileMemUsage = build.tileMemUsage;
+	m_tileBuildTime = build.tileBuildTime;
+
+	build.release();
+	return navData;
+}
+
+unsigned char* Editor_TileMesh::buildTileMesh(TileMeshBuildData& build, const int tx, const int ty, const float* bmin, const float* bmax, int& dataSize)
 {
 	if (!m_geom || !m_geom->getMesh() || !m_geom->getChunkyMesh())
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Input mesh is not specified.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Input mesh is not specified.");
 		return 0;
 	}
 	
-	m_tileMemUsage = 0;
-	m_tileBuildTime = 0;
+	build.tileMemUsage = 0;
+	build.tileBuildTime = 0;
 	
-	cleanup();
+	build.cleanup();
 	
 	const float* verts = m_geom->getMesh()->getVerts();
 	const int nverts = m_geom->getMesh()->getVertCount();
@@ -924,24 +1061,24 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 	const rcChunkyTriMesh* chunkyMesh = m_geom->getChunkyMesh();
 		
 	// Init build configuration from GUI
-	memset(&m_cfg, 0, sizeof(m_cfg));
-	m_cfg.cs = m_cellSize;
-	m_cfg.ch = m_cellHeight;
-	m_cfg.walkableSlopeAngle = m_agentMaxSlope;
-	m_cfg.walkableHeight = (int)ceilf(m_agentHeight / m_cfg.ch);
-	m_cfg.walkableClimb = (int)floorf(m_agentMaxClimb / m_cfg.ch);
-	m_cfg.walkableRadius = (int)ceilf(m_agentRadius / m_cfg.cs);
-	m_cfg.maxEdgeLen = (int)(m_edgeMaxLen / m_cellSize);
-	m_cfg.maxSimplificationError = m_edgeMaxError;
-	m_cfg.minRegionArea = rdSqr(m_regionMinSize);		// Note: area = size*size
-	m_cfg.mergeRegionArea = rdSqr(m_regionMergeSize);	// Note: area = size*size
-	m_cfg.maxVertsPerPoly = (int)m_vertsPerPoly;
-	m_cfg.tileSize = m_tileSize;
-	m_cfg.borderSize = m_cfg.walkableRadius + 3; // Reserve enough padding.
-	m_cfg.width = m_cfg.tileSize + m_cfg.borderSize*2;
-	m_cfg.height = m_cfg.tileSize + m_cfg.borderSize*2;
-	m_cfg.detailSampleDist = m_detailSampleDist < 0.9f ? 0 : m_cellSize * m_detailSampleDist;
-	m_cfg.detailSampleMaxError = m_cellHeight * m_detailSampleMaxError;
+	memset(&build.cfg, 0, sizeof(build.cfg));
+	build.cfg.cs = m_cellSize;
+	build.cfg.ch = m_cellHeight;
+	build.cfg.walkableSlopeAngle = m_agentMaxSlope;
+	build.cfg.walkableHeight = (int)ceilf(m_agentHeight / build.cfg.ch);
+	build.cfg.walkableClimb = (int)floorf(m_agentMaxClimb / build.cfg.ch);
+	build.cfg.walkableRadius = (int)ceilf(m_agentRadius / build.cfg.cs);
+	build.cfg.maxEdgeLen = (int)(m_edgeMaxLen / m_cellSize);
+	build.cfg.maxSimplificationError = m_edgeMaxError;
+	build.cfg.minRegionArea = rdSqr(m_regionMinSize);		// Note: area = size*size
+	build.cfg.mergeRegionArea = rdSqr(m_regionMergeSize);	// Note: area = size*size
+	build.cfg.maxVertsPerPoly = (int)m_vertsPerPoly;
+	build.cfg.tileSize = m_tileSize;
+	build.cfg.borderSize = build.cfg.walkableRadius + 3; // Reserve enough padding.
+	build.cfg.width = build.cfg.tileSize + build.cfg.borderSize*2;
+	build.cfg.height = build.cfg.tileSize + build.cfg.borderSize*2;
+	build.cfg.detailSampleDist = m_detailSampleDist < 0.9f ? 0 : m_cellSize * m_detailSampleDist;
+	build.cfg.detailSampleMaxError = m_cellHeight * m_detailSampleMaxError;
 	
 	// Expand the heighfield bounding box by border size to find the extents of geometry we need to build this tile.
 	//
@@ -964,58 +1101,58 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 	// For example if you build a navmesh for terrain, and want the navmesh tiles to match the terrain tile size
 	// you will need to pass in data from neighbour terrain tiles too! In a simple case, just pass in all the 8 neighbours,
 	// or use the bounding box below to only pass in a sliver of each of the 8 neighbours.
-	rdVcopy(m_cfg.bmin, bmin);
-	rdVcopy(m_cfg.bmax, bmax);
-	m_cfg.bmin[0] -= m_cfg.borderSize*m_cfg.cs;
-	m_cfg.bmin[1] -= m_cfg.borderSize*m_cfg.cs;
-	m_cfg.bmax[0] += m_cfg.borderSize*m_cfg.cs;
-	m_cfg.bmax[1] += m_cfg.borderSize*m_cfg.cs;
+	rdVcopy(build.cfg.bmin, bmin);
+	rdVcopy(build.cfg.bmax, bmax);
+	build.cfg.bmin[0] -= build.cfg.borderSize*build.cfg.cs;
+	build.cfg.bmin[1] -= build.cfg.borderSize*build.cfg.cs;
+	build.cfg.bmax[0] += build.cfg.borderSize*build.cfg.cs;
+	build.cfg.bmax[1] += build.cfg.borderSize*build.cfg.cs;
 	
 	// Reset build times gathering.
-	m_ctx->resetTimers();
+	build.ctx->resetTimers();
 	
 	// Start the build process.
-	m_ctx->startTimer(RC_TIMER_TOTAL);
+	build.ctx->startTimer(RC_TIMER_TOTAL);
 	
-	m_ctx->log(RC_LOG_PROGRESS, "Building navigation:");
-	m_ctx->log(RC_LOG_PROGRESS, " - %d x %d cells", m_cfg.width, m_cfg.height);
-	m_ctx->log(RC_LOG_PROGRESS, " - %.1fK verts, %.1fK tris", nverts/1000.0f, ntris/1000.0f);
+	build.ctx->log(RC_LOG_PROGRESS, "Building navigation:");
+	build.ctx->log(RC_LOG_PROGRESS, " - %d x %d cells", build.cfg.width, build.cfg.height);
+	build.ctx->log(RC_LOG_PROGRESS, " - %.1fK verts, %.1fK tris", nverts/1000.0f, ntris/1000.0f);
 	
 	// Allocate voxel heightfield where we rasterize our input data to.
-	m_solid = rcAllocHeightfield();
-	if (!m_solid)
+	build.solid = rcAllocHeightfield();
+	if (!build.solid)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'solid'.");
 		return 0;
 	}
-	if (!rcCreateHeightfield(m_ctx, *m_solid, m_cfg.width, m_cfg.height, m_cfg.bmin, m_cfg.bmax, m_cfg.cs, m_cfg.ch))
+	if (!rcCreateHeightfield(build.ctx, *build.solid, build.cfg.width, build.cfg.height, build.cfg.bmin, build.cfg.bmax, build.cfg.cs, build.cfg.ch))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create solid heightfield.");
 		return 0;
 	}
 	
 	// Allocate array that can hold triangle flags.
 	// If you have multiple meshes you need to process, allocate
 	// an array which can hold the max number of triangles you need to process.
-	m_triareas = new unsigned char[chunkyMesh->maxTrisPerChunk];
-	if (!m_triareas)
+	build.triareas = new unsigned char[chunkyMesh->maxTrisPerChunk];
+	if (!build.triareas)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'm_triareas' (%d).", chunkyMesh->maxTrisPerChunk);
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'triareas' (%d).", chunkyMesh->maxTrisPerChunk);
 		return 0;
 	}
 	
 	float tbmin[2], tbmax[2];
-	tbmin[0] = m_cfg.bmin[0];
-	tbmin[1] = m_cfg.bmin[1];
-	tbmax[0] = m_cfg.bmax[0];
-	tbmax[1] = m_cfg.bmax[1];
+	tbmin[0] = build.cfg.bmin[0];
+	tbmin[1] = build.cfg.bmin[1];
+	tbmax[0] = build.cfg.bmax[0];
+	tbmax[1] = build.cfg.bmax[1];
 #if 0 //NOTE(warmist): original algo
 	int cid[2048];// TODO: Make grow when returning too many items.
 	const int ncid = rcGetChunksOverlappingRect(chunkyMesh, tbmin, tbmax, cid, 2048);
 	if (!ncid)
 		return 0;
 	
-	m_tileTriCount = 0;
+	build.tileTriCount = 0;
 	
 	for (int i = 0; i < ncid; ++i)
 	{
@@ -1023,13 +1160,13 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 		const int* ctris = &chunkyMesh->tris[node.i*3];
 		const int nctris = node.n;
 		
-		m_tileTriCount += nctris;
+		build.tileTriCount += nctris;
 		
-		memset(m_triareas, 0, nctris*sizeof(unsigned char));
-		rcMarkWalkableTriangles(m_ctx, m_cfg.walkableSlopeAngle,
-								verts, nverts, ctris, nctris, m_triareas);
+		memset(build.triareas, 0, nctris*sizeof(unsigned char));
+		rcMarkWalkableTriangles(build.ctx, build.cfg.walkableSlopeAngle,
+								verts, nverts, ctris, nctris, build.triareas);
 		
-		if (!rcRasterizeTriangles(m_ctx, verts, nverts, ctris, m_triareas, nctris, *m_solid, m_cfg.walkableClimb))
+		if (!rcRasterizeTriangles(build.ctx, verts, nverts, ctris, build.triareas, nctris, *build.solid, build.cfg.walkableClimb))
 			return 0;
 	}
 #else //NOTE(warmist): algo with limited return but can be reinvoked to continue the query
@@ -1037,7 +1174,7 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 	int currentNode = 0;
 
 	bool done = false;
-	m_tileTriCount = 0;
+	build.tileTriCount = 0;
 	do{
 		int currentCount = 0;
 		done=rcGetChunksOverlappingRect(chunkyMesh, tbmin, tbmax, cid, 1024,currentCount,currentNode);
@@ -1047,68 +1184,68 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 			const int* ctris = &chunkyMesh->tris[node.i*3];
 			const int nctris = node.n;
 
-			m_tileTriCount += nctris;
+			build.tileTriCount += nctris;
 
-			memset(m_triareas, 0, nctris * sizeof(unsigned char));
-			rcMarkWalkableTriangles(m_ctx, m_cfg.walkableSlopeAngle,
-				verts, nverts, ctris, nctris, m_triareas);
+			memset(build.triareas, 0, nctris * sizeof(unsigned char));
+			rcMarkWalkableTriangles(build.ctx, build.cfg.walkableSlopeAngle,
+				verts, nverts, ctris, nctris, build.triareas);
 
-			if (!rcRasterizeTriangles(m_ctx, verts, nverts, ctris, m_triareas, nctris, *m_solid, m_cfg.walkableClimb))
+			if (!rcRasterizeTriangles(build.ctx, verts, nverts, ctris, build.triareas, nctris, *build.solid, build.cfg.walkableClimb))
 				return 0;
 		}
 	} while (!done);
 
-	if (m_tileTriCount == 0)
+	if (build.tileTriCount == 0)
 		return 0;
 #endif
-	if (!m_keepInterResults)
+	if (!build.keepInterResults)
 	{
-		delete [] m_triareas;
-		m_triareas = 0;
+		delete [] build.triareas;
+		build.triareas = 0;
 	}
 	
 	// Once all geometry is rasterized, we do initial pass of filtering to
 	// remove unwanted overhangs caused by the conservative rasterization
 	// as well as filter spans where the character cannot possibly stand.
 	if (m_filterLowHangingObstacles)
-		rcFilterLowHangingWalkableObstacles(m_ctx, m_cfg.walkableClimb, *m_solid);
+		rcFilterLowHangingWalkableObstacles(build.ctx, build.cfg.walkableClimb, *build.solid);
 	if (m_filterLedgeSpans)
-		rcFilterLedgeSpans(m_ctx, m_cfg.walkableHeight, m_cfg.walkableClimb, *m_solid);
+		rcFilterLedgeSpans(build.ctx, build.cfg.walkableHeight, build.cfg.walkableClimb, *build.solid);
 	if (m_filterWalkableLowHeightSpans)
-		rcFilterWalkableLowHeightSpans(m_ctx, m_cfg.walkableHeight, *m_solid);
+		rcFilterWalkableLowHeightSpans(build.ctx, build.cfg.walkableHeight, *build.solid);
 	
 	// Compact the heightfield so that it is faster to handle from now on.
 	// This will result more cache coherent data as well as the neighbours
 	// between walkable cells will be calculated.
-	m_chf = rcAllocCompactHeightfield();
-	if (!m_chf)
+	build.chf = rcAllocCompactHeightfield();
+	if (!build.chf)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'chf'.");
 		return 0;
 	}
-	if (!rcBuildCompactHeightfield(m_ctx, m_cfg.walkableHeight, m_cfg.walkableClimb, *m_solid, *m_chf))
+	if (!rcBuildCompactHeightfield(build.ctx, build.cfg.walkableHeight, build.cfg.walkableClimb, *build.solid, *build.chf))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build compact data.");
 		return 0;
 	}
 	
-	if (!m_keepInterResults)
+	if (!build.keepInterResults)
 	{
-		rcFreeHeightField(m_solid);
-		m_solid = 0;
+		rcFreeHeightField(build.solid);
+		build.solid = 0;
 	}
 
 	// Erode the walkable area by agent radius.
-	if (!rcErodeWalkableArea(m_ctx, m_cfg.walkableRadius, *m_chf))
+	if (!rcErodeWalkableArea(build.ctx, build.cfg.walkableRadius, *build.chf))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not erode.");
 		return 0;
 	}
 
 	// (Optional) Mark areas.
 	const ConvexVolume* vols = m_geom->getConvexVolumes();
 	for (int i  = 0; i < m_geom->getConvexVolumeCount(); ++i)
-		rcMarkConvexPolyArea(m_ctx, vols[i].verts, vols[i].nverts, vols[i].hmin, vols[i].hmax, (unsigned short)vols[i].flags, (unsigned char)vols[i].area, *m_chf);
+		rcMarkConvexPolyArea(build.ctx, vols[i].verts, vols[i].nverts, vols[i].hmin, vols[i].hmax, (unsigned short)vols[i].flags, (unsigned char)vols[i].area, *build.chf);
 	
 	
 	// Partition the heightfield so that we can use simple algorithm later to triangulate the walkable areas.
@@ -1140,16 +1277,16 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 	if (m_partitionType == EDITOR_PARTITION_WATERSHED)
 	{
 		// Prepare for region partitioning, by calculating distance field along the walkable surface.
-		if (!rcBuildDistanceField(m_ctx, *m_chf))
+		if (!rcBuildDistanceField(build.ctx, *build.chf))
 		{
-			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build distance field.");
+			build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build distance field.");
 			return 0;
 		}
 		
 		// Partition the walkable surface into simple regions without holes.
-		if (!rcBuildRegions(m_ctx, *m_chf, m_cfg.borderSize, m_cfg.minRegionArea, m_cfg.mergeRegionArea))
+		if (!rcBuildRegions(build.ctx, *build.chf, build.cfg.borderSize, build.cfg.minRegionArea, build.cfg.mergeRegionArea))
 		{
-			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build watershed regions.");
+			build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build watershed regions.");
 			return 0;
 		}
 	}
@@ -1157,118 +1294,118 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 	{
 		// Partition the walkable surface into simple regions without holes.
 		// Monotone partitioning does not need distancefield.
-		if (!rcBuildRegionsMonotone(m_ctx, *m_chf, m_cfg.borderSize, m_cfg.minRegionArea, m_cfg.mergeRegionArea))
+		if (!rcBuildRegionsMonotone(build.ctx, *build.chf, build.cfg.borderSize, build.cfg.minRegionArea, build.cfg.mergeRegionArea))
 		{
-			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build monotone regions.");
+			build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build monotone regions.");
 			return 0;
 		}
 	}
 	else // EDITOR_PARTITION_LAYERS
 	{
 		// Partition the walkable surface into simple regions without holes.
-		if (!rcBuildLayerRegions(m_ctx, *m_chf, m_cfg.borderSize, m_cfg.minRegionArea))
+		if (!rcBuildLayerRegions(build.ctx, *build.chf, build.cfg.borderSize, build.cfg.minRegionArea))
 		{
-			m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build layer regions.");
+			build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build layer regions.");
 			return 0;
 		}
 	}
 	 	
 	// Create contours.
-	m_cset = rcAllocContourSet();
-	if (!m_cset)
+	build.cset = rcAllocContourSet();
+	if (!build.cset)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'cset'.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'cset'.");
 		return 0;
 	}
-	if (!rcBuildContours(m_ctx, *m_chf, m_cfg.maxSimplificationError, m_cfg.maxEdgeLen, *m_cset))
+	if (!rcBuildContours(build.ctx, *build.chf, build.cfg.maxSimplificationError, build.cfg.maxEdgeLen, *build.cset))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create contours.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not create contours.");
 		return 0;
 	}
 
-	if (m_cset->nconts == 0)
+	if (build.cset->nconts == 0)
 	{
 		return 0;
 	}
 	
 	// Build polygon navmesh from the contours.
-	m_pmesh = rcAllocPolyMesh();
-	if (!m_pmesh)
+	build.pmesh = rcAllocPolyMesh();
+	if (!build.pmesh)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmesh'.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'pmesh'.");
 		return 0;
 	}
-	if (!rcBuildPolyMesh(m_ctx, *m_cset, m_cfg.maxVertsPerPoly, *m_pmesh))
+	if (!rcBuildPolyMesh(build.ctx, *build.cset, build.cfg.maxVertsPerPoly, *build.pmesh))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not triangulate contours.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not triangulate contours.");
 		return 0;
 	}
 	
 	// Build detail mesh.
-	m_dmesh = rcAllocPolyMeshDetail();
-	if (!m_dmesh)
+	build.dmesh = rcAllocPolyMeshDetail();
+	if (!build.dmesh)
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'dmesh'.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Out of memory 'dmesh'.");
 		return 0;
 	}
 	
-	//rcFlipPolyMesh(*m_pmesh);
-	if (!rcBuildPolyMeshDetail(m_ctx, *m_pmesh, *m_chf,
-							   m_cfg.detailSampleDist, m_cfg.detailSampleMaxError,
-							   *m_dmesh))
+	//rcFlipPolyMesh(*build.pmesh);
+	if (!rcBuildPolyMeshDetail(build.ctx, *build.pmesh, *build.chf,
+							   build.cfg.detailSampleDist, build.cfg.detailSampleMaxError,
+							   *build.dmesh))
 	{
-		m_ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build polymesh detail.");
+		build.ctx->log(RC_LOG_ERROR, "buildNavigation: Could not build polymesh detail.");
 		return 0;
 	}
 	
-	//rcFlipPolyMeshDetail(*m_dmesh,m_pmesh->nverts);
-	if (!m_keepInterResults)
+	//rcFlipPolyMeshDetail(*build.dmesh,build.pmesh->nverts);
+	if (!build.keepInterResults)
 	{
-		rcFreeCompactHeightfield(m_chf);
-		m_chf = 0;
-		rcFreeContourSet(m_cset);
-		m_cset = 0;
+		rcFreeCompactHeightfield(build.chf);
+		build.chf = 0;
+		rcFreeContourSet(build.cset);
+		build.cset = 0;
 	}
 	
 	unsigned char* navData = 0;
 	int navDataSize = 0;
-	if (m_cfg.maxVertsPerPoly <= DT_VERTS_PER_POLYGON)
+	if (build.cfg.maxVertsPerPoly <= DT_VERTS_PER_POLYGON)
 	{
-		if (m_pmesh->nverts >= 0xffff)
+		if (build.pmesh->nverts >= 0xffff)
 		{
 			// The vertex indices are ushorts, and cannot point to more than 0xffff vertices.
-			m_ctx->log(RC_LOG_ERROR, "Too many vertices per tile %d (max: %d).", m_pmesh->nverts, 0xffff);
+			build.ctx->log(RC_LOG_ERROR, "Too many vertices per tile %d (max: %d).", build.pmesh->nverts, 0xffff);
 			return 0;
 		}
 		
 		// Update poly flags from areas.
-		for (int i = 0; i < m_pmesh->npolys; ++i)
+		for (int i = 0; i < build.pmesh->npolys; ++i)
 		{
-			if (m_pmesh->areas[i] == RC_WALKABLE_AREA)
-				m_pmesh->areas[i] = EDITOR_POLYAREA_GROUND;
+			if (build.pmesh->areas[i] == RC_WALKABLE_AREA)
+				build.pmesh->areas[i] = EDITOR_POLYAREA_GROUND;
 			
-			if (m_pmesh->areas[i] == EDITOR_POLYAREA_GROUND
+			if (build.pmesh->areas[i] == EDITOR_POLYAREA_GROUND
 				//||
-				//m_pmesh->areas[i] == EDITOR_POLYAREA_GRASS ||
-				//m_pmesh->areas[i] == EDITOR_POLYAREA_ROAD
+				//build.pmesh->areas[i] == EDITOR_POLYAREA_GRASS ||
+				//build.pmesh->areas[i] == EDITOR_POLYAREA_ROAD
 				)
 			{
-				m_pmesh->flags[i] |= EDITOR_POLYFLAGS_WALK;
+				build.pmesh->flags[i] |= EDITOR_POLYFLAGS_WALK;
 			}
-			//else if (m_pmesh->areas[i] == EDITOR_POLYAREA_WATER)
+			//else if (build.pmesh->areas[i] == EDITOR_POLYAREA_WATER)
 			//{
-			//	m_pmesh->flags[i] = EDITOR_POLYFLAGS_SWIM;
+			//	build.pmesh->flags[i] = EDITOR_POLYFLAGS_SWIM;
 			//}
-			else if (m_pmesh->areas[i] == EDITOR_POLYAREA_TRIGGER)
+			else if (build.pmesh->areas[i] == EDITOR_POLYAREA_TRIGGER)
 			{
-				m_pmesh->flags[i] |= EDITOR_POLYFLAGS_WALK /*| EDITOR_POLYFLAGS_DOOR*/;
+				build.pmesh->flags[i] |= EDITOR_POLYFLAGS_WALK /*| EDITOR_POLYFLAGS_DOOR*/;
 			}
 
-			if (m_pmesh->surfa[i] <= NAVMESH_SMALL_POLYGON_THRESHOLD)
-				m_pmesh->flags[i] |= EDITOR_POLYFLAGS_TOO_SMALL;
+			if (build.pmesh->surfa[i] <= NAVMESH_SMALL_POLYGON_THRESHOLD)
+				build.pmesh->flags[i] |= EDITOR_POLYFLAGS_TOO_SMALL;
 
-			const int nvp = m_pmesh->nvp;
-			const unsigned short* p = &m_pmesh->polys[i*nvp*2];
+			const int nvp = build.pmesh->nvp;
+			const unsigned short* p = &build.pmesh->polys[i*nvp*2];
 
 			// If polygon connects to a polygon on a neighbouring tile, flag it.
 			for (int j = 0; j < nvp; ++j)
@@ -1280,26 +1417,26 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 				if ((p[nvp+j] & 0xf) == 0xf)
 					continue;
 
-				m_pmesh->flags[i] |= EDITOR_POLYFLAGS_HAS_NEIGHBOUR;
+				build.pmesh->flags[i] |= EDITOR_POLYFLAGS_HAS_NEIGHBOUR;
 			}
 		}
 		
 		dtNavMeshCreateParams params;
 		memset(&params, 0, sizeof(params));
-		params.verts = m_pmesh->verts;
-		params.vertCount = m_pmesh->nverts;
-		params.polys = m_pmesh->polys;
-		params.polyFlags = m_pmesh->flags;
-		params.polyAreas = m_pmesh->areas;
-		params.surfAreas = m_pmesh->surfa;
-		params.polyCount = m_pmesh->npolys;
-		params.nvp = m_pmesh->nvp;
+		params.verts = build.pmesh->verts;
+		params.vertCount = build.pmesh->nverts;
+		params.polys = build.pmesh->polys;
+		params.polyFlags = build.pmesh->flags;
+		params.polyAreas = build.pmesh->areas;
+		params.surfAreas = build.pmesh->surfa;
+		params.polyCount = build.pmesh->npolys;
+		params.nvp = build.pmesh->nvp;
 		params.cellResolution = m_polyCellRes;
-		params.detailMeshes = m_dmesh->meshes;
-		params.detailVerts = m_dmesh->verts;
-		params.detailVertsCount = m_dmesh->nverts;
-		params.detailTris = m_dmesh->tris;
-		params.detailTriCount = m_dmesh->ntris;
+		params.detailMeshes = build.dmesh->meshes;
+		params.detailVerts = build.dmesh->verts;
+		params.detailVertsCount = build.dmesh->nverts;
+		params.detailTris = build.dmesh->tris;
+		params.detailTriCount = build.dmesh->ntris;
 		params.offMeshConVerts = m_geom->getOffMeshConnectionVerts();
 		params.offMeshConRefPos = m_geom->getOffMeshConnectionRefPos();
 		params.offMeshConRad = m_geom->getOffMeshConnectionRads();
@@ -1317,41 +1454,41 @@ unsigned char* Editor_TileMesh::buildTileMesh(const int tx, const int ty, const
 		params.tileX = tx;
 		params.tileY = ty;
 		params.tileLayer = 0;
-		rdVcopy(params.bmin, m_pmesh->bmin);
-		rdVcopy(params.bmax, m_pmesh->bmax);
-		params.cs = m_cfg.cs;
-		params.ch = m_cfg.ch;
+		rdVcopy(params.bmin, build.pmesh->bmin);
+		rdVcopy(params.bmax, build.pmesh->bmax);
+		params.cs = build.cfg.cs;
+		params.ch = build.cfg.ch;
 		params.buildBvTree = m_buildBvTree;
 
 		const bool navMeshBuildSuccess = dtCreateNavMeshData(&params, &navData, &navDataSize);
 
 		// Restore poly areas.
-		for (int i = 0; i < m_pmesh->npolys; ++i)
+		for (int i = 0; i < build.pmesh->npolys; ++i)
 		{
 			// The game's poly area (ground) shares the same value as
 			// RC_NULL_AREA, if we try to render the recast polymesh cache
 			// without restoring this, the renderer will draw it as NULL area
 			// even though it's walkable. The other values will get color ID'd
 			// by the renderer so we don't need to check on those.
-			if (m_pmesh->areas[i] == EDITOR_POLYAREA_GROUND)
-				m_pmesh->areas[i] = RC_WALKABLE_AREA;
+			if (build.pmesh->areas[i] == EDITOR_POLYAREA_GROUND)
+				build.pmesh->areas[i] = RC_WALKABLE_AREA;
 		}
 
 		if (!navMeshBuildSuccess)
 		{
-			m_ctx->log(RC_LOG_ERROR, "Could not build Detour navmesh.");
+			build.ctx->log(RC_LOG_ERROR, "Could not build Detour navmesh.");
 			return 0;
 		}
 	}
-	m_tileMemUsage = navDataSize/1024.0f;
+	build.tileMemUsage = navDataSize/1024.0f;
 	
-	m_ctx->stopTimer(RC_TIMER_TOTAL);
+	build.ctx->stopTimer(RC_TIMER_TOTAL);
 	
 	// Show performance stats.
-	duLogBuildTimes(*m_ctx, m_ctx->getAccumulatedTime(RC_TIMER_TOTAL));
-	m_ctx->log(RC_LOG_PROGRESS, ">> Polymesh: %d vertices  %d polygons", m_pmesh->nverts, m_pmesh->npolys);
+	duLogBuildTimes(*build.ctx, build.ctx->getAccumulatedTime(RC_TIMER_TOTAL));
+	build.ctx->log(RC_LOG_PROGRESS, ">> Polymesh: %d vertices  %d polygons", build.pmesh->nverts, build.pmesh->npolys);
 	
-	m_tileBuildTime = m_ctx->getAccumulatedTime(RC_TIMER_TOTAL)/1000.0f;
+	build.tileBuildTime = build.ctx->getAccumulatedTime(RC_TIMER_TOTAL)/1000.0f;
 
 	dataSize = navDataSize;
 	return navData;
@@ -26,6 +26,7 @@
 #include "Detour/Include/DetourNavMesh.h"
 #include "NavEditor/Include/Editor.h"
 #include <naveditor/include/GameUtils.h>
+#include "NavEditor/Include/PerfTimer.h"
 
 static inline bool intersectSegmentTriangle(const float* sp, const float* sq,
 									 const float* a, const float* b, const float* c,
@@ -70,6 +71,21 @@ static inline bool intersectSegmentTriangle(const float* sp, const float* sq,
 	return true;
 }
 
+static void calcConvexVolumeBounds(ConvexVolume* vol)
+{
+	vol->bmin[0] = vol->bmax[0] = vol->verts[0];
+	vol->bmin[1] = vol->bmax[1] = vol->verts[1];
+
+	for (int i = 1; i < vol->nverts; ++i)
+	{
+		const float* v = &vol->verts[i*3];
+		vol->bmin[0] = rdMin(vol->bmin[0], v[0]);
+		vol->bmin[1] = rdMin(vol->bmin[1], v[1]);
+		vol->bmax[0] = rdMax(vol->bmax[0], v[0]);
+		vol->bmax[1] = rdMax(vol->bmax[1], v[1]);
+	}
+}
+
 static char* parseRow(char* buf, char* bufEnd, char* row, int len)
 {
 	bool start = true;
@@ -108,6 +124,7 @@ static char* parseRow(char* buf, char* bufEnd, char* row, int len)
 
 InputGeom::InputGeom() :
 	m_chunkyMesh(0),
+	m_triMeshBVH(0),
 	m_mesh(0),
 	m_hasBuildSettings(false),
 	m_offMeshConCount(0),
@@ -122,8 +139,38 @@ InputGeom::InputGeom() :
 InputGeom::~InputGeom()
 {
 	delete m_chunkyMesh;
+	delete m_triMeshBVH;
 	delete m_mesh;
 }
+
+bool InputGeom::createAccelerationStructures(rcContext* ctx)
+{
+	m_chunkyMesh = new rcChunkyTriMesh;
+	if (!m_chunkyMesh)
+	{
+		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Out of memory 'm_chunkyMesh'.");
+		return false;
+	}
+	if (!rcCreateChunkyTriMesh(m_mesh->getVerts(), m_mesh->getTris(), m_mesh->getTriCount(), 256, m_chunkyMesh))
+	{
+		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Failed to build chunky mesh.");
+		return false;
+	}
+
+	m_triMeshBVH = new rcTriMeshBVH;
+	if (!m_triMeshBVH)
+	{
+		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Out of memory 'm_triMeshBVH'.");
+		return false;
+	}
+	if (!rcCreateTriMeshBVH(m_mesh->getVerts(), m_mesh->getTris(), m_mesh->getTriCount(), m_triMeshBVH))
+	{
+		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Failed to build triangle mesh BVH.");
+		return false;
+	}
+
+	return true;
+}
 		
 bool InputGeom::loadMesh(rcContext* ctx, const std::string& filepath)
 {
@@ -131,6 +178,8 @@ bool InputGeom::loadMesh(rcContext* ctx, const std::string& filepath)
 	{
 		delete m_chunkyMesh;
 		m_chunkyMesh = 0;
+		delete m_triMeshBVH;
+		m_triMeshBVH = 0;
 		delete m_mesh;
 		m_mesh = 0;
 	}
@@ -153,17 +202,8 @@ bool InputGeom::loadMesh(rcContext* ctx, const std::string& filepath)
 	rdVcopy(m_navMeshBMin, m_meshBMin);
 	rdVcopy(m_navMeshBMax, m_meshBMax);
 
-	m_chunkyMesh = new rcChunkyTriMesh;
-	if (!m_chunkyMesh)
-	{
-		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Out of memory 'm_chunkyMesh'.");
-		return false;
-	}
-	if (!rcCreateChunkyTriMesh(m_mesh->getVerts(), m_mesh->getTris(), m_mesh->getTriCount(), 256, m_chunkyMesh))
-	{
-		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Failed to build chunky mesh.");
+	if (!createAccelerationStructures(ctx))
 		return false;
-	}		
 
 	return true;
 }
@@ -173,6 +213,8 @@ bool InputGeom::loadPlyMesh(rcContext* ctx, const std::string& filepath)
 	{
 		delete m_chunkyMesh;
 		m_chunkyMesh = 0;
+		delete m_triMeshBVH;
+		m_triMeshBVH = 0;
 		delete m_mesh;
 		m_mesh = 0;
 	}
@@ -195,17 +237,8 @@ bool InputGeom::loadPlyMesh(rcContext* ctx, const std::string& filepath)
 	rdVcopy(m_navMeshBMin, m_meshBMin);
 	rdVcopy(m_navMeshBMax, m_meshBMax);
 
-	m_chunkyMesh = new rcChunkyTriMesh;
-	if (!m_chunkyMesh)
-	{
-		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Out of memory 'm_chunkyMesh'.");
-		return false;
-	}
-	if (!rcCreateChunkyTriMesh(m_mesh->getVerts(), m_mesh->getTris(), m_mesh->getTriCount(), 256, m_chunkyMesh))
-	{
-		ctx->log(RC_LOG_ERROR, "buildTiledNavigation: Failed to build chunky mesh.");
+	if (!createAccelerationStructures(ctx))
 		return false;
-	}
 
 	return true;
 }
@@ -319,6 +352,7 @@ bool InputGeom::loadGeomSet(rcContext* ctx, const std::string& filepath)
 					src = parseRow(src, srcEnd, row, sizeof(row)/sizeof(char));
 					sscanf(row, "%f %f %f", &vol->verts[i*3+0], &vol->verts[i*3+1], &vol->verts[i*3+2]);
 				}
+				calcConvexVolumeBounds(vol);
 			}
 		}
 		else if (row[0] == 's')
@@ -497,60 +531,66 @@ static bool isectSegAABB(const float* sp, const float* sq,
 }
 
 
-bool InputGeom::raycastMesh(const float* src, const float* dst, float* tmin) const
+bool InputGeom::raycastClipVolumes(const float* src, const float* dst, float* tmin) const
 {
-	// Prune hit ray.
-	float btmin, btmax;
-	if (!isectSegAABB(src, dst, m_meshBMin, m_meshBMax, btmin, btmax))
-		return false;
-	float p[2], q[2];
-	p[0] = src[0] + (dst[0]-src[0])*btmin;
-	p[1] = src[1] + (dst[1]-src[1])*btmin;
-	q[0] = src[0] + (dst[0]-src[0])*btmax;
-	q[1] = src[1] + (dst[1]-src[1])*btmax;
-	
-	int cid[4096]; //stack is crying for help
-	const int ncid = rcGetChunksOverlappingSegment(m_chunkyMesh, p, q, cid, 4096);
-	if (!ncid)
-		return false;
-
-	bool hit = false;
-	const int nvol = m_volumeCount;
+	const float segMin[2] = { rdMin(src[0], dst[0]), rdMin(src[1], dst[1]) };
+	const float segMax[2] = { rdMax(src[0], dst[0]), rdMax(src[1], dst[1]) };
 
 	float tsmin = 0.0f, tsmax = 0.0f;
-	int segMin = 0, segMax = 0;
-
-	const bool calcTmin = tmin != nullptr;
+	int segMinIdx = 0, segMaxIdx = 0;
 
-	for (int i = 0; i < nvol; i++)
+	for (int i = 0; i < m_volumeCount; i++)
 	{
 		const ConvexVolume& vol = m_volumes[i];
 
 		if (vol.area != RC_NULL_AREA)
 			continue; // Clip brushes only.
 
+		if (segMin[0] > vol.bmax[0] || segMax[0] < vol.bmin[0] ||
+			segMin[1] > vol.bmax[1] || segMax[1] < vol.bmin[1])
+			continue;
+
 		if ((src[2] >= vol.hmin && src[2] <= vol.hmax) ||
 			(dst[2] >= vol.hmin && dst[2] <= vol.hmax))
 		{
 			if (rdIntersectSegmentPoly2D(src, dst, vol.verts, vol.nverts,
-				tsmin, tsmax, segMin, segMax))
+				tsmin, tsmax, segMinIdx, segMaxIdx))
 			{
-				hit = true;
-				break;
+				if (tmin)
+					*tmin = tsmin;
+
+				return true;
 			}
 		}
 	}
 
-	if (hit)
-	{
-		if (calcTmin)
-			*tmin = tsmin;
+	return false;
+}
+
+bool InputGeom::raycastChunkyMesh(const float* src, const float* dst, float* tmin) const
+{
+	// Prune hit ray.
+	float btmin, btmax;
+	if (!isectSegAABB(src, dst, m_meshBMin, m_meshBMax, btmin, btmax))
+		return false;
+	float p[2], q[2];
+	p[0] = src[0] + (dst[0]-src[0])*btmin;
+	p[1] = src[1] + (dst[1]-src[1])*btmin;
+	q[0] = src[0] + (dst[0]-src[0])*btmax;
+	q[1] = src[1] + (dst[1]-src[1])*btmax;
+	
+	int cid[4096]; //stack is crying for help
+	const int ncid = rcGetChunksOverlappingSegment(m_chunkyMesh, p, q, cid, 4096);
+	if (!ncid)
+		return false;
 
+	if (raycastClipVolumes(src, dst, tmin))
 		return true;
-	}
 
+	const bool calcTmin = tmin != nullptr;
 	const float* verts = m_mesh->getVerts();
 	float localtmin = 1.0f;
+	bool hit = false;
 	
 	for (int i = 0; i < ncid; ++i)
 	{
@@ -582,6 +622,145 @@ bool InputGeom::raycastMesh(const float* src, const float* dst, float* tmin) con
 	return hit;
 }
 
+bool InputGeom::raycastMesh(const float* src, const float* dst, float* tmin) const
+{
+	// Prune hit ray.
+	float btmin, btmax;
+	if (!isectSegAABB(src, dst, m_meshBMin, m_meshBMax, btmin, btmax))
+		return false;
+	float p[2], q[2];
+	p[0] = src[0] + (dst[0]-src[0])*btmin;
+	p[1] = src[1] + (dst[1]-src[1])*btmin;
+	q[0] = src[0] + (dst[0]-src[0])*btmax;
+	q[1] = src[1] + (dst[1]-src[1])*btmax;
+
+	// Rays that don't cross any geometry don't hit clip volumes either.
+	if (!rcChunksOverlapSegment(m_chunkyMesh, p, q))
+		return false;
+
+	if (raycastClipVolumes(src, dst, tmin))
+		return true;
+
+	return rcRaycastTriMeshBVH(m_triMeshBVH, src, dst, tmin);
+}
+
+void InputGeom::raycastMeshBatch(const float* srcs, const float* dsts, const int count, bool* hits, float* tmins) const
+{
+	// Segments that pass the same early outs as raycastMesh are gathered
+	// into packets, so the triangle BVH is traversed once per packet.
+	float packetSrcs[RC_BVH_RAY_PACKET_SIZE*3];
+	float packetDsts[RC_BVH_RAY_PACKET_SIZE*3];
+	bool packetHits[RC_BVH_RAY_PACKET_SIZE];
+	float packetTmins[RC_BVH_RAY_PACKET_SIZE];
+	int packetIds[RC_BVH_RAY_PACKET_SIZE];
+	int npacket = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		const float* src = &srcs[i*3];
+		const float* dst = &dsts[i*3];
+		float* tmin = tmins ? &tmins[i] : nullptr;
+
+		hits[i] = false;
+
+		// Prune hit ray.
+		float btmin, btmax;
+		if (isectSegAABB(src, dst, m_meshBMin, m_meshBMax, btmin, btmax))
+		{
+			float p[2], q[2];
+			p[0] = src[0] + (dst[0]-src[0])*btmin;
+			p[1] = src[1] + (dst[1]-src[1])*btmin;
+			q[0] = src[0] + (dst[0]-src[0])*btmax;
+			q[1] = src[1] + (dst[1]-src[1])*btmax;
+
+			if (rcChunksOverlapSegment(m_chunkyMesh, p, q))
+			{
+				if (raycastClipVolumes(src, dst, tmin))
+					hits[i] = true;
+				else
+				{
+					rdVcopy(&packetSrcs[npacket*3], src);
+					rdVcopy(&packetDsts[npacket*3], dst);
+					packetIds[npacket++] = i;
+				}
+			}
+		}
+
+		if (npacket == RC_BVH_RAY_PACKET_SIZE || (i == count-1 && npacket > 0))
+		{
+			rcRaycastTriMeshBVHBatch(m_triMeshBVH, packetSrcs, packetDsts, npacket,
+				packetHits, tmins ? packetTmins : nullptr);
+
+			for (int j = 0; j < npacket; j++)
+			{
+				hits[packetIds[j]] = packetHits[j];
+
+				if (tmins)
+					tmins[packetIds[j]] = packetTmins[j];
+			}
+
+			npacket = 0;
+		}
+	}
+}
+
+void InputGeom::benchmarkRaycastMesh(rcContext* ctx, const int rayCount) const
+{
+	if (!m_mesh || rayCount <= 0)
+		return;
+
+	float* srcs = new float[rayCount*3];
+	float* dsts = new float[rayCount*3];
+	bool* hits = new bool[rayCount*2];
+
+	// Deterministic rays across the mesh bounds, half of them short ones
+	// in the range of traverse links, the rest spanning the whole level.
+	unsigned int seed = 1;
+	for (int i = 0; i < rayCount*3; i++)
+	{
+		seed = seed*1103515245 + 12345;
+		const int axis = i%3;
+		const float f = (float)((seed>>8) & 0xffff) / 65535.0f;
+		srcs[i] = m_meshBMin[axis] + (m_meshBMax[axis]-m_meshBMin[axis])*f;
+
+		seed = seed*1103515245 + 12345;
+		const float g = (float)((seed>>8) & 0xffff) / 65535.0f;
+
+		if ((i/3) & 1)
+			dsts[i] = srcs[i] + (g-0.5f)*2.0f*DT_TRAVERSE_DIST_MAX;
+		else
+			dsts[i] = m_meshBMin[axis] + (m_meshBMax[axis]-m_meshBMin[axis])*g;
+	}
+
+	const TimeVal chunkyStart = getPerfTime();
+	for (int i = 0; i < rayCount; i++)
+		hits[i] = raycastChunkyMesh(&srcs[i*3], &dsts[i*3], nullptr);
+	const TimeVal chunkyEnd = getPerfTime();
+
+	const TimeVal bvhStart = getPerfTime();
+	raycastMeshBatch(srcs, dsts, rayCount, &hits[rayCount]);
+	const TimeVal bvhEnd = getPerfTime();
+
+	int numHits = 0;
+	int numMismatches = 0;
+
+	for (int i = 0; i < rayCount; i++)
+	{
+		if (hits[i])
+			numHits++;
+		if (hits[i] != hits[rayCount+i])
+			numMismatches++;
+	}
+
+	ctx->log(RC_LOG_PROGRESS, ">> Raycast benchmark: %d rays  %d hits  %d mismatches", rayCount, numHits, numMismatches);
+	ctx->log(RC_LOG_PROGRESS, ">>   chunky mesh: %.2fms", getPerfTimeUsec(chunkyEnd-chunkyStart)/1000.0f);
+	ctx->log(RC_LOG_PROGRESS, ">>   triangle BVH: %.2fms", getPerfTimeUsec(bvhEnd-bvhStart)/1000.0f);
+
+	delete[] srcs;
+	delete[] dsts;
+	delete[] hits;
+}
+
 void InputGeom::addOffMeshConnection(const float* spos, const float* epos, const float rad,
 									 unsigned char bidir, unsigned char jump, unsigned char order,
 									 unsigned char area, unsigned short flags)
@@ -680,6 +859,7 @@ void InputGeom::addConvexVolume(const float* verts, const int nverts,
 	vol->nverts = nverts;
 	vol->flags = flags;
 	vol->area = area;
+	calcConvexVolumeBounds(vol);
 }
 
 void InputGeom::deleteConvexVolume(int i)
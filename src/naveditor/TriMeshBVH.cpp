@@ -0,0 +1,457 @@
+#include "Shared/Include/SharedCommon.h"
+#include "NavEditor/Include/TriMeshBVH.h"
+#include "mathlib/ssemath.h"
+#include <algorithm>
+
+struct BVHBoundsItem
+{
+	float bmin[3];
+	float bmax[3];
+	float center[3];
+	int i;
+};
+
+static void calcExtends(const BVHBoundsItem* items, const int imin, const int imax,
+						float* bmin, float* bmax)
+{
+	rdVcopy(bmin, items[imin].bmin);
+	rdVcopy(bmax, items[imin].bmax);
+
+	for (int i = imin+1; i < imax; ++i)
+	{
+		const BVHBoundsItem& it = items[i];
+		rdVmin(bmin, it.bmin);
+		rdVmax(bmax, it.bmax);
+	}
+}
+
+static void calcCenterExtends(const BVHBoundsItem* items, const int imin, const int imax,
+							  float* bmin, float* bmax)
+{
+	rdVcopy(bmin, items[imin].center);
+	rdVcopy(bmax, items[imin].center);
+
+	for (int i = imin+1; i < imax; ++i)
+	{
+		const BVHBoundsItem& it = items[i];
+		rdVmin(bmin, it.center);
+		rdVmax(bmax, it.center);
+	}
+}
+
+inline int longestAxis(const float x, const float y, const float z)
+{
+	int axis = 0;
+	float maxVal = x;
+	if (y > maxVal)
+	{
+		axis = 1;
+		maxVal = y;
+	}
+	if (z > maxVal)
+	{
+		axis = 2;
+	}
+	return axis;
+}
+
+static void storePacket(rcTriMeshBVHPacket& packet, const BVHBoundsItem* items, const int imin, const int imax,
+						const float* verts, const int* tris)
+{
+	memset(&packet, 0, sizeof(rcTriMeshBVHPacket));
+
+	for (int i = imin, lane = 0; i < imax; ++i, ++lane)
+	{
+		const int* t = &tris[items[i].i*3];
+		const float* va = &verts[t[0]*3];
+		const float* vb = &verts[t[1]*3];
+		const float* vc = &verts[t[2]*3];
+
+		float ab[3], ac[3], norm[3];
+		rdVsub(ab, vb, va);
+		rdVsub(ac, vc, va);
+		rdVcross(norm, ab, ac);
+
+		for (int j = 0; j < 3; ++j)
+		{
+			packet.a[j][lane] = va[j];
+			packet.ab[j][lane] = ab[j];
+			packet.ac[j][lane] = ac[j];
+			packet.norm[j][lane] = norm[j];
+		}
+	}
+}
+
+static void subdivide(BVHBoundsItem* items, int imin, int imax,
+					  int& curNode, rcTriMeshBVHNode* nodes, const int maxNodes,
+					  int& curPacket, rcTriMeshBVHPacket* packets, const int maxPackets,
+					  const float* verts, const int* tris)
+{
+	const int inum = imax - imin;
+	const int icur = curNode;
+
+	if (curNode >= maxNodes)
+		return;
+
+	rcTriMeshBVHNode& node = nodes[curNode++];
+	calcExtends(items, imin, imax, node.bmin, node.bmax);
+
+	if (inum <= RC_BVH_MAX_LEAF_TRIS)
+	{
+		// Leaf, pack the triangles.
+		node.i = curPacket;
+		node.n = 0;
+
+		for (int i = imin; i < imax; i += RC_BVH_PACKET_WIDTH)
+		{
+			if (curPacket >= maxPackets)
+				break;
+
+			storePacket(packets[curPacket++], items, i, rdMin(i+RC_BVH_PACKET_WIDTH, imax), verts, tris);
+			node.n++;
+		}
+	}
+	else
+	{
+		// Split at the median of the triangle centers along the longest axis.
+		float cmin[3], cmax[3];
+		calcCenterExtends(items, imin, imax, cmin, cmax);
+
+		const int axis = longestAxis(cmax[0] - cmin[0],
+									 cmax[1] - cmin[1],
+									 cmax[2] - cmin[2]);
+
+		const int isplit = imin+inum/2;
+
+		std::nth_element(items+imin, items+isplit, items+imax,
+			[axis](const BVHBoundsItem& a, const BVHBoundsItem& b)
+			{
+				return a.center[axis] < b.center[axis];
+			});
+
+		// Left
+		subdivide(items, imin, isplit, curNode, nodes, maxNodes, curPacket, packets, maxPackets, verts, tris);
+		// Right
+		subdivide(items, isplit, imax, curNode, nodes, maxNodes, curPacket, packets, maxPackets, verts, tris);
+
+		const int iescape = curNode - icur;
+		// Negative index means escape.
+		node.i = -iescape;
+		node.n = 0;
+	}
+}
+
+bool rcCreateTriMeshBVH(const float* verts, const int* tris, int ntris, rcTriMeshBVH* bvh)
+{
+	if (ntris <= 0)
+		return true; // Nothing to hit.
+
+	// Every split leaves at least RC_BVH_MAX_LEAF_TRIS/2 triangles on each
+	// side, which bounds the number of leaves, and thus nodes and packets.
+	const int maxLeaves = ntris/(RC_BVH_MAX_LEAF_TRIS/2) + 1;
+	const int maxNodes = maxLeaves*2;
+	const int maxPackets = maxLeaves*(RC_BVH_MAX_LEAF_TRIS/RC_BVH_PACKET_WIDTH);
+
+	bvh->nodes = new rcTriMeshBVHNode[maxNodes];
+	if (!bvh->nodes)
+		return false;
+
+	bvh->packets = new rcTriMeshBVHPacket[maxPackets];
+	if (!bvh->packets)
+		return false;
+
+	BVHBoundsItem* items = new BVHBoundsItem[ntris];
+	if (!items)
+		return false;
+
+	for (int i = 0; i < ntris; i++)
+	{
+		const int* t = &tris[i*3];
+		BVHBoundsItem& it = items[i];
+		it.i = i;
+
+		rdVcopy(it.bmin, &verts[t[0]*3]);
+		rdVcopy(it.bmax, &verts[t[0]*3]);
+
+		for (int j = 1; j < 3; ++j)
+		{
+			const float* v = &verts[t[j]*3];
+			rdVmin(it.bmin, v);
+			rdVmax(it.bmax, v);
+		}
+
+		it.center[0] = (it.bmin[0]+it.bmax[0])*0.5f;
+		it.center[1] = (it.bmin[1]+it.bmax[1])*0.5f;
+		it.center[2] = (it.bmin[2]+it.bmax[2])*0.5f;
+	}
+
+	int curNode = 0;
+	int curPacket = 0;
+	subdivide(items, 0, ntris, curNode, bvh->nodes, maxNodes, curPacket, bvh->packets, maxPackets, verts, tris);
+
+	delete [] items;
+
+	bvh->nnodes = curNode;
+	bvh->npackets = curPacket;
+
+	return true;
+}
+
+struct BVHSegment
+{
+	float sp[3];
+	float qp[3]; // sp - sq
+	float ood[3];
+	bool parallel[3];
+};
+
+static bool checkOverlapSegment3D(const BVHSegment& seg, const float* bmin, const float* bmax, const float tmax)
+{
+	float t0 = 0.0f;
+	float t1 = tmax;
+
+	for (int i = 0; i < 3; i++)
+	{
+		if (seg.parallel[i])
+		{
+			if (seg.sp[i] < bmin[i] || seg.sp[i] > bmax[i])
+				return false;
+		}
+		else
+		{
+			float tn = (bmin[i] - seg.sp[i]) * seg.ood[i];
+			float tf = (bmax[i] - seg.sp[i]) * seg.ood[i];
+			if (tn > tf) { const float tmp = tn; tn = tf; tf = tmp; }
+			if (tn > t0) t0 = tn;
+			if (tf < t1) t1 = tf;
+			if (t0 > t1) return false;
+		}
+	}
+
+	return true;
+}
+
+// Tests the segment against all triangles in the packet. The operations are
+// done in the same order as the scalar segment/triangle test used elsewhere
+// in the editor, so the results are identical. Returns the mask of hit lanes,
+// the undivided distances and denominators are written to tnum and tden.
+static int intersectSegmentPacket(const BVHSegment& seg, const rcTriMeshBVHPacket& packet,
+								  fltx4& tnum, fltx4& tden)
+{
+	const fltx4 zero = LoadZeroSIMD();
+
+	const fltx4 qpx = ReplicateX4(seg.qp[0]);
+	const fltx4 qpy = ReplicateX4(seg.qp[1]);
+	const fltx4 qpz = ReplicateX4(seg.qp[2]);
+
+	const fltx4 nx = LoadUnalignedSIMD(packet.norm[0]);
+	const fltx4 ny = LoadUnalignedSIMD(packet.norm[1]);
+	const fltx4 nz = LoadUnalignedSIMD(packet.norm[2]);
+
+	// If d <= 0, segment is parallel to or points away from triangle.
+	const fltx4 d = AddSIMD(AddSIMD(MulSIMD(qpx, nx), MulSIMD(qpy, ny)), MulSIMD(qpz, nz));
+	fltx4 mask = CmpGtSIMD(d, zero);
+
+	if (!TestSignSIMD(mask))
+		return 0;
+
+	const fltx4 apx = SubSIMD(ReplicateX4(seg.sp[0]), LoadUnalignedSIMD(packet.a[0]));
+	const fltx4 apy = SubSIMD(ReplicateX4(seg.sp[1]), LoadUnalignedSIMD(packet.a[1]));
+	const fltx4 apz = SubSIMD(ReplicateX4(seg.sp[2]), LoadUnalignedSIMD(packet.a[2]));
+
+	// Segment intersects plane if 0 <= t <= d.
+	const fltx4 t = AddSIMD(AddSIMD(MulSIMD(apx, nx), MulSIMD(apy, ny)), MulSIMD(apz, nz));
+	mask = AndSIMD(mask, AndSIMD(CmpGeSIMD(t, zero), CmpLeSIMD(t, d)));
+
+	if (!TestSignSIMD(mask))
+		return 0;
+
+	// Barycentric coordinate components, e = cross(qp, ap).
+	const fltx4 ex = SubSIMD(MulSIMD(qpy, apz), MulSIMD(qpz, apy));
+	const fltx4 ey = SubSIMD(MulSIMD(qpz, apx), MulSIMD(qpx, apz));
+	const fltx4 ez = SubSIMD(MulSIMD(qpx, apy), MulSIMD(qpy, apx));
+
+	const fltx4 v = AddSIMD(AddSIMD(
+		MulSIMD(LoadUnalignedSIMD(packet.ac[0]), ex),
+		MulSIMD(LoadUnalignedSIMD(packet.ac[1]), ey)),
+		MulSIMD(LoadUnalignedSIMD(packet.ac[2]), ez));
+
+	const fltx4 w = SubSIMD(zero, AddSIMD(AddSIMD(
+		MulSIMD(LoadUnalignedSIMD(packet.ab[0]), ex),
+		MulSIMD(LoadUnalignedSIMD(packet.ab[1]), ey)),
+		MulSIMD(LoadUnalignedSIMD(packet.ab[2]), ez)));
+
+	mask = AndSIMD(mask, AndSIMD(CmpGeSIMD(v, zero), CmpLeSIMD(v, d)));
+	mask = AndSIMD(mask, AndSIMD(CmpGeSIMD(w, zero), CmpLeSIMD(AddSIMD(v, w), d)));
+
+	tnum = t;
+	tden = d;
+
+	return TestSignSIMD(mask);
+}
+
+static void initSegment(BVHSegment& seg, const float* sp, const float* sq)
+{
+	rdVcopy(seg.sp, sp);
+	rdVsub(seg.qp, sp, sq);
+
+	for (int i = 0; i < 3; i++)
+	{
+		const float d = sq[i] - sp[i];
+		seg.parallel[i] = rdMathFabsf(d) < RD_EPS;
+		seg.ood[i] = seg.parallel[i] ? 0.0f : 1.0f / d;
+	}
+}
+
+// Tests the segment against the triangles in the leaf. If calcTmin is false,
+// the test stops at the first hit, otherwise tmin is lowered to the closest
+// hit found in the leaf. Returns true if any triangle was hit.
+static bool raycastLeaf(const rcTriMeshBVH* bvh, const rcTriMeshBVHNode* node, const BVHSegment& seg,
+						const bool calcTmin, float& tmin)
+{
+	bool hit = false;
+
+	for (int j = 0; j < node->n; ++j)
+	{
+		fltx4 tnum, tden;
+		const int mask = intersectSegmentPacket(seg, bvh->packets[node->i+j], tnum, tden);
+
+		if (!mask)
+			continue;
+
+		hit = true;
+
+		if (!calcTmin)
+			break;
+
+		float tn[RC_BVH_PACKET_WIDTH], td[RC_BVH_PACKET_WIDTH];
+		StoreUnalignedSIMD(tn, tnum);
+		StoreUnalignedSIMD(td, tden);
+
+		for (int k = 0; k < RC_BVH_PACKET_WIDTH; ++k)
+		{
+			if (!(mask & (1<<k)))
+				continue;
+
+			const float t = tn[k] / td[k];
+			if (t < tmin)
+				tmin = t;
+		}
+	}
+
+	return hit;
+}
+
+bool rcRaycastTriMeshBVH(const rcTriMeshBVH* bvh, const float* sp, const float* sq, float* tmin)
+{
+	BVHSegment seg;
+	initSegment(seg, sp, sq);
+
+	const bool calcTmin = tmin != nullptr;
+	float localtmin = 1.0f;
+	bool hit = false;
+
+	// Traverse tree
+	int i = 0;
+	while (i < bvh->nnodes)
+	{
+		const rcTriMeshBVHNode* node = &bvh->nodes[i];
+		// Nodes beyond the closest hit so far can't contain a closer one.
+		const bool overlap = checkOverlapSegment3D(seg, node->bmin, node->bmax, localtmin);
+		const bool isLeafNode = node->i >= 0;
+
+		if (isLeafNode && overlap && raycastLeaf(bvh, node, seg, calcTmin, localtmin))
+		{
+			if (!calcTmin)
+				return true;
+
+			hit = true;
+		}
+
+		if (overlap || isLeafNode)
+			i++;
+		else
+		{
+			const int escapeIndex = -node->i;
+			i += escapeIndex;
+		}
+	}
+
+	if (calcTmin)
+		*tmin = localtmin;
+
+	return hit;
+}
+
+void rcRaycastTriMeshBVHBatch(const rcTriMeshBVH* bvh, const float* sps, const float* sqs, const int count,
+							  bool* hits, float* tmins)
+{
+	const bool calcTmin = tmins != nullptr;
+
+	for (int base = 0; base < count; base += RC_BVH_RAY_PACKET_SIZE)
+	{
+		const int nsegs = rdMin(count-base, RC_BVH_RAY_PACKET_SIZE);
+
+		BVHSegment segs[RC_BVH_RAY_PACKET_SIZE];
+		float localtmin[RC_BVH_RAY_PACKET_SIZE];
+		bool hit[RC_BVH_RAY_PACKET_SIZE];
+
+		// Segments that already hit something drop out of the packet when
+		// only the first hit is requested.
+		unsigned int active = 0;
+
+		for (int r = 0; r < nsegs; r++)
+		{
+			initSegment(segs[r], &sps[(base+r)*3], &sqs[(base+r)*3]);
+			localtmin[r] = 1.0f;
+			hit[r] = false;
+			active |= 1u<<r;
+		}
+
+		// Traverse tree once for the whole packet, descending into a node
+		// as long as any of the segments overlaps it.
+		int i = 0;
+		while (i < bvh->nnodes && active)
+		{
+			const rcTriMeshBVHNode* node = &bvh->nodes[i];
+			const bool isLeafNode = node->i >= 0;
+			unsigned int overlap = 0;
+
+			for (int r = 0; r < nsegs; r++)
+			{
+				if ((active & (1u<<r)) && checkOverlapSegment3D(segs[r], node->bmin, node->bmax, localtmin[r]))
+					overlap |= 1u<<r;
+			}
+
+			if (isLeafNode && overlap)
+			{
+				for (int r = 0; r < nsegs; r++)
+				{
+					if (!(overlap & (1u<<r)) || !raycastLeaf(bvh, node, segs[r], calcTmin, localtmin[r]))
+						continue;
+
+					hit[r] = true;
+
+					if (!calcTmin)
+						active &= ~(1u<<r);
+				}
+			}
+
+			if (overlap || isLeafNode)
+				i++;
+			else
+			{
+				const int escapeIndex = -node->i;
+				i += escapeIndex;
+			}
+		}
+
+		for (int r = 0; r < nsegs; r++)
+		{
+			hits[base+r] = hit[r];
+
+			if (calcTmin)
+				tmins[base+r] = localtmin[r];
+		}
+	}
+}
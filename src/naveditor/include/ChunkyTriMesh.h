@@ -58,5 +58,8 @@ int rcGetChunksOverlappingRect(const rcChunkyTriMesh* cm, float bmin[2], float b
 /// Returns the chunk indices which overlap the input segment.
 int rcGetChunksOverlappingSegment(const rcChunkyTriMesh* cm, float p[2], float q[2], int* ids, const int maxIds);
 
+/// Returns true if any chunk overlaps the input segment, stops at the first overlapping chunk.
+bool rcChunksOverlapSegment(const rcChunkyTriMesh* cm, float p[2], float q[2]);
+
 
 #endif // CHUNKYTRIMESH_H
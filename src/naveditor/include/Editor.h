@@ -414,7 +414,11 @@ public:
 	void handleCommonSettings();
 
 	void connectTileTraverseLinks(dtMeshTile* const baseTile, const bool linkToNeighbor); // Make private.
+	void connectTraverseLinks(const dtTileRef* tileRefs, const int tileRefCount, const bool linkToNeighbor);
+
 	bool createTraverseLinks();
+	bool updateTraverseLinks(const dtTileRef* tileRefs, const int tileRefCount);
+	void removeTraverseLinkPolyPairs(const dtTileRef tileRef);
 
 	void createTraverseLinkParams(dtTraverseLinkConnectParams& params);
 
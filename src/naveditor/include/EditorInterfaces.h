@@ -48,6 +48,8 @@ public:
 	int getLogCount() const;
 	/// Returns log message text.
 	const char* getLogText(const int i) const;
+	/// Returns log message category.
+	rcLogCategory getLogCategory(const int i) const;
 	
 protected:	
 	/// Virtual functions for custom implementations.
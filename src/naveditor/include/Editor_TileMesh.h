@@ -25,6 +25,45 @@
 #include "NavEditor/Include/Editor.h"
 #include "NavEditor/Include/Editor_Common.h"
 
+/// Per-tile build state; each build thread owns one so tiles can be built
+/// concurrently without touching the intermediate results of the editor.
+struct TileMeshBuildData
+{
+	TileMeshBuildData();
+	~TileMeshBuildData();
+
+	void cleanup();
+	void release();
+
+	BuildContext* ctx;
+	rcConfig cfg;
+
+	unsigned char* triareas;
+	rcHeightfield* solid;
+	rcCompactHeightfield* chf;
+	rcContourSet* cset;
+	rcPolyMesh* pmesh;
+	rcPolyMeshDetail* dmesh;
+
+	int tileTriCount;
+	float tileMemUsage;
+	float tileBuildTime;
+
+	bool keepInterResults;
+};
+
+struct TileMeshBuildResult
+{
+	TileMeshBuildResult() : data(0), dataSize(0), tileTriCount(0), tileMemUsage(0), tileBuildTime(0) {}
+
+	unsigned char* data;
+	int dataSize;
+
+	int tileTriCount;
+	float tileMemUsage;
+	float tileBuildTime;
+};
+
 class Editor_TileMesh : public Editor_StaticTileMeshCommon
 {
 protected:
@@ -38,6 +77,7 @@ protected:
 	int m_tileTriCount;
 
 	unsigned char* buildTileMesh(const int tx, const int ty, const float* bmin, const float* bmax, int& dataSize);
+	unsigned char* buildTileMesh(TileMeshBuildData& build, const int tx, const int ty, const float* bmin, const float* bmax, int& dataSize);
 	
 	void saveAll(const char* path, const dtNavMesh* mesh);
 	dtNavMesh* loadAll(const char* path);
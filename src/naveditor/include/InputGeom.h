@@ -20,6 +20,7 @@
 #define INPUTGEOM_H
 
 #include "NavEditor/Include/ChunkyTriMesh.h"
+#include "NavEditor/Include/TriMeshBVH.h"
 #include "NavEditor/Include/MeshLoaderObj.h"
 
 static const int MAX_CONVEXVOL_PTS = 12;
@@ -27,6 +28,7 @@ struct ConvexVolume
 {
 	float verts[MAX_CONVEXVOL_PTS*3];
 	float hmin, hmax;
+	float bmin[2], bmax[2]; // 2D bounds of the verts, for early rejection.
 	int nverts;
 	unsigned short flags;
 	unsigned char area;
@@ -78,6 +80,7 @@ struct BuildSettings
 class InputGeom
 {
 	rcChunkyTriMesh* m_chunkyMesh;
+	rcTriMeshBVH* m_triMeshBVH;
 	IMeshLoader* m_mesh;
 	float m_meshBMin[3], m_meshBMax[3];
 	float m_navMeshBMin[3], m_navMeshBMax[3];
@@ -110,6 +113,10 @@ class InputGeom
 	bool loadMesh(class rcContext* ctx, const std::string& filepath);
 	bool loadPlyMesh(class rcContext* ctx, const std::string& filepath);
 	bool loadGeomSet(class rcContext* ctx, const std::string& filepath);
+	bool createAccelerationStructures(class rcContext* ctx);
+
+	bool raycastClipVolumes(const float* src, const float* dst, float* tmin) const;
+	bool raycastChunkyMesh(const float* src, const float* dst, float* tmin) const;
 public:
 	InputGeom();
 	~InputGeom();
@@ -135,6 +142,8 @@ public:
 	const rcChunkyTriMesh* getChunkyMesh() const { return m_chunkyMesh; }
 	const BuildSettings* getBuildSettings() const { return m_hasBuildSettings ? &m_buildSettings : 0; }
 	bool raycastMesh(const float* src, const float* dst, float* tmin = nullptr) const;
+	void raycastMeshBatch(const float* srcs, const float* dsts, const int count, bool* hits, float* tmins = nullptr) const;
+	void benchmarkRaycastMesh(class rcContext* ctx, const int rayCount) const;
 
 	/// @name Off-Mesh connections.
 	///@{
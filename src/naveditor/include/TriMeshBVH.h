@@ -0,0 +1,67 @@
+#ifndef TRIMESHBVH_H
+#define TRIMESHBVH_H
+
+// Bounding volume hierarchy over the input triangle mesh, used to accelerate
+// segment queries against the input geometry.
+
+/// Number of triangles tested at once against a segment.
+static const int RC_BVH_PACKET_WIDTH = 4;
+
+/// Maximum number of triangles stored in a single leaf node.
+static const int RC_BVH_MAX_LEAF_TRIS = 8;
+
+/// Number of segments traversed together by rcRaycastTriMeshBVHBatch, at
+/// most the number of bits in an unsigned int.
+static const int RC_BVH_RAY_PACKET_SIZE = 32;
+
+struct rcTriMeshBVHNode
+{
+	float bmin[3];
+	float bmax[3];
+	int i; ///< Index of the first packet if leaf, negative escape index otherwise.
+	int n; ///< Number of packets in the leaf.
+};
+
+/// Triangles stored as structure of arrays, so a segment can be tested
+/// against all of them at once. Unused lanes are zeroed, which makes them
+/// degenerate and never reported as hit.
+struct rcTriMeshBVHPacket
+{
+	float a[3][RC_BVH_PACKET_WIDTH];    ///< First vertex.
+	float ab[3][RC_BVH_PACKET_WIDTH];   ///< Edge from the first to the second vertex.
+	float ac[3][RC_BVH_PACKET_WIDTH];   ///< Edge from the first to the third vertex.
+	float norm[3][RC_BVH_PACKET_WIDTH]; ///< Unnormalized face normal, cross(ab, ac).
+};
+
+struct rcTriMeshBVH
+{
+	inline rcTriMeshBVH() : nodes(0), nnodes(0), packets(0), npackets(0) {};
+	inline ~rcTriMeshBVH() { delete [] nodes; delete [] packets; }
+
+	rcTriMeshBVHNode* nodes;
+	int nnodes;
+	rcTriMeshBVHPacket* packets;
+	int npackets;
+
+private:
+	// Explicitly disabled copy constructor and copy assignment operator.
+	rcTriMeshBVH(const rcTriMeshBVH&);
+	rcTriMeshBVH& operator=(const rcTriMeshBVH&);
+};
+
+/// Creates the bounding volume hierarchy (3D AABB tree) over the triangles.
+bool rcCreateTriMeshBVH(const float* verts, const int* tris, int ntris, rcTriMeshBVH* bvh);
+
+/// Tests the segment sp->sq against the triangles in the hierarchy. If tmin
+/// is null, the traversal stops at the first hit, otherwise the parametric
+/// distance of the closest hit along the segment is written to tmin.
+bool rcRaycastTriMeshBVH(const rcTriMeshBVH* bvh, const float* sp, const float* sq, float* tmin);
+
+/// Tests count segments against the triangles in the hierarchy, traversing
+/// it once per packet of RC_BVH_RAY_PACKET_SIZE segments. The results in hits
+/// and tmins match those of rcRaycastTriMeshBVH for each segment, tmins may
+/// be null in which case each segment stops at its first hit.
+void rcRaycastTriMeshBVHBatch(const rcTriMeshBVH* bvh, const float* sps, const float* sqs, const int count,
+							  bool* hits, float* tmins);
+
+#endif // TRIMESHBVH_H
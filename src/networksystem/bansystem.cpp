@@ -15,6 +15,212 @@
 #include "networksystem/bansystem.h"
 #include "game/server/gameinterface.h"
 
+//-----------------------------------------------------------------------------
+// Purpose: parses an address or address range into its binary form
+// Input  : *address      - ('1.2.3.4', '::1', '[::1]:37015', '1.2.3.0/24', ..)
+//          &outAddress   - (masked to the prefix length)
+//          &outPrefixLen - (0 to 128, IPv4 is mapped into IPv6)
+// Output : true on success, false if the address couldn't be parsed
+//-----------------------------------------------------------------------------
+static bool BanSystem_ParseAddress(const char* address, CBanSystem::BanAddress_t& outAddress, int& outPrefixLen)
+{
+	char buf[128];
+	const size_t len = strlen(address);
+
+	if (!len || len >= sizeof(buf))
+		return false;
+
+	memcpy(buf, address, len + 1);
+
+	char* host = buf;
+	char* prefix = nullptr;
+
+	if (host[0] == '[')
+	{
+		host++;
+		char* const bracketEnd = strchr(host, ']');
+
+		if (!bracketEnd)
+			return false;
+
+		*bracketEnd = '\0';
+
+		// A port may follow the bracket, a range would be '[::]/64'.
+		if (bracketEnd[1] == '/')
+			prefix = &bracketEnd[2];
+	}
+	else
+	{
+		char* const slash = strchr(host, '/');
+
+		if (slash)
+		{
+			*slash = '\0';
+			prefix = &slash[1];
+		}
+	}
+
+	uint8_t bytes[16];
+	int maxPrefixLen;
+
+	in_addr addr4;
+
+	if (inet_pton(AF_INET6, host, bytes) == 1)
+	{
+		maxPrefixLen = 128;
+	}
+	else if (inet_pton(AF_INET, host, &addr4) == 1)
+	{
+		static const uint8_t s_MappedPrefix[12] = { 0,0,0,0,0,0,0,0,0,0,0xFF,0xFF };
+
+		memcpy(bytes, s_MappedPrefix, sizeof(s_MappedPrefix));
+		memcpy(&bytes[12], &addr4, sizeof(addr4));
+
+		maxPrefixLen = 32;
+	}
+	else
+	{
+		return false;
+	}
+
+	int prefixLen = maxPrefixLen;
+
+	if (prefix)
+	{
+		if (!*prefix || strlen(prefix) > 3 || !V_IsAllDigit(prefix))
+			return false;
+
+		prefixLen = atoi(prefix);
+
+		if (prefixLen > maxPrefixLen)
+			return false;
+	}
+
+	outPrefixLen = prefixLen + (128 - maxPrefixLen);
+
+	uint64_t high = 0;
+	uint64_t low = 0;
+
+	for (int i = 0; i < 8; i++)
+	{
+		high = (high << 8) | bytes[i];
+		low = (low << 8) | bytes[i + 8];
+	}
+
+	const int highBits = Min(outPrefixLen, 64);
+	const int lowBits = Max(outPrefixLen - 64, 0);
+
+	outAddress.m_High = highBits ? high & (~0ull << (64 - highBits)) : 0;
+	outAddress.m_Low = lowBits ? low & (~0ull << (64 - lowBits)) : 0;
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: returns the lower case address, used as key for addresses which
+//          couldn't be parsed as these are compared case insensitively
+//-----------------------------------------------------------------------------
+static string BanSystem_LowerAddress(const char* address)
+{
+	string lower(address);
+	std::transform(lower.begin(), lower.end(), lower.begin(),
+		[](const char c) { return char(tolower(uint8_t(c))); });
+
+	return lower;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: adds or removes the entry from the lookup indices
+// Input  : &banned - 
+//          delta   - (1 to add, -1 to remove)
+//-----------------------------------------------------------------------------
+void CBanSystem::IndexEntry(const Banned_t& banned, const int delta)
+{
+	if (banned.m_NucleusID == NULL ||
+		banned.m_Address.IsEmpty())
+	{
+		// Never matched by IsBanned.
+		return;
+	}
+
+	const auto adjust = [delta](auto& index, const auto& key)
+	{
+		auto it = index.emplace(key, 0).first;
+		it->second += delta;
+
+		if (it->second <= 0)
+			index.erase(it);
+	};
+
+	adjust(m_NucleusIndex, banned.m_NucleusID);
+
+	BanAddress_t address;
+	int prefixLen;
+
+	if (BanSystem_ParseAddress(banned.m_Address.String(), address, prefixLen))
+	{
+		adjust(m_AddressIndex[prefixLen], address);
+		m_PrefixCount[prefixLen] += delta;
+	}
+	else
+	{
+		adjust(m_UnparsedAddressIndex, BanSystem_LowerAddress(banned.m_Address.String()));
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: rebuilds the lookup indices from the banned list
+//-----------------------------------------------------------------------------
+void CBanSystem::RebuildIndex(void)
+{
+	m_NucleusIndex.clear();
+	m_UnparsedAddressIndex.clear();
+
+	for (int i = 0; i <= BAN_ADDRESS_BITS; i++)
+	{
+		m_AddressIndex[i].clear();
+		m_PrefixCount[i] = 0;
+	}
+
+	m_NucleusIndex.reserve(m_BannedList.Count());
+	m_AddressIndex[128].reserve(m_BannedList.Count());
+
+	FOR_EACH_VEC(m_BannedList, i)
+	{
+		IndexEntry(m_BannedList[i], 1);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: checks if an exact duplicate of the entry could be in the banned
+//          list, false means that it certainly isn't
+// Input  : *ipAddress - 
+//			nucleusId - 
+//-----------------------------------------------------------------------------
+bool CBanSystem::MightBeListed(const char* ipAddress, const NucleusID_t nucleusId) const
+{
+	if (nucleusId == NULL || !*ipAddress)
+	{
+		// Not indexed, could be anywhere.
+		return true;
+	}
+
+	if (m_NucleusIndex.find(nucleusId) == m_NucleusIndex.end())
+	{
+		return false;
+	}
+
+	BanAddress_t address;
+	int prefixLen;
+
+	if (BanSystem_ParseAddress(ipAddress, address, prefixLen))
+	{
+		return m_AddressIndex[prefixLen].find(address) != m_AddressIndex[prefixLen].end();
+	}
+
+	return m_UnparsedAddressIndex.find(BanSystem_LowerAddress(ipAddress)) != m_UnparsedAddressIndex.end();
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: loads and parses the banned list
 //-----------------------------------------------------------------------------
@@ -23,6 +229,8 @@ void CBanSystem::LoadList(void)
 	if (IsBanListValid())
 		m_BannedList.Purge();
 
+	RebuildIndex();
+
 	FileHandle_t pFile = FileSystem()->Open("banlist.json", "rt", "PLATFORM");
 	if (!pFile)
 		return;
@@ -56,31 +264,45 @@ void CBanSystem::LoadList(void)
 		return;
 	}
 
-	for (int i = 0; i < nTotalBans; i++)
+	if (nTotalBans <= 0)
 	{
-		char idx[12]; itoa(i, idx, 10);
+		return;
+	}
 
-		rapidjson::Value::ConstMemberIterator entryIt;
+	m_BannedList.EnsureCapacity(Min(nTotalBans, int(document.MemberCount())));
 
-		if (JSON_GetIterator(document, idx, JSONFieldType_e::kObject, entryIt))
-		{
-			const rapidjson::Value& entry = entryIt->value;
+	// Walk the members in order instead of looking up each index by name,
+	// as the latter is a linear search per entry.
+	for (rapidjson::Value::ConstMemberIterator entryIt = document.MemberBegin();
+		entryIt != document.MemberEnd(); ++entryIt)
+	{
+		if (!entryIt->value.IsObject())
+			continue;
 
-			const char* ipAddress = nullptr;
-			NucleusID_t nucleusId = NULL;
+		char* pEnd = nullptr;
+		const long idx = strtol(entryIt->name.GetString(), &pEnd, 10);
 
-			if (JSON_GetValue(entry, "ipAddress", JSONFieldType_e::kString, ipAddress) && 
-				JSON_GetValue(entry, "nucleusId", JSONFieldType_e::kUint64, nucleusId))
-			{
-				Banned_t banned;
+		if (*pEnd || pEnd == entryIt->name.GetString() || idx < 0 || idx >= nTotalBans)
+			continue;
 
-				banned.m_Address = ipAddress;
-				banned.m_NucleusID = nucleusId;
+		const rapidjson::Value& entry = entryIt->value;
 
-				m_BannedList.AddToTail(banned);
-			}
+		const char* ipAddress = nullptr;
+		NucleusID_t nucleusId = NULL;
+
+		if (JSON_GetValue(entry, "ipAddress", JSONFieldType_e::kString, ipAddress) && 
+			JSON_GetValue(entry, "nucleusId", JSONFieldType_e::kUint64, nucleusId))
+		{
+			Banned_t banned;
+
+			banned.m_Address = ipAddress;
+			banned.m_NucleusID = nucleusId;
+
+			m_BannedList.AddToTail(banned);
 		}
 	}
+
+	RebuildIndex();
 }
 
 //-----------------------------------------------------------------------------
@@ -132,21 +354,19 @@ bool CBanSystem::AddEntry(const char* ipAddress, const NucleusID_t nucleusId)
 	Assert(VALID_CHARSTAR(ipAddress));
 	const Banned_t banned(ipAddress, nucleusId);
 
-	if (IsBanListValid())
+	// Only scan the list if the index can't rule out a duplicate.
+	if (IsBanListValid() && MightBeListed(ipAddress, nucleusId))
 	{
-		if (m_BannedList.Find(banned) == m_BannedList.InvalidIndex())
+		if (m_BannedList.Find(banned) != m_BannedList.InvalidIndex())
 		{
-			m_BannedList.AddToTail(banned);
-			return true;
+			return false;
 		}
 	}
-	else
-	{
-		m_BannedList.AddToTail(banned);
-		return true;
-	}
 
-	return false;
+	m_BannedList.AddToTail(banned);
+	IndexEntry(banned, 1);
+
+	return true;
 }
 
 //-----------------------------------------------------------------------------
@@ -167,7 +387,9 @@ bool CBanSystem::DeleteEntry(const char* ipAddress, const NucleusID_t nucleusId)
 			if (banned.m_NucleusID == nucleusId ||
 				banned.m_Address.IsEqual_CaseInsensitive(ipAddress))
 			{
+				IndexEntry(banned, -1);
 				m_BannedList.Remove(i);
+
 				return true;
 			}
 		}
@@ -184,19 +406,38 @@ bool CBanSystem::DeleteEntry(const char* ipAddress, const NucleusID_t nucleusId)
 //-----------------------------------------------------------------------------
 bool CBanSystem::IsBanned(const char* ipAddress, const NucleusID_t nucleusId) const
 {
-	FOR_EACH_VEC(m_BannedList, i)
+	if (nucleusId != NULL &&
+		m_NucleusIndex.find(nucleusId) != m_NucleusIndex.end())
 	{
-		const Banned_t& banned = m_BannedList[i];
+		return true;
+	}
 
-		if (banned.m_NucleusID == NULL ||
-			banned.m_Address.IsEmpty())
-		{
-			// Cannot be NULL.
+	BanAddress_t address;
+	int prefixLen;
+
+	if (!BanSystem_ParseAddress(ipAddress, address, prefixLen))
+	{
+		return !m_UnparsedAddressIndex.empty() &&
+			m_UnparsedAddressIndex.find(BanSystem_LowerAddress(ipAddress)) != m_UnparsedAddressIndex.end();
+	}
+
+	// Match the address against each banned range length in use, from the
+	// longest to the shortest prefix.
+	for (int i = prefixLen; i >= 0; i--)
+	{
+		if (!m_PrefixCount[i])
 			continue;
-		}
 
-		if (banned.m_NucleusID == nucleusId ||
-			banned.m_Address.IsEqual_CaseInsensitive(ipAddress))
+		const int highBits = Min(i, 64);
+		const int lowBits = Max(i - 64, 0);
+
+		const BanAddress_t masked =
+		{
+			highBits ? address.m_High & (~0ull << (64 - highBits)) : 0,
+			lowBits ? address.m_Low & (~0ull << (64 - lowBits)) : 0
+		};
+
+		if (m_AddressIndex[i].find(masked) != m_AddressIndex[i].end())
 		{
 			return true;
 		}
@@ -423,6 +664,119 @@ void CBanSystem::AuthorPlayerById(const char* playerHandle, const bool shouldBan
 	}
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: measures the lookup latency of the banned list indices against the
+//          linear scan, on a synthetic list
+// Input  : numEntries - 
+//          numLookups - 
+//-----------------------------------------------------------------------------
+void CBanSystem::BenchmarkLookups(const int numEntries, const int numLookups)
+{
+	std::unique_ptr<CBanSystem> banSystem(new CBanSystem);
+	banSystem->m_BannedList.EnsureCapacity(numEntries);
+
+	uint64_t state = 0x2545F4914F6CDD1Dull;
+
+	const auto nextRandom = [&state]()
+	{
+		state ^= state << 13; state ^= state >> 7; state ^= state << 17;
+		return state;
+	};
+
+	// Mostly IPv6 and IPv4-mapped addresses like the netchannel reports,
+	// with a range ban every so often. Nucleus id's are even numbers, so
+	// lookups with an odd id only match on address.
+	const auto formatAddress = [](char* buf, const size_t bufSize, const uint64_t value, const int i)
+	{
+		if (i % 1000 == 999)
+			snprintf(buf, bufSize, "%u.%u.%u.0/24", uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8));
+		else if (i % 4 == 0)
+			snprintf(buf, bufSize, "::ffff:%u.%u.%u.%u", uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8), uint8_t(value));
+		else
+			snprintf(buf, bufSize, "2001:db8:%x:%x::%x", uint16_t(value >> 48), uint16_t(value >> 32), uint16_t(value));
+	};
+
+	vector<uint64_t> addressValues(numEntries);
+	char address[64];
+
+	double startTime = Plat_FloatTime();
+
+	for (int i = 0; i < numEntries; i++)
+	{
+		addressValues[i] = nextRandom();
+		formatAddress(address, sizeof(address), addressValues[i], i);
+
+		banSystem->AddEntry(address, (NucleusID_t(i) + 1) * 2);
+	}
+
+	const double buildTime = Plat_FloatTime() - startTime;
+
+	// Half of the lookups hit an entry by address, the others miss.
+	vector<string> lookupAddresses(numLookups);
+
+	for (int i = 0; i < numLookups; i++)
+	{
+		if (i & 1)
+		{
+			const int entry = int(nextRandom() % numEntries);
+			const uint64_t value = addressValues[entry];
+
+			// Look up an address within the range instead of the range.
+			if (entry % 1000 == 999)
+				snprintf(address, sizeof(address), "%u.%u.%u.7", uint8_t(value >> 24), uint8_t(value >> 16), uint8_t(value >> 8));
+			else
+				formatAddress(address, sizeof(address), value, entry);
+		}
+		else
+		{
+			formatAddress(address, sizeof(address), nextRandom(), 1);
+		}
+
+		lookupAddresses[i] = address;
+	}
+
+	int numHits = 0;
+	startTime = Plat_FloatTime();
+
+	for (int i = 0; i < numLookups; i++)
+	{
+		if (banSystem->IsBanned(lookupAddresses[i].c_str(), 1))
+			numHits++;
+	}
+
+	const double indexTime = Plat_FloatTime() - startTime;
+
+	// The linear scan is too slow to run all lookups on large lists.
+	const int numLinearLookups = Min(numLookups, 64);
+	int numLinearHits = 0;
+
+	startTime = Plat_FloatTime();
+
+	for (int i = 0; i < numLinearLookups; i++)
+	{
+		const CBanSystem::BannedList_t& bannedList = banSystem->m_BannedList;
+
+		FOR_EACH_VEC(bannedList, j)
+		{
+			if (bannedList[j].m_NucleusID == 1 ||
+				bannedList[j].m_Address.IsEqual_CaseInsensitive(lookupAddresses[i].c_str()))
+			{
+				numLinearHits++;
+				break;
+			}
+		}
+	}
+
+	const double linearTime = Plat_FloatTime() - startTime;
+
+	Msg(eDLL_T::SERVER, "%s: built index of '%d' entries in '%lf' seconds\n",
+		__FUNCTION__, numEntries, buildTime);
+	Msg(eDLL_T::SERVER, "%s: indexed: '%.1lf' ns per lookup ('%d' of '%d' banned)\n",
+		__FUNCTION__, indexTime * 1e9 / numLookups, numHits, numLookups);
+	Msg(eDLL_T::SERVER, "%s: linear:  '%.1lf' ns per lookup ('%d' of '%d' banned, ranges not supported)\n",
+		__FUNCTION__, linearTime * 1e9 / numLinearLookups, numLinearHits, numLinearLookups);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Console command handlers
 ///////////////////////////////////////////////////////////////////////////////
@@ -494,6 +848,13 @@ static void Host_ReloadBanList_f()
 {
 	g_BanSystem.LoadList(); // Reload banned list.
 }
+static void Host_BenchmarkBanList_f(const CCommand& args)
+{
+	const int numEntries = args.ArgC() > 1 ? Clamp(atoi(args.Arg(1)), 1, 10000000) : 1000000;
+	const int numLookups = args.ArgC() > 2 ? Clamp(atoi(args.Arg(2)), 1, 10000000) : 1000000;
+
+	CBanSystem::BenchmarkLookups(numEntries, numLookups);
+}
 
 static ConCommand kick("kick", Host_Kick_f, "Kick a client from the server by user name", FCVAR_RELEASE, nullptr, "kick \"<userId>\"");
 static ConCommand kickid("kickid", Host_KickID_f, "Kick a client from the server by handle, nucleus id or ip address", FCVAR_RELEASE, nullptr, "kickid \"<handle>\"/\"<nucleusId>/<ipAddress>\"");
@@ -501,6 +862,7 @@ static ConCommand ban("ban", Host_Ban_f, "Bans a client from the server by user
 static ConCommand banid("banid", Host_BanID_f, "Bans a client from the server by handle, nucleus id or ip address", FCVAR_RELEASE, nullptr, "banid \"<handle>\"/\"<nucleusId>/<ipAddress>\"");
 static ConCommand unban("unban", Host_Unban_f, "Unbans a client from the server by nucleus id or ip address", FCVAR_RELEASE, nullptr, "unban \"<nucleusId>\"/\"<ipAddress>\"");
 static ConCommand reload_banlist("banlist_reload", Host_ReloadBanList_f, "Reloads the banned list", FCVAR_RELEASE);
+static ConCommand benchmark_banlist("banlist_benchmark", Host_BenchmarkBanList_f, "Benchmarks banned list lookups on a synthetic list", FCVAR_DEVELOPMENTONLY, nullptr, "banlist_benchmark <numEntries> <numLookups>");
 
 ///////////////////////////////////////////////////////////////////////////////
 CBanSystem g_BanSystem;
@@ -1,6 +1,8 @@
 #pragma once
 #include "ebisusdk/EbisuTypes.h"
 
+#define BAN_ADDRESS_BITS 128
+
 enum EKickType
 {
 	KICK_NAME = 0,
@@ -31,6 +33,27 @@ public:
 
 	typedef CUtlVector<Banned_t> BannedList_t;
 
+	// IPv4 addresses are stored as IPv4-mapped IPv6 addresses,
+	// the halves are stored in host order to simplify masking.
+	struct BanAddress_t
+	{
+		uint64_t m_High;
+		uint64_t m_Low;
+
+		inline bool operator==(const BanAddress_t& other) const
+		{
+			return m_High == other.m_High && m_Low == other.m_Low;
+		}
+	};
+
+	struct BanAddressHash_t
+	{
+		inline size_t operator()(const BanAddress_t& address) const
+		{
+			return size_t(address.m_High * 0x9E3779B97F4A7C15ull ^ address.m_Low);
+		}
+	};
+
 public:
 	void LoadList(void);
 	void SaveList(void) const;
@@ -49,11 +72,25 @@ public:
 
 	void UnbanPlayer(const char* criteria);
 
+	static void BenchmarkLookups(const int numEntries, const int numLookups);
+
 private:
+	void IndexEntry(const Banned_t& banned, const int delta);
+	void RebuildIndex(void);
+	bool MightBeListed(const char* ipAddress, const NucleusID_t nucleusId) const;
+
 	void AuthorPlayerByName(const char* playerName, const bool bBan, const char* reason = nullptr);
 	void AuthorPlayerById(const char* playerHandle, const bool bBan, const char* reason = nullptr);
 
 	BannedList_t m_BannedList;
+
+	// Lookup indices over the banned list, counting the entries per key.
+	// Entries without a nucleus id or address never match, and are not
+	// indexed. Address ranges (CIDR) are stored per prefix length.
+	std::unordered_map<NucleusID_t, int> m_NucleusIndex;
+	std::unordered_map<BanAddress_t, int, BanAddressHash_t> m_AddressIndex[BAN_ADDRESS_BITS + 1];
+	std::unordered_map<string, int> m_UnparsedAddressIndex; // Lower case.
+	int m_PrefixCount[BAN_ADDRESS_BITS + 1] = {};
 };
 
 extern CBanSystem g_BanSystem;
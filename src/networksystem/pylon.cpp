@@ -9,6 +9,7 @@
 #include <tier1/cvar.h>
 #include <tier2/curlutils.h>
 #include <tier2/jsonutils.h>
+#include <tier0/frametask.h>
 #include <networksystem/pylon.h>
 #include <engine/server/server.h>
 
@@ -18,6 +19,15 @@
 ConVar pylon_matchmaking_hostname("pylon_matchmaking_hostname", "ms.r5reloaded.com", FCVAR_RELEASE | FCVAR_ACCESSIBLE_FROM_THREADS, "Holds the pylon matchmaking hostname");
 ConVar pylon_host_update_interval("pylon_host_update_interval", "5", FCVAR_RELEASE | FCVAR_ACCESSIBLE_FROM_THREADS, "Length of time in seconds between each status update interval to master server", true, 5.f, false, 0.f);
 ConVar pylon_showdebuginfo("pylon_showdebuginfo", "0", FCVAR_RELEASE | FCVAR_ACCESSIBLE_FROM_THREADS, "Shows debug output for pylon");
+ConVar pylon_worker_threads("pylon_worker_threads", "4", FCVAR_RELEASE, "Number of worker threads performing master server requests, takes effect on the first request", true, 1.f, true, 16.f);
+ConVar pylon_bancheck_window("pylon_bancheck_window", "250", FCVAR_RELEASE, "Time in milliseconds to wait for more ban checks to coalesce into a single bulk request", true, 0.f, true, 5000.f);
+
+// Max number of ban checks coalesced into a single bulk request.
+#define PYLON_MAX_BANCHECK_BATCH 128
+
+// Persistent handle of the executor worker running on this thread, requests
+// performed on it reuse its connection. Null on any other thread.
+static thread_local CURL* s_pWorkerCurl = nullptr;
 
 //-----------------------------------------------------------------------------
 // Purpose: checks if server listing fields are valid, and sets outGameServer
@@ -205,9 +215,11 @@ bool CPylon::PostServerHost(string& outMessage, string& outToken, string& outHos
 // Purpose: Checks a list of clients for their banned status.
 // Input  : &inBannedVec - 
 //			&outBannedVec  - 
+//			*personaNames  - (optional, one name per entry in inBannedVec)
 // Output : True on success, false otherwise.
 //-----------------------------------------------------------------------------
-bool CPylon::GetBannedList(const CBanSystem::BannedList_t& inBannedVec, CBanSystem::BannedList_t& outBannedVec) const
+bool CPylon::GetBannedList(const CBanSystem::BannedList_t& inBannedVec, CBanSystem::BannedList_t& outBannedVec,
+    const vector<string>* personaNames) const
 {
     rapidjson::Document requestJson;
     requestJson.SetObject();
@@ -221,6 +233,11 @@ bool CPylon::GetBannedList(const CBanSystem::BannedList_t& inBannedVec, CBanSyst
         const CBanSystem::Banned_t& banned = inBannedVec[i];
         rapidjson::Value player(rapidjson::kObjectType);
 
+        if (personaNames)
+        {
+            player.AddMember("name", rapidjson::Value((*personaNames)[i].c_str(), allocator), allocator);
+        }
+
         player.AddMember("id", banned.m_NucleusID, allocator);
         player.AddMember("ip", rapidjson::Value(banned.m_Address.String(), allocator), allocator);
 
@@ -514,20 +531,39 @@ bool CPylon::QueryServer(const char* endpoint, const char* request,
     params.verbose = curl_debug.GetBool();
 
     curl_slist* sList = nullptr;
-    CURL* curl = CURLInitRequest(finalUrl.c_str(), request, outResponse, sList, params);
-    if (!curl)
+    CURL* curl = s_pWorkerCurl;
+
+    const bool persistent = curl != nullptr;
+
+    if (persistent)
     {
-        return false;
+        curl_easy_reset(curl);
+
+        if (!CURLSetupRequest(curl, finalUrl.c_str(), request, outResponse, sList, params))
+        {
+            return false;
+        }
+
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    }
+    else
+    {
+        curl = CURLInitRequest(finalUrl.c_str(), request, outResponse, sList, params);
+
+        if (!curl)
+        {
+            return false;
+        }
     }
 
     CURLcode res = CURLSubmitRequest(curl, sList);
     if (!CURLHandleError(curl, res, outMessage,
-        !IsDedicated(/* Errors are already shown for dedicated! */)))
+        !IsDedicated(/* Errors are already shown for dedicated! */), !persistent))
     {
         return false;
     }
 
-    outStatus = CURLRetrieveInfo(curl);
+    outStatus = CURLRetrieveInfo(curl, !persistent);
 
     if (showDebug)
     {
@@ -607,5 +643,247 @@ void CPylon::LogBody(const rapidjson::Document& responseJson) const
     Msg(eDLL_T::ENGINE, "\n%s\n", stringBuffer.GetString());
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: CPylonExecutor destructor
+//-----------------------------------------------------------------------------
+CPylonExecutor::~CPylonExecutor()
+{
+    // Workers should have been shut down before static destruction, don't
+    // block the loader on requests that may still be in flight.
+    for (std::thread& worker : m_Workers)
+    {
+        if (worker.joinable())
+            worker.detach();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: queues a job to run on a worker thread, results should be applied
+//          on the main thread through g_TaskQueue.
+// Input  : job - 
+//-----------------------------------------------------------------------------
+void CPylonExecutor::Submit(std::function<void()> job)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if (m_bShutdown)
+    {
+        return;
+    }
+
+    StartWorkers();
+    m_Jobs.push_back(std::move(job));
+
+    lock.unlock();
+    m_WorkAvailable.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: queues a global ban check, checks queued within the ban check window
+//          are performed in a single bulk request.
+// Input  : &ipAddress   - 
+//          nucleusId    - 
+//          &personaName - 
+//          onBanned     - (invoked on the main thread if banned)
+//-----------------------------------------------------------------------------
+void CPylonExecutor::QueueBanCheck(const string& ipAddress, const NucleusID_t nucleusId,
+    const string& personaName, BannedCallback_t onBanned)
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+
+    if (m_bShutdown)
+    {
+        return;
+    }
+
+    StartWorkers();
+
+    const bool firstInWindow = m_BanChecks.empty();
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+    if (firstInWindow)
+    {
+        m_BanCheckDeadline = now + std::chrono::milliseconds(pylon_bancheck_window.GetInt());
+    }
+
+    m_BanChecks.push_back({ ipAddress, nucleusId, personaName, std::move(onBanned) });
+
+    if (m_BanChecks.size() >= PYLON_MAX_BANCHECK_BATCH)
+    {
+        m_BanCheckDeadline = now;
+    }
+
+    lock.unlock();
+
+    // Wake all idle workers on the first check, so they all wait on the
+    // deadline of this window instead of indefinitely.
+    if (firstInWindow)
+        m_WorkAvailable.notify_all();
+    else
+        m_WorkAvailable.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: stops all workers, queued jobs and ban checks are discarded while
+//          requests in flight are completed.
+//-----------------------------------------------------------------------------
+void CPylonExecutor::Shutdown()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+
+        m_bShutdown = true;
+        m_Jobs.clear();
+        m_BanChecks.clear();
+    }
+
+    m_WorkAvailable.notify_all();
+
+    for (std::thread& worker : m_Workers)
+    {
+        if (worker.joinable())
+            worker.join();
+    }
+
+    m_Workers.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: starts the worker pool if it isn't running yet, must be called
+//          while holding the executor mutex.
+//-----------------------------------------------------------------------------
+void CPylonExecutor::StartWorkers()
+{
+    if (!m_Workers.empty())
+    {
+        return;
+    }
+
+    const int numWorkers = pylon_worker_threads.GetInt();
+    m_Workers.reserve(numWorkers);
+
+    for (int i = 0; i < numWorkers; i++)
+    {
+        m_Workers.emplace_back(&CPylonExecutor::WorkerThread, this);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: worker loop, takes the coalesced ban checks once their window has
+//          expired, or the next queued job.
+//-----------------------------------------------------------------------------
+void CPylonExecutor::WorkerThread()
+{
+    // If this fails, requests fall back to a handle per request.
+    s_pWorkerCurl = curl_easy_init();
+
+    for (;;)
+    {
+        std::function<void()> job;
+        vector<BanCheck_s> banChecks;
+
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+
+            while (!m_bShutdown)
+            {
+                if (!m_BanChecks.empty() && std::chrono::steady_clock::now() >= m_BanCheckDeadline)
+                {
+                    banChecks.swap(m_BanChecks);
+                    break;
+                }
+
+                if (!m_Jobs.empty())
+                {
+                    job = std::move(m_Jobs.front());
+                    m_Jobs.pop_front();
+                    break;
+                }
+
+                if (!m_BanChecks.empty())
+                    m_WorkAvailable.wait_until(lock, m_BanCheckDeadline);
+                else
+                    m_WorkAvailable.wait(lock);
+            }
+
+            if (m_bShutdown)
+            {
+                break;
+            }
+        }
+
+        if (job)
+            job();
+        else
+            ProcessBanChecks(banChecks);
+    }
+
+    if (s_pWorkerCurl)
+    {
+        curl_easy_cleanup(s_pWorkerCurl);
+        s_pWorkerCurl = nullptr;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: performs the coalesced ban checks, a single check uses the regular
+//          endpoint while multiple checks are performed in one bulk request;
+//          if the bulk request fails, each player is checked separately.
+// Input  : &banChecks - 
+//-----------------------------------------------------------------------------
+void CPylonExecutor::ProcessBanChecks(vector<BanCheck_s>& banChecks) const
+{
+    CBanSystem::BannedList_t inBannedVec;
+    CBanSystem::BannedList_t outBannedVec;
+    vector<string> personaNames;
+
+    if (banChecks.size() > 1)
+    {
+        personaNames.reserve(banChecks.size());
+
+        for (const BanCheck_s& check : banChecks)
+        {
+            inBannedVec.AddToTail(CBanSystem::Banned_t(check.ipAddress.c_str(), check.nucleusId));
+            personaNames.push_back(check.personaName);
+        }
+
+        if (g_MasterServer.GetBannedList(inBannedVec, outBannedVec, &personaNames))
+        {
+            FOR_EACH_VEC(outBannedVec, i)
+            {
+                // The bulk endpoint returns the banned reason in the address field.
+                const CBanSystem::Banned_t& banned = outBannedVec[i];
+                const string reason = banned.m_Address.String();
+
+                for (const BanCheck_s& check : banChecks)
+                {
+                    if (check.nucleusId != banned.m_NucleusID)
+                        continue;
+
+                    BannedCallback_t onBanned = check.onBanned;
+                    g_TaskQueue.Dispatch([onBanned, reason] { onBanned(reason); }, 0);
+                }
+            }
+
+            return;
+        }
+
+        // The bulk request failed, check each player separately so a failing
+        // bulk endpoint doesn't let banned players through.
+    }
+
+    for (const BanCheck_s& check : banChecks)
+    {
+        string reason;
+
+        if (g_MasterServer.CheckForBan(check.ipAddress, check.nucleusId, check.personaName, reason))
+        {
+            BannedCallback_t onBanned = check.onBanned;
+            g_TaskQueue.Dispatch([onBanned, reason] { onBanned(reason); }, 0);
+        }
+    }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 CPylon g_MasterServer;
+CPylonExecutor g_PylonExecutor;
@@ -1,4 +1,6 @@
 #pragma once
+#include <condition_variable>
+#include <deque>
 #include "thirdparty/curl/include/curl/curl.h"
 #include "bansystem.h"
 #include "serverlisting.h"
@@ -7,6 +9,8 @@
 extern ConVar pylon_matchmaking_hostname;
 extern ConVar pylon_host_update_interval;
 extern ConVar pylon_showdebuginfo;
+extern ConVar pylon_worker_threads;
+extern ConVar pylon_bancheck_window;
 
 struct MSEulaData_t
 {
@@ -24,7 +28,8 @@ public:
 	bool GetServerByToken(NetGameServer_t& slOutServer, string& outMessage, const string& svToken) const;
 	bool PostServerHost(string& outMessage, string& svOutToken, string& outHostIp, const NetGameServer_t& netGameServer) const;
 
-	bool GetBannedList(const CBanSystem::BannedList_t& inBannedVec, CBanSystem::BannedList_t& outBannedVec) const;
+	bool GetBannedList(const CBanSystem::BannedList_t& inBannedVec, CBanSystem::BannedList_t& outBannedVec,
+		const vector<string>* personaNames = nullptr) const;
 	bool CheckForBan(const string& ipAddress, const uint64_t nucleusId, const string& personaName, string& outReason) const;
 
 	bool AuthForConnection(const uint64_t nucleusId, const char* ipAddress, const char* authCode, string& outToken, string& outMessage) const;
@@ -54,3 +59,50 @@ private:
 	mutable CThreadFastMutex m_StringMutex;
 };
 extern CPylon g_MasterServer;
+
+//-----------------------------------------------------------------------------
+// Runs master server requests on a bounded pool of worker threads, each worker
+// keeps its connection alive between requests. Ban checks queued within the
+// window of 'pylon_bancheck_window' are coalesced into a single bulk request.
+//-----------------------------------------------------------------------------
+class CPylonExecutor
+{
+public:
+	// Invoked on the main thread through g_TaskQueue if the client is banned.
+	typedef std::function<void(const string& reason)> BannedCallback_t;
+
+	CPylonExecutor() : m_bShutdown(false) {};
+	~CPylonExecutor();
+
+	void Submit(std::function<void()> job);
+	void QueueBanCheck(const string& ipAddress, const NucleusID_t nucleusId,
+		const string& personaName, BannedCallback_t onBanned);
+
+	void Shutdown();
+
+private:
+	struct BanCheck_s
+	{
+		string ipAddress;
+		NucleusID_t nucleusId;
+		string personaName;
+		BannedCallback_t onBanned;
+	};
+
+	void StartWorkers();
+	void WorkerThread();
+
+	void ProcessBanChecks(vector<BanCheck_s>& banChecks) const;
+
+	vector<std::thread> m_Workers;
+	std::deque<std::function<void()>> m_Jobs;
+
+	vector<BanCheck_s> m_BanChecks;
+	std::chrono::steady_clock::time_point m_BanCheckDeadline;
+
+	std::mutex m_Mutex;
+	std::condition_variable m_WorkAvailable;
+
+	bool m_bShutdown;
+};
+extern CPylonExecutor g_PylonExecutor;
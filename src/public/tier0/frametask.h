@@ -2,6 +2,33 @@
 #define TIER0_FRAMETASK_H
 
 #include "public/iframetask.h"
+#include "tier0/tslist.h"
+
+#define FRAMETASK_WHEEL_SIZE 256 // Must be a power of 2; longer delays take multiple turns.
+#define FRAMETASK_INLINE_SIZE 64 // Functors up to this size are stored in the task itself.
+#define FRAMETASK_MAX_FREE_TASKS 1024 // Recycled tasks kept around for reuse.
+
+//-----------------------------------------------------------------------------
+// Task queued in CFrameTask, recycled through a free list so dispatching
+// small functors never allocates
+//-----------------------------------------------------------------------------
+struct ALIGN16 FrameTask_s : public TSQueueNode_t, public TSStackNode_t
+{
+    typedef void (*FnInvoke_t)(void* pFunctor);
+    typedef void (*FnDestroy_t)(void* pFunctor);
+
+    FrameTask_s() : m_pWheelNext(nullptr), m_nDueFrame(0),
+        m_pInvoke(nullptr), m_pDestroy(nullptr), m_pFunctor(nullptr) {}
+
+    FrameTask_s* m_pWheelNext;
+    uint64_t m_nDueFrame; // Delay in frames until scheduled in the wheel.
+
+    FnInvoke_t m_pInvoke;
+    FnDestroy_t m_pDestroy;
+    void* m_pFunctor; // Points into m_Storage, or to the heap if it didn't fit.
+
+    ALIGN16 char m_Storage[FRAMETASK_INLINE_SIZE];
+};
 
 //=============================================================================//
 // This class is set up to run before each frame, committed tasks are scheduled
@@ -11,19 +38,70 @@
 // performing a web request in a separate thread, and apply the results (such as
 // server lists in the browser) onto the imgui panels which are created/drawn in
 // the main thread
+// ----------------------------------------------------------------------------
+// Any thread may dispatch; tasks are pushed onto a lock-free queue which the
+// thread calling RunFrame drains into a timing wheel indexed by frame, so
+// each frame only touches the tasks that are due. Callbacks run without any
+// lock held, and may dispatch new tasks.
 //=============================================================================//
 class CFrameTask : public IFrameTask
 {
 public:
-    virtual ~CFrameTask() {}
+    CFrameTask();
+    virtual ~CFrameTask();
     virtual void RunFrame();
     virtual bool IsFinished() const;
 
-    void Dispatch(std::function<void()> functor, unsigned int frames);
+    //-----------------------------------------------------------------------------
+    // Purpose: adds functor to the queue, to be called after 'frames' frames
+    //          (0 = the next frame). Can be called from any thread.
+    // Input  : &&functor - 
+    //          frames - 
+    //-----------------------------------------------------------------------------
+    template <typename Functor>
+    void Dispatch(Functor&& functor, const unsigned int frames)
+    {
+        typedef typename std::decay<Functor>::type Functor_t;
+        FrameTask_s* const pTask = AllocTask();
+
+        if constexpr (sizeof(Functor_t) <= FRAMETASK_INLINE_SIZE && alignof(Functor_t) <= 16)
+        {
+            pTask->m_pFunctor = new (pTask->m_Storage) Functor_t(std::forward<Functor>(functor));
+            pTask->m_pDestroy = [](void* pFunctor) { static_cast<Functor_t*>(pFunctor)->~Functor_t(); };
+        }
+        else
+        {
+            pTask->m_pFunctor = new Functor_t(std::forward<Functor>(functor));
+            pTask->m_pDestroy = [](void* pFunctor) { delete static_cast<Functor_t*>(pFunctor); };
+        }
+
+        pTask->m_pInvoke = [](void* pFunctor) { (*static_cast<Functor_t*>(pFunctor))(); };
+        pTask->m_nDueFrame = frames;
+
+        m_SubmitQueue.Push(pTask);
+    }
 
 private:
-    mutable CThreadMutex m_Mutex;
-    std::list<QueuedTasks_s> m_QueuedTasks;
+    FrameTask_s* AllocTask();
+    void FreeTask(FrameTask_s* const pTask);
+
+    void ScheduleTask(FrameTask_s* const pTask);
+
+    CTSQueueMPSC m_SubmitQueue;
+    CTSStack m_FreeTasks;
+
+    // Tasks in each slot are kept in dispatch order.
+    struct WheelSlot_s
+    {
+        FrameTask_s* m_pHead;
+        FrameTask_s* m_pTail;
+    };
+
+    static void AppendTask(WheelSlot_s& slot, FrameTask_s* const pTask);
+
+    // Only accessed by the thread calling RunFrame.
+    WheelSlot_s m_Wheel[FRAMETASK_WHEEL_SIZE];
+    uint64_t m_nFrame;
 };
 
 extern std::list<IFrameTask*> g_TaskQueueList;
@@ -28,6 +28,7 @@ public:
 	void LoadSections();
 
 	CMemory FindPatternSIMD(const char* szPattern, const ModuleSections_t* moduleSection = nullptr) const;
+	size_t  FindPatternsSIMD(const char* const* pszPatterns, const size_t nPatternCount, CMemory* pResults, const ModuleSections_t* moduleSection = nullptr) const;
 	CMemory FindString(const char* szString, const ptrdiff_t occurrence = 1, bool nullTerminator = false) const;
 	CMemory FindStringReadOnly(const char* szString, bool nullTerminator) const;
 	CMemory FindFreeDataPage(const size_t nSize) const;
@@ -70,13 +71,20 @@ public:
 	void                 UnlinkFromPEB(void) const;
 
 private:
+	friend void PatternScan_Benchmark(const CModule& module, const size_t nBufferSize, const size_t nMaxPatterns);
+
 	CMemory FindPatternSIMD(const uint8_t* pPattern, const char* szMask,
 		const ModuleSections_t* moduleSection = nullptr, const size_t nOccurrence = 0) const;
 
+	static void FindPatternsInRange(const uint8_t* pBase, const size_t nSize,
+		const char* const* pszPatterns, const size_t nPatternCount, CMemory* pResults);
+
 	QWORD                m_pModuleBase;
 	DWORD                m_nModuleSize;
 	string               m_ModuleName;
 	ModuleSectionsMap_t  m_ModuleSections;
 };
 
+void PatternScan_Benchmark(const CModule& module, const size_t nBufferSize, const size_t nMaxPatterns);
+
 #endif // MODULE_H
\ No newline at end of file
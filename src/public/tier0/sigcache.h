@@ -1,38 +1,106 @@
 #ifndef SIGCACHE_H
 #define SIGCACHE_H
 
-#include "protoc/sig_map.pb.h"
-
 #define SIGDB_MAGIC	(('p'<<24)+('a'<<16)+('M'<<8)+'S')
 #define SIGDB_DICT_SIZE 20
 
-#define SIGDB_MAJOR_VERSION 0x2 // Increment when library changes are made.
+#define SIGDB_MAJOR_VERSION 0x4 // Increment when library changes are made.
 #define SIGDB_MINOR_VERSION 0xB // Increment when SDK updates are released.
 
+#define SIGDB_LEGACY_MAJOR_VERSION 0x2 // Compressed protobuf map.
+#define SIGDB_BLOB_OFFSET 32 // Aligned start of the table past the header.
+
+//-----------------------------------------------------------------------------
+// On-disk table layout, the blob starts at SIGDB_BLOB_OFFSET and is used
+// directly from the mapped file:
+//
+//   SigDBTableHeader_t header;
+//   SigDBEntry_t       entries[m_nEntryCount];       // Sorted on hash.
+//   uint32_t           stringOffsets[m_nEntryCount]; // Into the string pool.
+//   uint8_t            entryKinds[m_nEntryCount];    // SigDBEntryKind_e.
+//   char               stringPool[m_nStringPoolSize];
+//
+// The pattern strings are only read when the cache is outdated, so the
+// game executable patterns could be resolved again in a single batch.
+//-----------------------------------------------------------------------------
+struct SigDBTableHeader_t
+{
+	uint32_t m_nEntryCount;
+	uint32_t m_nStringPoolSize;
+};
+
+struct SigDBEntry_t
+{
+	uint64_t m_nHash;
+	uint64_t m_nRVA;
+};
+
+enum SigDBEntryKind_e : uint8_t
+{
+	SIGDB_ENTRY_OTHER = 0,   // Strings, virtual tables and patterns of other modules.
+	SIGDB_ENTRY_GAME_PATTERN // Byte pattern in the code section of the game executable.
+};
+
+struct SigCacheEntry_t
+{
+	uint64_t m_nRVA;
+	SigDBEntryKind_e m_nKind;
+};
+
 class CSigCache
 {
 public:
 	CSigCache()
 		: m_bInitialized(false)
-		, m_bDisabled(false) {};
-	~CSigCache() {};
+		, m_bDisabled(false)
+		, m_hFile(INVALID_HANDLE_VALUE)
+		, m_hMapping(NULL)
+		, m_pMappedView(nullptr)
+		, m_pEntries(nullptr)
+		, m_nEntryCount(0) {};
+	~CSigCache() { UnmapCache(); };
 
 	void SetDisabled(const bool bDisabled);
 	void InvalidateMap();
 
-	void AddEntry(const char* szPattern, const uint64_t nRVA);
+	void AddEntry(const char* szPattern, const uint64_t nRVA, const SigDBEntryKind_e nKind = SIGDB_ENTRY_OTHER);
 	bool FindEntry(const char* szPattern, uint64_t& nRVA);
 
+	// Game executable patterns of a cache file from another SDK build, most
+	// of these are still in use but their RVA's have to be resolved again.
+	inline const vector<string>& GetStalePatterns() const { return m_StalePatterns; }
+	void ClearStalePatterns();
+
 	bool ReadCache(const char* szCacheFile);
 	bool WriteCache(const char* szCacheFile) const;
 
+	static bool ConvertLegacyCache(const char* szLegacyFile, const char* szCacheFile);
+
 private:
-	bool CompressBlob(const size_t nSrcLen, size_t& nDstLen, uint32_t& nAdler32, const uint8_t* pSrcBuf, uint8_t* pDstBuf) const;
-	bool DecompressBlob(const size_t nSrcLen, size_t& nDstLen, uint32_t& nAdler32, const uint8_t* pSrcBuf, uint8_t* pDstBuf) const;
+	bool MapCache(const char* szCacheFile, size_t& nFileSize);
+	void UnmapCache();
+
+	void HarvestPatterns(const uint8_t* pBlob, const size_t nBlobSize);
+
+	static bool ReadLegacyCache(const char* szCacheFile, std::unordered_map<string, uint64_t>& entries, uint16_t& nMinorVersion);
+	static bool WriteTable(const char* szCacheFile, const std::unordered_map<string, SigCacheEntry_t>& entries, const uint16_t nMinorVersion);
+	static void ConvertLegacyEntries(const std::unordered_map<string, uint64_t>& legacyEntries, std::unordered_map<string, SigCacheEntry_t>& entries);
+
+	static bool DecompressBlob(const size_t nSrcLen, size_t& nDstLen, uint32_t& nAdler32, const uint8_t* pSrcBuf, uint8_t* pDstBuf);
+
+	// Entries added during this session, written out if the cache is invalid.
+	std::unordered_map<string, SigCacheEntry_t> m_NewEntries;
+	vector<string> m_StalePatterns;
 
-	SigMap_Pb m_Cache;
 	bool m_bInitialized;
 	bool m_bDisabled;
+
+	HANDLE m_hFile;
+	HANDLE m_hMapping;
+	const uint8_t* m_pMappedView;
+
+	const SigDBEntry_t* m_pEntries;
+	uint32_t m_nEntryCount;
 };
 extern CSigCache g_SigCache;
 
@@ -48,4 +116,6 @@ struct SigDBHeader_t
 };
 #pragma pack(pop)
 
+static_assert(sizeof(SigDBHeader_t) <= SIGDB_BLOB_OFFSET);
+
 #endif // !SIGCACHE_H
@@ -1,5 +1,6 @@
 #ifndef TSLIST_H
 #define TSLIST_H
+#include <atomic>
 
 //-----------------------------------------------------------------------------
 // 
@@ -38,6 +39,118 @@ inline CAlignedMemAlloc* AlignedMemAlloc()
 	return g_pAlignedMemAlloc;
 }
 
+//-----------------------------------------------------------------------------
+// Intrusive node for CTSQueueMPSC, derive queued items from this
+//-----------------------------------------------------------------------------
+struct TSQueueNode_t
+{
+	TSQueueNode_t() : m_pNext(nullptr) {}
+	std::atomic<TSQueueNode_t*> m_pNext;
+};
+
+//-----------------------------------------------------------------------------
+// Lock-free intrusive multi-producer single-consumer queue. Any thread may
+// push, but only one thread at a time may pop. Pushing never blocks and costs
+// a single atomic exchange; nodes are owned by the caller and must outlive
+// their stay in the queue.
+//-----------------------------------------------------------------------------
+class CTSQueueMPSC
+{
+public:
+	CTSQueueMPSC()
+		: m_pHead(&m_Stub)
+		, m_pTail(&m_Stub) {}
+
+	//-----------------------------------------------------------------------------
+	// Purpose: appends a node to the queue (any thread)
+	//-----------------------------------------------------------------------------
+	inline void Push(TSQueueNode_t* const pNode)
+	{
+		pNode->m_pNext.store(nullptr, std::memory_order_relaxed);
+		TSQueueNode_t* const pPrev = m_pHead.exchange(pNode, std::memory_order_acq_rel);
+
+		// Between the exchange and this store the queue is momentarily
+		// disconnected, the consumer treats this as empty and retries later.
+		pPrev->m_pNext.store(pNode, std::memory_order_release);
+	}
+
+	//-----------------------------------------------------------------------------
+	// Purpose: removes the oldest node from the queue (consumer thread only)
+	// Output : the node, or nullptr if the queue is empty
+	//-----------------------------------------------------------------------------
+	inline TSQueueNode_t* Pop()
+	{
+		TSQueueNode_t* pTail = m_pTail;
+		TSQueueNode_t* pNext = pTail->m_pNext.load(std::memory_order_acquire);
+
+		if (pTail == &m_Stub)
+		{
+			if (!pNext)
+				return nullptr;
+
+			m_pTail = pNext;
+			pTail = pNext;
+			pNext = pNext->m_pNext.load(std::memory_order_acquire);
+		}
+
+		if (pNext)
+		{
+			m_pTail = pNext;
+			return pTail;
+		}
+
+		if (pTail != m_pHead.load(std::memory_order_acquire))
+			return nullptr; // A producer is mid push.
+
+		// Last node in the queue, re-insert the stub so it can be detached.
+		Push(&m_Stub);
+		pNext = pTail->m_pNext.load(std::memory_order_acquire);
+
+		if (pNext)
+		{
+			m_pTail = pNext;
+			return pTail;
+		}
+
+		return nullptr;
+	}
+
+private:
+	std::atomic<TSQueueNode_t*> m_pHead;
+	char m_Pad[64 - sizeof(std::atomic<TSQueueNode_t*>)]; // Keep producers and the consumer on separate cache lines.
+	TSQueueNode_t* m_pTail;
+	TSQueueNode_t m_Stub;
+};
+
+//-----------------------------------------------------------------------------
+// Intrusive node for CTSStack, derive stacked items from this
+//-----------------------------------------------------------------------------
+struct TSStackNode_t : public SLIST_ENTRY
+{
+	TSStackNode_t() { Next = nullptr; }
+};
+
+//-----------------------------------------------------------------------------
+// Lock-free intrusive LIFO stack on top of the interlocked SList, any thread
+// may push and pop. Suitable for free lists of recycled items, as opposed to
+// CTSQueueMPSC which only allows a single consumer. Nodes are owned by the
+// caller and must be 16 byte aligned.
+//-----------------------------------------------------------------------------
+class ALIGN16 CTSStack
+{
+public:
+	CTSStack() { InitializeSListHead(&m_Head); }
+
+	inline void Push(TSStackNode_t* const pNode) { InterlockedPushEntrySList(&m_Head, pNode); }
+	inline TSStackNode_t* Pop() { return static_cast<TSStackNode_t*>(InterlockedPopEntrySList(&m_Head)); }
+
+	// Number of nodes on the stack, only a snapshot under contention.
+	inline unsigned short Count() { return QueryDepthSList(&m_Head); }
+
+private:
+	SLIST_HEADER m_Head;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 class VTSListBase : public IDetour
 {
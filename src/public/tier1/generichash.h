@@ -112,5 +112,8 @@ uint32 MurmurHash2LowerCase(char const* pString, uint32 nSeed);
 
 uint64 MurmurHash64(const void* key, int len, uint32 seed);
 
+// 128 bit murmurhash3 (x64 variant), for hashing large blocks of data
+void MurmurHash3_128(const void* key, size_t len, uint32 seed, uint64 out[2]);
+
 
 #endif /* !GENERICHASH_H */
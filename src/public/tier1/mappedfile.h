@@ -0,0 +1,47 @@
+//===========================================================================//
+//
+// Purpose: Read-only memory mapped file views
+//
+//===========================================================================//
+#ifndef TIER1_MAPPEDFILE_H
+#define TIER1_MAPPEDFILE_H
+
+//-----------------------------------------------------------------------------
+// Access pattern hint for mapped file views
+//-----------------------------------------------------------------------------
+enum class FileMapAccess_t
+{
+	FILEMAP_ACCESS_SEQUENTIAL = 0, // Read front to back; opened for sequential scan.
+	FILEMAP_ACCESS_RANDOM          // Scattered reads; no read-ahead.
+};
+
+//-----------------------------------------------------------------------------
+// A read-only view of a whole file mapped into memory. Anything pointing into
+// the view becomes invalid once it is unmapped or destroyed.
+//-----------------------------------------------------------------------------
+class CMappedFileView
+{
+public:
+	CMappedFileView();
+	~CMappedFileView();
+
+	bool Map(const char* pFullPath, const FileMapAccess_t access);
+	void Unmap();
+
+	void PrefetchRange(const ptrdiff_t nOffset, const ssize_t nSize) const;
+
+	inline bool IsMapped() const { return m_pData != nullptr; }
+	inline const uint8_t* Base() const { return m_pData; }
+	inline ssize_t Size() const { return m_nSize; }
+
+private:
+	CMappedFileView(const CMappedFileView&) = delete;
+	CMappedFileView& operator=(const CMappedFileView&) = delete;
+
+	HANDLE m_hFile;
+	HANDLE m_hMapping;
+	const uint8_t* m_pData;
+	ssize_t m_nSize;
+};
+
+#endif // TIER1_MAPPEDFILE_H
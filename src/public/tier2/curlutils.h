@@ -53,11 +53,13 @@ bool CURLDownloadFile(const char* remote, const char* savePath, const char* file
 
 CURL* CURLInitRequest(const char* remote, const char* request, string& outResponse,
 	curl_slist*& slist, const CURLParams& params);
+bool CURLSetupRequest(CURL* curl, const char* remote, const char* request, string& outResponse,
+	curl_slist*& slist, const CURLParams& params);
 
 CURLcode CURLSubmitRequest(CURL* curl, curl_slist*& slist);
-CURLINFO CURLRetrieveInfo(CURL* curl);
+CURLINFO CURLRetrieveInfo(CURL* curl, const bool cleanup = true);
 
-bool CURLHandleError(CURL* curl, const CURLcode res, string& outMessage, const bool logError);
+bool CURLHandleError(CURL* curl, const CURLcode res, string& outMessage, const bool logError, const bool cleanup = true);
 void CURLFormatUrl(string& outUrl, const char* host, const char* api);
 
 #endif // !TIER2_CURLUTILS_H
\ No newline at end of file
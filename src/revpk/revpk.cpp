@@ -20,6 +20,7 @@
 
 #define PACK_COMMAND "pack"
 #define UNPACK_COMMAND "unpack"
+#define READBENCH_COMMAND "readbench"
 
 #define PACK_LOG_DIR "manifest/pack_logs/"
 #define UNPACK_LOG_DIR "manifest/unpack_logs/"
@@ -91,12 +92,19 @@ static void ReVPK_Usage()
         "\t<%s>\t- ( optional ) path to the workspace containing the manifest file\n"
         "\t<%s>\t- ( optional ) path in which the VPK files will be built\n"
         "\t<%s>\t- ( optional ) max LZHAM helper threads [\"%d\", \"%d\"] \"%d\" ( default ) for max practical\n"
-        "\t<%s>\t- ( optional ) the level of compression [\"%s\", \"%s\", \"%s\", \"%s\", \"%s\"]\n\n"
+        "\t<%s>\t- ( optional ) the level of compression [\"%s\", \"%s\", \"%s\", \"%s\", \"%s\"]\n"
+        "\t<%s>\t- ( optional ) number of threads reading and compressing entries \"%d\" ( default ) for all logical processors\n"
+        "\t<%s>\t- ( optional ) whether to carve deduplicated entries on content-defined boundaries\n\n"
 
         "For unpacking; run 'revpk %s' with the following parameters:\n"
         "\t<%s>\t- path and name of the target VPK files\n"
         "\t<%s>\t- ( optional ) path in which the VPK files will be unpacked\n"
-        "\t<%s>\t- ( optional ) whether to parse the directory file name from the pack file name\n",
+        "\t<%s>\t- ( optional ) whether to parse the directory file name from the pack file name\n"
+        "\t<%s>\t- ( optional ) number of threads extracting entries \"%d\" ( default ) for all logical processors\n\n"
+
+        "For benchmarking file reads; run 'revpk %s' with the following parameters:\n"
+        "\t<%s>\t- path and name of the file to read ( preferably a large pack file )\n"
+        "\t<%s>\t- ( optional ) number of passes per read method \"%d\" ( default )\n",
 
         PACK_COMMAND, // Pack parameters:
         "locale", g_LanguageNames[0],
@@ -110,8 +118,17 @@ static void ReVPK_Usage()
         "compressLevel", // Compress level.
         "fastest", "faster", "default", "better", "uber",
 
+        "numWorkers", // Num worker threads.
+        -1,
+
+        "contentChunking", // Content-defined chunking.
+
         UNPACK_COMMAND,// Unpack parameters:
-        "fileName", "outPath", "sanitize"
+        "fileName", "outPath", "sanitize",
+        "numWorkers", -1, // Num worker threads.
+
+        READBENCH_COMMAND, // Read benchmark parameters:
+        "fileName", "numPasses", 3
     );
 
     Warning(eDLL_T::FS, "%s", usage.Get());
@@ -199,6 +216,9 @@ static void ReVPK_Pack(const CCommand& args)
         argCount > 7 ? (std::min)(atoi(args.Arg(7)), LZHAM_MAX_HELPER_THREADS) : -1, // Num threads.
         argCount > 8 ? args.Arg(8) : "default"); // Compress level.
 
+    builder.InitWorkerThreads(argCount > 9 ? atoi(args.Arg(9)) : -1); // Num workers.
+    builder.InitChunking(argCount > 10 ? atoi(args.Arg(10)) != NULL : false); // Content-defined chunking.
+
     builder.PackStore(pair, workspacePath.String(), buildPath.String());
 
     timer.End();
@@ -247,6 +267,8 @@ static void ReVPK_Unpack(const CCommand& args)
     CPackedStoreBuilder builder;
 
     builder.InitLzDecoder();
+    builder.InitWorkerThreads(argCount > 5 ? atoi(args.Arg(5)) : -1); // Num workers.
+
     builder.UnpackStore(vpk, argCount > 3 ? args.Arg(3) : "ship/");
 
     timer.End();
@@ -254,6 +276,151 @@ static void ReVPK_Unpack(const CCommand& args)
     Msg(eDLL_T::FS, "\n");
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: touches every byte of the buffer so mapped pages are faulted in
+// Input  : &buf    - 
+//          bRandom - whether to visit the pages in a scattered order
+// Output : checksum, to keep the reads from being optimized away
+//-----------------------------------------------------------------------------
+static uint64_t ReVPK_ScanBuffer(const CUtlBuffer& buf, const bool bRandom)
+{
+    const uint8_t* const pData = reinterpret_cast<const uint8_t*>(buf.Base());
+    const size_t nSize = size_t(buf.TellMaxPut());
+
+    const size_t nPageSize = 4096;
+    const size_t nNumPages = (nSize + nPageSize - 1) / nPageSize;
+
+    // Stride through the pages with a large step coprime with the page count,
+    // so every page is visited exactly once in a scattered order.
+    size_t nStep = 1;
+
+    if (bRandom && nNumPages > 2)
+    {
+        nStep = (nNumPages / 2) | 1;
+
+        for (;;)
+        {
+            size_t a = nNumPages, b = nStep;
+
+            while (b)
+            {
+                const size_t t = a % b;
+                a = b;
+                b = t;
+            }
+
+            if (a == 1)
+                break;
+
+            nStep += 2;
+        }
+    }
+
+    uint64_t nSum = 0;
+
+    for (size_t i = 0, nCurPage = 0; i < nNumPages; i++, nCurPage = (nCurPage + nStep) % nNumPages)
+    {
+        const size_t nStart = nCurPage * nPageSize;
+        const size_t nEnd = Min(nStart + nPageSize, nSize);
+
+        for (size_t j = nStart; j < nEnd; j += sizeof(uint64_t))
+        {
+            uint64_t nValue = 0;
+            memcpy(&nValue, &pData[j], Min(sizeof(uint64_t), nEnd - j));
+
+            nSum += nValue;
+        }
+    }
+
+    return nSum;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compares buffered reads against mapped reads of a large file
+//-----------------------------------------------------------------------------
+static void ReVPK_ReadBench(const CCommand& args)
+{
+    const int argCount = args.ArgC();
+
+    if (argCount < 3)
+    {
+        ReVPK_Usage();
+        return;
+    }
+
+    const char* fileName = args.Arg(2);
+    const int numPasses = argCount > 3 ? Max(atoi(args.Arg(3)), 1) : 3;
+
+    const ssize_t fileSize = FileSystem()->FSize(fileName, "PLATFORM");
+
+    if (!fileSize)
+    {
+        Error(eDLL_T::FS, NO_ERROR, "Failed to open file \"%s\" or file is empty!\n", fileName);
+        return;
+    }
+
+    Msg(eDLL_T::FS, "*** Starting read benchmark for: '%s' (%.1f MiB, %d passes)\n",
+        fileName, double(fileSize) / (1024.0 * 1024.0), numPasses);
+
+    struct ReadMethod_s
+    {
+        const char* name;
+        bool mapped;
+        FileMapAccess_t access;
+    };
+
+    const ReadMethod_s methods[] =
+    {
+        { "ReadFile",                    false, FileMapAccess_t::FILEMAP_ACCESS_SEQUENTIAL },
+        { "ReadFileMapped (sequential)", true,  FileMapAccess_t::FILEMAP_ACCESS_SEQUENTIAL },
+        { "ReadFileMapped (random)",     true,  FileMapAccess_t::FILEMAP_ACCESS_RANDOM },
+    };
+
+    for (const ReadMethod_s& method : methods)
+    {
+        double bestSeconds = DBL_MAX;
+        double totalSeconds = 0.0;
+        uint64_t checksum = 0;
+
+        for (int i = 0; i < numPasses; i++)
+        {
+            CUtlBuffer buf;
+            CMappedFileView view;
+
+            CFastTimer timer;
+            timer.Start();
+
+            const bool success = method.mapped
+                ? FileSystem()->ReadFileMapped(fileName, "PLATFORM", buf, view, method.access)
+                : FileSystem()->ReadFile(fileName, "PLATFORM", buf);
+
+            if (!success)
+            {
+                Error(eDLL_T::FS, NO_ERROR, "%s failed to read \"%s\"!\n", method.name, fileName);
+                break;
+            }
+
+            checksum = ReVPK_ScanBuffer(buf, method.access == FileMapAccess_t::FILEMAP_ACCESS_RANDOM);
+
+            timer.End();
+
+            const double seconds = timer.GetDuration().GetSeconds();
+
+            bestSeconds = Min(bestSeconds, seconds);
+            totalSeconds += seconds;
+        }
+
+        if (bestSeconds == DBL_MAX)
+            continue;
+
+        Msg(eDLL_T::FS, "%-28s: best '%lf' avg '%lf' seconds (%.1f MiB/s) checksum '%llx'\n",
+            method.name, bestSeconds, totalSeconds / numPasses,
+            (double(fileSize) / (1024.0 * 1024.0)) / bestSeconds, checksum);
+    }
+
+    Msg(eDLL_T::FS, "\n");
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: 
 //-----------------------------------------------------------------------------
@@ -283,6 +450,9 @@ int main(int argc, char* argv[])
         else if (V_strcmp(args.Arg(1), UNPACK_COMMAND) == NULL) {
             ReVPK_Unpack(args);
         }
+        else if (V_strcmp(args.Arg(1), READBENCH_COMMAND) == NULL) {
+            ReVPK_ReadBench(args);
+        }
         else {
             ReVPK_Usage();
         }
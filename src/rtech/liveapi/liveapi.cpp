@@ -4,8 +4,17 @@
 // 
 //===========================================================================//
 #include "liveapi.h"
+#include "protobuf/io/coded_stream.h"
 #include "protobuf/util/json_util.h"
 
+#pragma warning(push)
+#pragma warning(disable : 4505)
+#include "protoc/events.pb.h"
+#pragma warning(pop)
+
+#define LIVE_API_TYPE_URL_PREFIX "type.googleapis.com/"
+#define LIVE_API_WIRE_TAG(fieldNum, wireType) uint8_t(((fieldNum) << 3) | (wireType))
+
 #include "DirtySDK/dirtysock.h"
 #include "DirtySDK/dirtysock/netconn.h"
 #include "DirtySDK/proto/protossl.h"
@@ -52,7 +61,12 @@ static ConVar liveapi_keepalive("liveapi_keepalive", "30", FCVAR_RELEASE | FCVAR
 static ConVar liveapi_lax_ssl("liveapi_lax_ssl", "1", FCVAR_RELEASE | FCVAR_SERVER_FRAME_THREAD, "Skip SSL certificate validation for all WSS connections (allows the use of self-signed certificates)", &LiveAPI_ParamsChangedCallback);
 
 // Print core
-static ConVar liveapi_print_enabled("liveapi_print_enabled", "0", FCVAR_RELEASE | FCVAR_SERVER_FRAME_THREAD, "Whether to enable the printing of all events to a LiveAPI JSON file");
+static ConVar liveapi_print_enabled("liveapi_print_enabled", "0", FCVAR_RELEASE | FCVAR_SERVER_FRAME_THREAD, "Whether to enable the recording of all events to a LiveAPI match file");
+static ConVar liveapi_print_json("liveapi_print_json", "0", FCVAR_RELEASE | FCVAR_SERVER_FRAME_THREAD, "Whether to print events to a JSON text file instead of a binary match recording");
+static ConVar liveapi_print_compression_level("liveapi_print_compression_level", "3", FCVAR_RELEASE | FCVAR_SERVER_FRAME_THREAD, "ZStandard compression level of the binary match recording blocks, 0 stores them uncompressed", true, 0.f, true, 22.f);
+
+// WebSocket transmission parameters
+static ConVar liveapi_batch_events("liveapi_batch_events", "0", FCVAR_RELEASE | FCVAR_SERVER_FRAME_THREAD, "Whether to pack the events of a frame into a single WebSocket message, each event is prefixed with its varint encoded size");
 
 // Print parameters
 static ConVar liveapi_print_pretty("liveapi_print_pretty", "0", FCVAR_RELEASE | FCVAR_SERVER_FRAME_THREAD, "Whether to print events in a formatted manner to the LiveAPI JSON file");
@@ -63,12 +77,26 @@ static ConVar liveapi_print_primitive("liveapi_print_primitive", "0", FCVAR_RELE
 //-----------------------------------------------------------------------------
 LiveAPI::LiveAPI()
 {
+	pendingEvents = 0;
+	workPending = false;
+	workerRunning = false;
 	matchLogCount = 0;
 	initialLog = false;
+	loggerActive = false;
 	initialized = false;
 }
 LiveAPI::~LiveAPI()
 {
+	// Shutdown() should have joined the worker already, but don't take the
+	// process down with us if it didn't.
+	if (workerThread.joinable())
+	{
+		workerThread.detach();
+		return;
+	}
+
+	while (TSQueueNode_t* const node = freeQueue.Pop())
+		delete static_cast<LiveAPIQueuedEvent_s*>(node);
 }
 
 //-----------------------------------------------------------------------------
@@ -80,6 +108,8 @@ void LiveAPI::Init()
 		return;
 
 	InitWebSocket();
+	StartWorker();
+
 	initialized = true;
 }
 
@@ -88,8 +118,12 @@ void LiveAPI::Init()
 //-----------------------------------------------------------------------------
 void LiveAPI::Shutdown()
 {
-	webSocketSystem.Shutdown();
+	// Close the logger and flush all pending events before the sockets go
+	// down, so nothing gets lost or truncated.
 	DestroyLogger();
+	StopWorker();
+
+	ShutdownWebSocket();
 	initialized = false;
 }
 
@@ -130,6 +164,7 @@ void LiveAPI::UpdateParams()
 	CWebSocket::ConnParams_s connParams;
 	CreateParams(connParams);
 
+	std::lock_guard<std::mutex> lock(webSocketMutex);
 	webSocketSystem.UpdateParams(connParams);
 }
 
@@ -145,6 +180,7 @@ void LiveAPI::InitWebSocket()
 	CreateParams(connParams);
 
 	const char* initError = nullptr;
+	std::lock_guard<std::mutex> lock(webSocketMutex);
 
 	if (!webSocketSystem.Init(liveapi_servers.GetString(), connParams, initError))
 	{
@@ -158,6 +194,7 @@ void LiveAPI::InitWebSocket()
 //-----------------------------------------------------------------------------
 void LiveAPI::ShutdownWebSocket()
 {
+	std::lock_guard<std::mutex> lock(webSocketMutex);
 	webSocketSystem.Shutdown();
 }
 
@@ -197,6 +234,46 @@ void LiveAPI::CreateLogger()
 	if (!liveapi_print_enabled.GetBool())
 		return; // Logging is disabled
 
+	LiveAPIQueuedEvent_s* const item = AllocEvent();
+
+	item->type = LiveAPIQueuedEvent_s::CREATE_LOGGER;
+	item->printJson = liveapi_print_json.GetBool();
+	item->compressionLevel = liveapi_print_compression_level.GetInt();
+
+	loggerActive = true;
+	DispatchEvent(item);
+}
+
+//-----------------------------------------------------------------------------
+// Destroy the file logger
+//-----------------------------------------------------------------------------
+void LiveAPI::DestroyLogger()
+{
+	if (!loggerActive)
+		return; // Nothing to drop
+
+	LiveAPIQueuedEvent_s* const item = AllocEvent();
+	item->type = LiveAPIQueuedEvent_s::DESTROY_LOGGER;
+
+	loggerActive = false;
+	DispatchEvent(item);
+}
+
+//-----------------------------------------------------------------------------
+// Open the file logger, or the binary match recorder (pipeline thread)
+//-----------------------------------------------------------------------------
+void LiveAPI::OpenLogger(const LiveAPIQueuedEvent_s* const item)
+{
+	CloseLogger();
+
+	if (!item->printJson)
+	{
+		matchRecorder.Open(Format("platform/liveapi/logs/%s/match_%d.lapr",
+			g_LogSessionUUID.c_str(), matchLogCount++).c_str(), item->compressionLevel);
+
+		return;
+	}
+
 	matchLogger = spdlog::basic_logger_mt("match_logger",
 		Format("platform/liveapi/logs/%s/match_%d.json", g_LogSessionUUID.c_str(), matchLogCount++));
 
@@ -205,13 +282,15 @@ void LiveAPI::CreateLogger()
 }
 
 //-----------------------------------------------------------------------------
-// Destroy the file logger
+// Close the file logger (pipeline thread)
 //-----------------------------------------------------------------------------
-void LiveAPI::DestroyLogger()
+void LiveAPI::CloseLogger()
 {
 	if (initialLog)
 		initialLog = false;
 
+	matchRecorder.Close();
+
 	if (!matchLogger)
 		return; // Nothing to drop
 
@@ -222,44 +301,310 @@ void LiveAPI::DestroyLogger()
 }
 
 //-----------------------------------------------------------------------------
-// LiveAPI state machine
+// Start the thread that serializes, transmits and prints the events
 //-----------------------------------------------------------------------------
-void LiveAPI::RunFrame()
+void LiveAPI::StartWorker()
 {
-	if (!IsEnabled())
+	if (workerThread.joinable())
 		return;
 
-	if (WebSocketInitialized())
-		webSocketSystem.Update();
+	workerRunning = true;
+	workPending = false;
+
+	workerThread = std::thread(&LiveAPI::WorkerThread, this);
 }
 
 //-----------------------------------------------------------------------------
-// Send an event to all sockets
+// Stop the worker after it processed everything that is still queued
 //-----------------------------------------------------------------------------
-void LiveAPI::LogEvent(const google::protobuf::Message* const toTransmit, const google::protobuf::Message* toPrint)
+void LiveAPI::StopWorker()
 {
-	if (!IsEnabled())
+	if (!workerThread.joinable())
 		return;
 
-	if (WebSocketInitialized())
 	{
-		const string data = toTransmit->SerializeAsString();
-		webSocketSystem.SendData(data.c_str(), (int)data.size());
+		std::lock_guard<std::mutex> lock(workerMutex);
+		workerRunning = false;
 	}
 
+	workerSignal.notify_one();
+	workerThread.join();
+
+	// Release the recycled items, the queues are empty and the worker gone.
+	while (TSQueueNode_t* const node = freeQueue.Pop())
+		delete static_cast<LiveAPIQueuedEvent_s*>(node);
+}
+
+//-----------------------------------------------------------------------------
+// Worker main loop, woken once per frame by RunFrame() or when idle for
+// LIVE_API_WORKER_IDLE_WAIT milliseconds
+//-----------------------------------------------------------------------------
+void LiveAPI::WorkerThread()
+{
+	for (;;)
+	{
+		bool running;
+		{
+			std::unique_lock<std::mutex> lock(workerMutex);
+			workerSignal.wait_for(lock, std::chrono::milliseconds(LIVE_API_WORKER_IDLE_WAIT),
+				[this] { return workPending || !workerRunning; });
+
+			workPending = false;
+			running = workerRunning;
+		}
+
+		ProcessQueue();
+
+		if (!running)
+			break;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Get a work item, reusing a released one when possible (frame thread)
+//-----------------------------------------------------------------------------
+LiveAPIQueuedEvent_s* LiveAPI::AllocEvent()
+{
+	TSQueueNode_t* const node = freeQueue.Pop();
+
+	if (node)
+		return static_cast<LiveAPIQueuedEvent_s*>(node);
+
+	return new LiveAPIQueuedEvent_s();
+}
+
+//-----------------------------------------------------------------------------
+// Reset a work item and return it to the free queue (any thread)
+//-----------------------------------------------------------------------------
+void LiveAPI::ReleaseEvent(LiveAPIQueuedEvent_s* const item)
+{
+	// The arena keeps its initial block, so reused items don't allocate
+	// unless an event outgrew it.
+	item->message = nullptr;
+	item->arena.Reset();
+	item->type = LiveAPIQueuedEvent_s::EVENT;
+
+	freeQueue.Push(item);
+}
+
+//-----------------------------------------------------------------------------
+// Hand a work item to the worker, or process it in place if there is none
+//-----------------------------------------------------------------------------
+void LiveAPI::DispatchEvent(LiveAPIQueuedEvent_s* const item)
+{
+	if (workerThread.joinable())
+	{
+		pendingEvents.fetch_add(1, std::memory_order_relaxed);
+		eventQueue.Push(item);
+
+		return;
+	}
+
+	ProcessItem(item);
+	FlushBatch();
+
+	ReleaseEvent(item);
+}
+
+//-----------------------------------------------------------------------------
+// Process all queued work items (worker thread)
+//-----------------------------------------------------------------------------
+void LiveAPI::ProcessQueue()
+{
+	const double startTime = Plat_FloatTime();
+	bool processed = false;
+
+	while (TSQueueNode_t* const node = eventQueue.Pop())
+	{
+		LiveAPIQueuedEvent_s* const item = static_cast<LiveAPIQueuedEvent_s*>(node);
+
+		ProcessItem(item);
+		processed = true;
+
+		pendingEvents.fetch_sub(1, std::memory_order_relaxed);
+		ReleaseEvent(item);
+	}
+
+	if (!processed)
+		return;
+
+	// Everything queued during this frame goes out in as few messages as
+	// possible when batching.
+	FlushBatch();
+	stats.workerTimeUs += uint64_t((Plat_FloatTime() - startTime) * 1000000.0);
+}
+
+//-----------------------------------------------------------------------------
+// Process a single work item
+//-----------------------------------------------------------------------------
+void LiveAPI::ProcessItem(LiveAPIQueuedEvent_s* const item)
+{
+	switch (item->type)
+	{
+	case LiveAPIQueuedEvent_s::EVENT:
+		ProcessEvent(item);
+		break;
+	case LiveAPIQueuedEvent_s::CREATE_LOGGER:
+		OpenLogger(item);
+		break;
+	case LiveAPIQueuedEvent_s::DESTROY_LOGGER:
+		CloseLogger();
+		break;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Returns the timestamp of an event, all event messages carry one in field 1
+//-----------------------------------------------------------------------------
+static uint64_t LiveAPI_GetEventTimestamp(const google::protobuf::Message& msg)
+{
+	const google::protobuf::FieldDescriptor* const field = msg.GetDescriptor()->FindFieldByNumber(1);
+
+	if (!field || field->cpp_type() != google::protobuf::FieldDescriptor::CPPTYPE_UINT64)
+		return 0;
+
+	return msg.GetReflection()->GetUInt64(msg, field);
+}
+
+//-----------------------------------------------------------------------------
+// Wire layout of a LiveAPIEvent wrapping a game message:
+//
+//   LiveAPIEvent { fixed32 event_size = 1; google.protobuf.Any gameMessage = 3; }
+//   Any          { string type_url = 1; bytes value = 2; }
+//
+// Computing it caches the sizes inside the game message, so the encode pass
+// serializes the game message exactly once, straight into the output. The
+// result is identical to set_event_size() + PackFrom() + Serialize().
+//-----------------------------------------------------------------------------
+struct LiveAPIEventLayout_s
+{
+	size_t messageSize;
+	size_t typeUrlSize;
+	size_t anySize;
+	size_t eventSize;
+};
+
+static void LiveAPI_ComputeEventLayout(const google::protobuf::Message& msg, LiveAPIEventLayout_s& layout)
+{
+	using google::protobuf::io::CodedOutputStream;
+
+	layout.messageSize = msg.ByteSizeLong();
+	layout.typeUrlSize = sizeof(LIVE_API_TYPE_URL_PREFIX) - 1 + msg.GetDescriptor()->full_name().size();
+
+	layout.anySize = 1 + CodedOutputStream::VarintSize32(uint32_t(layout.typeUrlSize)) + layout.typeUrlSize;
+
+	if (layout.messageSize) // Default valued fields are omitted on the wire.
+		layout.anySize += 1 + CodedOutputStream::VarintSize32(uint32_t(layout.messageSize)) + layout.messageSize;
+
+	layout.eventSize = 1 + CodedOutputStream::VarintSize32(uint32_t(layout.anySize)) + layout.anySize;
+
+	if (layout.messageSize)
+		layout.eventSize += 1 + sizeof(uint32_t);
+}
+
+static uint8_t* LiveAPI_EncodeEvent(const google::protobuf::Message& msg, const LiveAPIEventLayout_s& layout, uint8_t* target)
+{
+	using google::protobuf::io::CodedOutputStream;
+
+	if (layout.messageSize)
+	{
+		*target++ = LIVE_API_WIRE_TAG(1, 5); // event_size, fixed32
+		target = CodedOutputStream::WriteLittleEndian32ToArray(uint32_t(layout.messageSize), target);
+	}
+
+	*target++ = LIVE_API_WIRE_TAG(3, 2); // gameMessage, length delimited
+	target = CodedOutputStream::WriteVarint32ToArray(uint32_t(layout.anySize), target);
+
+	const std::string& typeName = msg.GetDescriptor()->full_name();
+
+	*target++ = LIVE_API_WIRE_TAG(1, 2); // type_url, length delimited
+	target = CodedOutputStream::WriteVarint32ToArray(uint32_t(layout.typeUrlSize), target);
+
+	memcpy(target, LIVE_API_TYPE_URL_PREFIX, sizeof(LIVE_API_TYPE_URL_PREFIX) - 1);
+	target += sizeof(LIVE_API_TYPE_URL_PREFIX) - 1;
+
+	memcpy(target, typeName.data(), typeName.size());
+	target += typeName.size();
+
+	if (layout.messageSize)
+	{
+		*target++ = LIVE_API_WIRE_TAG(2, 2); // value, length delimited
+		target = CodedOutputStream::WriteVarint32ToArray(uint32_t(layout.messageSize), target);
+		target = msg.SerializeWithCachedSizesToArray(target);
+	}
+
+	return target;
+}
+
+//-----------------------------------------------------------------------------
+// Serialize, transmit and print a single event
+//-----------------------------------------------------------------------------
+static rtech::liveapi::LiveAPIEvent s_pipelineEvent; // Only used by the thread running the pipeline.
+
+void LiveAPI::ProcessEvent(LiveAPIQueuedEvent_s* const item)
+{
+	const google::protobuf::Message* const msg = item->message;
+
+	// Encoded once, shared between the transmission and the recording.
+	const bool record = item->print && matchRecorder.IsOpen();
+
+	const char* eventData = nullptr;
+	size_t eventSize = 0;
+
+	if (item->transmit || record)
+	{
+		LiveAPIEventLayout_s layout;
+		LiveAPI_ComputeEventLayout(*msg, layout);
+
+		eventSize = layout.eventSize;
+
+		if (item->transmit && item->batch)
+		{
+			using google::protobuf::io::CodedOutputStream;
+			const size_t recordSize = CodedOutputStream::VarintSize32(uint32_t(eventSize)) + eventSize;
+
+			if (!batchBuffer.empty() && batchBuffer.size() + recordSize > LIVE_API_MAX_FRAME_BUFFER_SIZE)
+				FlushBatch();
+
+			const size_t offset = batchBuffer.size();
+			batchBuffer.resize(offset + recordSize);
+
+			uint8_t* const payload = CodedOutputStream::WriteVarint32ToArray(uint32_t(eventSize),
+				reinterpret_cast<uint8_t*>(&batchBuffer[offset]));
+
+			LiveAPI_EncodeEvent(*msg, layout, payload);
+			eventData = reinterpret_cast<const char*>(payload);
+		}
+		else
+		{
+			sendBuffer.resize(eventSize);
+			LiveAPI_EncodeEvent(*msg, layout, reinterpret_cast<uint8_t*>(&sendBuffer[0]));
+
+			eventData = sendBuffer.data();
+
+			if (item->transmit)
+				SendFrame(eventData, eventSize);
+		}
+	}
+
+	if (record)
+		matchRecorder.WriteEvent(LiveAPI_GetEventTimestamp(*msg), eventData, eventSize);
+
 	// NOTE: we don't check on the cvar 'liveapi_print_enabled' here because if
 	// this cvar gets disabled on the fly and we check it here, the output will
 	// be truncated and thus invalid! Log for as long as the SpdLog instance is
 	// valid.
-	if (matchLogger)
+	if (item->print && matchLogger)
 	{
 		std::string jsonStr(initialLog ? ",\n" : "");
 		google::protobuf::util::JsonPrintOptions options;
 
-		options.add_whitespace = liveapi_print_pretty.GetBool();
-		options.always_print_primitive_fields = liveapi_print_primitive.GetBool();
+		options.add_whitespace = item->printPretty;
+		options.always_print_primitive_fields = item->printPrimitive;
 
-		google::protobuf::util::MessageToJsonString(*toPrint, &jsonStr, options);
+		// The JSON printer resolves the type through the Any wrapper.
+		s_pipelineEvent.mutable_gamemessage()->PackFrom(*msg);
+		google::protobuf::util::MessageToJsonString(s_pipelineEvent.gamemessage(), &jsonStr, options);
 
 		// Remove the trailing newline character
 		if (options.add_whitespace && !jsonStr.empty())
@@ -270,6 +615,132 @@ void LiveAPI::LogEvent(const google::protobuf::Message* const toTransmit, const
 		if (!initialLog)
 			initialLog = true;
 	}
+
+	s_pipelineEvent.Clear();
+	stats.eventsProcessed++;
+}
+
+//-----------------------------------------------------------------------------
+// Send a single message to all sockets (pipeline thread)
+//-----------------------------------------------------------------------------
+void LiveAPI::SendFrame(const char* const data, const size_t size)
+{
+	std::lock_guard<std::mutex> lock(webSocketMutex);
+
+	// Could have been shut down while this event was queued.
+	if (!webSocketSystem.IsInitialized())
+		return;
+
+	webSocketSystem.SendData(data, int32_t(size));
+
+	stats.framesSent++;
+	stats.bytesSent += size;
+}
+
+//-----------------------------------------------------------------------------
+// Send out the events that were batched so far (pipeline thread)
+//-----------------------------------------------------------------------------
+void LiveAPI::FlushBatch()
+{
+	if (batchBuffer.empty())
+		return;
+
+	SendFrame(batchBuffer.data(), batchBuffer.size());
+	batchBuffer.clear();
+}
+
+//-----------------------------------------------------------------------------
+// LiveAPI state machine
+//-----------------------------------------------------------------------------
+void LiveAPI::RunFrame()
+{
+	if (!IsEnabled())
+		return;
+
+	if (WebSocketInitialized())
+	{
+		std::lock_guard<std::mutex> lock(webSocketMutex);
+		webSocketSystem.Update();
+	}
+
+	if (!stats.frameEvents)
+		return;
+
+	stats.lastFrameCost = stats.frameCost;
+	stats.lastFrameEvents = stats.frameEvents;
+	stats.peakFrameCost = Max(stats.peakFrameCost, stats.frameCost);
+	stats.totalFrameCost += stats.frameCost;
+	stats.activeFrames++;
+
+	stats.frameCost = 0.0;
+	stats.frameEvents = 0;
+
+	// Wake the worker once for everything queued during this frame.
+	{
+		std::lock_guard<std::mutex> lock(workerMutex);
+		workPending = true;
+	}
+
+	workerSignal.notify_one();
+}
+
+//-----------------------------------------------------------------------------
+// Queue an event for all sockets and the file logger, the message must have
+// been created in the item's arena
+//-----------------------------------------------------------------------------
+void LiveAPI::LogEvent(LiveAPIQueuedEvent_s* const item)
+{
+	Assert(item->message && item->message->GetArena() == &item->arena);
+
+	const bool transmit = IsEnabled() && WebSocketInitialized();
+	const bool print = IsEnabled() && loggerActive;
+
+	if (!transmit && !print)
+	{
+		ReleaseEvent(item);
+		return;
+	}
+
+	const double startTime = Plat_FloatTime();
+
+	if (pendingEvents.load(std::memory_order_relaxed) >= LIVE_API_MAX_QUEUED_EVENTS)
+	{
+		stats.eventsDropped++;
+		ReleaseEvent(item);
+
+		return;
+	}
+
+	item->transmit = transmit;
+	item->print = print;
+	item->printPretty = liveapi_print_pretty.GetBool();
+	item->printPrimitive = liveapi_print_primitive.GetBool();
+	item->batch = liveapi_batch_events.GetBool();
+
+	DispatchEvent(item);
+
+	stats.eventsQueued++;
+	stats.frameEvents++;
+	stats.frameCost += Plat_FloatTime() - startTime;
+}
+
+//-----------------------------------------------------------------------------
+// Print the pipeline statistics
+//-----------------------------------------------------------------------------
+void LiveAPI::PrintStats() const
+{
+	const double avgFrameCost = stats.activeFrames
+		? stats.totalFrameCost / double(stats.activeFrames)
+		: 0.0;
+
+	Msg(eDLL_T::RTECH, "LiveAPI frame thread: last frame %d events in %.1f us; avg %.1f us; peak %.1f us over %llu frames\n",
+		stats.lastFrameEvents, stats.lastFrameCost * 1000000.0, avgFrameCost * 1000000.0,
+		stats.peakFrameCost * 1000000.0, stats.activeFrames);
+	Msg(eDLL_T::RTECH, "LiveAPI pipeline: %llu queued; %d pending; %llu dropped; %llu processed in %llu us\n",
+		stats.eventsQueued, pendingEvents.load(std::memory_order_relaxed), stats.eventsDropped,
+		stats.eventsProcessed.load(), stats.workerTimeUs.load());
+	Msg(eDLL_T::RTECH, "LiveAPI transmit: %llu messages; %llu bytes\n",
+		stats.framesSent.load(), stats.bytesSent.load());
 }
 
 //-----------------------------------------------------------------------------
@@ -288,8 +759,182 @@ bool LiveAPI::IsValidToRun() const
 	return (IsEnabled() && (WebSocketInitialized() || FileLoggerInitialized()));
 }
 
+//-----------------------------------------------------------------------------
+// Benchmark event data, roughly what the game scripts send
+//-----------------------------------------------------------------------------
+static void LiveAPI_FillBenchmarkPlayer(rtech::liveapi::Player* const player, const int index)
+{
+	char name[32];
+	snprintf(name, sizeof(name), "benchmark_player_%d", index);
+
+	player->set_name(name);
+	player->set_teamid(uint32_t(index % 20));
+	player->set_nucleushash("6f1ed002ab5595859014ebf0951522d9");
+	player->set_hardwarename("PC");
+	player->set_character("wraith");
+	player->set_skin("default");
+
+	rtech::liveapi::Vector3* const pos = player->mutable_pos();
+	pos->set_x(float(index));
+	pos->set_y(1024.f);
+	pos->set_z(-512.f);
+
+	rtech::liveapi::Vector3* const angles = player->mutable_angles();
+	angles->set_y(90.f);
+
+	player->set_currenthealth(75);
+	player->set_maxhealth(100);
+	player->set_shieldhealth(50);
+	player->set_shieldmaxhealth(100);
+}
+
+static void LiveAPI_FillBenchmarkEvent(rtech::liveapi::PlayerDamaged* const event, const int index)
+{
+	event->set_timestamp(1700000000 + index);
+	event->set_category("playerDamaged");
+	LiveAPI_FillBenchmarkPlayer(event->mutable_attacker(), index);
+	LiveAPI_FillBenchmarkPlayer(event->mutable_victim(), index + 1);
+	event->set_weapon("mp_weapon_r97");
+	event->set_damageinflicted(14);
+}
+
+static void LiveAPI_FillBenchmarkEvent(rtech::liveapi::PlayerKilled* const event, const int index)
+{
+	event->set_timestamp(1700000000 + index);
+	event->set_category("playerKilled");
+	LiveAPI_FillBenchmarkPlayer(event->mutable_attacker(), index);
+	LiveAPI_FillBenchmarkPlayer(event->mutable_victim(), index + 1);
+	LiveAPI_FillBenchmarkPlayer(event->mutable_awardedto(), index);
+	event->set_weapon("mp_weapon_wingman");
+}
+
+static void LiveAPI_FillBenchmarkEvent(rtech::liveapi::AmmoUsed* const event, const int index)
+{
+	event->set_timestamp(1700000000 + index);
+	event->set_category("ammoUsed");
+	LiveAPI_FillBenchmarkPlayer(event->mutable_player(), index);
+	event->set_ammotype("bullet");
+	event->set_amountused(1);
+	event->set_oldammocount(28);
+	event->set_newammocount(27);
+}
+
+//-----------------------------------------------------------------------------
+// Builds and encodes events the previous way (static heap message, ByteSize,
+// PackFrom, Serialize) and in a recycled arena with a single encode pass
+//-----------------------------------------------------------------------------
+template<typename T>
+static void LiveAPI_BenchmarkEventType(const char* const typeName, const int numEvents)
+{
+	// Previous path, the messages are cleared and reused like the static ones.
+	T heapEvent;
+	rtech::liveapi::LiveAPIEvent heapWrapper;
+	std::string heapOutput;
+
+	size_t heapBytes = 0;
+	double startTime = Plat_FloatTime();
+
+	for (int i = 0; i < numEvents; i++)
+	{
+		LiveAPI_FillBenchmarkEvent(&heapEvent, i);
+
+		heapWrapper.set_event_size(int(heapEvent.ByteSizeLong()));
+		heapWrapper.mutable_gamemessage()->PackFrom(heapEvent);
+		heapWrapper.SerializeToString(&heapOutput);
+
+		if (i == 0)
+			heapBytes = heapEvent.SpaceUsedLong() + heapWrapper.SpaceUsedLong() - sizeof(heapEvent) - sizeof(heapWrapper);
+
+		heapEvent.Clear();
+		heapWrapper.Clear();
+	}
+
+	const double heapTime = Plat_FloatTime() - startTime;
+
+	// Arena path, as done by the script bindings and the pipeline.
+	std::unique_ptr<LiveAPIQueuedEvent_s> item(new LiveAPIQueuedEvent_s());
+	std::string arenaOutput;
+
+	size_t arenaBytes = 0;
+	int arenaOverflows = 0;
+	startTime = Plat_FloatTime();
+
+	for (int i = 0; i < numEvents; i++)
+	{
+		T* const arenaEvent = google::protobuf::Arena::CreateMessage<T>(&item->arena);
+		LiveAPI_FillBenchmarkEvent(arenaEvent, i);
+
+		LiveAPIEventLayout_s layout;
+		LiveAPI_ComputeEventLayout(*arenaEvent, layout);
+
+		arenaOutput.resize(layout.eventSize);
+		LiveAPI_EncodeEvent(*arenaEvent, layout, reinterpret_cast<uint8_t*>(&arenaOutput[0]));
+
+		if (i == 0)
+			arenaBytes = size_t(item->arena.SpaceUsed());
+
+		// Anything beyond the initial block came from the heap.
+		if (item->arena.SpaceAllocated() > LIVE_API_EVENT_ARENA_SIZE)
+			arenaOverflows++;
+
+		item->arena.Reset();
+	}
+
+	const double arenaTime = Plat_FloatTime() - startTime;
+
+	// Both encodings of the last event must be identical.
+	if (heapOutput != arenaOutput)
+		Warning(eDLL_T::RTECH, "%s: %s encodings differ (%zu vs %zu bytes)!\n", __FUNCTION__, typeName, heapOutput.size(), arenaOutput.size());
+
+	Msg(eDLL_T::RTECH, "%-14s heap: %7.1f ns/event; %4zu heap bytes/event | arena: %7.1f ns/event; %4zu arena bytes/event; %d heap fallbacks\n",
+		typeName, (heapTime * 1e9) / numEvents, heapBytes, (arenaTime * 1e9) / numEvents, arenaBytes, arenaOverflows);
+}
+
+//-----------------------------------------------------------------------------
+// Benchmarks building and encoding the most common event types
+//-----------------------------------------------------------------------------
+void LiveAPI::BenchmarkEvents(const int numEvents)
+{
+	LiveAPI_BenchmarkEventType<rtech::liveapi::PlayerDamaged>("PlayerDamaged", numEvents);
+	LiveAPI_BenchmarkEventType<rtech::liveapi::PlayerKilled>("PlayerKilled", numEvents);
+	LiveAPI_BenchmarkEventType<rtech::liveapi::AmmoUsed>("AmmoUsed", numEvents);
+}
+
 static LiveAPI s_liveApi;
 
+//-----------------------------------------------------------------------------
+// Purpose: prints the LiveAPI pipeline statistics
+//-----------------------------------------------------------------------------
+static void LiveAPI_Stats_f(const CCommand& args)
+{
+	s_liveApi.PrintStats();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: converts a binary match recording to a JSON file
+//-----------------------------------------------------------------------------
+static void LiveAPI_ConvertRecording_f(const CCommand& args)
+{
+	if (args.ArgC() < 3)
+		return;
+
+	const uint64_t startTime = args.ArgC() > 3 ? strtoull(args.Arg(3), nullptr, 10) : 0;
+	LiveAPI_ConvertRecordingToJson(args.Arg(1), args.Arg(2), startTime, liveapi_print_pretty.GetBool());
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: benchmarks building and encoding LiveAPI events
+//-----------------------------------------------------------------------------
+static void LiveAPI_Benchmark_f(const CCommand& args)
+{
+	const int numEvents = args.ArgC() > 1 ? Clamp(atoi(args.Arg(1)), 1, 10000000) : 100000;
+	LiveAPI::BenchmarkEvents(numEvents);
+}
+
+static ConCommand liveapi_stats("liveapi_stats", LiveAPI_Stats_f, "Prints the per frame cost and throughput of the LiveAPI event pipeline", FCVAR_RELEASE);
+static ConCommand liveapi_convert_recording("liveapi_convert_recording", LiveAPI_ConvertRecording_f, "Converts a binary LiveAPI match recording to JSON, optionally starting at a given event timestamp", FCVAR_RELEASE, nullptr, "liveapi_convert_recording <input> <output> [startTime]");
+static ConCommand liveapi_benchmark("liveapi_benchmark", LiveAPI_Benchmark_f, "Benchmarks building and encoding common LiveAPI events on the heap versus in an arena", FCVAR_DEVELOPMENTONLY, nullptr, "liveapi_benchmark <numEvents>");
+
 //-----------------------------------------------------------------------------
 // Singleton accessor
 //-----------------------------------------------------------------------------
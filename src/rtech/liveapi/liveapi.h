@@ -1,9 +1,16 @@
 #ifndef RTECH_LIVEAPI_H
 #define RTECH_LIVEAPI_H
+#include <condition_variable>
+#include "tier0/tslist.h"
 #include "tier2/websocket.h"
+#include "rtech/liveapi/liverecord.h"
+#include "thirdparty/protobuf/arena.h"
 #include "thirdparty/protobuf/message.h"
 
 #define LIVE_API_MAX_FRAME_BUFFER_SIZE 0x8000
+#define LIVE_API_EVENT_ARENA_SIZE 0x1000 // Initial arena block of each queued event, common events fit.
+#define LIVE_API_MAX_QUEUED_EVENTS 8192 // Events beyond this are dropped until the worker caught up.
+#define LIVE_API_WORKER_IDLE_WAIT 100 // Milliseconds the worker sleeps when not signaled.
 
 extern ConVar liveapi_enabled;
 extern ConVar liveapi_session_name;
@@ -12,6 +19,85 @@ extern ConVar liveapi_truncate_hash_fields;
 struct ProtoWebSocketRefT;
 typedef void (*LiveAPISendCallback_t)(ProtoWebSocketRefT* webSocket);
 
+//-----------------------------------------------------------------------------
+// Work item handed off from the server frame thread to the LiveAPI worker,
+// events are copied into the item's arena so the caller's message could be
+// reused immediately. Items are recycled, so the arena block is allocated once.
+//-----------------------------------------------------------------------------
+struct LiveAPIQueuedEvent_s : public TSQueueNode_t
+{
+	enum Type_e
+	{
+		EVENT = 0,
+		CREATE_LOGGER,
+		DESTROY_LOGGER
+	};
+
+	LiveAPIQueuedEvent_s()
+		: arena(arenaBlock, sizeof(arenaBlock))
+		, message(nullptr)
+		, type(EVENT)
+		, transmit(false)
+		, print(false)
+		, printPretty(false)
+		, printPrimitive(false)
+		, printJson(false)
+		, batch(false)
+		, compressionLevel(0) {}
+
+	alignas(8) char arenaBlock[LIVE_API_EVENT_ARENA_SIZE];
+	google::protobuf::Arena arena;
+	google::protobuf::Message* message;
+
+	Type_e type;
+	bool transmit;
+	bool print;
+	bool printPretty;
+	bool printPrimitive;
+	bool printJson;
+	bool batch;
+
+	int compressionLevel;
+};
+
+//-----------------------------------------------------------------------------
+// Pipeline statistics, the frame fields are only touched by the server frame
+// thread, the rest is updated by the worker.
+//-----------------------------------------------------------------------------
+struct LiveAPIStats_s
+{
+	LiveAPIStats_s()
+		: frameCost(0.0)
+		, frameEvents(0)
+		, lastFrameCost(0.0)
+		, lastFrameEvents(0)
+		, peakFrameCost(0.0)
+		, totalFrameCost(0.0)
+		, activeFrames(0)
+		, eventsQueued(0)
+		, eventsDropped(0)
+		, eventsProcessed(0)
+		, framesSent(0)
+		, bytesSent(0)
+		, workerTimeUs(0) {}
+
+	double frameCost;
+	int frameEvents;
+
+	double lastFrameCost;
+	int lastFrameEvents;
+	double peakFrameCost;
+	double totalFrameCost;
+	uint64_t activeFrames;
+	uint64_t eventsQueued;
+	uint64_t eventsDropped;
+
+	std::atomic<uint64_t> eventsProcessed;
+	std::atomic<uint64_t> framesSent;
+	std::atomic<uint64_t> bytesSent;
+	std::atomic<uint64_t> workerTimeUs;
+};
+
 class LiveAPI
 {
 public:
@@ -37,20 +123,66 @@ public:
 	void DestroyLogger();
 
 	void RunFrame();
-	void LogEvent(const google::protobuf::Message* const toTransmit, const google::protobuf::Message* toPrint);
+
+	// Events are built directly in the arena of a work item, LogEvent()
+	// takes ownership of the item, ReleaseEvent() discards it.
+	LiveAPIQueuedEvent_s* AllocEvent();
+	void ReleaseEvent(LiveAPIQueuedEvent_s* const item);
+	void LogEvent(LiveAPIQueuedEvent_s* const item);
+
+	void PrintStats() const;
+	static void BenchmarkEvents(const int numEvents);
 
 	bool IsEnabled() const;
 	bool IsValidToRun() const;
 
+	// Frame thread only, the worker checks the state again when sending.
 	inline bool WebSocketInitialized() const { return webSocketSystem.IsInitialized(); }
-	inline bool FileLoggerInitialized() const { return matchLogger != nullptr; }
+	inline bool FileLoggerInitialized() const { return loggerActive; }
 
 private:
-	CWebSocket webSocketSystem;
+	void StartWorker();
+	void StopWorker();
+	void WorkerThread();
+
+	void DispatchEvent(LiveAPIQueuedEvent_s* const item);
+
+	void ProcessQueue();
+	void ProcessItem(LiveAPIQueuedEvent_s* const item);
+	void ProcessEvent(LiveAPIQueuedEvent_s* const item);
+
+	void OpenLogger(const LiveAPIQueuedEvent_s* const item);
+	void CloseLogger();
 
+	void SendFrame(const char* const data, const size_t size);
+	void FlushBatch();
+
+	CWebSocket webSocketSystem;
+	mutable std::mutex webSocketMutex;
+
+	// Pending work, pushed by the frame thread and popped by the worker. The
+	// free queue carries processed items back for reuse.
+	CTSQueueMPSC eventQueue;
+	CTSQueueMPSC freeQueue;
+	std::atomic<int> pendingEvents;
+
+	std::thread workerThread;
+	std::mutex workerMutex;
+	std::condition_variable workerSignal;
+	bool workPending;
+	bool workerRunning;
+
+	// Only accessed by the thread running the pipeline.
+	std::string sendBuffer;
+	std::string batchBuffer;
 	std::shared_ptr<spdlog::logger> matchLogger;
+	CLiveAPIRecordWriter matchRecorder;
 	int matchLogCount;
 	bool initialLog;
+
+	LiveAPIStats_s stats;
+
+	bool loggerActive; // Logger state as requested from the frame thread.
 	bool initialized;
 };
 
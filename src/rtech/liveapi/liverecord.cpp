@@ -0,0 +1,676 @@
+//===========================================================================//
+//
+// Purpose: LiveAPI binary match recording
+//
+//===========================================================================//
+#include "liverecord.h"
+#include "protobuf/util/json_util.h"
+
+#pragma warning(push)
+#pragma warning(disable : 4505)
+#include "protoc/events.pb.h"
+#pragma warning(pop)
+
+//-----------------------------------------------------------------------------
+// Purpose: encodes a varint into the buffer
+// Output : number of bytes written, at most 10
+//-----------------------------------------------------------------------------
+static size_t LiveAPIRecord_WriteVarint(uint8_t* const out, uint64_t value)
+{
+	size_t numBytes = 0;
+
+	while (value >= 0x80)
+	{
+		out[numBytes++] = uint8_t(value | 0x80);
+		value >>= 7;
+	}
+
+	out[numBytes++] = uint8_t(value);
+	return numBytes;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: decodes a varint from the buffer at given position
+// Output : true on success, false if the buffer is truncated or malformed
+//-----------------------------------------------------------------------------
+static bool LiveAPIRecord_ReadVarint(const std::string& data, size_t& pos, uint64_t& value)
+{
+	value = 0;
+
+	for (int shift = 0; shift < 64; shift += 7)
+	{
+		if (pos >= data.size())
+			return false;
+
+		const uint8_t byte = uint8_t(data[pos++]);
+		value |= uint64_t(byte & 0x7F) << shift;
+
+		if (!(byte & 0x80))
+			return true;
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: decodes the timestamp and size of the event at given position
+// Output : true on success, false if the record runs past the buffer
+//-----------------------------------------------------------------------------
+static bool LiveAPIRecord_ReadEventHeader(const std::string& data, size_t& pos, uint64_t& timestamp, uint64_t& size)
+{
+	if (!LiveAPIRecord_ReadVarint(data, pos, timestamp) ||
+		!LiveAPIRecord_ReadVarint(data, pos, size))
+		return false;
+
+	return size <= data.size() - pos;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writer constructors/destructors
+//-----------------------------------------------------------------------------
+CLiveAPIRecordWriter::CLiveAPIRecordWriter()
+	: m_writeOffset(0)
+	, m_lastIndexOffset(0)
+	, m_blockFirstTimestamp(0)
+	, m_blockLastTimestamp(0)
+	, m_blockEventCount(0)
+	, m_compressContext(nullptr)
+	, m_compressionLevel(0)
+	, m_isOpen(false)
+{
+}
+CLiveAPIRecordWriter::~CLiveAPIRecordWriter()
+{
+	Close();
+
+	if (m_compressContext)
+		ZSTD_freeCCtx(reinterpret_cast<ZSTD_CCtx*>(m_compressContext));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: creates a new recording, truncating any existing file
+// Input  : *filePath -
+//          compressionLevel - zstd level, 0 stores the blocks uncompressed
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CLiveAPIRecordWriter::Open(const char* const filePath, const int compressionLevel)
+{
+	Close();
+	CreateDirectories(filePath);
+
+	if (!m_stream.Open(filePath, CIOStream::WRITE | CIOStream::BINARY))
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to create recording '%s'\n", __FUNCTION__, filePath);
+		return false;
+	}
+
+	LiveAPIRecordHeader_s header;
+
+	header.magic = LIVE_API_RECORD_MAGIC;
+	header.version = LIVE_API_RECORD_VERSION;
+	header.flags = 0;
+
+	m_stream.Write(header);
+
+	m_writeOffset = sizeof(header);
+	m_lastIndexOffset = 0;
+
+	m_blockBuffer.clear();
+	m_pendingIndex.clear();
+	m_blockEventCount = 0;
+
+	m_compressionLevel = compressionLevel;
+
+	if (m_compressionLevel > 0 && !m_compressContext)
+		m_compressContext = ZSTD_createCCtx();
+
+	m_isOpen = true;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes out the remaining events, the index and the trailer
+//-----------------------------------------------------------------------------
+void CLiveAPIRecordWriter::Close()
+{
+	if (!m_isOpen)
+		return;
+
+	FlushBlock();
+	WriteIndex();
+
+	LiveAPIRecordTrailer_s trailer;
+
+	trailer.lastIndexOffset = m_lastIndexOffset;
+	trailer.magic = LIVE_API_RECORD_MAGIC;
+
+	m_stream.Write(trailer);
+	m_stream.Close();
+
+	m_isOpen = false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: appends a serialized LiveAPIEvent to the recording
+// Input  : timestamp -
+//          *data -
+//          size -
+//-----------------------------------------------------------------------------
+void CLiveAPIRecordWriter::WriteEvent(const uint64_t timestamp, const char* const data, const size_t size)
+{
+	if (!m_isOpen)
+		return;
+
+	uint8_t prefix[20];
+	size_t prefixSize = LiveAPIRecord_WriteVarint(prefix, timestamp);
+	prefixSize += LiveAPIRecord_WriteVarint(&prefix[prefixSize], size);
+
+	if (!m_blockBuffer.empty() && m_blockBuffer.size() + prefixSize + size > LIVE_API_RECORD_BLOCK_SIZE)
+		FlushBlock();
+
+	m_blockBuffer.append(reinterpret_cast<const char*>(prefix), prefixSize);
+	m_blockBuffer.append(data, size);
+
+	if (!m_blockEventCount)
+	{
+		m_blockFirstTimestamp = timestamp;
+		m_blockLastTimestamp = timestamp;
+	}
+	else
+	{
+		m_blockFirstTimestamp = Min(m_blockFirstTimestamp, timestamp);
+		m_blockLastTimestamp = Max(m_blockLastTimestamp, timestamp);
+	}
+
+	m_blockEventCount++;
+
+	// Events larger than the block size get a block of their own.
+	if (m_blockBuffer.size() >= LIVE_API_RECORD_BLOCK_SIZE)
+		FlushBlock();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compresses and writes the current data block
+//-----------------------------------------------------------------------------
+void CLiveAPIRecordWriter::FlushBlock()
+{
+	if (!m_blockEventCount)
+		return;
+
+	LiveAPIRecordBlock_s block;
+
+	block.magic = LIVE_API_RECORD_BLOCK_MAGIC;
+	block.type = LIVE_API_RECORD_DATA;
+	block.codec = LIVE_API_RECORD_CODEC_NONE;
+	block.rawSize = uint32_t(m_blockBuffer.size());
+	block.diskSize = block.rawSize;
+	block.eventCount = m_blockEventCount;
+	block.firstTimestamp = m_blockFirstTimestamp;
+	block.lastTimestamp = m_blockLastTimestamp;
+
+	const char* payload = m_blockBuffer.data();
+
+	if (m_compressContext && m_compressionLevel > 0)
+	{
+		const size_t bound = ZSTD_compressBound(m_blockBuffer.size());
+		m_compressBuffer.resize(bound);
+
+		const size_t result = ZSTD_compressCCtx(reinterpret_cast<ZSTD_CCtx*>(m_compressContext),
+			&m_compressBuffer[0], bound, m_blockBuffer.data(), m_blockBuffer.size(), m_compressionLevel);
+
+		// Store it raw if compression failed or didn't gain us anything.
+		if (!ZSTD_isError(result) && result < m_blockBuffer.size())
+		{
+			block.codec = LIVE_API_RECORD_CODEC_ZSTD;
+			block.diskSize = uint32_t(result);
+
+			payload = m_compressBuffer.data();
+		}
+	}
+
+	LiveAPIRecordIndexEntry_s entry;
+
+	entry.offset = m_writeOffset;
+	entry.firstTimestamp = block.firstTimestamp;
+	entry.lastTimestamp = block.lastTimestamp;
+	entry.eventCount = block.eventCount;
+
+	m_pendingIndex.push_back(entry);
+
+	m_stream.Write(block);
+	m_stream.Write(payload, block.diskSize);
+	m_stream.Flush();
+
+	m_writeOffset += sizeof(block) + block.diskSize;
+
+	m_blockBuffer.clear();
+	m_blockEventCount = 0;
+
+	if (m_pendingIndex.size() >= LIVE_API_RECORD_INDEX_INTERVAL)
+		WriteIndex();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes an index block for the data blocks written since the last
+//-----------------------------------------------------------------------------
+void CLiveAPIRecordWriter::WriteIndex()
+{
+	if (m_pendingIndex.empty())
+		return;
+
+	const size_t indexSize = sizeof(uint64_t) + m_pendingIndex.size() * sizeof(LiveAPIRecordIndexEntry_s);
+	LiveAPIRecordBlock_s block;
+
+	block.magic = LIVE_API_RECORD_BLOCK_MAGIC;
+	block.type = LIVE_API_RECORD_INDEX;
+	block.codec = LIVE_API_RECORD_CODEC_NONE;
+	block.rawSize = uint32_t(indexSize);
+	block.diskSize = uint32_t(indexSize);
+	block.eventCount = uint32_t(m_pendingIndex.size());
+	block.firstTimestamp = m_pendingIndex.front().firstTimestamp;
+	block.lastTimestamp = m_pendingIndex.front().lastTimestamp;
+
+	for (const LiveAPIRecordIndexEntry_s& entry : m_pendingIndex)
+	{
+		block.firstTimestamp = Min(block.firstTimestamp, entry.firstTimestamp);
+		block.lastTimestamp = Max(block.lastTimestamp, entry.lastTimestamp);
+	}
+
+	m_stream.Write(block);
+	m_stream.Write(m_lastIndexOffset);
+	m_stream.Write(m_pendingIndex.data(), m_pendingIndex.size() * sizeof(LiveAPIRecordIndexEntry_s));
+	m_stream.Flush();
+
+	m_lastIndexOffset = m_writeOffset;
+	m_writeOffset += sizeof(block) + indexSize;
+
+	m_pendingIndex.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reader constructors
+//-----------------------------------------------------------------------------
+CLiveAPIRecordReader::CLiveAPIRecordReader()
+	: m_fileSize(0)
+	, m_nextBlock(0)
+	, m_blockCursor(0)
+	, m_isIndexed(false)
+{
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: opens a recording and loads its block index
+// Input  : *filePath -
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CLiveAPIRecordReader::Open(const char* const filePath)
+{
+	Close();
+
+	if (!m_stream.Open(filePath, CIOStream::READ | CIOStream::BINARY))
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to open recording '%s'\n", __FUNCTION__, filePath);
+		return false;
+	}
+
+	m_fileSize = uint64_t(m_stream.GetSize());
+	LiveAPIRecordHeader_s header;
+
+	if (m_fileSize < sizeof(header))
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: recording '%s' is truncated\n", __FUNCTION__, filePath);
+		Close();
+
+		return false;
+	}
+
+	m_stream.Read(header);
+
+	if (header.magic != LIVE_API_RECORD_MAGIC || header.version != LIVE_API_RECORD_VERSION)
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: recording '%s' has invalid magic or unsupported version (%hu)\n",
+			__FUNCTION__, filePath, header.version);
+		Close();
+
+		return false;
+	}
+
+	m_isIndexed = ReadIndexChain();
+
+	if (!m_isIndexed)
+	{
+		// Not closed properly, rebuild the index from the block headers.
+		Warning(eDLL_T::RTECH, "%s: recording '%s' has no valid index; scanning blocks\n", __FUNCTION__, filePath);
+		ScanBlocks();
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: closes the recording
+//-----------------------------------------------------------------------------
+void CLiveAPIRecordReader::Close()
+{
+	m_stream.Close();
+	m_blocks.clear();
+	m_blockData.clear();
+
+	m_fileSize = 0;
+	m_nextBlock = 0;
+	m_blockCursor = 0;
+	m_isIndexed = false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: positions the reader at the first event at or after given time
+// Input  : timestamp -
+// Output : true if such an event exists, false otherwise
+//-----------------------------------------------------------------------------
+bool CLiveAPIRecordReader::SeekToTime(const uint64_t timestamp)
+{
+	m_blockData.clear();
+	m_blockCursor = 0;
+
+	size_t blockIndex = 0;
+
+	for (; blockIndex < m_blocks.size(); blockIndex++)
+	{
+		if (m_blocks[blockIndex].lastTimestamp >= timestamp)
+			break;
+	}
+
+	m_nextBlock = blockIndex;
+
+	if (blockIndex == m_blocks.size() || !LoadBlock(blockIndex))
+		return false;
+
+	m_nextBlock = blockIndex + 1;
+
+	// Skip the events in this block that are before the requested time.
+	while (m_blockCursor < m_blockData.size())
+	{
+		size_t pos = m_blockCursor;
+		uint64_t eventTime;
+		uint64_t eventSize;
+
+		if (!LiveAPIRecord_ReadEventHeader(m_blockData, pos, eventTime, eventSize))
+			return false;
+
+		if (eventTime >= timestamp)
+			return true;
+
+		m_blockCursor = size_t(pos + eventSize);
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reads the next event from the recording
+// Input  : &event - LiveAPIEvent message to parse into
+//          &timestamp -
+// Output : true on success, false on end of recording or corrupt data
+//-----------------------------------------------------------------------------
+bool CLiveAPIRecordReader::ReadEvent(google::protobuf::Message& event, uint64_t& timestamp)
+{
+	while (m_blockCursor >= m_blockData.size())
+	{
+		if (m_nextBlock >= m_blocks.size())
+			return false;
+
+		if (!LoadBlock(m_nextBlock++))
+			return false;
+	}
+
+	size_t pos = m_blockCursor;
+	uint64_t eventSize;
+
+	if (!LiveAPIRecord_ReadEventHeader(m_blockData, pos, timestamp, eventSize))
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: event record in block #%zu is corrupt\n", __FUNCTION__, m_nextBlock - 1);
+		return false;
+	}
+
+	m_blockCursor = size_t(pos + eventSize);
+	return event.ParseFromArray(&m_blockData[pos], int(eventSize));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: returns the total number of events in the recording
+//-----------------------------------------------------------------------------
+uint64_t CLiveAPIRecordReader::GetEventCount() const
+{
+	uint64_t eventCount = 0;
+
+	for (const LiveAPIRecordIndexEntry_s& entry : m_blocks)
+		eventCount += entry.eventCount;
+
+	return eventCount;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: loads the block index by walking the index blocks from the trailer
+// Output : true on success, false if the trailer or any index block is invalid
+//-----------------------------------------------------------------------------
+bool CLiveAPIRecordReader::ReadIndexChain()
+{
+	LiveAPIRecordTrailer_s trailer;
+
+	if (m_fileSize < sizeof(LiveAPIRecordHeader_s) + sizeof(trailer))
+		return false;
+
+	const uint64_t dataEnd = m_fileSize - sizeof(trailer);
+
+	m_stream.SeekGet(std::streampos(dataEnd));
+	m_stream.Read(trailer);
+
+	if (trailer.magic != LIVE_API_RECORD_MAGIC)
+		return false;
+
+	// The chain runs from the last index block to the first.
+	std::vector<std::vector<LiveAPIRecordIndexEntry_s>> indexBlocks;
+	uint64_t indexOffset = trailer.lastIndexOffset;
+
+	while (indexOffset)
+	{
+		LiveAPIRecordBlock_s block;
+
+		if (!ReadBlockHeader(indexOffset, dataEnd, block) || block.type != LIVE_API_RECORD_INDEX ||
+			block.diskSize != sizeof(uint64_t) + uint64_t(block.eventCount) * sizeof(LiveAPIRecordIndexEntry_s))
+			return false;
+
+		uint64_t prevIndexOffset;
+		m_stream.Read(prevIndexOffset);
+
+		// Offsets must strictly decrease, or a corrupt file could loop forever.
+		if (prevIndexOffset >= indexOffset)
+			return false;
+
+		indexBlocks.emplace_back(block.eventCount);
+		m_stream.Read(indexBlocks.back().data(), block.eventCount * sizeof(LiveAPIRecordIndexEntry_s));
+
+		indexOffset = prevIndexOffset;
+	}
+
+	m_blocks.clear();
+
+	for (auto it = indexBlocks.rbegin(); it != indexBlocks.rend(); ++it)
+	{
+		for (const LiveAPIRecordIndexEntry_s& entry : *it)
+		{
+			if (entry.offset + sizeof(LiveAPIRecordBlock_s) > dataEnd)
+				return false;
+
+			m_blocks.push_back(entry);
+		}
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: builds the block index by walking all block headers
+//-----------------------------------------------------------------------------
+void CLiveAPIRecordReader::ScanBlocks()
+{
+	m_blocks.clear();
+	uint64_t offset = sizeof(LiveAPIRecordHeader_s);
+
+	LiveAPIRecordBlock_s block;
+
+	// Stops at the trailer or at a partially written block.
+	while (ReadBlockHeader(offset, m_fileSize, block))
+	{
+		if (block.type == LIVE_API_RECORD_DATA)
+		{
+			LiveAPIRecordIndexEntry_s entry;
+
+			entry.offset = offset;
+			entry.firstTimestamp = block.firstTimestamp;
+			entry.lastTimestamp = block.lastTimestamp;
+			entry.eventCount = block.eventCount;
+
+			m_blocks.push_back(entry);
+		}
+
+		offset += sizeof(block) + block.diskSize;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reads and validates the block header at given offset, the stream
+//          is left at the start of the block's payload
+// Output : true if the block and its payload lie within the limit
+//-----------------------------------------------------------------------------
+bool CLiveAPIRecordReader::ReadBlockHeader(const uint64_t offset, const uint64_t limit, LiveAPIRecordBlock_s& block)
+{
+	if (offset + sizeof(block) > limit)
+		return false;
+
+	m_stream.SeekGet(std::streampos(offset));
+	m_stream.Read(block);
+
+	if (block.magic != LIVE_API_RECORD_BLOCK_MAGIC)
+		return false;
+
+	return offset + sizeof(block) + block.diskSize <= limit;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: reads and decompresses a data block
+// Input  : blockIndex -
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CLiveAPIRecordReader::LoadBlock(const size_t blockIndex)
+{
+	LiveAPIRecordBlock_s block;
+
+	m_blockData.clear();
+	m_blockCursor = 0;
+
+	if (!ReadBlockHeader(m_blocks[blockIndex].offset, m_fileSize, block) || block.type != LIVE_API_RECORD_DATA ||
+		block.rawSize > LIVE_API_RECORD_MAX_BLOCK_SIZE || block.diskSize > LIVE_API_RECORD_MAX_BLOCK_SIZE)
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: block #%zu is corrupt\n", __FUNCTION__, blockIndex);
+		return false;
+	}
+
+	if (block.codec == LIVE_API_RECORD_CODEC_NONE)
+	{
+		if (block.rawSize != block.diskSize)
+		{
+			Error(eDLL_T::RTECH, NO_ERROR, "%s: block #%zu has mismatching sizes\n", __FUNCTION__, blockIndex);
+			return false;
+		}
+
+		m_blockData.resize(block.rawSize);
+		m_stream.Read(&m_blockData[0], block.rawSize);
+
+		return true;
+	}
+
+	if (block.codec != LIVE_API_RECORD_CODEC_ZSTD)
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: block #%zu uses unsupported codec (%hu)\n", __FUNCTION__, blockIndex, block.codec);
+		return false;
+	}
+
+	m_compressBuffer.resize(block.diskSize);
+	m_stream.Read(&m_compressBuffer[0], block.diskSize);
+
+	m_blockData.resize(block.rawSize);
+
+	const size_t result = ZSTD_decompress(&m_blockData[0], m_blockData.size(), m_compressBuffer.data(), m_compressBuffer.size());
+
+	if (ZSTD_isError(result) || result != block.rawSize)
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to decompress block #%zu: %s\n", __FUNCTION__, blockIndex,
+			ZSTD_isError(result) ? ZSTD_getErrorName(result) : "size mismatch");
+		m_blockData.clear();
+
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: converts a binary match recording to the LiveAPI JSON log format
+// Input  : *inputPath -
+//          *outputPath -
+//          startTime - only convert events at or after this timestamp
+//          pretty -
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool LiveAPI_ConvertRecordingToJson(const char* const inputPath, const char* const outputPath, const uint64_t startTime, const bool pretty)
+{
+	CLiveAPIRecordReader reader;
+
+	if (!reader.Open(inputPath))
+		return false;
+
+	CreateDirectories(outputPath);
+	CIOStream output;
+
+	if (!output.Open(outputPath, CIOStream::WRITE))
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to create '%s'\n", __FUNCTION__, outputPath);
+		return false;
+	}
+
+	if (startTime && !reader.SeekToTime(startTime))
+		Warning(eDLL_T::RTECH, "%s: no events at or after timestamp %llu\n", __FUNCTION__, startTime);
+
+	google::protobuf::util::JsonPrintOptions options;
+	options.add_whitespace = pretty;
+
+	rtech::liveapi::LiveAPIEvent event;
+	uint64_t timestamp;
+	uint64_t eventCount = 0;
+
+	std::string jsonStr("[\n");
+
+	while (reader.ReadEvent(event, timestamp))
+	{
+		if (eventCount++)
+			jsonStr.append(",\n");
+
+		google::protobuf::util::MessageToJsonString(event.gamemessage(), &jsonStr, options);
+
+		// Remove the trailing newline character
+		if (options.add_whitespace && !jsonStr.empty())
+			jsonStr.pop_back();
+
+		output.WriteString(jsonStr);
+		jsonStr.clear();
+	}
+
+	jsonStr.append("\n]\n");
+	output.WriteString(jsonStr);
+
+	Msg(eDLL_T::RTECH, "Converted %llu of %llu events from '%s' to '%s'\n",
+		eventCount, reader.GetEventCount(), inputPath, outputPath);
+
+	return true;
+}
@@ -0,0 +1,157 @@
+#ifndef RTECH_LIVERECORD_H
+#define RTECH_LIVERECORD_H
+#include "tier0/binstream.h"
+#include "thirdparty/protobuf/message.h"
+
+#define LIVE_API_RECORD_MAGIC (('R'<<24)+('P'<<16)+('A'<<8)+'L')
+#define LIVE_API_RECORD_BLOCK_MAGIC (('B'<<24)+('P'<<16)+('A'<<8)+'L')
+#define LIVE_API_RECORD_VERSION 1
+
+#define LIVE_API_RECORD_BLOCK_SIZE 0x10000 // Uncompressed event data per block.
+#define LIVE_API_RECORD_INDEX_INTERVAL 64 // Data blocks between each index block.
+#define LIVE_API_RECORD_MAX_BLOCK_SIZE (64 * 1024 * 1024) // Sanity limit for readers.
+
+//-----------------------------------------------------------------------------
+// Binary match recording layout:
+//
+//   LiveAPIRecordHeader_s header;
+//   { LiveAPIRecordBlock_s block; uint8_t payload[block.diskSize]; } ...
+//   LiveAPIRecordTrailer_s trailer; // Only present if closed properly.
+//
+// The payload of a data block (after decompression) is a sequence of events:
+//
+//   varint timestamp, varint size, LiveAPIEvent message[size]
+//
+// An index block is written after every LIVE_API_RECORD_INDEX_INTERVAL data
+// blocks and when closing, its payload is the offset of the previous index
+// block (0 if none) followed by the LiveAPIRecordIndexEntry_s of each data
+// block written since. A file without trailer (e.g. the server crashed) can
+// still be read by walking the block headers.
+//-----------------------------------------------------------------------------
+enum LiveAPIRecordBlockType_e : uint16_t
+{
+	LIVE_API_RECORD_DATA = 0,
+	LIVE_API_RECORD_INDEX
+};
+
+enum LiveAPIRecordCodec_e : uint16_t
+{
+	LIVE_API_RECORD_CODEC_NONE = 0,
+	LIVE_API_RECORD_CODEC_ZSTD
+};
+
+#pragma pack(push, 1)
+struct LiveAPIRecordHeader_s
+{
+	int magic;
+	uint16_t version;
+	uint16_t flags;
+};
+
+struct LiveAPIRecordBlock_s
+{
+	int magic;
+	uint16_t type;
+	uint16_t codec;
+	uint32_t rawSize;
+	uint32_t diskSize;
+	uint32_t eventCount;
+	uint64_t firstTimestamp; // Lowest timestamp in this block.
+	uint64_t lastTimestamp; // Highest timestamp in this block.
+};
+
+struct LiveAPIRecordIndexEntry_s
+{
+	uint64_t offset;
+	uint64_t firstTimestamp;
+	uint64_t lastTimestamp;
+	uint32_t eventCount;
+};
+
+struct LiveAPIRecordTrailer_s
+{
+	uint64_t lastIndexOffset;
+	int magic;
+};
+#pragma pack(pop)
+
+//-----------------------------------------------------------------------------
+// Writes serialized LiveAPIEvent messages to a binary match recording
+//-----------------------------------------------------------------------------
+class CLiveAPIRecordWriter
+{
+public:
+	CLiveAPIRecordWriter();
+	~CLiveAPIRecordWriter();
+
+	bool Open(const char* const filePath, const int compressionLevel);
+	void Close();
+
+	void WriteEvent(const uint64_t timestamp, const char* const data, const size_t size);
+
+	inline bool IsOpen() const { return m_isOpen; }
+
+private:
+	void FlushBlock();
+	void WriteIndex();
+
+	CIOStream m_stream;
+	uint64_t m_writeOffset;
+	uint64_t m_lastIndexOffset;
+
+	std::string m_blockBuffer;
+	std::string m_compressBuffer;
+	std::vector<LiveAPIRecordIndexEntry_s> m_pendingIndex;
+
+	uint64_t m_blockFirstTimestamp;
+	uint64_t m_blockLastTimestamp;
+	uint32_t m_blockEventCount;
+
+	void* m_compressContext;
+	int m_compressionLevel;
+	bool m_isOpen;
+};
+
+//-----------------------------------------------------------------------------
+// Reads events from a binary match recording, with seeking on timestamps
+//-----------------------------------------------------------------------------
+class CLiveAPIRecordReader
+{
+public:
+	CLiveAPIRecordReader();
+
+	bool Open(const char* const filePath);
+	void Close();
+
+	bool SeekToTime(const uint64_t timestamp);
+	bool ReadEvent(google::protobuf::Message& event, uint64_t& timestamp);
+
+	inline size_t GetBlockCount() const { return m_blocks.size(); }
+	uint64_t GetEventCount() const;
+
+	inline bool IsIndexed() const { return m_isIndexed; }
+
+private:
+	bool ReadIndexChain();
+	void ScanBlocks();
+
+	bool ReadBlockHeader(const uint64_t offset, const uint64_t limit, LiveAPIRecordBlock_s& block);
+	bool LoadBlock(const size_t blockIndex);
+
+	CIOStream m_stream;
+	uint64_t m_fileSize;
+
+	std::vector<LiveAPIRecordIndexEntry_s> m_blocks;
+
+	std::string m_blockData;
+	std::string m_compressBuffer;
+
+	size_t m_nextBlock; // Block to load once the current one is exhausted.
+	size_t m_blockCursor;
+
+	bool m_isIndexed;
+};
+
+bool LiveAPI_ConvertRecordingToJson(const char* const inputPath, const char* const outputPath, const uint64_t startTime, const bool pretty);
+
+#endif // RTECH_LIVERECORD_H
@@ -5,6 +5,7 @@
 //=============================================================================//
 #include "tier0/binstream.h"
 #include "tier1/fmtstr.h"
+#include "tier1/mappedfile.h"
 
 #include "rtech/ipakfile.h"
 
@@ -791,7 +792,170 @@ bool Pak_BufferToBufferDecode(uint8_t* const inBuf, uint8_t* const outBuf, const
 }
 
 //-----------------------------------------------------------------------------
-// decodes the pak file from file name
+// the RTech decoder reads the input a qword at a time, and could therefore read
+// up to 7 bytes past the end of the file; this is only safe on mapped views if
+// these bytes are still within the last page of the mapping
+//-----------------------------------------------------------------------------
+static bool Pak_CanDecodeFromMappedFile(const size_t fileSize, const PakDecodeMode_e decodeMode)
+{
+	if (decodeMode != PakDecodeMode_e::MODE_RTECH)
+		return true;
+
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+
+	const size_t pageSize = systemInfo.dwPageSize;
+	const size_t pageSlack = (pageSize - (fileSize % pageSize)) % pageSize;
+
+	return pageSlack >= sizeof(uint64_t);
+}
+
+//-----------------------------------------------------------------------------
+// writes the decoded data from the output ring buffer to the stream, the bytes
+// that belong to the file header region are also copied into the header buffer
+// as they need to be updated once decoding has finished
+//-----------------------------------------------------------------------------
+static void Pak_WriteDecodedFrame(CIOStream& outStream, const uint8_t* const ringBuf, const uint64_t ringMask,
+	const uint64_t startPos, const uint64_t endPos, uint8_t* const headerBuf, const size_t headerBufLen)
+{
+	uint64_t seekPos = startPos;
+
+	// the frame may wrap around the end of the ring buffer, in which case
+	// we have to write it in two parts
+	while (seekPos != endPos)
+	{
+		const PakRingBufferFrame_s frame = Pak_DetermineRingBufferFrame(ringMask, seekPos, endPos);
+		const uint8_t* const frameData = &ringBuf[frame.bufIndex];
+
+		if (seekPos < headerBufLen)
+		{
+			const size_t headerBytes = Min(size_t(headerBufLen - seekPos), frame.frameLen);
+			memcpy(&headerBuf[seekPos], frameData, headerBytes);
+		}
+
+		outStream.Write(frameData, frame.frameLen);
+		seekPos += frame.frameLen;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// decodes the mapped pak data into the output stream through a ring buffer,
+// writing each decoded frame out as soon as it has been produced
+//-----------------------------------------------------------------------------
+static bool Pak_StreamToStreamDecode(const uint8_t* const inBuf, const size_t pakSize, CIOStream& outStream,
+	const char* const outPakFile, const PakDecodeMode_e decodeMode)
+{
+	const PakFileHeader_s* const inHeader = reinterpret_cast<const PakFileHeader_s*>(inBuf);
+	size_t ringBufSize = PAK_DECODE_OUT_RING_BUFFER_SIZE;
+
+	// the RTech decoder decodes in blocks, the size of which is parsed out of
+	// the frame header; the ring buffer must be able to hold an entire block
+	if (decodeMode == PakDecodeMode_e::MODE_RTECH)
+	{
+		PakDecoder_s probe{};
+		Pak_InitDecoder(&probe, inBuf, nullptr, UINT64_MAX, PAK_DECODE_OUT_RING_BUFFER_MASK,
+			pakSize, NULL, sizeof(PakFileHeader_s), decodeMode);
+
+		const uint64_t blockSize = probe.outputInvMask < probe.decompSize
+			? probe.outputInvMask + 1
+			: probe.decompSize;
+
+		while (ringBufSize < blockSize)
+			ringBufSize <<= 1;
+	}
+
+	std::unique_ptr<uint8_t[]> ringBufContainer(new uint8_t[ringBufSize]);
+	uint8_t* const ringBuf = ringBufContainer.get();
+
+	const uint64_t ringMask = ringBufSize - 1;
+
+	PakDecoder_s decoder{};
+	const size_t decompressedSize = Pak_InitDecoder(&decoder, inBuf, ringBuf, UINT64_MAX, ringMask,
+		pakSize, NULL, sizeof(PakFileHeader_s), decodeMode);
+
+	if (decompressedSize != inHeader->decompressedSize)
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: decompressed size: '%zu' expected: '%zu'!\n",
+			__FUNCTION__, decompressedSize, inHeader->decompressedSize);
+
+		return false;
+	}
+
+	// the file header and the patch headers following it must be updated
+	// before the final write, keep a copy of this region around
+	size_t headerBufLen = sizeof(PakFileHeader_s);
+
+	if (inHeader->patchIndex)
+	{
+		headerBufLen += sizeof(PakPatchDataHeader_s) +
+			inHeader->patchIndex * (sizeof(PakPatchFileHeader_s) + sizeof(short));
+	}
+
+	headerBufLen = Min(headerBufLen, decompressedSize);
+
+	std::unique_ptr<uint8_t[]> headerBufContainer(new uint8_t[headerBufLen]);
+	uint8_t* const headerBuf = headerBufContainer.get();
+
+	PakFileHeader_s* const outHeader = reinterpret_cast<PakFileHeader_s*>(headerBuf);
+
+	// copy the header over to the decoded buffer
+	*outHeader = *inHeader;
+
+	// remove compress flags
+	outHeader->flags &= ~PAK_HEADER_FLAGS_COMPRESSED;
+	outHeader->flags &= ~PAK_HEADER_FLAGS_ZSTREAM_ENCODED;
+
+	// equal compressed size with decompressed
+	outHeader->compressedSize = outHeader->decompressedSize;
+
+	// the decoder starts writing past the header, reserve it in the stream
+	outStream.Write(outHeader, sizeof(PakFileHeader_s));
+
+	uint64_t processedSize = sizeof(PakFileHeader_s);
+	bool decoded = false;
+
+	while (!decoded)
+	{
+		// all input data is available at once as the file is mapped, the
+		// output is limited to what fits in the ring buffer without
+		// overwriting data we haven't written out yet
+		decoded = Pak_StreamToBufferDecode(&decoder, pakSize, processedSize + ringBufSize, decodeMode);
+
+		const uint64_t decodedSize = decoder.outBufBytePos;
+
+		if (decodedSize == processedSize && !decoded)
+		{
+			Error(eDLL_T::RTECH, NO_ERROR, "%s: decoder stalled at '%zu' of '%zu' bytes!\n",
+				__FUNCTION__, size_t(decodedSize), decompressedSize);
+
+			// free the zstd decoder if it hasn't been released yet
+			if (decodeMode == PakDecodeMode_e::MODE_ZSTD && decoder.zstreamContext)
+				ZSTD_freeDStream(decoder.zstreamContext);
+
+			return false;
+		}
+
+		Pak_WriteDecodedFrame(outStream, ringBuf, ringMask, processedSize, decodedSize, headerBuf, headerBufLen);
+		processedSize = decodedSize;
+	}
+
+	// NOTE: if the paks this particular pak patches have different sizes than
+	// current sizes in the patch header, the runtime will crash!
+	if (outHeader->patchIndex && !Pak_UpdatePatchHeaders(headerBuf, outPakFile))
+	{
+		Warning(eDLL_T::RTECH, "%s: pak is a patch pak, but the pak(s) it patches weren't found; patch headers not updated!\n",
+			__FUNCTION__);
+	}
+
+	outStream.SeekPut(0);
+	outStream.Write(headerBuf, headerBufLen);
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// decodes the pak file from file name; the input is mapped and decoded through
+// a ring buffer, so only a few MB are held in memory regardless of pak size
 //-----------------------------------------------------------------------------
 bool Pak_DecodePakFile(const char* const inPakFile, const char* const outPakFile)
 {
@@ -805,9 +969,9 @@ bool Pak_DecodePakFile(const char* const inPakFile, const char* const outPakFile
 		return false;
 	}
 
-	CIOStream inPakStream;
+	CMappedFileView inPakMapping;
 
-	if (!inPakStream.Open(inPakFile, CIOStream::READ | CIOStream::BINARY))
+	if (!inPakMapping.Map(inPakFile, FileMapAccess_t::FILEMAP_ACCESS_SEQUENTIAL))
 	{
 		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to open pak file '%s' for read!\n",
 			__FUNCTION__, inPakFile);
@@ -825,7 +989,7 @@ bool Pak_DecodePakFile(const char* const inPakFile, const char* const outPakFile
 		return false;
 	}
 
-	const size_t fileSize = inPakStream.GetSize();
+	const size_t fileSize = size_t(inPakMapping.Size());
 
 	if (fileSize <= sizeof(PakFileHeader_s))
 	{
@@ -835,13 +999,7 @@ bool Pak_DecodePakFile(const char* const inPakFile, const char* const outPakFile
 		return false;
 	}
 
-	std::unique_ptr<uint8_t[]> inPakBufContainer(new uint8_t[fileSize]);
-	uint8_t* const inPakBuf = inPakBufContainer.get();
-
-	inPakStream.Read(inPakBuf, fileSize);
-	inPakStream.Close();
-
-	PakFileHeader_s* const inHeader = reinterpret_cast<PakFileHeader_s*>(inPakBuf);
+	const PakFileHeader_s* const inHeader = reinterpret_cast<const PakFileHeader_s*>(inPakMapping.Base());
 
 	if (inHeader->magic != PAK_HEADER_MAGIC || inHeader->version != PAK_HEADER_VERSION)
 	{
@@ -871,28 +1029,29 @@ bool Pak_DecodePakFile(const char* const inPakFile, const char* const outPakFile
 
 	Pak_ShowHeaderDetails(inHeader);
 
-	std::unique_ptr<uint8_t[]> outPakBufContainer(new uint8_t[inHeader->decompressedSize]);
-	uint8_t* const outPakBuf = outPakBufContainer.get();
+	const uint8_t* inPakBuf = inPakMapping.Base();
+	std::unique_ptr<uint8_t[]> inPakBufContainer;
 
-	if (!Pak_BufferToBufferDecode(inPakBuf, outPakBuf, fileSize, decodeMode))
+	// decoding straight from the mapping could fault on the last page, decode
+	// from a padded copy of the file instead
+	if (!Pak_CanDecodeFromMappedFile(fileSize, decodeMode))
 	{
-		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to decompress pak file '%s'!\n",
-			__FUNCTION__, inPakFile);
+		inPakBufContainer.reset(new uint8_t[fileSize + sizeof(uint64_t)]);
+		memcpy(inPakBufContainer.get(), inPakMapping.Base(), fileSize);
 
-		return false;
+		inPakBuf = inPakBufContainer.get();
 	}
 
-	const PakFileHeader_s* const outHeader = reinterpret_cast<PakFileHeader_s*>(outPakBuf);
+	const bool decoded = Pak_StreamToStreamDecode(inPakBuf, fileSize, outPakStream, outPakFile, decodeMode);
+	inPakMapping.Unmap();
 
-	// NOTE: if the paks this particular pak patches have different sizes than
-	// current sizes in the patch header, the runtime will crash!
-	if (outHeader->patchIndex && !Pak_UpdatePatchHeaders(outPakBuf, outPakFile))
+	if (!decoded)
 	{
-		Warning(eDLL_T::RTECH, "%s: pak '%s' is a patch pak, but the pak(s) it patches weren't found; patch headers not updated!\n",
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to decompress pak file '%s'!\n",
 			__FUNCTION__, inPakFile);
-	}
 
-	outPakStream.Write(outPakBuf, outHeader->decompressedSize);
+		return false;
+	}
 
 	Msg(eDLL_T::RTECH, "Decompressed pak file to: '%s'\n", outPakFile);
 	return true;
@@ -25,13 +25,96 @@ static const char* Pak_GetEncodeError(const size_t result)
 }
 
 //-----------------------------------------------------------------------------
-// encodes the pak file from buffer, we can't do streamed compression as we
-// need to know the actual decompress size ahead of time, else the runtime will
-// fail as we wouldn't be able to parse the decompressed size from the frame
-// header
+// sets an encoder parameter, logs an error on failure
+//-----------------------------------------------------------------------------
+static bool Pak_SetEncodeParameter(ZSTD_CCtx* const cctx, const ZSTD_cParameter param, const int value)
+{
+	const size_t result = ZSTD_CCtx_setParameter(cctx, param, value);
+
+	if (Pak_HasEncodeFailed(result))
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to set parameter '%d' to '%d'! [%s]\n",
+			__FUNCTION__, param, value, Pak_GetEncodeError(result));
+
+		return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// creates the encoder, the caller must free it with ZSTD_freeCCtx()
+//-----------------------------------------------------------------------------
+static ZSTD_CCtx* Pak_CreateEncoder(const uint64_t srcLen, const PakEncodeParams_s& params)
+{
+	ZSTD_CCtx* const cctx = ZSTD_createCCtx();
+
+	if (!cctx)
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to create encoder!\n", __FUNCTION__);
+		return nullptr;
+	}
+
+	bool success = Pak_SetEncodeParameter(cctx, ZSTD_c_compressionLevel, params.level);
+
+	// worker threads compress jobs in parallel while we feed the stream
+	if (success && params.workerCount > 0)
+		success = Pak_SetEncodeParameter(cctx, ZSTD_c_nbWorkers, params.workerCount);
+
+	// the runtime's decoder is initialized with the default window limit, a
+	// larger window would make it refuse the frame, see Pak_ZStdDecoderInit()
+	if (success && params.windowLog > 0)
+	{
+		const int windowLog = Clamp(params.windowLog, ZSTD_WINDOWLOG_MIN, ZSTD_WINDOWLOG_LIMIT_DEFAULT);
+
+		success = Pak_SetEncodeParameter(cctx, ZSTD_c_enableLongDistanceMatching, 1) &&
+			Pak_SetEncodeParameter(cctx, ZSTD_c_windowLog, windowLog);
+	}
+
+	if (success)
+	{
+		// the runtime parses the decompressed size from the frame header, we
+		// must pledge it up front as we stream the data into the encoder
+		const size_t result = ZSTD_CCtx_setPledgedSrcSize(cctx, srcLen);
+
+		if (Pak_HasEncodeFailed(result))
+		{
+			Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to set pledged size! [%s]\n",
+				__FUNCTION__, Pak_GetEncodeError(result));
+
+			success = false;
+		}
+	}
+
+	if (!success)
+	{
+		ZSTD_freeCCtx(cctx);
+		return nullptr;
+	}
+
+	return cctx;
+}
+
+//-----------------------------------------------------------------------------
+// marks the pak header as zstd encoded with the given compressed data size
+//-----------------------------------------------------------------------------
+static void Pak_SetEncodedHeader(PakFileHeader_s* const outHeader, const size_t compressSize)
+{
+	// the compressed size includes the entire buffer, even the data we didn't
+	// compress like the file header
+	outHeader->compressedSize = compressSize + sizeof(PakFileHeader_s);
+
+	// these flags are required for the game's runtime to decide whether or not to
+	// decompress the pak, and how; see Pak_ProcessPakFile() for more details
+	outHeader->flags |= PAK_HEADER_FLAGS_COMPRESSED;
+	outHeader->flags |= PAK_HEADER_FLAGS_ZSTREAM_ENCODED;
+}
+
+//-----------------------------------------------------------------------------
+// encodes the pak file from buffer
 //-----------------------------------------------------------------------------
 bool Pak_BufferToBufferEncode(const uint8_t* const inBuf, const uint64_t inLen,
-	uint8_t* const outBuf, const uint64_t outLen, const int level)
+	uint8_t* const outBuf, const uint64_t outLen, const PakEncodeParams_s& params)
 {
 	// offset to the actual pak data, the main file header shouldn't be
 	// compressed
@@ -43,9 +126,13 @@ bool Pak_BufferToBufferEncode(const uint8_t* const inBuf, const uint64_t inLen,
 	const uint8_t* const srcBuf = inBuf + dataOffset;
 	const size_t srcLen = inLen - dataOffset;
 
-	size_t compressSize = NULL;
+	ZSTD_CCtx* const cctx = Pak_CreateEncoder(srcLen, params);
+
+	if (!cctx)
+		return false;
 
-	compressSize = ZSTD_compress(dstBuf, dstLen, srcBuf, srcLen, level);
+	const size_t compressSize = ZSTD_compress2(cctx, dstBuf, dstLen, srcBuf, srcLen);
+	ZSTD_freeCCtx(cctx);
 
 	if (Pak_HasEncodeFailed(compressSize))
 	{
@@ -55,24 +142,77 @@ bool Pak_BufferToBufferEncode(const uint8_t* const inBuf, const uint64_t inLen,
 		return false;
 	}
 
-	PakFileHeader_s* const outHeader = reinterpret_cast<PakFileHeader_s* const>(outBuf);
+	Pak_SetEncodedHeader(reinterpret_cast<PakFileHeader_s* const>(outBuf), compressSize);
+	return true;
+}
 
-	// the compressed size includes the entire buffer, even the data we didn't
-	// compress like the file header
-	outHeader->compressedSize = compressSize + dataOffset;
+//-----------------------------------------------------------------------------
+// encodes the pak data from the input stream into the output stream, the
+// first chunk has already been read into the input buffer by the caller as the
+// header had to be validated and patched first
+//-----------------------------------------------------------------------------
+static bool Pak_StreamToStreamEncode(CIOStream& inStream, CIOStream& outStream, ZSTD_CCtx* const cctx,
+	uint8_t* const inBuf, const size_t inBufLen, size_t inChunkLen, size_t inChunkPos,
+	uint64_t bytesRemaining, uint8_t* const outBuf, const size_t outBufLen, size_t& compressSize)
+{
+	compressSize = 0;
 
-	// these flags are required for the game's runtime to decide whether or not to
-	// decompress the pak, and how; see Pak_ProcessPakFile() for more details
-	outHeader->flags |= PAK_HEADER_FLAGS_COMPRESSED;
-	outHeader->flags |= PAK_HEADER_FLAGS_ZSTREAM_ENCODED;
+	for (;;)
+	{
+		const bool lastChunk = bytesRemaining == 0;
+		const ZSTD_EndDirective mode = lastChunk ? ZSTD_e_end : ZSTD_e_continue;
+
+		ZSTD_inBuffer inBuffer = { inBuf + inChunkPos, inChunkLen - inChunkPos, 0 };
+		bool finished = false;
+
+		// keep going until the encoder consumed the whole chunk, or flushed
+		// the entire frame if this was the last one
+		while (!finished)
+		{
+			ZSTD_outBuffer outBuffer = { outBuf, outBufLen, 0 };
+			const size_t remaining = ZSTD_compressStream2(cctx, &outBuffer, &inBuffer, mode);
+
+			if (Pak_HasEncodeFailed(remaining))
+			{
+				Error(eDLL_T::RTECH, NO_ERROR, "%s: compression failed! [%s]\n",
+					__FUNCTION__, Pak_GetEncodeError(remaining));
+
+				return false;
+			}
+
+			outStream.Write(outBuf, outBuffer.pos);
+			compressSize += outBuffer.pos;
+
+			finished = lastChunk
+				? (remaining == 0)
+				: (inBuffer.pos == inBuffer.size);
+		}
+
+		if (lastChunk)
+			break;
+
+		inChunkLen = static_cast<size_t>(Min(bytesRemaining, static_cast<uint64_t>(inBufLen)));
+		inChunkPos = 0;
+
+		inStream.Read(inBuf, inChunkLen);
+
+		if (!inStream.IsReadable())
+		{
+			Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to read from input stream!\n", __FUNCTION__);
+			return false;
+		}
+
+		bytesRemaining -= inChunkLen;
+	}
 
 	return true;
 }
 
 //-----------------------------------------------------------------------------
-// encodes the pak file from file name
+// encodes the pak file from file name, the file is streamed through the
+// encoder so we never hold more than a single chunk of it in memory
 //-----------------------------------------------------------------------------
-bool Pak_EncodePakFile(const char* const inPakFile, const char* const outPakFile, const int level)
+bool Pak_EncodePakFile(const char* const inPakFile, const char* const outPakFile, const PakEncodeParams_s& params)
 {
 	if (!Pak_CreateBasePath())
 	{
@@ -113,11 +253,16 @@ bool Pak_EncodePakFile(const char* const inPakFile, const char* const outPakFile
 		return false;
 	}
 
-	std::unique_ptr<uint8_t[]> inPakBufContainer(new uint8_t[fileSize]);
+	const double startTime = Plat_FloatTime();
+
+	// the first chunk always contains the file header and the patch headers,
+	// as the latter have to be updated before they are getting compressed
+	const size_t inBufSize = PAK_ENCODE_STREAM_CHUNK_SIZE;
+	std::unique_ptr<uint8_t[]> inPakBufContainer(new uint8_t[inBufSize]);
 	uint8_t* const inPakBuf = inPakBufContainer.get();
 
-	inPakStream.Read(inPakBuf, fileSize);
-	inPakStream.Close();
+	const size_t firstChunkLen = Min(fileSize, inBufSize);
+	inPakStream.Read(inPakBuf, firstChunkLen);
 
 	const PakFileHeader_s* const inHeader = reinterpret_cast<PakFileHeader_s* const>(inPakBuf);
 
@@ -145,26 +290,58 @@ bool Pak_EncodePakFile(const char* const inPakFile, const char* const outPakFile
 		return false;
 	}
 
-	// NOTE: if the paks this particular pak patches have different sizes than
-	// current sizes in the patch header, the runtime will crash!
-	if (inHeader->patchIndex && !Pak_UpdatePatchHeaders(inPakBuf, outPakFile))
+	if (inHeader->patchIndex)
 	{
-		Warning(eDLL_T::RTECH, "%s: pak '%s' is a patch pak, but the pak(s) it patches weren't found; patch headers not updated!\n",
-			__FUNCTION__, inPakFile);
+		const size_t patchHeadersEnd = sizeof(PakFileHeader_s) + sizeof(PakPatchDataHeader_s) +
+			inHeader->patchIndex * (sizeof(PakPatchFileHeader_s) + sizeof(short));
+
+		if (patchHeadersEnd > firstChunkLen)
+		{
+			Error(eDLL_T::RTECH, NO_ERROR, "%s: pak '%s' appears truncated; patch headers exceed file size!\n",
+				__FUNCTION__, inPakFile);
+
+			return false;
+		}
+
+		// NOTE: if the paks this particular pak patches have different sizes than
+		// current sizes in the patch header, the runtime will crash!
+		if (!Pak_UpdatePatchHeaders(inPakBuf, outPakFile))
+		{
+			Warning(eDLL_T::RTECH, "%s: pak '%s' is a patch pak, but the pak(s) it patches weren't found; patch headers not updated!\n",
+				__FUNCTION__, inPakFile);
+		}
 	}
 
-	const size_t outBufSize = inHeader->decompressedSize;
+	PakFileHeader_s outHeader = *inHeader;
+
+	// reserve space for the header, the final one is written once we know the
+	// compressed size
+	outPakStream.Write(&outHeader, sizeof(PakFileHeader_s));
 
+	const size_t dataOffset = sizeof(PakFileHeader_s);
+	ZSTD_CCtx* const cctx = Pak_CreateEncoder(fileSize - dataOffset, params);
+
+	if (!cctx)
+	{
+		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to create encoder for pak file '%s'!\n",
+			__FUNCTION__, inPakFile);
+
+		return false;
+	}
+
+	const size_t outBufSize = ZSTD_CStreamOutSize();
 	std::unique_ptr<uint8_t[]> outPakBufContainer(new uint8_t[outBufSize]);
-	uint8_t* const outPakBuf = outPakBufContainer.get();
 
-	PakFileHeader_s* const outHeader = reinterpret_cast<PakFileHeader_s* const>(outPakBuf);
+	size_t compressSize = 0;
 
-	// copy the header over
-	*outHeader = *inHeader;
+	const bool encoded = Pak_StreamToStreamEncode(inPakStream, outPakStream, cctx,
+		inPakBuf, inBufSize, firstChunkLen, dataOffset, fileSize - firstChunkLen,
+		outPakBufContainer.get(), outBufSize, compressSize);
+
+	ZSTD_freeCCtx(cctx);
 
 	// encoding failed
-	if (!Pak_BufferToBufferEncode(inPakBuf, fileSize, outPakBuf, outBufSize, level))
+	if (!encoded)
 	{
 		Error(eDLL_T::RTECH, NO_ERROR, "%s: failed to compress pak file '%s'!\n",
 			__FUNCTION__, inPakFile);
@@ -172,13 +349,17 @@ bool Pak_EncodePakFile(const char* const inPakFile, const char* const outPakFile
 		return false;
 	}
 
-	const PakFileHeader_s* const outPakHeader = reinterpret_cast<PakFileHeader_s* const>(outPakBuf);
+	Pak_SetEncodedHeader(&outHeader, compressSize);
+	Pak_ShowHeaderDetails(&outHeader);
+
+	outPakStream.SeekPut(0);
+	outPakStream.Write(&outHeader, sizeof(PakFileHeader_s));
 
-	Pak_ShowHeaderDetails(outPakHeader);
+	const double elapsedTime = Plat_FloatTime() - startTime;
+	const double throughput = elapsedTime > 0.0 ? (fileSize / (1024.0 * 1024.0)) / elapsedTime : 0.0;
 
-	// this will be true if the entire buffer has been written
-	outPakStream.Write(outPakBuf, outPakHeader->compressedSize);
+	Msg(eDLL_T::RTECH, "Compressed pak file to: '%s' (%zu -> %zu bytes; %.3f seconds; %.2f MiB/s)\n",
+		outPakFile, fileSize, outHeader.compressedSize, elapsedTime, throughput);
 
-	Msg(eDLL_T::RTECH, "Compressed pak file to: '%s'\n", outPakFile);
 	return true;
 }
@@ -2,9 +2,25 @@
 #define RTECH_PAKENCODE_H
 #include "rtech/ipakfile.h"
 
+// the amount of uncompressed pak data read and fed into the encoder at a time
+#define PAK_ENCODE_STREAM_CHUNK_SIZE (8 * 1024 * 1024)
+
+struct PakEncodeParams_s
+{
+	// zstd compression level, 0 means default
+	int level;
+
+	// number of encoder worker threads, 0 means single threaded
+	int workerCount;
+
+	// log2 of the long distance matching window, 0 disables long distance
+	// matching; clamped to the max window size the runtime can decode
+	int windowLog;
+};
+
 bool Pak_BufferToBufferEncode(const uint8_t* const inBuf, const uint64_t inLen,
-	uint8_t* const outBuf, const uint64_t outLen, const int level);
+	uint8_t* const outBuf, const uint64_t outLen, const PakEncodeParams_s& params);
 
-bool Pak_EncodePakFile(const char* const inPakFile, const char* const outPakFile, const int level);
+bool Pak_EncodePakFile(const char* const inPakFile, const char* const outPakFile, const PakEncodeParams_s& params);
 
 #endif // RTECH_PAKENCODE_H
@@ -3,6 +3,7 @@
 // Purpose: pak runtime memory and management
 //
 //=============================================================================//
+#include "tier0/cpu.h"
 #include "tier1/fmtstr.h"
 #include "common/completion.h"
 #include "rtech/ipakfile.h"
@@ -10,6 +11,10 @@
 #include "pakdecode.h"
 #include "paktools.h"
 #include "pakstate.h"
+
+static ConVar pak_compress_workers("pak_compress_workers", "-1", FCVAR_DEVELOPMENTONLY, "Number of encoder worker threads used by pak_compress", true, -1.f, true, 256.f, "-1 = logical processor count, 0 = single threaded");
+static ConVar pak_compress_windowlog("pak_compress_windowlog", "0", FCVAR_DEVELOPMENTONLY, "Long distance matching window size (log2) used by pak_compress; the decoder must allocate a history buffer of this size", true, 0.f, true, float(ZSTD_WINDOWLOG_LIMIT_DEFAULT), "0 = long distance matching disabled");
+
 /*
 =====================
 Pak_ListPaks_f
@@ -236,10 +241,17 @@ static void Pak_Compress_f(const CCommand& args)
 	CFmtStr1024 inPakFile(PAK_PLATFORM_OVERRIDE_PATH "%s", args.Arg(1));
 	CFmtStr1024 outPakFile(PAK_PLATFORM_PATH "%s", args.Arg(1));
 
+	PakEncodeParams_s params;
+
 	// NULL means default compress level
-	const int compressLevel = args.ArgC() > 2 ? atoi(args.Arg(2)) : NULL;
+	params.level = args.ArgC() > 2 ? atoi(args.Arg(2)) : NULL;
+	params.workerCount = pak_compress_workers.GetInt();
+	params.windowLog = pak_compress_windowlog.GetInt();
+
+	if (params.workerCount < 0)
+		params.workerCount = GetCPUInformation().m_nLogicalProcessors;
 
-	if (!Pak_EncodePakFile(inPakFile.String(), outPakFile.String(), compressLevel))
+	if (!Pak_EncodePakFile(inPakFile.String(), outPakFile.String(), params))
 	{
 		Error(eDLL_T::RTECH, NO_ERROR, "%s - compression failed for '%s'!\n",
 			__FUNCTION__, inPakFile.String());
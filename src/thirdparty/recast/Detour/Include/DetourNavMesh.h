@@ -503,9 +503,10 @@ struct dtTraverseLinkConnectParams
 	///  @param[in]		slopeAngle		The slope angle from base to land position. [Unit: Degrees]
 	///  @param[in]		baseOverlaps	Whether the projection of the base edge overlaps with the land edge.
 	///  @param[in]		landOverlaps	Whether the projection of the land edge overlaps with the base edge.
+	///  @param[in]		samePolyGroup	Whether the base and land polygons are in the same polygon group.
 	/// @return The desired traverse type for provided spatial and logical characteristics.
 	unsigned char(*getTraverseType)(void* userData, const float traverseDist, const float elevation,
-		const float slopeAngle, const bool baseOverlaps, const bool landOverlaps);
+		const float slopeAngle, const bool baseOverlaps, const bool landOverlaps, const bool samePolyGroup);
 
 	/// User defined callback that returns whether a traverse link based on
 	/// provided spatial characteristics is clear in terms of line-of-sight.
@@ -544,6 +545,26 @@ struct dtTraverseLinkConnectParams
 	bool linkToNeighbor;			///< Whether to link to polygons in neighboring tiles. Limits linkage to internal polygons if false.
 };
 
+/// A traverse link found by #dtNavMesh::findTraverseLinks that has yet
+/// to be committed to the tiles with #dtNavMesh::commitTraverseLinks.
+/// @ingroup detour
+struct dtTraverseLinkCandidate
+{
+	dtMeshTile* landTile;			///< The tile hosting the land polygon.
+	unsigned short basePoly;		///< The index of the polygon on the base tile.
+	unsigned short landPoly;		///< The index of the polygon on the land tile.
+	unsigned char baseEdge;			///< The edge of the base polygon the link starts from.
+	unsigned char landEdge;			///< The edge of the land polygon the link ends on.
+	unsigned char baseSide;			///< The side of the base tile the base edge is on.
+	unsigned char landSide;			///< The side of the land tile the land edge is on.
+	unsigned char baseBmin;			///< The minimum sub-edge area of the base edge.
+	unsigned char baseBmax;			///< The maximum sub-edge area of the base edge.
+	unsigned char landBmin;			///< The minimum sub-edge area of the land edge.
+	unsigned char landBmax;			///< The maximum sub-edge area of the land edge.
+	unsigned char traverseType;		///< The traverse type of the link.
+	unsigned char traverseDist;		///< The quantized distance of the link.
+};
+
 /// Configuration parameters used to define multi-tile navigation meshes.
 /// The values are used to allocate space during the initialization of a navigation mesh.
 /// @see dtNavMesh::init()
@@ -906,8 +927,19 @@ public:
 	int getNeighbourTilesAt(const int x, const int y, const int side,
 		dtMeshTile** tiles, const int maxTiles) const;
 
-	/// Builds external polygon links for a tile.
+	/// Builds traverse links for a tile.
 	dtStatus connectTraverseLinks(const dtTileRef tileRef, const dtTraverseLinkConnectParams& params);
+
+	/// Finds all traverse links that could be established for a tile, without
+	/// modifying the navmesh. This can be called concurrently for several tiles
+	/// as long as the callbacks in @p params are thread safe.
+	dtStatus findTraverseLinks(const dtTileRef tileRef, const dtTraverseLinkConnectParams& params,
+		rdTempVector<dtTraverseLinkCandidate>& candidates) const;
+
+	/// Commits the traverse links found by #findTraverseLinks to the tiles, as
+	/// long as there are enough links available.
+	dtStatus commitTraverseLinks(const dtTileRef tileRef, const dtTraverseLinkConnectParams& params,
+		const dtTraverseLinkCandidate* candidates, const int candidateCount);
 	/// Builds external polygon links for a tile.
 	dtStatus connectExtOffMeshLinks(const dtTileRef tileRef);
 	/// Builds internal polygons links for a tile.
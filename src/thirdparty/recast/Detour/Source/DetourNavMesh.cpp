@@ -735,7 +735,8 @@ dtStatus dtNavMesh::baseOffMeshLinks(const dtTileRef tileRef)
 	return DT_SUCCESS;
 }
 
-dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraverseLinkConnectParams& params)
+dtStatus dtNavMesh::findTraverseLinks(const dtTileRef tileRef, const dtTraverseLinkConnectParams& params,
+	rdTempVector<dtTraverseLinkCandidate>& candidates) const
 {
 	const int tileIndex = (int)decodePolyIdTile((dtPolyRef)tileRef);
 	if (tileIndex >= m_maxTiles)
@@ -757,11 +758,10 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 	static const float detailEdgeAlignThresh = 0.01f*0.01f;
 
 	const dtPolyRef basePolyRefBase = getPolyRefBase(baseTile);
-	bool firstBaseTileLinkUsed = false;
 
 	for (int i = 0; i < baseHeader->polyCount; ++i)
 	{
-		dtPoly* const basePoly = &baseTile->polys[i];
+		const dtPoly* const basePoly = &baseTile->polys[i];
 
 		if (basePoly->groupId == DT_UNLINKED_POLY_GROUP)
 			continue;
@@ -769,7 +769,7 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 		if (basePoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
 			continue;
 
-		dtPolyDetail* const baseDetail = &baseTile->detailMeshes[i];
+		const dtPolyDetail* const baseDetail = &baseTile->detailMeshes[i];
 
 		for (int j = 0; j < basePoly->vertCount; ++j)
 		{
@@ -860,11 +860,10 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 							continue;
 
 						const dtPolyRef landPolyRefBase = getPolyRefBase(landTile);
-						bool firstLandTileLinkUsed = false;
 
 						for (int o = 0; o < landHeader->polyCount; ++o)
 						{
-							dtPoly* const landPoly = &landTile->polys[o];
+							const dtPoly* const landPoly = &landTile->polys[o];
 
 							if (landPoly->groupId == DT_UNLINKED_POLY_GROUP)
 								continue;
@@ -872,7 +871,7 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 							if (landPoly->getType() == DT_POLYTYPE_OFFMESH_CONNECTION)
 								continue;
 
-							dtPolyDetail* const landDetail = &landTile->detailMeshes[o];
+							const dtPolyDetail* const landDetail = &landTile->detailMeshes[o];
 
 							for (int p = 0; p < landPoly->vertCount; ++p)
 							{
@@ -896,19 +895,6 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 									}
 									for (int r = 0, s = 2; r < 3; s = r++)
 									{
-										// We need at least 2 links available, figure out if
-										// we link to the same tile or another one.
-										if (params.linkToNeighbor)
-										{
-											if (firstLandTileLinkUsed && !landTile->linkCountAvailable(1))
-												continue;
-
-											else if (firstBaseTileLinkUsed && !baseTile->linkCountAvailable(1))
-												return DT_FAILURE | DT_OUT_OF_MEMORY;
-										}
-										else if (firstBaseTileLinkUsed && !baseTile->linkCountAvailable(2))
-											return DT_FAILURE | DT_OUT_OF_MEMORY;
-
 										if ((dtGetDetailTriEdgeFlags(landTri[3], s) & RD_DETAIL_EDGE_BOUNDARY) == 0)
 											continue;
 
@@ -957,7 +943,9 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 										const bool baseOverlaps = rdCalcEdgeOverlap2D(baseDetailPolyEdgeSpos, baseDetailPolyEdgeEpos, landDetailPolyEdgeSpos, landDetailPolyEdgeEpos, baseEdgeDir) > params.minEdgeOverlap;
 										const bool landOverlaps = rdCalcEdgeOverlap2D(landDetailPolyEdgeSpos, landDetailPolyEdgeEpos, baseDetailPolyEdgeSpos, baseDetailPolyEdgeEpos, landEdgeDir) > params.minEdgeOverlap;
 
-										const unsigned char traverseType = params.getTraverseType(params.userData, dist, elevation, slopeAngle, baseOverlaps, landOverlaps);
+										const bool samePolyGroup = basePoly->groupId == landPoly->groupId;
+
+										const unsigned char traverseType = params.getTraverseType(params.userData, dist, elevation, slopeAngle, baseOverlaps, landOverlaps, samePolyGroup);
 
 										if (traverseType == DT_NULL_TRAVERSE_TYPE)
 											continue;
@@ -965,9 +953,11 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 										const dtPolyRef basePolyRef = basePolyRefBase | i;
 										const dtPolyRef landPolyRef = landPolyRefBase | o;
 
-										unsigned int* linkedTraverseType = params.findPolyLink(params.userData, basePolyRef, landPolyRef);
+										const unsigned int* linkedTraverseType = params.findPolyLink(params.userData, basePolyRef, landPolyRef);
 
-										// These 2 polygons are already linked with the same traverse type.
+										// These 2 polygons are already linked with the same traverse type. The
+										// link map only grows during a pass, so we can skip the raycasts here
+										// and leave the final check to commitTraverseLinks().
 										if (linkedTraverseType && (rdBitCellBit(traverseType) & *linkedTraverseType))
 											continue;
 
@@ -986,52 +976,23 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 											? rdClassifyPointOutsideBounds(landPolyEdgeMid, landHeader->bmin, landHeader->bmax)
 											: rdClassifyPointInsideBounds(landPolyEdgeMid, landHeader->bmin, landHeader->bmax);
 
-										const unsigned int forwardIdx = baseTile->allocLink();
-										const unsigned int reverseIdx = landTile->allocLink();
-
-										// Allocated 2 new links, need to check for enough space on subsequent runs.
-										// This optimization saves a lot of time generating navmeshes for larger or
-										// more complicated geometry.
-										firstBaseTileLinkUsed = true;
-										firstLandTileLinkUsed = true;
-
-										dtLink* const forwardLink = &baseTile->links[forwardIdx];
-
-										forwardLink->ref = landPolyRef;
-										forwardLink->edge = (unsigned char)j;
-										forwardLink->side = landSide;
-										forwardLink->bmin = (unsigned char)rdMathRoundf(baseTmin*255.f);
-										forwardLink->bmax = (unsigned char)rdMathRoundf(baseTmax*255.f);
-										forwardLink->next = basePoly->firstLink;
-										basePoly->firstLink = forwardIdx;
-										forwardLink->traverseType = (unsigned char)traverseType;
-										forwardLink->traverseDist = quantDist;
-										forwardLink->reverseLink = (unsigned short)reverseIdx;
-
-										dtLink* const reverseLink = &landTile->links[reverseIdx];
-
-										reverseLink->ref = basePolyRef;
-										reverseLink->edge = (unsigned char)p;
-										reverseLink->side = baseSide;
-										reverseLink->bmin = (unsigned char)rdMathRoundf(landTmin*255.f);
-										reverseLink->bmax = (unsigned char)rdMathRoundf(landTmax*255.f);
-										reverseLink->next = landPoly->firstLink;
-										landPoly->firstLink = reverseIdx;
-										reverseLink->traverseType = (unsigned char)traverseType;
-										reverseLink->traverseDist = quantDist;
-										reverseLink->reverseLink = (unsigned short)forwardIdx;
-
-										if (linkedTraverseType)
-											*linkedTraverseType |= 1<<traverseType;
-										else
-										{
-											const int ret = params.addPolyLink(params.userData, basePolyRef, landPolyRef, 1<<traverseType);
-
-											if (ret < 0)
-												return DT_FAILURE | DT_OUT_OF_MEMORY;
-											if (ret > 0)
-												return DT_FAILURE | DT_INVALID_PARAM;
-										}
+										dtTraverseLinkCandidate candidate;
+
+										candidate.landTile = landTile;
+										candidate.basePoly = (unsigned short)i;
+										candidate.landPoly = (unsigned short)o;
+										candidate.baseEdge = (unsigned char)j;
+										candidate.landEdge = (unsigned char)p;
+										candidate.baseSide = baseSide;
+										candidate.landSide = landSide;
+										candidate.baseBmin = (unsigned char)rdMathRoundf(baseTmin*255.f);
+										candidate.baseBmax = (unsigned char)rdMathRoundf(baseTmax*255.f);
+										candidate.landBmin = (unsigned char)rdMathRoundf(landTmin*255.f);
+										candidate.landBmax = (unsigned char)rdMathRoundf(landTmax*255.f);
+										candidate.traverseType = traverseType;
+										candidate.traverseDist = quantDist;
+
+										candidates.push_back(candidate);
 									}
 								}
 							}
@@ -1045,6 +1006,110 @@ dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraver
 	return DT_SUCCESS;
 }
 
+dtStatus dtNavMesh::commitTraverseLinks(const dtTileRef tileRef, const dtTraverseLinkConnectParams& params,
+	const dtTraverseLinkCandidate* candidates, const int candidateCount)
+{
+	const int tileIndex = (int)decodePolyIdTile((dtPolyRef)tileRef);
+	if (tileIndex >= m_maxTiles)
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	dtMeshTile* baseTile = &m_tiles[tileIndex];
+
+	if (!baseTile->header)
+		return DT_FAILURE | DT_INVALID_PARAM; // Invalid tile.
+
+	// If we link to the same tile, we need at least 2 links.
+	if (!baseTile->linkCountAvailable(params.linkToNeighbor ? 1 : 2))
+		return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+	const dtPolyRef basePolyRefBase = getPolyRefBase(baseTile);
+
+	for (int i = 0; i < candidateCount; ++i)
+	{
+		const dtTraverseLinkCandidate& candidate = candidates[i];
+		dtMeshTile* const landTile = candidate.landTile;
+
+		// We need at least 2 links available, figure out if
+		// we link to the same tile or another one.
+		if (params.linkToNeighbor)
+		{
+			if (!landTile->linkCountAvailable(1))
+				continue;
+
+			else if (!baseTile->linkCountAvailable(1))
+				return DT_FAILURE | DT_OUT_OF_MEMORY;
+		}
+		else if (!baseTile->linkCountAvailable(2))
+			return DT_FAILURE | DT_OUT_OF_MEMORY;
+
+		const dtPolyRef basePolyRef = basePolyRefBase | candidate.basePoly;
+		const dtPolyRef landPolyRef = getPolyRefBase(landTile) | candidate.landPoly;
+
+		unsigned int* linkedTraverseType = params.findPolyLink(params.userData, basePolyRef, landPolyRef);
+
+		// These 2 polygons are already linked with the same traverse type.
+		if (linkedTraverseType && (rdBitCellBit(candidate.traverseType) & *linkedTraverseType))
+			continue;
+
+		dtPoly* const basePoly = &baseTile->polys[candidate.basePoly];
+		dtPoly* const landPoly = &landTile->polys[candidate.landPoly];
+
+		const unsigned int forwardIdx = baseTile->allocLink();
+		const unsigned int reverseIdx = landTile->allocLink();
+
+		dtLink* const forwardLink = &baseTile->links[forwardIdx];
+
+		forwardLink->ref = landPolyRef;
+		forwardLink->edge = candidate.baseEdge;
+		forwardLink->side = candidate.landSide;
+		forwardLink->bmin = candidate.baseBmin;
+		forwardLink->bmax = candidate.baseBmax;
+		forwardLink->next = basePoly->firstLink;
+		basePoly->firstLink = forwardIdx;
+		forwardLink->traverseType = candidate.traverseType;
+		forwardLink->traverseDist = candidate.traverseDist;
+		forwardLink->reverseLink = (unsigned short)reverseIdx;
+
+		dtLink* const reverseLink = &landTile->links[reverseIdx];
+
+		reverseLink->ref = basePolyRef;
+		reverseLink->edge = candidate.landEdge;
+		reverseLink->side = candidate.baseSide;
+		reverseLink->bmin = candidate.landBmin;
+		reverseLink->bmax = candidate.landBmax;
+		reverseLink->next = landPoly->firstLink;
+		landPoly->firstLink = reverseIdx;
+		reverseLink->traverseType = candidate.traverseType;
+		reverseLink->traverseDist = candidate.traverseDist;
+		reverseLink->reverseLink = (unsigned short)forwardIdx;
+
+		if (linkedTraverseType)
+			*linkedTraverseType |= 1<<candidate.traverseType;
+		else
+		{
+			const int ret = params.addPolyLink(params.userData, basePolyRef, landPolyRef, 1<<candidate.traverseType);
+
+			if (ret < 0)
+				return DT_FAILURE | DT_OUT_OF_MEMORY;
+			if (ret > 0)
+				return DT_FAILURE | DT_INVALID_PARAM;
+		}
+	}
+
+	return DT_SUCCESS;
+}
+
+dtStatus dtNavMesh::connectTraverseLinks(const dtTileRef tileRef, const dtTraverseLinkConnectParams& params)
+{
+	rdTempVector<dtTraverseLinkCandidate> candidates;
+	const dtStatus status = findTraverseLinks(tileRef, params, candidates);
+
+	if (dtStatusFailed(status))
+		return status;
+
+	return commitTraverseLinks(tileRef, params, candidates.data(), candidates.size());
+}
+
 namespace
 {
 	template<bool onlyBoundary>
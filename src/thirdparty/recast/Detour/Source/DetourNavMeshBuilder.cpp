@@ -22,6 +22,7 @@
 #include "Shared/Include/SharedAssert.h"
 #include "Detour/Include/DetourNavMesh.h"
 #include "Detour/Include/DetourNavMeshBuilder.h"
+#include <thread>
 
 static unsigned short MESH_NULL_IDX = 0xffff;
 
@@ -236,18 +237,6 @@ static int createBVTree(dtNavMeshCreateParams* params, dtBVNode* nodes, int /*nn
 	return curNode;
 }
 
-static void setPolyGroupsTraversalReachability(int* const tableData, const int numPolyGroups,
-	const unsigned short polyGroup1, const unsigned short polyGroup2, const bool isReachable)
-{
-	const int index = dtCalcTraverseTableCellIndex(numPolyGroups, polyGroup1, polyGroup2);
-	const int value = 1<<(polyGroup2 & 31);
-
-	if (isReachable)
-		tableData[index] |= value;
-	else
-		tableData[index] &= ~value;
-}
-
 bool dtCreateDisjointPolyGroups(const dtTraverseTableCreateParams* params)
 {
 	dtNavMesh* nav = params->nav;
@@ -530,6 +519,60 @@ bool dtUpdateDisjointPolyGroups(const dtTraverseTableCreateParams* params)
 	return true;
 }
 
+// Fills a traverse table by bucketing all poly groups on their disjoint set
+// root, the reachability row of every member in a bucket is identical, so the
+// row is only built once per bucket and then copied over to all its members.
+static void buildTraverseTable(int* const tableData, const dtDisjointSet& set, const int numPolyGroups)
+{
+	const int rowCellCount = (numPolyGroups+(RD_BITS_PER_BIT_CELL-1))/RD_BITS_PER_BIT_CELL;
+
+	rdIntArray roots(numPolyGroups);
+	rdIntArray bucketStart(numPolyGroups+1);
+	rdIntArray members(numPolyGroups);
+
+	// Resolve the root of each poly group once, and count the bucket sizes.
+	for (int i = 0; i < numPolyGroups; i++)
+	{
+		const int root = set.find(i);
+		roots[i] = root;
+		bucketStart[root+1]++;
+	}
+
+	for (int i = 0; i < numPolyGroups; i++)
+		bucketStart[i+1] += bucketStart[i];
+
+	// Scatter the poly groups in their buckets, this keeps the members of each
+	// bucket sorted on their poly group id.
+	{
+		rdIntArray cursor(numPolyGroups);
+		memcpy(cursor.data(), bucketStart.data(), sizeof(int)*numPolyGroups);
+
+		for (int i = 0; i < numPolyGroups; i++)
+			members[cursor[roots[i]]++] = i;
+	}
+
+	for (int i = 0; i < numPolyGroups; i++)
+	{
+		const int first = bucketStart[i];
+		const int last = bucketStart[i+1];
+
+		if (first == last)
+			continue;
+
+		// Only reachable if its the same polygroup or if they are linked!
+		int* const baseRow = &tableData[dtCalcTraverseTableCellIndex(numPolyGroups, (unsigned short)members[first], 0)];
+
+		for (int j = first; j < last; j++)
+			baseRow[members[j]/RD_BITS_PER_BIT_CELL] |= rdBitCellBit(members[j]);
+
+		for (int j = first+1; j < last; j++)
+		{
+			int* const row = &tableData[dtCalcTraverseTableCellIndex(numPolyGroups, (unsigned short)members[j], 0)];
+			memcpy(row, baseRow, sizeof(int)*rowCellCount);
+		}
+	}
+}
+
 bool dtCreateTraverseTableData(const dtTraverseTableCreateParams* params)
 {
 	dtNavMesh* nav = params->nav;
@@ -546,6 +589,7 @@ bool dtCreateTraverseTableData(const dtTraverseTableCreateParams* params)
 	nav->setTraverseTableSize(tableSize);
 	nav->setTraverseTableCount(tableCount);
 
+	// Allocate all tables up front so we can bail out before spawning workers.
 	for (int i = 0; i < tableCount; i++)
 	{
 		int* const traverseTable = (int*)rdAlloc(sizeof(int)*tableSize, RD_ALLOC_PERM);
@@ -555,20 +599,30 @@ bool dtCreateTraverseTableData(const dtTraverseTableCreateParams* params)
 
 		nav->setTraverseTable(i, traverseTable);
 		memset(traverseTable, 0, sizeof(int)*tableSize);
+	}
 
-		const dtDisjointSet& set = params->sets[i];
+	int** const traverseTables = nav->getTraverseTables();
 
-		for (unsigned short j = 0; j < polyGroupCount; j++)
-		{
-			for (unsigned short k = 0; k < polyGroupCount; k++)
-			{
-				// Only reachable if its the same polygroup or if they are linked!
-				const bool isReachable = j == k || set.find(j) == set.find(k);
-				setPolyGroupsTraversalReachability(traverseTable, polyGroupCount, j, k, isReachable);
-			}
-		}
+	if (tableCount == 1)
+	{
+		buildTraverseTable(traverseTables[0], params->sets[0], polyGroupCount);
+		return true;
 	}
 
+	// Each table has its own disjoint set and output buffer, so they can
+	// be built concurrently.
+	std::vector<std::thread> workers;
+	workers.reserve(tableCount);
+
+	for (int i = 0; i < tableCount; i++)
+	{
+		workers.emplace_back(buildTraverseTable, traverseTables[i],
+			std::cref(params->sets[i]), polyGroupCount);
+	}
+
+	for (std::thread& worker : workers)
+		worker.join();
+
 	return true;
 }
 
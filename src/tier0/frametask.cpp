@@ -8,29 +8,71 @@
 #include "tier0/frametask.h"
 
 //-----------------------------------------------------------------------------
-// Purpose: run frame task and process queued calls
+// Purpose: constructor
 //-----------------------------------------------------------------------------
-void CFrameTask::RunFrame()
+CFrameTask::CFrameTask()
+    : m_nFrame(0)
+{
+    memset(m_Wheel, 0, sizeof(m_Wheel));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: destructor, pending tasks are released without being called
+//-----------------------------------------------------------------------------
+CFrameTask::~CFrameTask()
 {
-    AUTO_LOCK(m_Mutex);
+    while (TSQueueNode_t* const pNode = m_SubmitQueue.Pop())
+        FreeTask(static_cast<FrameTask_s*>(pNode));
 
-    for (QueuedTasks_s& delay : m_QueuedTasks)
+    for (WheelSlot_s& slot : m_Wheel)
     {
-        if (delay.m_nDelayedFrames == 0)
+        while (FrameTask_s* const pTask = slot.m_pHead)
         {
-            delay.m_rFunctor();
+            slot.m_pHead = pTask->m_pWheelNext;
+            FreeTask(pTask);
         }
-
-        --delay.m_nDelayedFrames;
     }
 
-    const auto newEnd = std::remove_if(m_QueuedTasks.begin(), m_QueuedTasks.end(),
-        [](const QueuedTasks_s& delay)
+    while (TSStackNode_t* const pNode = m_FreeTasks.Pop())
+        delete static_cast<FrameTask_s*>(pNode);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: run frame task and process queued calls
+//-----------------------------------------------------------------------------
+void CFrameTask::RunFrame()
+{
+    // Move everything dispatched since the last frame into the wheel.
+    while (TSQueueNode_t* const pNode = m_SubmitQueue.Pop())
+        ScheduleTask(static_cast<FrameTask_s*>(pNode));
+
+    const uint64_t nFrame = m_nFrame++;
+    WheelSlot_s& slot = m_Wheel[nFrame & (FRAMETASK_WHEEL_SIZE - 1)];
+
+    // Detach the slot first, tasks that are due on a later turn of the wheel
+    // get put back in. Tasks dispatched by callbacks go through the submit
+    // queue, so they never end up in this list while we walk it.
+    FrameTask_s* pTask = slot.m_pHead;
+
+    slot.m_pHead = nullptr;
+    slot.m_pTail = nullptr;
+
+    while (pTask)
+    {
+        FrameTask_s* const pNext = pTask->m_pWheelNext;
+
+        if (pTask->m_nDueFrame == nFrame)
+        {
+            pTask->m_pInvoke(pTask->m_pFunctor);
+            FreeTask(pTask);
+        }
+        else
         {
-            return delay.m_nDelayedFrames == 0;
-        });
+            AppendTask(slot, pTask);
+        }
 
-    m_QueuedTasks.erase(newEnd, m_QueuedTasks.end());
+        pTask = pNext;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -43,14 +85,65 @@ bool CFrameTask::IsFinished() const
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: adds function to list, to be called after 'i' frames.
-// Input  : functor - 
-//          frames - 
+// Purpose: gets a task, reusing a released one when possible (any thread)
 //-----------------------------------------------------------------------------
-void CFrameTask::Dispatch(std::function<void()> functor, unsigned int frames)
+FrameTask_s* CFrameTask::AllocTask()
 {
-    AUTO_LOCK(m_Mutex);
-    m_QueuedTasks.emplace_back(frames, functor);
+    TSStackNode_t* const pNode = m_FreeTasks.Pop();
+
+    if (pNode)
+        return static_cast<FrameTask_s*>(pNode);
+
+    return new FrameTask_s();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: destroys the functor and returns the task to the free list
+// Input  : *pTask - 
+//-----------------------------------------------------------------------------
+void CFrameTask::FreeTask(FrameTask_s* const pTask)
+{
+    pTask->m_pDestroy(pTask->m_pFunctor);
+
+    pTask->m_pFunctor = nullptr;
+    pTask->m_pWheelNext = nullptr;
+
+    if (m_FreeTasks.Count() >= FRAMETASK_MAX_FREE_TASKS)
+    {
+        delete pTask;
+        return;
+    }
+
+    m_FreeTasks.Push(pTask);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: inserts a dispatched task in the wheel slot of the frame it is due
+// Input  : *pTask - 
+//-----------------------------------------------------------------------------
+void CFrameTask::ScheduleTask(FrameTask_s* const pTask)
+{
+    // Delay was stored in the due frame on dispatch.
+    pTask->m_nDueFrame += m_nFrame;
+
+    AppendTask(m_Wheel[pTask->m_nDueFrame & (FRAMETASK_WHEEL_SIZE - 1)], pTask);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: appends a task to the end of a wheel slot
+// Input  : &slot - 
+//          *pTask - 
+//-----------------------------------------------------------------------------
+void CFrameTask::AppendTask(WheelSlot_s& slot, FrameTask_s* const pTask)
+{
+    pTask->m_pWheelNext = nullptr;
+
+    if (slot.m_pTail)
+        slot.m_pTail->m_pWheelNext = pTask;
+    else
+        slot.m_pHead = pTask;
+
+    slot.m_pTail = pTask;
 }
 
 //-----------------------------------------------------------------------------
@@ -5,6 +5,7 @@
 //===========================================================================//
 #include "tier0/memaddr.h"
 #include "tier0/sigcache.h"
+#include "tier0/cpu.h"
 
 //-----------------------------------------------------------------------------
 // Purpose: constructor
@@ -179,6 +180,20 @@ CMemory CModule::FindPatternSIMD(const uint8_t* pPattern, const char* szMask,
 	return nullptr;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: gets the cache entry kind of a pattern scanned for in a module,
+//          only patterns scanned for in the code section of the game
+//          executable can be batch resolved when the cache is outdated
+// Input  : &module        - 
+//          *moduleSection - 
+//-----------------------------------------------------------------------------
+static SigDBEntryKind_e GetPatternEntryKind(const CModule& module, const CModule::ModuleSections_t* moduleSection)
+{
+	return (!moduleSection && module.GetModuleBase() == g_GameDll.GetModuleBase())
+		? SIGDB_ENTRY_GAME_PATTERN
+		: SIGDB_ENTRY_OTHER;
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: find a string pattern in process memory using SIMD instructions
 // Input  : *szPattern     - 
@@ -200,10 +215,471 @@ CMemory CModule::FindPatternSIMD(const char* szPattern,
 	const CMemory memory = FindPatternSIMD(patternInfo.first.data(),
 		patternInfo.second.c_str(), moduleSection);
 
-	g_SigCache.AddEntry(szPattern, GetRVA(memory.GetPtr()));
+	g_SigCache.AddEntry(szPattern, GetRVA(memory.GetPtr()), GetPatternEntryKind(*this, moduleSection));
 	return memory;
 }
 
+//-----------------------------------------------------------------------------
+// A pattern prepared for the batched scanner; the anchor is a pair of known
+// bytes within the pattern which is used to look up candidate patterns for
+// each position in the section, only those are fully compared.
+//-----------------------------------------------------------------------------
+struct PatternScanEntry_s
+{
+	vector<uint8_t> bytes; // Padded to a multiple of 16.
+	vector<int> masks;     // One 16 bit mask per 16 bytes.
+	size_t length;
+	size_t anchorOffset;
+};
+
+//-----------------------------------------------------------------------------
+// Purpose: checks whether the string is a 'xx ?? xx' style byte pattern
+//-----------------------------------------------------------------------------
+static bool IsBytePattern(const char* szPattern)
+{
+	size_t nTokens = 0;
+
+	for (const char* p = szPattern; *p;)
+	{
+		if (*p == ' ')
+		{
+			++p;
+			continue;
+		}
+
+		if (p[0] == '?')
+		{
+			p += (p[1] == '?') ? 2 : 1;
+		}
+		else if (isxdigit(uint8_t(p[0])) && isxdigit(uint8_t(p[1])))
+		{
+			p += 2;
+		}
+		else
+		{
+			return false;
+		}
+
+		if (*p && *p != ' ')
+			return false;
+
+		nTokens++;
+	}
+
+	return nTokens != 0;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: ranks how common a byte is in x64 code, anchors are picked on the
+//          least common bytes to keep the number of candidates per position low
+//-----------------------------------------------------------------------------
+static int PatternByteCommonness(const uint8_t nByte)
+{
+	switch (nByte)
+	{
+	case 0x00: case 0xCC: case 0xFF: case 0x48:
+		return 3;
+	case 0x89: case 0x8B: case 0x8D: case 0x24: case 0x4C: case 0x44:
+		return 2;
+	case 0x83: case 0xC3: case 0xE8: case 0x0F: case 0x85: case 0xC0: case 0x01:
+		return 1;
+	default:
+		return 0;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: prepares the pattern for the batched scanner
+// Output : false if the pattern is malformed or has no anchor (2 consecutive
+//          known bytes), these have to be resolved with the single scanner
+//-----------------------------------------------------------------------------
+static bool PreparePatternScanEntry(const char* szPattern, PatternScanEntry_s& entry)
+{
+	if (!IsBytePattern(szPattern))
+		return false;
+
+	const pair<vector<uint8_t>, string> patternInfo = PatternToMaskedBytes(szPattern);
+	const string& svMask = patternInfo.second;
+
+	entry.length = svMask.size();
+
+	if (entry.length < 2 || entry.length > 1024)
+		return false;
+
+	int nBestScore = INT_MAX;
+
+	for (size_t i = 0; i + 1 < entry.length; i++)
+	{
+		if (svMask[i] != 'x' || svMask[i + 1] != 'x')
+			continue;
+
+		const int nScore = PatternByteCommonness(patternInfo.first[i]) + PatternByteCommonness(patternInfo.first[i + 1]);
+
+		if (nScore < nBestScore)
+		{
+			nBestScore = nScore;
+			entry.anchorOffset = i;
+
+			if (!nScore)
+				break;
+		}
+	}
+
+	if (nBestScore == INT_MAX)
+		return false;
+
+	const size_t nNumMasks = (entry.length + 15) / 16;
+
+	entry.bytes.assign(nNumMasks * 16, 0);
+	entry.masks.assign(nNumMasks, 0);
+
+	for (size_t i = 0; i < entry.length; i++)
+	{
+		entry.bytes[i] = patternInfo.first[i];
+
+		if (svMask[i] == 'x')
+			entry.masks[i / 16] |= (1 << (i % 16));
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: compares the prepared pattern against the data using SSE,
+//          the caller must ensure 'entry.length' bytes are readable at pData,
+//          blocks that would cross pEnd are compared per byte
+//-----------------------------------------------------------------------------
+static FORCEINLINE bool MatchPatternScanEntry(const uint8_t* pData, const uint8_t* pEnd, const PatternScanEntry_s& entry)
+{
+	for (size_t i = 0; i < entry.masks.size(); i++)
+	{
+		const uint8_t* const pBlock = pData + i * 16;
+
+		if (size_t(pEnd - pBlock) < 16)
+		{
+			// Only the last block can cross the end of the range, its length
+			// is within bounds as the candidate fits the range.
+			for (size_t j = 0; i * 16 + j < entry.length; j++)
+			{
+				if ((entry.masks[i] & (1 << j)) && pBlock[j] != entry.bytes[i * 16 + j])
+					return false;
+			}
+
+			return true;
+		}
+
+		const __m128i xmm1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pBlock));
+		const __m128i xmm2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(entry.bytes.data() + i * 16));
+
+		if ((_mm_movemask_epi8(_mm_cmpeq_epi8(xmm1, xmm2)) & entry.masks[i]) != entry.masks[i])
+			return false;
+	}
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: finds the first occurrence of each pattern within the memory range
+//          in a single pass; the range is split across all logical processors,
+//          each position is looked up in a table of pattern anchors and only
+//          the patterns with a matching anchor are compared in full
+// Input  : *pBase         - 
+//          nSize          - 
+//          *pszPatterns   - 
+//          nPatternCount  - 
+//          *pResults      - (nullptr for patterns that weren't found)
+//-----------------------------------------------------------------------------
+void CModule::FindPatternsInRange(const uint8_t* pBase, const size_t nSize,
+	const char* const* pszPatterns, const size_t nPatternCount, CMemory* pResults)
+{
+	vector<PatternScanEntry_s> entries(nPatternCount);
+	vector<uint32_t> fallbackIndices;
+
+	// Bucket the patterns on their anchor, stored as a compressed table
+	// indexed by the 2 anchor bytes (little endian).
+	vector<uint32_t> bucketStart(0x10000 + 1, 0);
+	vector<uint64_t> bucketBits(0x10000 / 64, 0);
+
+	for (size_t i = 0; i < nPatternCount; i++)
+	{
+		pResults[i] = CMemory();
+
+		if (!PreparePatternScanEntry(pszPatterns[i], entries[i]))
+		{
+			fallbackIndices.push_back(uint32_t(i));
+			continue;
+		}
+
+		const uint8_t* pAnchor = &entries[i].bytes[entries[i].anchorOffset];
+		const uint16_t nKey = uint16_t(pAnchor[0] | (pAnchor[1] << 8));
+
+		bucketStart[nKey + 1]++;
+		bucketBits[nKey / 64] |= (1ull << (nKey % 64));
+	}
+
+	for (size_t i = 1; i < bucketStart.size(); i++)
+		bucketStart[i] += bucketStart[i - 1];
+
+	vector<uint32_t> bucketEntries(bucketStart.back());
+	vector<uint32_t> bucketFill(bucketStart.begin(), bucketStart.end() - 1);
+
+	for (size_t i = 0; i < nPatternCount; i++)
+	{
+		if (entries[i].masks.empty())
+			continue;
+
+		const uint8_t* pAnchor = &entries[i].bytes[entries[i].anchorOffset];
+		const uint16_t nKey = uint16_t(pAnchor[0] | (pAnchor[1] << 8));
+
+		bucketEntries[bucketFill[nKey]++] = uint32_t(i);
+	}
+
+	const uint8_t* const pEnd = pBase + nSize;
+
+	// Each worker scans the anchor positions of its own slice, so the first
+	// match of a worker is the first match within its slice; the final result
+	// is the match with the lowest address across all workers.
+	const size_t nMinSliceSize = 1024 * 1024;
+	const size_t nNumWorkers = Max(Min(size_t(GetCPUInformation().m_nLogicalProcessors), nSize / nMinSliceSize), size_t(1));
+	const size_t nSliceSize = (nSize + nNumWorkers - 1) / nNumWorkers;
+
+	vector<vector<const uint8_t*>> workerResults(nNumWorkers, vector<const uint8_t*>(nPatternCount, nullptr));
+
+	auto scanFunc = [&](const size_t nWorker)
+	{
+		vector<const uint8_t*>& results = workerResults[nWorker];
+
+		const uint8_t* pData = pBase + (nWorker * nSliceSize);
+		const uint8_t* const pSliceEnd = Min(pData + nSliceSize, pEnd - 1);
+
+		for (; pData < pSliceEnd; ++pData)
+		{
+			const uint16_t nKey = uint16_t(pData[0] | (pData[1] << 8));
+
+			if (!(bucketBits[nKey / 64] & (1ull << (nKey % 64))))
+				continue;
+
+			for (uint32_t j = bucketStart[nKey]; j < bucketStart[nKey + 1]; j++)
+			{
+				const uint32_t nIndex = bucketEntries[j];
+				const PatternScanEntry_s& entry = entries[nIndex];
+
+				if (results[nIndex])
+					continue; // Already found an earlier occurrence.
+
+				if (size_t(pData - pBase) < entry.anchorOffset)
+					continue;
+
+				const uint8_t* const pCandidate = pData - entry.anchorOffset;
+
+				if (size_t(pEnd - pCandidate) < entry.length)
+					continue;
+
+				if (MatchPatternScanEntry(pCandidate, pEnd, entry))
+					results[nIndex] = pCandidate;
+			}
+		}
+	};
+
+	vector<std::thread> workers;
+
+	for (size_t i = 1; i < nNumWorkers; i++)
+		workers.emplace_back(scanFunc, i);
+
+	scanFunc(0);
+
+	for (std::thread& worker : workers)
+		worker.join();
+
+	for (size_t i = 0; i < nPatternCount; i++)
+	{
+		const uint8_t* pBest = nullptr;
+
+		for (size_t w = 0; w < nNumWorkers; w++)
+		{
+			const uint8_t* const pResult = workerResults[w][i];
+
+			if (pResult && (!pBest || pResult < pBest))
+				pBest = pResult;
+		}
+
+		if (pBest)
+			pResults[i] = CMemory(const_cast<uint8_t*>(pBest));
+	}
+
+	// Patterns without an anchor are rare, scan these one by one.
+	for (const uint32_t nIndex : fallbackIndices)
+	{
+		if (!IsBytePattern(pszPatterns[nIndex]))
+			continue;
+
+		const pair<vector<uint8_t>, string> patternInfo = PatternToMaskedBytes(pszPatterns[nIndex]);
+		const string& svMask = patternInfo.second;
+
+		if (svMask.empty() || svMask.size() > 1024 || svMask.size() > nSize)
+			continue;
+
+		PatternScanEntry_s entry;
+		entry.length = svMask.size();
+		entry.bytes.assign(((entry.length + 15) / 16) * 16, 0);
+		entry.masks.assign((entry.length + 15) / 16, 0);
+
+		for (size_t i = 0; i < entry.length; i++)
+		{
+			entry.bytes[i] = patternInfo.first[i];
+
+			if (svMask[i] == 'x')
+				entry.masks[i / 16] |= (1 << (i % 16));
+		}
+
+		for (const uint8_t* pData = pBase; pData + entry.length <= pEnd; ++pData)
+		{
+			if (MatchPatternScanEntry(pData, pEnd, entry))
+			{
+				pResults[nIndex] = CMemory(const_cast<uint8_t*>(pData));
+				break;
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: find multiple string patterns in a single pass using SIMD
+//          instructions, all resolved patterns are added to the signature cache
+// Input  : *pszPatterns   - 
+//          nPatternCount  - 
+//          *pResults      - (nullptr for patterns that weren't found)
+//          *moduleSection - 
+// Output : number of patterns found
+//-----------------------------------------------------------------------------
+size_t CModule::FindPatternsSIMD(const char* const* pszPatterns, const size_t nPatternCount,
+	CMemory* pResults, const ModuleSections_t* moduleSection) const
+{
+	const ModuleSections_t& executableCode = GetSectionByName(".text");
+
+	if (!executableCode.IsSectionValid())
+		return 0;
+
+	const bool bSectionValid = moduleSection ? moduleSection->IsSectionValid() : false;
+
+	const QWORD nBase = bSectionValid ?
+		moduleSection->m_pSectionBase : executableCode.m_pSectionBase;
+	const QWORD nSize = bSectionValid ?
+		moduleSection->m_nSectionSize : executableCode.m_nSectionSize;
+
+	FindPatternsInRange(reinterpret_cast<const uint8_t*>(nBase), nSize,
+		pszPatterns, nPatternCount, pResults);
+
+	const SigDBEntryKind_e nKind = GetPatternEntryKind(*this, moduleSection);
+	size_t nFound = 0;
+
+	for (size_t i = 0; i < nPatternCount; i++)
+	{
+		if (!pResults[i])
+			continue;
+
+		g_SigCache.AddEntry(pszPatterns[i], GetRVA(pResults[i].GetPtr()), nKind);
+		nFound++;
+	}
+
+	return nFound;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: measures cold start time of the single and batched pattern scanner
+//          against the number of patterns, on a synthetic buffer
+// Input  : &module      - (module with a valid code section, runs the single scanner)
+//          nBufferSize  - 
+//          nMaxPatterns - 
+//-----------------------------------------------------------------------------
+void PatternScan_Benchmark(const CModule& module, const size_t nBufferSize, const size_t nMaxPatterns)
+{
+	const size_t nPatternLen = 24;
+
+	if (nBufferSize < nPatternLen * 2)
+		return;
+
+	// Pad the buffer as the single scanner reads up to 16 bytes past a candidate.
+	std::unique_ptr<uint8_t[]> pBuffer(new uint8_t[nBufferSize + 1024]);
+	memset(pBuffer.get() + nBufferSize, 0xCC, 1024);
+
+	uint64_t nState = 0x9E3779B97F4A7C15ull;
+
+	// Skew the distribution towards common opcode bytes, to get somewhat
+	// realistic anchor collisions.
+	static const uint8_t s_CommonBytes[] = { 0x48, 0x89, 0x8B, 0x00, 0xCC, 0xE8, 0x24, 0x4C, 0x8D, 0x83, 0xC3, 0xFF };
+
+	for (size_t i = 0; i < nBufferSize; i++)
+	{
+		nState ^= nState << 13; nState ^= nState >> 7; nState ^= nState << 17;
+		pBuffer[i] = (nState & 0x300) ? uint8_t(nState) : s_CommonBytes[(nState >> 16) % sizeof(s_CommonBytes)];
+	}
+
+	// Sample patterns from the buffer itself, with a few wildcards.
+	vector<string> patterns;
+	patterns.reserve(nMaxPatterns);
+
+	for (size_t i = 0; i < nMaxPatterns; i++)
+	{
+		nState ^= nState << 13; nState ^= nState >> 7; nState ^= nState << 17;
+		const size_t nOffset = nState % (nBufferSize - nPatternLen);
+
+		string svPattern;
+		char szByte[4];
+
+		for (size_t j = 0; j < nPatternLen; j++)
+		{
+			if (j && (j % 7) == 0)
+				svPattern += "??";
+			else
+			{
+				snprintf(szByte, sizeof(szByte), "%02X", pBuffer[nOffset + j]);
+				svPattern += szByte;
+			}
+
+			if (j + 1 < nPatternLen)
+				svPattern += ' ';
+		}
+
+		patterns.push_back(svPattern);
+	}
+
+	const CModule::ModuleSections_t bufferSection(reinterpret_cast<QWORD>(pBuffer.get()), nBufferSize);
+
+	for (size_t nCount = Min(size_t(16), nMaxPatterns); nCount; nCount = Min(nCount * 4, nMaxPatterns))
+	{
+		vector<const char*> pszPatterns(nCount);
+		vector<CMemory> batchResults(nCount);
+
+		for (size_t i = 0; i < nCount; i++)
+			pszPatterns[i] = patterns[i].c_str();
+
+		double flStart = Plat_FloatTime();
+		CModule::FindPatternsInRange(pBuffer.get(), nBufferSize, pszPatterns.data(), nCount, batchResults.data());
+		const double flBatchTime = Plat_FloatTime() - flStart;
+
+		size_t nMismatches = 0;
+		flStart = Plat_FloatTime();
+
+		for (size_t i = 0; i < nCount; i++)
+		{
+			const pair<vector<uint8_t>, string> patternInfo = PatternToMaskedBytes(pszPatterns[i]);
+			const CMemory single = module.FindPatternSIMD(patternInfo.first.data(), patternInfo.second.c_str(), &bufferSection);
+
+			if (single.GetPtr() != batchResults[i].GetPtr())
+				nMismatches++;
+		}
+
+		const double flSingleTime = Plat_FloatTime() - flStart;
+
+		Msg(eDLL_T::COMMON, "%s: '%zu' patterns over '%zu' MiB; single: '%.3f' seconds, batched: '%.3f' seconds ('%zu' mismatches)\n",
+			__FUNCTION__, nCount, nBufferSize / (1024 * 1024), flSingleTime, flBatchTime, nMismatches);
+
+		if (nCount == nMaxPatterns)
+			break;
+	}
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: find address of reference to string constant in executable memory
 // Input  : *szString       - 
@@ -6,18 +6,51 @@
 // sigcache.cpp
 // 
 // The system creates a static cache file on the disk, who's blob contains a 
-// map of string signatures and its precomputed relative virtual address.
+// table of hashed string signatures and its precomputed relative virtual
+// address, sorted on the hash.
 // 
-// This file gets loaded and parsed during DLL init. If the file is absent or 
-// outdated/corrupt, the system will generate a new cache file if enabled.
+// This file gets mapped during DLL init and is queried directly from the
+// mapped view. If the file is absent or outdated/corrupt, the system will
+// generate a new cache file if enabled.
 // 
 // By caching the relative virtual addresses, we can drop a significant amount 
-// of time initializing the DLL by parsing the precomputed data instead of 
+// of time initializing the DLL by looking up the precomputed data instead of 
 // searching for each signature in the memory region of the target executable.
 //
 ///////////////////////////////////////////////////////////////////////////////
 #include "tier0/sigcache.h"
 #include "tier0/binstream.h"
+#include "protoc/sig_map.pb.h"
+
+//-----------------------------------------------------------------------------
+// Purpose: hashes the pattern string (64-bit FNV-1a)
+// Input  : *szPattern - 
+// Output : hash
+//-----------------------------------------------------------------------------
+static uint64_t SigCache_HashPattern(const char* szPattern)
+{
+	uint64_t nHash = 0xCBF29CE484222325ull;
+
+	for (const uint8_t* p = reinterpret_cast<const uint8_t*>(szPattern); *p; ++p)
+	{
+		nHash ^= *p;
+		nHash *= 0x100000001B3ull;
+	}
+
+	return nHash;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: computes the checksum of the table blob
+// Input  : *pBlob     - 
+//          nBlobSize  - 
+// Output : adler32
+//-----------------------------------------------------------------------------
+static uint32_t SigCache_ChecksumBlob(const uint8_t* pBlob, const size_t nBlobSize)
+{
+	const lzham_z_ulong nInitial = lzham_z_adler32(0, nullptr, 0);
+	return uint32_t(lzham_z_adler32(nInitial, pBlob, nBlobSize));
+}
 
 //-----------------------------------------------------------------------------
 // Purpose: whether or not to disable the caching of signatures
@@ -38,22 +71,25 @@ void CSigCache::InvalidateMap()
 		return;
 	}
 
-	m_Cache.mutable_smap()->clear();
+	std::unordered_map<string, SigCacheEntry_t>().swap(m_NewEntries);
+	UnmapCache();
 }
 
 //-----------------------------------------------------------------------------
 // Purpose: creates a map of a pattern and relative virtual address
 // Input  : *szPattern - (key)
 //			nRVA       - (value)
+//			nKind      - (only game executable patterns are batch resolved
+//			              when the cache is outdated)
 //-----------------------------------------------------------------------------
-void CSigCache::AddEntry(const char* szPattern, const uint64_t nRVA)
+void CSigCache::AddEntry(const char* szPattern, const uint64_t nRVA, const SigDBEntryKind_e nKind)
 {
 	if (m_bDisabled)
 	{
 		return;
 	}
 
-	(*m_Cache.mutable_smap())[szPattern] = nRVA;
+	m_NewEntries[szPattern] = { nRVA, nKind };
 }
 
 //-----------------------------------------------------------------------------
@@ -64,14 +100,33 @@ void CSigCache::AddEntry(const char* szPattern, const uint64_t nRVA)
 //-----------------------------------------------------------------------------
 bool CSigCache::FindEntry(const char* szPattern, uint64_t& nRVA)
 {
-	if (!m_bDisabled && m_bInitialized)
+	if (m_bDisabled)
 	{
-		google::protobuf::Map<string, uint64_t>* sMap = m_Cache.mutable_smap();
-		auto p = sMap->find(szPattern);
+		return false;
+	}
+
+	if (m_nEntryCount)
+	{
+		const uint64_t nHash = SigCache_HashPattern(szPattern);
+
+		const SigDBEntry_t* const pEnd = m_pEntries + m_nEntryCount;
+		const SigDBEntry_t* const pEntry = std::lower_bound(m_pEntries, pEnd, nHash,
+			[](const SigDBEntry_t& entry, const uint64_t nKey) { return entry.m_nHash < nKey; });
 
-		if (p != sMap->end())
+		if (pEntry != pEnd && pEntry->m_nHash == nHash)
 		{
-			nRVA = p->second;
+			nRVA = pEntry->m_nRVA;
+			return true;
+		}
+	}
+
+	if (!m_NewEntries.empty())
+	{
+		auto p = m_NewEntries.find(szPattern);
+
+		if (p != m_NewEntries.end())
+		{
+			nRVA = p->second.m_nRVA;
 			return true;
 		}
 	}
@@ -80,7 +135,120 @@ bool CSigCache::FindEntry(const char* szPattern, uint64_t& nRVA)
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: loads the cache map from the disk
+// Purpose: releases the patterns harvested from an outdated cache file
+//-----------------------------------------------------------------------------
+void CSigCache::ClearStalePatterns()
+{
+	m_StalePatterns.clear();
+	m_StalePatterns.shrink_to_fit();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: maps the cache file into memory
+// Input  : *szCacheFile - 
+//          &nFileSize   - 
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CSigCache::MapCache(const char* szCacheFile, size_t& nFileSize)
+{
+	m_hFile = CreateFileA(szCacheFile, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(m_hFile, &fileSize) || fileSize.QuadPart <= SIGDB_BLOB_OFFSET)
+	{
+		UnmapCache();
+		return false;
+	}
+
+	m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (!m_hMapping)
+	{
+		UnmapCache();
+		return false;
+	}
+
+	m_pMappedView = reinterpret_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (!m_pMappedView)
+	{
+		UnmapCache();
+		return false;
+	}
+
+	nFileSize = size_t(fileSize.QuadPart);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: unmaps the cache file
+//-----------------------------------------------------------------------------
+void CSigCache::UnmapCache()
+{
+	m_pEntries = nullptr;
+	m_nEntryCount = 0;
+
+	if (m_pMappedView)
+	{
+		UnmapViewOfFile(m_pMappedView);
+		m_pMappedView = nullptr;
+	}
+	if (m_hMapping)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = NULL;
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: collects the game executable pattern strings of an outdated table
+// Input  : *pBlob    - (validated table blob)
+//          nBlobSize - 
+//-----------------------------------------------------------------------------
+void CSigCache::HarvestPatterns(const uint8_t* pBlob, const size_t nBlobSize)
+{
+	const SigDBTableHeader_t* const pTable = reinterpret_cast<const SigDBTableHeader_t*>(pBlob);
+
+	const uint32_t* const pStringOffsets = reinterpret_cast<const uint32_t*>(
+		pBlob + sizeof(SigDBTableHeader_t) + pTable->m_nEntryCount * sizeof(SigDBEntry_t));
+	const uint8_t* const pEntryKinds = reinterpret_cast<const uint8_t*>(pStringOffsets + pTable->m_nEntryCount);
+	const char* const pStringPool = reinterpret_cast<const char*>(pEntryKinds + pTable->m_nEntryCount);
+
+	m_StalePatterns.reserve(pTable->m_nEntryCount);
+
+	for (uint32_t i = 0; i < pTable->m_nEntryCount; i++)
+	{
+		// Other entries can't be resolved by scanning the game executable.
+		if (pEntryKinds[i] != SIGDB_ENTRY_GAME_PATTERN)
+			continue;
+
+		const uint32_t nOffset = pStringOffsets[i];
+
+		if (nOffset >= pTable->m_nStringPoolSize)
+			continue;
+
+		const size_t nMaxLen = pTable->m_nStringPoolSize - nOffset;
+		const size_t nLen = strnlen(pStringPool + nOffset, nMaxLen);
+
+		if (nLen && nLen < nMaxLen)
+			m_StalePatterns.emplace_back(pStringPool + nOffset, nLen);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: loads the cache table from the disk
 // Output : true on success, false otherwise
 //-----------------------------------------------------------------------------
 bool CSigCache::ReadCache(const char* szCacheFile)
@@ -92,6 +260,174 @@ bool CSigCache::ReadCache(const char* szCacheFile)
 		return false;
 	}
 
+	size_t nFileSize;
+	if (!MapCache(szCacheFile, nFileSize))
+	{
+		return false;
+	}
+
+	const SigDBHeader_t* const pHeader = reinterpret_cast<const SigDBHeader_t*>(m_pMappedView);
+
+	if (pHeader->m_nMagic != SIGDB_MAGIC)
+	{
+		UnmapCache();
+		return false;
+	}
+
+	if (pHeader->m_nMajorVersion == SIGDB_LEGACY_MAJOR_VERSION)
+	{
+		UnmapCache();
+
+		// Serve the entries from memory if they are still valid, the
+		// cache will be written in the current format afterwards. The
+		// legacy format doesn't store which module or lookup an entry
+		// belongs to, so outdated entries can't be batch resolved.
+		std::unordered_map<string, uint64_t> legacyEntries;
+		uint16_t nMinorVersion;
+
+		if (!ReadLegacyCache(szCacheFile, legacyEntries, nMinorVersion))
+		{
+			return false;
+		}
+
+		if (nMinorVersion == SIGDB_MINOR_VERSION)
+		{
+			ConvertLegacyEntries(legacyEntries, m_NewEntries);
+		}
+
+		return false;
+	}
+
+	if (pHeader->m_nMajorVersion != SIGDB_MAJOR_VERSION)
+	{
+		UnmapCache();
+		return false;
+	}
+
+	// The table is stored uncompressed, so both sizes must match.
+	const uint64_t nBlobSize = pHeader->m_nBlobSizeDisk;
+
+	if (pHeader->m_nBlobSizeMem != nBlobSize ||
+		nBlobSize < sizeof(SigDBTableHeader_t) ||
+		nBlobSize > nFileSize - SIGDB_BLOB_OFFSET)
+	{
+		UnmapCache();
+		return false;
+	}
+
+	const uint8_t* const pBlob = m_pMappedView + SIGDB_BLOB_OFFSET;
+
+	if (SigCache_ChecksumBlob(pBlob, nBlobSize) != pHeader->m_nBlobChecksum)
+	{
+		UnmapCache();
+		return false;
+	}
+
+	const SigDBTableHeader_t* const pTable = reinterpret_cast<const SigDBTableHeader_t*>(pBlob);
+
+	const uint64_t nTableSize = sizeof(SigDBTableHeader_t) +
+		uint64_t(pTable->m_nEntryCount) * (sizeof(SigDBEntry_t) + sizeof(uint32_t) + sizeof(uint8_t)) +
+		pTable->m_nStringPoolSize;
+
+	if (nTableSize != nBlobSize)
+	{
+		UnmapCache();
+		return false;
+	}
+
+	// An outdated minor version means a different SDK build generated the
+	// cache, the offsets can't be trusted but most patterns are still used,
+	// so these are kept to be resolved in a single batch before the
+	// individual lookups run.
+	if (pHeader->m_nMinorVersion != SIGDB_MINOR_VERSION)
+	{
+		HarvestPatterns(pBlob, nBlobSize);
+		UnmapCache();
+
+		return false;
+	}
+
+	m_pEntries = reinterpret_cast<const SigDBEntry_t*>(pBlob + sizeof(SigDBTableHeader_t));
+	m_nEntryCount = pTable->m_nEntryCount;
+
+	m_bInitialized = true;
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: writes the cache table to the disk
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CSigCache::WriteCache(const char* szCacheFile) const
+{
+	if (m_bDisabled || m_bInitialized)
+	{
+		// Only write when we don't have anything valid on the disk.
+		return false;
+	}
+
+	return WriteTable(szCacheFile, m_NewEntries, SIGDB_MINOR_VERSION);
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: converts a cache file of the legacy format to the current format
+// Input  : *szLegacyFile - 
+//          *szCacheFile  - 
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CSigCache::ConvertLegacyCache(const char* szLegacyFile, const char* szCacheFile)
+{
+	std::unordered_map<string, uint64_t> legacyEntries;
+	uint16_t nMinorVersion;
+
+	if (!ReadLegacyCache(szLegacyFile, legacyEntries, nMinorVersion))
+	{
+		Error(eDLL_T::COMMON, NO_ERROR, "%s - Unable to read legacy cache '%s'\n",
+			__FUNCTION__, szLegacyFile);
+		return false;
+	}
+
+	std::unordered_map<string, SigCacheEntry_t> entries;
+	ConvertLegacyEntries(legacyEntries, entries);
+
+	// Keep the minor version of the source file, as the RVA's are only valid
+	// for the SDK build that generated it.
+	if (!WriteTable(szCacheFile, entries, nMinorVersion))
+	{
+		return false;
+	}
+
+	Msg(eDLL_T::COMMON, "Converted '%zu' signatures from '%s' to '%s'\n",
+		legacyEntries.size(), szLegacyFile, szCacheFile);
+
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: converts legacy entries, these are never batch resolved as the
+//          legacy format doesn't store which module or lookup they belong to
+// Input  : &legacyEntries - 
+//          &entries       - 
+//-----------------------------------------------------------------------------
+void CSigCache::ConvertLegacyEntries(const std::unordered_map<string, uint64_t>& legacyEntries,
+	std::unordered_map<string, SigCacheEntry_t>& entries)
+{
+	entries.reserve(legacyEntries.size());
+
+	for (const auto& it : legacyEntries)
+		entries[it.first] = { it.second, SIGDB_ENTRY_OTHER };
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: loads a compressed protobuf cache map from the disk
+// Input  : *szCacheFile   - 
+//          &entries       - 
+//          &nMinorVersion - 
+// Output : true on success, false otherwise
+//-----------------------------------------------------------------------------
+bool CSigCache::ReadLegacyCache(const char* szCacheFile,
+	std::unordered_map<string, uint64_t>& entries, uint16_t& nMinorVersion)
+{
 	CIOStream reader;
 	if (!reader.Open(szCacheFile, CIOStream::READ | CIOStream::BINARY))
 	{
@@ -111,21 +447,21 @@ bool CSigCache::ReadCache(const char* szCacheFile)
 	}
 
 	header.m_nMajorVersion = reader.Read<uint16_t>();
-	if (header.m_nMajorVersion != SIGDB_MAJOR_VERSION)
+	if (header.m_nMajorVersion != SIGDB_LEGACY_MAJOR_VERSION)
 	{
 		return false;
 	}
 
 	header.m_nMinorVersion = reader.Read<uint16_t>();
-	if (header.m_nMinorVersion != SIGDB_MINOR_VERSION)
-	{
-		return false;
-	}
-
 	header.m_nBlobSizeMem = reader.Read<uint64_t>();
 	header.m_nBlobSizeDisk = reader.Read<uint64_t>();
 	header.m_nBlobChecksum = reader.Read<uint32_t>();
 
+	if (header.m_nBlobSizeDisk > uint64_t(reader.GetSize()) - sizeof(SigDBHeader_t))
+	{
+		return false;
+	}
+
 	std::unique_ptr<uint8_t[]> pSrcBuf(new uint8_t[header.m_nBlobSizeDisk]);
 	std::unique_ptr<uint8_t[]> pDstBuf(new uint8_t[header.m_nBlobSizeMem]);
 
@@ -143,30 +479,112 @@ bool CSigCache::ReadCache(const char* szCacheFile)
 		return false;
 	}
 
+	SigMap_Pb legacyCache;
+
 #pragma warning(push)           // Disabled type conversion warning, as it is possible
 #pragma warning(disable : 4244) // for Protobuf to migrate this code to feature size_t.
-	if (!m_Cache.ParseFromArray(pDstBuf.get(), header.m_nBlobSizeMem))
+	if (!legacyCache.ParseFromArray(pDstBuf.get(), header.m_nBlobSizeMem))
 #pragma warning(pop)
 	{
 		return false;
 	}
 
-	m_bInitialized = true;
+	entries.reserve(legacyCache.smap().size());
+
+	for (const auto& it : legacyCache.smap())
+		entries.emplace(it.first, it.second);
+
+	nMinorVersion = header.m_nMinorVersion;
 	return true;
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: writes the cache map to the disk
+// Purpose: writes the entries as a sorted table to the disk
+// Input  : *szCacheFile  - 
+//          &entries      - 
+//          nMinorVersion - 
 // Output : true on success, false otherwise
 //-----------------------------------------------------------------------------
-bool CSigCache::WriteCache(const char* szCacheFile) const
+bool CSigCache::WriteTable(const char* szCacheFile,
+	const std::unordered_map<string, SigCacheEntry_t>& entries, const uint16_t nMinorVersion)
 {
-	if (m_bDisabled || m_bInitialized)
+	struct TableEntry_s
 	{
-		// Only write when we don't have anything valid on the disk.
+		SigDBEntry_t entry;
+		SigDBEntryKind_e kind;
+		const string* pattern;
+	};
+
+	vector<TableEntry_s> tableEntries;
+	tableEntries.reserve(entries.size());
+
+	for (const auto& it : entries)
+		tableEntries.push_back({ { SigCache_HashPattern(it.first.c_str()), it.second.m_nRVA }, it.second.m_nKind, &it.first });
+
+	std::sort(tableEntries.begin(), tableEntries.end(),
+		[](const TableEntry_s& a, const TableEntry_s& b) { return a.entry.m_nHash < b.entry.m_nHash; });
+
+	// Patterns sharing a hash can't be told apart at runtime,
+	// drop these so they will always be scanned for instead.
+	vector<TableEntry_s> uniqueEntries;
+	uniqueEntries.reserve(tableEntries.size());
+
+	for (size_t i = 0; i < tableEntries.size(); i++)
+	{
+		const uint64_t nHash = tableEntries[i].entry.m_nHash;
+
+		if ((i > 0 && tableEntries[i - 1].entry.m_nHash == nHash) ||
+			(i + 1 < tableEntries.size() && tableEntries[i + 1].entry.m_nHash == nHash))
+		{
+			Warning(eDLL_T::COMMON, "%s - Dropping '%s' due to a hash collision\n",
+				__FUNCTION__, tableEntries[i].pattern->c_str());
+			continue;
+		}
+
+		uniqueEntries.push_back(tableEntries[i]);
+	}
+
+	uint64_t nStringPoolSize = 0;
+
+	for (const TableEntry_s& tableEntry : uniqueEntries)
+		nStringPoolSize += tableEntry.pattern->size() + 1;
+
+	if (nStringPoolSize > UINT32_MAX)
+	{
+		Error(eDLL_T::COMMON, NO_ERROR, "%s - String pool too large ('%llu' bytes)\n",
+			__FUNCTION__, nStringPoolSize);
 		return false;
 	}
 
+	const uint32_t nEntryCount = uint32_t(uniqueEntries.size());
+	const size_t nBlobSize = sizeof(SigDBTableHeader_t) +
+		nEntryCount * (sizeof(SigDBEntry_t) + sizeof(uint32_t) + sizeof(uint8_t)) + size_t(nStringPoolSize);
+
+	std::unique_ptr<uint8_t[]> pBlob(new uint8_t[nBlobSize]);
+
+	SigDBTableHeader_t* const pTable = reinterpret_cast<SigDBTableHeader_t*>(pBlob.get());
+	pTable->m_nEntryCount = nEntryCount;
+	pTable->m_nStringPoolSize = uint32_t(nStringPoolSize);
+
+	SigDBEntry_t* const pEntries = reinterpret_cast<SigDBEntry_t*>(pBlob.get() + sizeof(SigDBTableHeader_t));
+	uint32_t* const pStringOffsets = reinterpret_cast<uint32_t*>(pEntries + nEntryCount);
+	uint8_t* const pEntryKinds = reinterpret_cast<uint8_t*>(pStringOffsets + nEntryCount);
+	char* const pStringPool = reinterpret_cast<char*>(pEntryKinds + nEntryCount);
+
+	uint32_t nStringOffset = 0;
+
+	for (uint32_t i = 0; i < nEntryCount; i++)
+	{
+		const string& svPattern = *uniqueEntries[i].pattern;
+
+		pEntries[i] = uniqueEntries[i].entry;
+		pStringOffsets[i] = nStringOffset;
+		pEntryKinds[i] = uniqueEntries[i].kind;
+
+		memcpy(pStringPool + nStringOffset, svPattern.c_str(), svPattern.size() + 1);
+		nStringOffset += uint32_t(svPattern.size() + 1);
+	}
+
 	CIOStream writer;
 	if (!writer.Open(szCacheFile, CIOStream::WRITE | CIOStream::BINARY))
 	{
@@ -178,30 +596,22 @@ bool CSigCache::WriteCache(const char* szCacheFile) const
 	SigDBHeader_t header;
 	header.m_nMagic = SIGDB_MAGIC;
 	header.m_nMajorVersion = SIGDB_MAJOR_VERSION;
-	header.m_nMinorVersion = SIGDB_MINOR_VERSION;
+	header.m_nMinorVersion = nMinorVersion;
+	header.m_nBlobSizeMem = nBlobSize;
+	header.m_nBlobSizeDisk = nBlobSize;
+	header.m_nBlobChecksum = SigCache_ChecksumBlob(pBlob.get(), nBlobSize);
 
-	const string svBuffer = m_Cache.SerializeAsString();
-	std::unique_ptr<uint8_t[]> pBuffer(new uint8_t[svBuffer.size()]);
-
-	header.m_nBlobSizeMem = svBuffer.size();
-	uint64_t nCompSize = svBuffer.size();
-
-	if (!CompressBlob(svBuffer.size(), nCompSize, header.m_nBlobChecksum, 
-		reinterpret_cast<const uint8_t*>(svBuffer.data()), pBuffer.get()))
-	{
-		return false;
-	}
-
-	header.m_nBlobSizeDisk = nCompSize;
+	const uint8_t padding[SIGDB_BLOB_OFFSET - sizeof(SigDBHeader_t)] = {};
 
 	writer.Write(header);
-	writer.Write(pBuffer.get(), nCompSize);
+	writer.Write(padding, sizeof(padding));
+	writer.Write(pBlob.get(), nBlobSize);
 
 	return true;
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: decompresses the blob containing the signature map
+// Purpose: decompresses the blob containing the legacy signature map
 // Input  : nSrcLen - 
 //			&nDstLen - 
 //			&nAdler - 
@@ -210,7 +620,7 @@ bool CSigCache::WriteCache(const char* szCacheFile) const
 // Output : true on success, false otherwise
 //-----------------------------------------------------------------------------
 bool CSigCache::DecompressBlob(const size_t nSrcLen, size_t& nDstLen, 
-	uint32_t& nAdler, const uint8_t* pSrcBuf, uint8_t* pDstBuf) const
+	uint32_t& nAdler, const uint8_t* pSrcBuf, uint8_t* pDstBuf)
 {
 	lzham_decompress_params lzDecompParams{};
 	lzDecompParams.m_dict_size_log2 = SIGDB_DICT_SIZE;
@@ -228,34 +638,6 @@ bool CSigCache::DecompressBlob(const size_t nSrcLen, size_t& nDstLen,
 	return true;
 }
 
-//-----------------------------------------------------------------------------
-// Purpose: compresses the blob containing the signature map
-// Input  : nSrcLen - 
-//			&nDstLen - 
-//			&nAdler - 
-//			*pSrcBuf - 
-//			*pDstBuf - 
-// Output : true on success, false otherwise
-//-----------------------------------------------------------------------------
-bool CSigCache::CompressBlob(const size_t nSrcLen, size_t& nDstLen, 
-	uint32_t& nAdler, const uint8_t* pSrcBuf, uint8_t* pDstBuf) const
-{
-	lzham_compress_params lzCompParams{};
-	lzCompParams.m_dict_size_log2 = SIGDB_DICT_SIZE;
-	lzCompParams.m_level = lzham_compress_level::LZHAM_COMP_LEVEL_FASTEST;
-	lzCompParams.m_compress_flags = lzham_compress_flags::LZHAM_COMP_FLAG_DETERMINISTIC_PARSING;
-
-	lzham_compress_status_t lzCompStatus = lzham_compress_memory(&lzCompParams, pDstBuf, &nDstLen, pSrcBuf, nSrcLen, &nAdler);
-
-	if (lzCompStatus != lzham_compress_status_t::LZHAM_COMP_STATUS_SUCCESS)
-	{
-		Error(eDLL_T::COMMON, NO_ERROR, "Failed to compress blob: status = %08x\n", lzCompStatus);
-		return false;
-	}
-
-	return true;
-}
-
 //-----------------------------------------------------------------------------
 // Singleton signature cache
 //-----------------------------------------------------------------------------
@@ -0,0 +1,123 @@
+//===========================================================================//
+//
+// Purpose: Read-only memory mapped file views
+//
+//===========================================================================//
+#include "tier1/mappedfile.h"
+
+//-----------------------------------------------------------------------------
+// Purpose: hints the kernel to read the range in ahead of access, the
+//          equivalent of madvise(MADV_WILLNEED); resolved at runtime as the
+//          function doesn't exist prior to Windows 8
+// Input  : *pAddress - 
+//          nSize     - 
+//-----------------------------------------------------------------------------
+static void MappedFile_PrefetchRange(const void* pAddress, const size_t nSize)
+{
+	typedef BOOL(WINAPI* PrefetchVirtualMemoryFn)(HANDLE, ULONG_PTR, PWIN32_MEMORY_RANGE_ENTRY, ULONG);
+	static const PrefetchVirtualMemoryFn s_pfnPrefetchVirtualMemory = reinterpret_cast<PrefetchVirtualMemoryFn>(
+		GetProcAddress(GetModuleHandleA("kernel32.dll"), "PrefetchVirtualMemory"));
+
+	if (!s_pfnPrefetchVirtualMemory)
+		return;
+
+	WIN32_MEMORY_RANGE_ENTRY range;
+	range.VirtualAddress = const_cast<void*>(pAddress);
+	range.NumberOfBytes = nSize;
+
+	s_pfnPrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+}
+
+CMappedFileView::CMappedFileView()
+	: m_hFile(INVALID_HANDLE_VALUE)
+	, m_hMapping(NULL)
+	, m_pData(nullptr)
+	, m_nSize(0)
+{
+}
+
+CMappedFileView::~CMappedFileView()
+{
+	Unmap();
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: maps the whole file into memory for read, replacing any previous
+//          mapping held by this view
+// Input  : *pFullPath - 
+//          access     - expected access pattern
+// Output : true on success, false otherwise (empty files can't be mapped)
+//-----------------------------------------------------------------------------
+bool CMappedFileView::Map(const char* pFullPath, const FileMapAccess_t access)
+{
+	Unmap();
+
+	const DWORD nAccessFlags = (access == FileMapAccess_t::FILEMAP_ACCESS_RANDOM)
+		? FILE_FLAG_RANDOM_ACCESS
+		: FILE_FLAG_SEQUENTIAL_SCAN;
+
+	m_hFile = CreateFileA(pFullPath, GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | nAccessFlags, NULL);
+
+	if (m_hFile == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+
+	if (!GetFileSizeEx(m_hFile, &fileSize) || !fileSize.QuadPart)
+	{
+		Unmap();
+		return false;
+	}
+
+	m_hMapping = CreateFileMappingA(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+
+	if (!m_hMapping)
+	{
+		Unmap();
+		return false;
+	}
+
+	m_pData = reinterpret_cast<const uint8_t*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+
+	if (!m_pData)
+	{
+		Unmap();
+		return false;
+	}
+
+	m_nSize = ssize_t(fileSize.QuadPart);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: prefetches the part of the view the caller is about to read,
+//          clamped to the bounds of the view
+// Input  : nOffset - 
+//          nSize   - 
+//-----------------------------------------------------------------------------
+void CMappedFileView::PrefetchRange(const ptrdiff_t nOffset, const ssize_t nSize) const
+{
+	if (!m_pData || nOffset < 0 || nOffset >= m_nSize || nSize <= 0)
+		return;
+
+	MappedFile_PrefetchRange(m_pData + nOffset, size_t(MIN(nSize, m_nSize - nOffset)));
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: releases the mapping, pointers into the view become invalid
+//-----------------------------------------------------------------------------
+void CMappedFileView::Unmap()
+{
+	if (m_pData)
+		UnmapViewOfFile(m_pData);
+	if (m_hMapping)
+		CloseHandle(m_hMapping);
+	if (m_hFile != INVALID_HANDLE_VALUE)
+		CloseHandle(m_hFile);
+
+	m_hFile = INVALID_HANDLE_VALUE;
+	m_hMapping = NULL;
+	m_pData = nullptr;
+	m_nSize = 0;
+}
@@ -223,18 +223,32 @@ bool CURLDownloadFile(const char* remote, const char* savePath, const char* file
 CURL* CURLInitRequest(const char* remote, const char* request,
     string& outResponse, curl_slist*& slist, const CURLParams& params)
 {
-    slist = CURLSlistAppend(slist, "Content-Type: application/json");
-    if (!slist)
+    CURL* curl = EasyInit();
+    if (!curl)
     {
         return nullptr;
     }
 
-    CURL* curl = EasyInit();
-    if (!curl)
+    if (!CURLSetupRequest(curl, remote, request, outResponse, slist, params))
     {
+        curl_easy_cleanup(curl);
         return nullptr;
     }
 
+    return curl;
+}
+
+// Sets up a request on an existing handle, handles which are reused after a
+// 'curl_easy_reset' keep their connections alive between requests.
+bool CURLSetupRequest(CURL* curl, const char* remote, const char* request,
+    string& outResponse, curl_slist*& slist, const CURLParams& params)
+{
+    slist = CURLSlistAppend(slist, "Content-Type: application/json");
+    if (!slist)
+    {
+        return false;
+    }
+
     CURLInitCommonOptions(curl, remote, nullptr, &outResponse, params, nullptr);
 
     curl_easy_setopt(curl, CURLOPT_HTTPHEADER, slist);
@@ -244,7 +258,7 @@ CURL* CURLInitRequest(const char* remote, const char* request,
         curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request);
     }
 
-    return curl;
+    return true;
 }
 
 CURLcode CURLSubmitRequest(CURL* curl, curl_slist*& slist)
@@ -255,16 +269,18 @@ CURLcode CURLSubmitRequest(CURL* curl, curl_slist*& slist)
     return res;
 }
 
-CURLINFO CURLRetrieveInfo(CURL* curl)
+CURLINFO CURLRetrieveInfo(CURL* curl, const bool cleanup)
 {
     CURLINFO status;
     curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
-    curl_easy_cleanup(curl);
+
+    if (cleanup)
+        curl_easy_cleanup(curl);
 
     return status;
 }
 
-bool CURLHandleError(CURL* curl, const CURLcode res, string& outMessage, const bool logError)
+bool CURLHandleError(CURL* curl, const CURLcode res, string& outMessage, const bool logError, const bool cleanup)
 {
     if (res == CURLE_OK)
         return true;
@@ -275,12 +291,19 @@ bool CURLHandleError(CURL* curl, const CURLcode res, string& outMessage, const b
         Error(eDLL_T::COMMON, NO_ERROR, "CURL: %s\n", curlError);
 
     outMessage = curlError;
-    curl_easy_cleanup(curl);
+
+    if (cleanup)
+        curl_easy_cleanup(curl);
 
     return false;
 }
 
 void CURLFormatUrl(string& outUrl, const char* host, const char* api)
 {
-    outUrl = Format("%s%s%s", "https://", host, api);
+    // Hosts with an explicit scheme are used as is, this allows
+    // pointing the client to a local plain http stand-in server.
+    if (strstr(host, "://"))
+        outUrl = Format("%s%s", host, api);
+    else
+        outUrl = Format("%s%s%s", "https://", host, api);
 }
@@ -25,16 +25,31 @@
 // 
 /////////////////////////////////////////////////////////////////////////////////
 
+#include "tier0/cpu.h"
 #include "tier1/keyvalues.h"
+#include "tier1/generichash.h"
+#include "tier1/mappedfile.h"
 #include "tier2/fileutils.h"
 #include "mathlib/adler32.h"
 #include "mathlib/crc32.h"
-#include "mathlib/sha1.h"
 #include "localize/ilocalize.h"
 #include "vpklib/packedstore.h"
+#include <condition_variable>
+#include <atomic>
 
 extern CFileSystem_Stdio* FileSystem();
 
+//-----------------------------------------------------------------------------
+// Purpose: constructor
+//-----------------------------------------------------------------------------
+CPackedStoreBuilder::CPackedStoreBuilder()
+	: m_nWorkerThreads(1)
+	, m_bContentDefinedChunking(false)
+{
+	memset(&m_Encoder, NULL, sizeof(m_Encoder));
+	memset(&m_Decoder, NULL, sizeof(m_Decoder));
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: gets the LZHAM compression level
 // output : lzham_compress_level
@@ -85,6 +100,31 @@ void CPackedStoreBuilder::InitLzDecoder(void)
 	m_Decoder.m_pSeed_bytes      = NULL;
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: sets the number of threads used to read and compress entries
+// Input  : numThreads - (-1 = use all logical processors)
+//-----------------------------------------------------------------------------
+void CPackedStoreBuilder::InitWorkerThreads(const int numThreads)
+{
+	const int logicalProcessors = int(GetCPUInformation().m_nLogicalProcessors);
+	m_nWorkerThreads = (numThreads < 0) ? logicalProcessors : numThreads;
+
+	if (m_nWorkerThreads < 1)
+		m_nWorkerThreads = 1;
+}
+
+//-----------------------------------------------------------------------------
+// Purpose: sets how entries that are deduplicated are carved into chunks
+// Input  : contentDefined - if true, chunk boundaries are determined by the
+//          data, so an asset that only differs slightly from another asset
+//          still shares most of its chunks with it; if false, entries are
+//          carved into fixed 'VPK_ENTRY_MAX_LEN' chunks
+//-----------------------------------------------------------------------------
+void CPackedStoreBuilder::InitChunking(const bool contentDefined)
+{
+	m_bContentDefinedChunking = contentDefined;
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: gets the level name from the directory file name
 // Input  : &dirFileName - 
@@ -383,57 +423,246 @@ static void BuildManifest(const CUtlVector<VPKEntryBlock_t>& entryBlocks, const
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: validates extraction result with precomputed CRC32 hash
-// Input  : &assetPath - 
-//        : nFileCRC   - 
+// Purpose: attempts to deduplicate a chunk of data by comparing it to existing chunks
+// Input  : &chunkHash  - hash of the uncompressed chunk
+//          &descriptor - 
+//          chunkIndex  - 
+// Output : true if the chunk was deduplicated, false otherwise
+// NOTE   : the descriptor of a newly seen chunk must be finalized (offset and
+//          compressed size) before calling this, as it gets copied into the map
 //-----------------------------------------------------------------------------
-static void ValidateCRC32PostDecomp(const CUtlString& assetPath, const uint32_t nFileCRC)
+bool CPackedStoreBuilder::Deduplicate(const VPKChunkHash_t& chunkHash, VPKChunkDescriptor_t& descriptor, const size_t chunkIndex)
 {
-	const char* pAssetPath = assetPath.Get();
+	auto p = m_ChunkHashMap.insert({ chunkHash, descriptor });
+	if (!p.second) // Map to existing chunk to avoid having copies of the same data.
+	{
+		Msg(eDLL_T::FS, "Mapping chunk '%zu' ('%016llx%016llx') to existing chunk at '0x%llx'\n",
+			chunkIndex, chunkHash.m_nHigh, chunkHash.m_nLow, p.first->second.m_nPackFileOffset);
+		descriptor = p.first->second;
 
-	FileHandle_t hAsset = FileSystem()->Open(pAssetPath, "rb", "PLATFORM");
-	if (!hAsset)
+		return true;
+	}
+
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// A chunk read and (optionally) compressed by a pack worker, the data is held
+// until the writer has committed all entries preceding the owning entry.
+//-----------------------------------------------------------------------------
+struct PackedStoreChunk_s
+{
+	std::unique_ptr<uint8_t[]> compressedData; // Null if stored uncompressed.
+	size_t dataOffset; // Offset of the chunk within the entry.
+	VPKChunkHash_t hash; // Only computed if the entry is deduplicated.
+};
+
+struct PackedStoreJob_s
+{
+	PackedStoreJob_s()
+		: isReady(false)
+	{}
+
+	std::unique_ptr<VPKEntryBlock_t> entryBlock; // Null if the asset couldn't be read.
+	std::unique_ptr<uint8_t[]> entryData;
+	std::vector<PackedStoreChunk_s> chunks;
+	const char* destPath;
+	bool isReady;
+};
+
+//-----------------------------------------------------------------------------
+// Gear table for the rolling hash used by content-defined chunking, this must
+// never change as it determines where chunk boundaries are placed.
+//-----------------------------------------------------------------------------
+struct PackedStoreGearTable_s
+{
+	PackedStoreGearTable_s()
 	{
-		Error(eDLL_T::FS, NO_ERROR, "%s - Unable to open '%s' (insufficient rights?)\n", __FUNCTION__, pAssetPath);
-		return;
+		uint64_t state = 0x9E3779B97F4A7C15ULL;
+
+		for (uint64_t& value : values) // SplitMix64.
+		{
+			uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+			value = z ^ (z >> 31);
+		}
 	}
 
-	const ssize_t nLen = FileSystem()->Size(hAsset);
-	std::unique_ptr<uint8_t[]> pBuf(new uint8_t[nLen]);
+	uint64_t values[256];
+};
 
-	FileSystem()->Read(pBuf.get(), nLen, hAsset);
-	FileSystem()->Close(hAsset);
+static const PackedStoreGearTable_s s_ChunkGearTable;
+
+//-----------------------------------------------------------------------------
+// Purpose: finds the end of the next content-defined chunk; the boundary is
+//          placed where the rolling hash of the last 64 bytes matches a mask,
+//          using a stricter mask before the average chunk size and a looser
+//          one after it to keep chunk sizes close to the average
+// Input  : *pData - 
+//          nLen   - 
+// Output : size of the chunk
+//-----------------------------------------------------------------------------
+static size_t PackedStore_FindChunkBoundary(const uint8_t* pData, const size_t nLen)
+{
+	const uint64_t strictMask = 0xFFFFF00000000000ULL; // 20 bits.
+	const uint64_t looseMask  = 0xFFFF000000000000ULL; // 16 bits.
+
+	if (nLen <= VPK_CDC_MIN_LEN)
+		return nLen;
+
+	const size_t maxLen = Min(nLen, size_t(VPK_ENTRY_MAX_LEN));
+	const size_t avgLen = Min(maxLen, size_t(VPK_CDC_AVG_LEN));
 
-	uint32_t nCrc32 = crc32::update(NULL, pBuf.get(), nLen);
-	if (nCrc32 != nFileCRC)
+	uint64_t fingerprint = 0;
+	size_t i = VPK_CDC_MIN_LEN;
+
+	for (; i < avgLen; i++)
 	{
-		Warning(eDLL_T::FS, "Computed checksum '0x%lX' doesn't match expected checksum '0x%lX'. File may be corrupt!\n", nCrc32, nFileCRC);
+		fingerprint = (fingerprint << 1) + s_ChunkGearTable.values[pData[i]];
+
+		if (!(fingerprint & strictMask))
+			return i + 1;
 	}
+
+	for (; i < maxLen; i++)
+	{
+		fingerprint = (fingerprint << 1) + s_ChunkGearTable.values[pData[i]];
+
+		if (!(fingerprint & looseMask))
+			return i + 1;
+	}
+
+	return maxLen;
 }
 
 //-----------------------------------------------------------------------------
-// Purpose: attempts to deduplicate a chunk of data by comparing it to existing chunks
-// Input  : *pEntryBuffer - 
-//          &descriptor   - 
-//          chunkIndex    - 
-// Output : true if the chunk was deduplicated, false otherwise
+// Purpose: carves the entry into content-defined chunks
+// Input  : &entryBlock   - 
+//          *pData        - 
+//          nLen          - 
+//          nLoadFlags    - 
+//          nTextureFlags - 
 //-----------------------------------------------------------------------------
-bool CPackedStoreBuilder::Deduplicate(const uint8_t* pEntryBuffer, VPKChunkDescriptor_t& descriptor, const size_t chunkIndex)
+static void PackedStore_CarveContentDefined(VPKEntryBlock_t& entryBlock, const uint8_t* pData, const size_t nLen,
+	const uint32_t nLoadFlags, const uint16_t nTextureFlags)
 {
-	string entryHash(reinterpret_cast<const char*>(pEntryBuffer), descriptor.m_nUncompressedSize);
-	entryHash = sha1(entryHash);
+	entryBlock.m_Fragments.RemoveAll();
+	size_t nOffset = 0;
 
-	auto p = m_ChunkHashMap.insert({ entryHash.c_str(), descriptor });
-	if (!p.second) // Map to existing chunk to avoid having copies of the same data.
+	while (nOffset < nLen)
 	{
-		Msg(eDLL_T::FS, "Mapping chunk '%zu' ('%s') to existing chunk at '0x%llx'\n",
-			chunkIndex, entryHash.c_str(), p.first->second.m_nPackFileOffset);
-		descriptor = p.first->second;
+		const size_t nSize = PackedStore_FindChunkBoundary(pData + nOffset, nLen - nOffset);
+		entryBlock.m_Fragments.AddToTail(VPKChunkDescriptor_t(nLoadFlags, nTextureFlags, 0, nSize, nSize));
 
-		return true;
+		nOffset += nSize;
 	}
+}
 
-	return false;
+//-----------------------------------------------------------------------------
+// Purpose: reads an asset from the workspace, and hashes and compresses all
+//          of its chunks; this runs on the pack workers and doesn't touch
+//          the pack file, so it can run on any number of entries at once
+// Input  : &job           - 
+//          &entryValue    - 
+//          *pEncoder      - 
+//          workspaceLen   - 
+//          entryIndex     - 
+//          contentDefined - 
+//-----------------------------------------------------------------------------
+static void PackedStore_ProcessEntry(PackedStoreJob_s& job, const VPKKeyValues_t& entryValue,
+	const lzham_compress_params* pEncoder, const int workspaceLen, const int entryIndex, const bool contentDefined)
+{
+	const char* pEntryPath = entryValue.m_EntryPath.Get();
+	FileHandle_t hAsset = FileSystem()->Open(pEntryPath, "rb", "PLATFORM");
+
+	if (!hAsset)
+	{
+		Error(eDLL_T::FS, NO_ERROR, "%s - Unable to open '%s' (insufficient rights?)\n", __FUNCTION__, pEntryPath);
+		return;
+	}
+
+	const char* szDestPath = (pEntryPath + workspaceLen);
+	if (PATHSEPARATOR(szDestPath[0]))
+	{
+		szDestPath++;
+	}
+
+	const ssize_t nLen = FileSystem()->Size(hAsset);
+	job.entryData.reset(new uint8_t[nLen]);
+
+	// Read the asset once; chunks are compressed straight from this buffer.
+	FileSystem()->Read(job.entryData.get(), nLen, hAsset);
+	FileSystem()->Close(hAsset);
+
+	job.destPath = szDestPath;
+	job.entryBlock.reset(new VPKEntryBlock_t(
+		job.entryData.get(),
+		nLen,
+		0, // Offsets are assigned by the writer.
+		entryValue.m_iPreloadSize,
+		0,
+		entryValue.m_nLoadFlags,
+		entryValue.m_nTextureFlags,
+		szDestPath));
+
+	VPKEntryBlock_t& entryBlock = *job.entryBlock;
+
+	if (contentDefined && entryValue.m_bDeduplicate)
+	{
+		PackedStore_CarveContentDefined(entryBlock, job.entryData.get(), nLen,
+			entryValue.m_nLoadFlags, entryValue.m_nTextureFlags);
+	}
+
+	job.chunks.resize(entryBlock.m_Fragments.Count());
+	size_t dataOffset = 0;
+
+	FOR_EACH_VEC(entryBlock.m_Fragments, j)
+	{
+		VPKChunkDescriptor_t& descriptor = entryBlock.m_Fragments[j];
+		PackedStoreChunk_s& chunk = job.chunks[j];
+
+		chunk.dataOffset = dataOffset;
+		dataOffset += descriptor.m_nUncompressedSize;
+
+		const uint8_t* pChunkData = job.entryData.get() + chunk.dataOffset;
+
+		if (entryValue.m_bDeduplicate)
+		{
+			uint64_t hash[2];
+			MurmurHash3_128(pChunkData, descriptor.m_nUncompressedSize, 0, hash);
+
+			chunk.hash.m_nLow = hash[0];
+			chunk.hash.m_nHigh = hash[1];
+		}
+
+		if (!entryValue.m_bUseCompression)
+		{
+			// Write data uncompressed.
+			continue;
+		}
+
+		// NOTE: chunks that later turn out to be duplicates are compressed
+		// as well, as we can't know this until all preceding entries have
+		// been committed; the output is discarded by the writer then.
+		chunk.compressedData.reset(new uint8_t[descriptor.m_nUncompressedSize]);
+		size_t compressedSize = descriptor.m_nUncompressedSize;
+
+		lzham_compress_status_t lzCompStatus = lzham_compress_memory(pEncoder, chunk.compressedData.get(), &compressedSize, pChunkData,
+			descriptor.m_nUncompressedSize, nullptr);
+
+		if (lzCompStatus != lzham_compress_status_t::LZHAM_COMP_STATUS_SUCCESS)
+		{
+			Warning(eDLL_T::FS, "Status '%d' for chunk '%i' within entry '%i' in block '%hu' (chunk packed without compression)\n",
+				lzCompStatus, j, entryIndex, entryBlock.m_iPackFileIndex);
+
+			chunk.compressedData.reset();
+			continue;
+		}
+
+		descriptor.m_nCompressedSize = compressedSize;
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -460,14 +689,6 @@ void CPackedStoreBuilder::PackStore(const VPKPair_t& vpkPair, const char* worksp
 		return;
 	}
 
-	std::unique_ptr<uint8_t[]> pEntryBuffer(new uint8_t[VPK_ENTRY_MAX_LEN]);
-
-	if (!pEntryBuffer)
-	{
-		Error(eDLL_T::FS, NO_ERROR, "%s - Unable to allocate chunk buffer!\n", __FUNCTION__);
-		return;
-	}
-
 	CUtlString packFilePath;
 	CUtlString dirFilePath;
 
@@ -484,86 +705,125 @@ void CPackedStoreBuilder::PackStore(const VPKPair_t& vpkPair, const char* worksp
 
 	size_t nSharedTotal = NULL;
 	size_t nSharedCount = NULL;
+	size_t nSharedUncompressed = NULL;
 
-	FOR_EACH_VEC(entryValues, i)
-	{
-		const VPKKeyValues_t& entryValue = entryValues[i];
-		const char* pEntryPath = entryValue.m_EntryPath.Get();
+	const int numEntries = entryValues.Count();
+	const int numWorkers = Min(m_nWorkerThreads, Max(numEntries, 1));
 
-		FileHandle_t hAsset = FileSystem()->Open(pEntryPath, "rb", "PLATFORM");
+	// Entries are read and compressed by the workers in any order, but only
+	// a limited number of entries ahead of the writer to bound memory usage.
+	const int maxInFlight = numWorkers * 2;
 
-		if (!hAsset)
-		{
-			Error(eDLL_T::FS, NO_ERROR, "%s - Unable to open '%s' (insufficient rights?)\n", __FUNCTION__, pEntryPath);
-			continue;
-		}
+	// Each worker compresses its own chunks, don't let LZHAM spawn helper
+	// threads for each of them as well. Deterministic parsing guarantees the
+	// same output regardless of the number of helper threads.
+	lzham_compress_params encoder = m_Encoder;
+	if (numWorkers > 1)
+		encoder.m_max_helper_threads = 0;
 
-		const char* szDestPath = (pEntryPath + workspacePath.Length());
-		if (PATHSEPARATOR(szDestPath[0]))
-		{
-			szDestPath++;
-		}
+	std::vector<PackedStoreJob_s> jobs(numEntries);
 
-		const ssize_t nLen = FileSystem()->Size(hAsset);
-		std::unique_ptr<uint8_t[]> pBuf(new uint8_t[nLen]);
+	std::mutex jobMutex;
+	std::condition_variable workerCond;
+	std::condition_variable writerCond;
 
-		FileSystem()->Read(pBuf.get(), nLen, hAsset);
-		FileSystem()->Seek(hAsset, 0, FileSystemSeek_t::FILESYSTEM_SEEK_HEAD);
+	int nextJob = 0;
+	int writeCursor = 0;
 
-		Msg(eDLL_T::FS, "Packing entry '%i' ('%s')\n", i, szDestPath);
-		int index = entryBlocks.AddToTail(VPKEntryBlock_t(
-			pBuf.get(),
-			nLen,
-			FileSystem()->Tell(hPackFile),
-			entryValue.m_iPreloadSize,
-			0,
-			entryValue.m_nLoadFlags,
-			entryValue.m_nTextureFlags,
-			CUtlString(szDestPath)));
+	auto workerFunc = [&]()
+	{
+		for (;;)
+		{
+			int jobIndex;
+			{
+				std::unique_lock<std::mutex> lock(jobMutex);
+				workerCond.wait(lock, [&] { return nextJob >= numEntries || nextJob < writeCursor + maxInFlight; });
 
-		VPKEntryBlock_t& entryBlock = entryBlocks[index];
+				if (nextJob >= numEntries)
+					break;
 
-		FOR_EACH_VEC(entryBlock.m_Fragments, j)
-		{
-			VPKChunkDescriptor_t& descriptor = entryBlock.m_Fragments[j];
+				jobIndex = nextJob++;
+			}
 
-			FileSystem()->Read(pEntryBuffer.get(), descriptor.m_nCompressedSize, hAsset);
-			descriptor.m_nPackFileOffset = FileSystem()->Tell(hPackFile);
+			PackedStore_ProcessEntry(jobs[jobIndex], entryValues[jobIndex], &encoder, workspacePath.Length(), jobIndex, m_bContentDefinedChunking);
 
-			if (entryValue.m_bDeduplicate && Deduplicate(pEntryBuffer.get(), descriptor, j))
 			{
-				nSharedTotal += descriptor.m_nCompressedSize;
-				nSharedCount++;
-
-				// Data was deduplicated.
-				continue;
+				std::lock_guard<std::mutex> lock(jobMutex);
+				jobs[jobIndex].isReady = true;
 			}
 
-			if (entryValue.m_bUseCompression)
+			writerCond.notify_one();
+		}
+	};
+
+	std::vector<std::thread> workers;
+	workers.reserve(numWorkers);
+
+	for (int i = 0; i < numWorkers; i++)
+		workers.emplace_back(workerFunc);
+
+	// The writer commits entries strictly in manifest order, so the pack file
+	// offsets and deduplication results are identical to a serial build.
+	for (int i = 0; i < numEntries; i++)
+	{
+		PackedStoreJob_s& job = jobs[i];
+		{
+			std::unique_lock<std::mutex> lock(jobMutex);
+			writerCond.wait(lock, [&] { return job.isReady; });
+		}
+
+		if (job.entryBlock)
+		{
+			Msg(eDLL_T::FS, "Packing entry '%i' ('%s')\n", i, job.destPath);
+			int index = entryBlocks.AddToTail(*job.entryBlock);
+
+			VPKEntryBlock_t& entryBlock = entryBlocks[index];
+
+			FOR_EACH_VEC(entryBlock.m_Fragments, j)
 			{
-				lzham_compress_status_t lzCompStatus = lzham_compress_memory(&m_Encoder, pEntryBuffer.get(), &descriptor.m_nCompressedSize, pEntryBuffer.get(),
-					descriptor.m_nUncompressedSize, nullptr);
+				VPKChunkDescriptor_t& descriptor = entryBlock.m_Fragments[j];
+				const PackedStoreChunk_s& chunk = job.chunks[j];
+
+				descriptor.m_nPackFileOffset = FileSystem()->Tell(hPackFile);
 
-				if (lzCompStatus != lzham_compress_status_t::LZHAM_COMP_STATUS_SUCCESS)
+				if (entryValues[i].m_bDeduplicate && Deduplicate(chunk.hash, descriptor, j))
 				{
-					Warning(eDLL_T::FS, "Status '%d' for chunk '%i' within entry '%i' in block '%hu' (chunk packed without compression)\n",
-						lzCompStatus, j, i, entryBlock.m_iPackFileIndex);
+					nSharedTotal += descriptor.m_nCompressedSize;
+					nSharedUncompressed += descriptor.m_nUncompressedSize;
+					nSharedCount++;
 
-					descriptor.m_nCompressedSize = descriptor.m_nUncompressedSize;
+					// Data was deduplicated.
+					continue;
 				}
+
+				const uint8_t* pChunkData = chunk.compressedData
+					? chunk.compressedData.get()
+					: job.entryData.get() + chunk.dataOffset;
+
+				FileSystem()->Write(pChunkData, descriptor.m_nCompressedSize, hPackFile);
 			}
-			else // Write data uncompressed.
-			{
-				descriptor.m_nCompressedSize = descriptor.m_nUncompressedSize;
-			}
+		}
 
-			FileSystem()->Write(pEntryBuffer.get(), descriptor.m_nCompressedSize, hPackFile);
+		// Release the entry's data and allow the workers to move ahead.
+		job.chunks.clear();
+		job.entryData.reset();
+		job.entryBlock.reset();
+		{
+			std::lock_guard<std::mutex> lock(jobMutex);
+			writeCursor = i + 1;
 		}
 
-		FileSystem()->Close(hAsset);
+		workerCond.notify_all();
 	}
 
-	Msg(eDLL_T::FS, "*** Build block totaling '%zd' bytes with '%zu' shared bytes among '%zu' chunks\n", FileSystem()->Tell(hPackFile), nSharedTotal, nSharedCount);
+	for (std::thread& worker : workers)
+		worker.join();
+
+	const ssize_t nPackSize = FileSystem()->Tell(hPackFile);
+
+	Msg(eDLL_T::FS, "*** Build block totaling '%zd' bytes with '%zu' shared bytes among '%zu' chunks\n", nPackSize, nSharedTotal, nSharedCount);
+	Msg(eDLL_T::FS, "*** Deduplication saved '%zu' bytes ('%zu' uncompressed, %.2f%% of block) using '%zu' unique chunks\n",
+		nSharedTotal, nSharedUncompressed, (nPackSize + nSharedTotal) ? (double(nSharedTotal) / double(nPackSize + nSharedTotal)) * 100.0 : 0.0, m_ChunkHashMap.size());
 	FileSystem()->Close(hPackFile);
 
 	m_ChunkHashMap.clear();
@@ -572,6 +832,91 @@ void CPackedStoreBuilder::PackStore(const VPKPair_t& vpkPair, const char* worksp
 	vDirectory.BuildDirectoryFile(dirFilePath, entryBlocks);
 }
 
+//-----------------------------------------------------------------------------
+// Purpose: extracts an entry from a mapped pack file, the CRC32 of the entry is
+//          computed while writing so the output doesn't have to be read back
+// Input  : &entryBlock    - 
+//          &packView      - 
+//          *pDecoder      - 
+//          *pDestBuffer   - 
+//          &workspacePath - 
+//          entryIndex     - 
+//-----------------------------------------------------------------------------
+static void PackedStore_UnpackEntry(const VPKEntryBlock_t& entryBlock, const CMappedFileView& packView,
+	const lzham_decompress_params* pDecoder, uint8_t* pDestBuffer, const CUtlString& workspacePath, const int entryIndex)
+{
+	const char* pEntryPath = entryBlock.m_EntryPath.Get();
+	const uint16_t packFileIndex = entryBlock.m_iPackFileIndex;
+
+	CUtlString filePath;
+	filePath.Format("%s%s", workspacePath.Get(), pEntryPath);
+
+	FileHandle_t hAsset = FileSystem()->Open(filePath.Get(), "wb", "PLATFORM");
+
+	if (!hAsset)
+	{
+		Error(eDLL_T::FS, NO_ERROR, "%s - Unable to write to '%s' (read-only?)\n", __FUNCTION__, filePath.Get());
+		return;
+	}
+
+	Msg(eDLL_T::FS, "Unpacking entry '%i' from block '%hu' ('%s')\n",
+		entryIndex, packFileIndex, pEntryPath);
+
+	uint32_t nCrc32 = NULL;
+
+	FOR_EACH_VEC(entryBlock.m_Fragments, k)
+	{
+		const VPKChunkDescriptor_t& fragment = entryBlock.m_Fragments[k];
+
+		const size_t nPackSize = size_t(packView.Size());
+
+		if (fragment.m_nPackFileOffset > nPackSize ||
+			fragment.m_nCompressedSize > (nPackSize - fragment.m_nPackFileOffset))
+		{
+			Error(eDLL_T::FS, NO_ERROR, "Chunk '%i' within entry '%i' in block '%hu' is out of bounds (chunk not decompressed)\n",
+				k, entryIndex, packFileIndex);
+			break; // Corrupt or invalid chunk descriptor.
+		}
+
+		const uint8_t* pSource = packView.Base() + fragment.m_nPackFileOffset;
+
+		if (fragment.m_nCompressedSize == fragment.m_nUncompressedSize) // Data is not compressed.
+		{
+			FileSystem()->Write(pSource, fragment.m_nUncompressedSize, hAsset);
+			nCrc32 = crc32::update(nCrc32, pSource, fragment.m_nUncompressedSize);
+
+			continue;
+		}
+
+		size_t nDstLen = VPK_ENTRY_MAX_LEN;
+		assert(fragment.m_nCompressedSize <= nDstLen);
+
+		if (fragment.m_nCompressedSize > nDstLen)
+			break; // Corrupt or invalid chunk descriptor.
+
+		lzham_decompress_status_t lzDecompStatus = lzham_decompress_memory(pDecoder, pDestBuffer,
+			&nDstLen, pSource, fragment.m_nCompressedSize, nullptr);
+
+		if (lzDecompStatus != lzham_decompress_status_t::LZHAM_DECOMP_STATUS_SUCCESS)
+		{
+			Error(eDLL_T::FS, NO_ERROR, "Status '%d' for chunk '%i' within entry '%i' in block '%hu' (chunk not decompressed)\n",
+				lzDecompStatus, k, entryIndex, packFileIndex);
+		}
+		else // If successfully decompressed, write to file.
+		{
+			FileSystem()->Write(pDestBuffer, nDstLen, hAsset);
+			nCrc32 = crc32::update(nCrc32, pDestBuffer, nDstLen);
+		}
+	}
+
+	FileSystem()->Close(hAsset);
+
+	if (nCrc32 != entryBlock.m_nFileCRC)
+	{
+		Warning(eDLL_T::FS, "Computed checksum '0x%lX' doesn't match expected checksum '0x%lX'. File may be corrupt!\n", nCrc32, entryBlock.m_nFileCRC);
+	}
+}
+
 //-----------------------------------------------------------------------------
 // Purpose: rebuilds manifest and extracts all files from specified VPK file
 // Input  : &vpkDirectory  - 
@@ -584,95 +929,111 @@ void CPackedStoreBuilder::UnpackStore(const VPKDir_t& vpkDir, const char* worksp
 	workspacePath.AppendSlash();
 	workspacePath.FixSlashes('/');
 
-	std::unique_ptr<uint8_t[]> pDestBuffer(new uint8_t[VPK_ENTRY_MAX_LEN]);
-	std::unique_ptr<uint8_t[]> pSourceBuffer(new uint8_t[VPK_ENTRY_MAX_LEN]);
+	BuildManifest(vpkDir.m_EntryBlocks, workspacePath, PackedStore_GetDirBaseName(vpkDir.m_DirFilePath));
+	const CUtlString basePath = vpkDir.m_DirFilePath.StripFilename(false);
+
+	// Group the entries by pack file, and order them by their offset within
+	// it so the pack file is read front to back rather than at random.
+	std::vector<int> entryOrder;
+	entryOrder.reserve(vpkDir.m_EntryBlocks.Count());
 
-	if (!pDestBuffer || !pSourceBuffer)
+	// Entries without fragments have no data in any pack file, but are
+	// still written out as empty files.
+	const CMappedFileView emptyView;
+
+	FOR_EACH_VEC(vpkDir.m_EntryBlocks, i)
 	{
-		Error(eDLL_T::FS, NO_ERROR, "%s - Unable to allocate chunk buffer!\n", __FUNCTION__);
-		return;
+		const VPKEntryBlock_t& entryBlock = vpkDir.m_EntryBlocks[i];
+
+		if (entryBlock.m_Fragments.Count())
+		{
+			entryOrder.push_back(i);
+			continue;
+		}
+
+		CUtlString filePath;
+		filePath.Format("%s%s", workspacePath.Get(), entryBlock.m_EntryPath.Get());
+
+		FileSystem()->CreateDirHierarchy(filePath.DirName().Get(), "PLATFORM");
+		PackedStore_UnpackEntry(entryBlock, emptyView, &m_Decoder, nullptr, workspacePath, i);
 	}
 
-	BuildManifest(vpkDir.m_EntryBlocks, workspacePath, PackedStore_GetDirBaseName(vpkDir.m_DirFilePath));
-	const CUtlString basePath = vpkDir.m_DirFilePath.StripFilename(false);
+	std::sort(entryOrder.begin(), entryOrder.end(), [&](const int a, const int b)
+		{
+			const VPKEntryBlock_t& blockA = vpkDir.m_EntryBlocks[a];
+			const VPKEntryBlock_t& blockB = vpkDir.m_EntryBlocks[b];
+
+			if (blockA.m_iPackFileIndex != blockB.m_iPackFileIndex)
+				return blockA.m_iPackFileIndex < blockB.m_iPackFileIndex;
 
-	for (uint16_t packFileIndex : vpkDir.m_PakFileIndices)
+			return blockA.m_Fragments[0].m_nPackFileOffset < blockB.m_Fragments[0].m_nPackFileOffset;
+		});
+
+	std::vector<std::thread> workers;
+	size_t packStart = 0;
+
+	while (packStart < entryOrder.size())
 	{
+		const uint16_t packFileIndex = vpkDir.m_EntryBlocks[entryOrder[packStart]].m_iPackFileIndex;
+		size_t packEnd = packStart + 1;
+
+		while (packEnd < entryOrder.size() && vpkDir.m_EntryBlocks[entryOrder[packEnd]].m_iPackFileIndex == packFileIndex)
+			packEnd++;
+
 		const CUtlString packFile = basePath + vpkDir.GetPackFileNameForIndex(packFileIndex);
 		const char* pPackFile = packFile.Get();
 
+		// Resolve the pack file through the search paths, as it is mapped
+		// rather than opened through the filesystem.
+		char fullPackPath[1024];
+		const char* pFullPackPath = FileSystem()->RelativePathToFullPath(pPackFile, "GAME", fullPackPath, sizeof(fullPackPath));
+
+		CMappedFileView packView;
+
 		// Read from each pack file.
-		FileHandle_t hPackFile = FileSystem()->Open(pPackFile, "rb", "GAME");
-		if (!hPackFile)
+		if (!pFullPackPath || !packView.Map(pFullPackPath, FileMapAccess_t::FILEMAP_ACCESS_SEQUENTIAL))
 		{
 			Error(eDLL_T::FS, NO_ERROR, "%s - Unable to open '%s' (insufficient rights?)\n", __FUNCTION__, pPackFile);
+
+			packStart = packEnd;
 			continue;
 		}
 
-		FOR_EACH_VEC(vpkDir.m_EntryBlocks, j)
+		// Create the directory tree up front, as the workers would otherwise
+		// race each other creating the same directories.
+		for (size_t i = packStart; i < packEnd; i++)
 		{
-			const VPKEntryBlock_t& entryBlock = vpkDir.m_EntryBlocks[j];
-
-			if (entryBlock.m_iPackFileIndex != packFileIndex)
-			{
-				// Chunk doesn't belongs to this block.
-				continue;
-			}
-
-			const char* pEntryPath = entryBlock.m_EntryPath.Get();
-
 			CUtlString filePath;
-			filePath.Format("%s%s", workspacePath.Get(), pEntryPath);
+			filePath.Format("%s%s", workspacePath.Get(), vpkDir.m_EntryBlocks[entryOrder[i]].m_EntryPath.Get());
 
 			FileSystem()->CreateDirHierarchy(filePath.DirName().Get(), "PLATFORM");
-			FileHandle_t hAsset = FileSystem()->Open(filePath.Get(), "wb", "PLATFORM");
+		}
 
-			if (!hAsset)
-			{
-				Error(eDLL_T::FS, NO_ERROR, "%s - Unable to write to '%s' (read-only?)\n", __FUNCTION__, filePath.Get());
-				continue;
-			}
+		std::atomic<size_t> nextEntry(packStart);
 
-			Msg(eDLL_T::FS, "Unpacking entry '%i' from block '%hu' ('%s')\n",
-				j, packFileIndex, pEntryPath);
+		auto workerFunc = [&]()
+		{
+			std::unique_ptr<uint8_t[]> pDestBuffer(new uint8_t[VPK_ENTRY_MAX_LEN]);
 
-			FOR_EACH_VEC(entryBlock.m_Fragments, k)
+			for (size_t i = nextEntry++; i < packEnd; i = nextEntry++)
 			{
-				const VPKChunkDescriptor_t& fragment = entryBlock.m_Fragments[k];
-
-				FileSystem()->Seek(hPackFile, fragment.m_nPackFileOffset, FileSystemSeek_t::FILESYSTEM_SEEK_HEAD);
-				FileSystem()->Read(pSourceBuffer.get(), fragment.m_nCompressedSize, hPackFile);
-
-				if (fragment.m_nCompressedSize == fragment.m_nUncompressedSize) // Data is not compressed.
-				{
-					FileSystem()->Write(pSourceBuffer.get(), fragment.m_nUncompressedSize, hAsset);
-					continue;
-				}
+				const int entryIndex = entryOrder[i];
+				PackedStore_UnpackEntry(vpkDir.m_EntryBlocks[entryIndex], packView, &m_Decoder, pDestBuffer.get(), workspacePath, entryIndex);
+			}
+		};
 
-				size_t nDstLen = VPK_ENTRY_MAX_LEN;
-				assert(fragment.m_nCompressedSize <= nDstLen);
+		const int numWorkers = int(Min(size_t(m_nWorkerThreads), packEnd - packStart));
 
-				if (fragment.m_nCompressedSize > nDstLen)
-					break; // Corrupt or invalid chunk descriptor.
+		for (int i = 0; i < numWorkers; i++)
+			workers.emplace_back(workerFunc);
 
-				lzham_decompress_status_t lzDecompStatus = lzham_decompress_memory(&m_Decoder, pDestBuffer.get(),
-					&nDstLen, pSourceBuffer.get(), fragment.m_nCompressedSize, nullptr);
+		for (std::thread& worker : workers)
+			worker.join();
 
-				if (lzDecompStatus != lzham_decompress_status_t::LZHAM_DECOMP_STATUS_SUCCESS)
-				{
-					Error(eDLL_T::FS, NO_ERROR, "Status '%d' for chunk '%i' within entry '%i' in block '%hu' (chunk not decompressed)\n",
-						lzDecompStatus, k, j, packFileIndex);
-				}
-				else // If successfully decompressed, write to file.
-				{
-					FileSystem()->Write(pDestBuffer.get(), nDstLen, hAsset);
-				}
-			}
+		workers.clear();
+		packView.Unmap();
 
-			FileSystem()->Close(hAsset);
-			ValidateCRC32PostDecomp(filePath, entryBlock.m_nFileCRC);
-		}
-		FileSystem()->Close(hPackFile);
+		packStart = packEnd;
 	}
 }
 
@@ -22,6 +22,8 @@ constexpr unsigned int VPK_MAJOR_VERSION = 2;
 constexpr unsigned int VPK_MINOR_VERSION = 3;
 constexpr unsigned int VPK_DICT_SIZE = 20;
 constexpr unsigned int VPK_ENTRY_MAX_LEN = 1024 * 1024;
+constexpr unsigned int VPK_CDC_MIN_LEN = 64 * 1024;  // Min chunk size with content-defined chunking.
+constexpr unsigned int VPK_CDC_AVG_LEN = 256 * 1024; // Avg chunk size with content-defined chunking.
 constexpr int PACKFILEPATCH_MAX = 512;
 constexpr int PACKFILEINDEX_SEP = 0x0;
 constexpr int PACKFILEINDEX_END = 0xffff;
@@ -200,16 +202,43 @@ struct VPKPair_t
 	VPKPair_t(const char* svLocale, const char* svTarget, const char* svLevel, int nPatch);
 };
 
+//-----------------------------------------------------------------------------
+// 128 bit hash of the uncompressed chunk data, used to find duplicate chunks.
+//-----------------------------------------------------------------------------
+struct VPKChunkHash_t
+{
+	uint64_t m_nLow;
+	uint64_t m_nHigh;
+
+	bool operator==(const VPKChunkHash_t& other) const
+	{
+		return m_nLow == other.m_nLow && m_nHigh == other.m_nHigh;
+	}
+};
+
+struct VPKChunkHashTraits_t
+{
+	size_t operator()(const VPKChunkHash_t& hash) const
+	{
+		// The hash is already well distributed.
+		return size_t(hash.m_nLow);
+	}
+};
+
 //-----------------------------------------------------------------------------
 // VPK utility class.
 //-----------------------------------------------------------------------------
 class CPackedStoreBuilder
 {
 public:
+	CPackedStoreBuilder();
+
 	void InitLzEncoder(const lzham_int32 maxHelperThreads = -1, const char* compressionLevel = "default");
 	void InitLzDecoder(void);
+	void InitWorkerThreads(const int numThreads = -1);
+	void InitChunking(const bool contentDefined);
 
-	bool Deduplicate(const uint8_t* pEntryBuffer, VPKChunkDescriptor_t& descriptor, const size_t chunkIndex);
+	bool Deduplicate(const VPKChunkHash_t& chunkHash, VPKChunkDescriptor_t& descriptor, const size_t chunkIndex);
 
 	void PackStore(const VPKPair_t& vpkPair, const char* workspaceName, const char* buildPath);
 	void UnpackStore(const VPKDir_t& vpkDir, const char* workspaceName = "");
@@ -217,7 +246,9 @@ public:
 private:
 	lzham_compress_params   m_Encoder; // LZham compression parameters.
 	lzham_decompress_params m_Decoder; // LZham decompression parameters.
-	std::unordered_map<string, const VPKChunkDescriptor_t&> m_ChunkHashMap;
+	int                     m_nWorkerThreads; // Number of threads used for packing and unpacking.
+	bool                    m_bContentDefinedChunking; // Whether to carve deduplicated entries on content boundaries.
+	std::unordered_map<VPKChunkHash_t, VPKChunkDescriptor_t, VPKChunkHashTraits_t> m_ChunkHashMap;
 };
 
 CUtlString PackedStore_GetDirBaseName(const CUtlString& dirFileName);